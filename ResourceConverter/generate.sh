@@ -9,7 +9,7 @@ ret=0
 
 rm -f "${PROJECT_DIR}/WhateverGreen/kern_resources.cpp"
 
-"${TARGET_BUILD_DIR}/ResourceConverter" \
+"${TARGET_BUILD_DIR}/ResourceConverter" --blob \
 	"${PROJECT_DIR}/Resources" \
 	"${PROJECT_DIR}/WhateverGreen/kern_resources.cpp" \
 	"${PROJECT_DIR}/WhateverGreen/kern_resources.hpp" || ret=1
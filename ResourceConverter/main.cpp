@@ -0,0 +1,737 @@
+//
+//  main.cpp
+//  ResourceConverter
+//
+//  Copyright © 2018 vit9696. All rights reserved.
+//
+
+// Portable converter from Resources/Patches.plist to kern_resources.cpp/.hpp.
+// Usage: ResourceConverter [--no-dedup | --blob] ResourcesDir kern_resources.cpp kern_resources.hpp
+//
+// Identical find/replace byte arrays are emitted once and shared by all patches referencing them,
+// --no-dedup emits one array per find/replace like the original Cocoa converter did,
+// --blob packs all patch bytes into a single array and prints a size report.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#define SYSLOG(str, ...) printf("ResourceConverter: " str "\n", ## __VA_ARGS__)
+#define ERROR(str, ...) do { SYSLOG(str, ## __VA_ARGS__); exit(1); } while(0)
+
+static const char ResourceHeader[] {"\
+//                                                   \n\
+//  kern_resources.cpp                               \n\
+//  WhateverGreen                                    \n\
+//                                                   \n\
+//  Copyright © 2018 vit9696. All rights reserved.   \n\
+//                                                   \n\
+//  This is an autogenerated file!                   \n\
+//  Please avoid any modifications!                  \n\
+//                                                   \n\n\
+#include \"kern_resources.hpp\"                      \n\n"
+};
+
+static const char ResourcePrivHeader[] {"\
+//                                                   \n\
+//  kern_resources.hpp                               \n\
+//  WhateverGreen                                    \n\
+//                                                   \n\
+//  Copyright © 2018 vit9696. All rights reserved.   \n\
+//                                                   \n\
+//  This is an autogenerated file!                   \n\
+//  Please avoid any modifications!                  \n\
+//                                                   \n\n\
+#include <Headers/kern_user.hpp>                     \n\
+#include <stdint.h>                                  \n\n\
+extern UserPatcher::BinaryModInfo ADDPR(binaryMod)[];\n\
+extern const size_t ADDPR(binaryModSize);            \n\n\
+extern UserPatcher::ProcInfo ADDPR(procInfoModern)[];\n\
+extern const size_t ADDPR(procInfoModernSize);       \n\n\
+extern UserPatcher::ProcInfo ADDPR(procInfoLegacy)[];\n\
+extern const size_t ADDPR(procInfoLegacySize);       \n\n"
+};
+
+/**
+ *  Parsed property list value, only the subset used by Patches.plist is kept
+ */
+struct PlistValue {
+	enum class Type {
+		String,
+		Integer,
+		Data,
+		Boolean,
+		Array,
+		Dict
+	};
+
+	Type type {Type::String};
+	std::string text;               // String, Integer (as written), Data (decoded bytes)
+	bool boolean {false};
+	std::vector<std::string> keys;  // Dict keys, values are in items
+	std::vector<PlistValue> items;  // Array items or Dict values
+
+	/**
+	 *  Look up a dictionary value
+	 *
+	 *  @param key  dictionary key
+	 *
+	 *  @return value or nullptr when missing or not a dictionary
+	 */
+	const PlistValue *get(const char *key) const {
+		if (type != Type::Dict)
+			return nullptr;
+		for (size_t i = 0; i < keys.size(); i++)
+			if (keys[i] == key)
+				return &items[i];
+		return nullptr;
+	}
+};
+
+/**
+ *  Single pass XML property list reader working directly on the file contents
+ */
+class PlistParser {
+	const char *cur;
+	const char *end;
+	const char *start;
+
+	[[noreturn]] void fail(const char *what) {
+		size_t line = 1;
+		for (auto p = start; p < cur && p < end; p++)
+			line += *p == '\n';
+		ERROR("Malformed Patches.plist at line %zu: %s", line, what);
+	}
+
+	bool startsWith(const char *str) const {
+		size_t len = strlen(str);
+		return static_cast<size_t>(end - cur) >= len && !memcmp(cur, str, len);
+	}
+
+	void skipPast(const char *str) {
+		size_t len = strlen(str);
+		while (static_cast<size_t>(end - cur) >= len) {
+			if (!memcmp(cur, str, len)) {
+				cur += len;
+				return;
+			}
+			cur++;
+		}
+		fail("unterminated markup");
+	}
+
+	/**
+	 *  Skip whitespace, XML declarations, doctypes and comments
+	 */
+	void skipMisc() {
+		while (cur < end) {
+			if (*cur == ' ' || *cur == '\t' || *cur == '\r' || *cur == '\n')
+				cur++;
+			else if (startsWith("<?"))
+				skipPast("?>");
+			else if (startsWith("<!--"))
+				skipPast("-->");
+			else if (startsWith("<!DOCTYPE"))
+				skipPast(">");
+			else
+				break;
+		}
+	}
+
+	/**
+	 *  Read an opening tag
+	 *
+	 *  @param name   tag name
+	 *  @param empty  set for self-closing tags
+	 */
+	void readTag(std::string &name, bool &empty) {
+		skipMisc();
+		if (cur >= end || *cur != '<' || cur + 1 >= end || cur[1] == '/')
+			fail("expected an element");
+		auto nameStart = ++cur;
+		while (cur < end && *cur != '>' && *cur != '/' && *cur != ' ' && *cur != '\t' && *cur != '\r' && *cur != '\n')
+			cur++;
+		name.assign(nameStart, cur);
+		while (cur < end && *cur != '>')
+			cur++;
+		if (cur >= end)
+			fail("unterminated element");
+		empty = cur[-1] == '/';
+		cur++;
+	}
+
+	void readClosingTag(const std::string &name) {
+		skipMisc();
+		if (!startsWith("</") || static_cast<size_t>(end - cur) < name.size() + 3 ||
+			memcmp(cur + 2, name.data(), name.size()) || cur[name.size() + 2] != '>')
+			fail("mismatched closing element");
+		cur += name.size() + 3;
+	}
+
+	bool atClosingTag() {
+		skipMisc();
+		return startsWith("</");
+	}
+
+	/**
+	 *  Read character data up to the closing tag, resolving entities and CDATA sections
+	 */
+	void readText(std::string &text, const std::string &name) {
+		text.clear();
+		while (cur < end) {
+			if (startsWith("<![CDATA[")) {
+				cur += strlen("<![CDATA[");
+				auto run = cur;
+				skipPast("]]>");
+				text.append(run, cur - 3);
+				continue;
+			}
+			if (*cur == '<')
+				break;
+
+			auto run = cur;
+			while (cur < end && *cur != '<' && *cur != '&')
+				cur++;
+			text.append(run, cur);
+			if (cur < end && *cur == '&') {
+				auto semi = static_cast<const char *>(memchr(cur, ';', end - cur));
+				if (!semi)
+					fail("unterminated entity");
+				std::string entity(cur + 1, semi);
+				if (entity == "lt") text += '<';
+				else if (entity == "gt") text += '>';
+				else if (entity == "amp") text += '&';
+				else if (entity == "quot") text += '"';
+				else if (entity == "apos") text += '\'';
+				else if (entity.size() > 1 && entity[0] == '#') {
+					auto code = entity[1] == 'x' ? strtoul(entity.c_str() + 2, nullptr, 16) : strtoul(entity.c_str() + 1, nullptr, 10);
+					appendUtf8(text, static_cast<uint32_t>(code));
+				} else {
+					fail("unknown entity");
+				}
+				cur = semi + 1;
+			}
+		}
+		readClosingTag(name);
+	}
+
+	static void appendUtf8(std::string &text, uint32_t code) {
+		if (code < 0x80) {
+			text += static_cast<char>(code);
+		} else if (code < 0x800) {
+			text += static_cast<char>(0xC0 | (code >> 6));
+			text += static_cast<char>(0x80 | (code & 0x3F));
+		} else if (code < 0x10000) {
+			text += static_cast<char>(0xE0 | (code >> 12));
+			text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			text += static_cast<char>(0x80 | (code & 0x3F));
+		} else {
+			text += static_cast<char>(0xF0 | (code >> 18));
+			text += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+			text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			text += static_cast<char>(0x80 | (code & 0x3F));
+		}
+	}
+
+	/**
+	 *  Decode base64 data in place, whitespace is ignored
+	 */
+	void decodeBase64(std::string &text) {
+		static int8_t table[256];
+		if (!table['B']) {
+			memset(table, -1, sizeof(table));
+			const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			for (int i = 0; i < 64; i++)
+				table[static_cast<uint8_t>(alphabet[i])] = static_cast<int8_t>(i);
+		}
+
+		size_t out = 0;
+		uint32_t acc = 0;
+		int bits = 0;
+		for (size_t i = 0; i < text.size(); i++) {
+			auto c = static_cast<uint8_t>(text[i]);
+			if (c == '=')
+				break;
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+				continue;
+			if (table[c] < 0)
+				fail("invalid base64 data");
+			acc = (acc << 6) | static_cast<uint32_t>(table[c]);
+			bits += 6;
+			if (bits >= 8) {
+				bits -= 8;
+				text[out++] = static_cast<char>((acc >> bits) & 0xFF);
+			}
+		}
+		text.resize(out);
+	}
+
+	void parseValue(PlistValue &value) {
+		std::string name;
+		bool empty;
+		readTag(name, empty);
+
+		if (name == "dict") {
+			value.type = PlistValue::Type::Dict;
+			if (empty)
+				return;
+			while (!atClosingTag()) {
+				readTag(name, empty);
+				if (name != "key")
+					fail("expected a key");
+				value.keys.emplace_back();
+				if (!empty)
+					readText(value.keys.back(), name);
+				value.items.emplace_back();
+				parseValue(value.items.back());
+			}
+			readClosingTag("dict");
+		} else if (name == "array") {
+			value.type = PlistValue::Type::Array;
+			if (empty)
+				return;
+			while (!atClosingTag()) {
+				value.items.emplace_back();
+				parseValue(value.items.back());
+			}
+			readClosingTag("array");
+		} else if (name == "true" || name == "false") {
+			value.type = PlistValue::Type::Boolean;
+			value.boolean = name == "true";
+			if (!empty)
+				readClosingTag(name);
+		} else if (name == "string" || name == "integer" || name == "real" || name == "date" || name == "data") {
+			value.type = name == "string" ? PlistValue::Type::String : name == "data" ? PlistValue::Type::Data : PlistValue::Type::Integer;
+			if (!empty)
+				readText(value.text, name);
+			if (value.type == PlistValue::Type::Data)
+				decodeBase64(value.text);
+		} else {
+			fail("unsupported element");
+		}
+	}
+
+public:
+	PlistParser(const char *data, size_t size) : cur(data), end(data + size), start(data) {}
+
+	/**
+	 *  Parse the root object of the property list
+	 *
+	 *  @param root  parsed root value
+	 */
+	void parse(PlistValue &root) {
+		std::string name;
+		bool empty;
+		readTag(name, empty);
+		if (name != "plist" || empty)
+			fail("expected plist root");
+		parseValue(root);
+		readClosingTag("plist");
+	}
+};
+
+/**
+ *  Generated source, appended to a buffer reserved once and written out in a single call
+ */
+class Output {
+	std::string buf;
+
+public:
+	explicit Output(size_t reserve) {
+		buf.reserve(reserve);
+	}
+
+	Output &operator<<(const char *str) {
+		buf.append(str);
+		return *this;
+	}
+
+	Output &operator<<(const std::string &str) {
+		buf.append(str);
+		return *this;
+	}
+
+	Output &operator<<(size_t num) {
+		char tmp[24];
+		size_t pos = sizeof(tmp);
+		do {
+			tmp[--pos] = static_cast<char>('0' + num % 10);
+			num /= 10;
+		} while (num);
+		buf.append(tmp + pos, sizeof(tmp) - pos);
+		return *this;
+	}
+
+	void appendBytes(const std::string &bytes) {
+		static const char hex[] = "0123456789ABCDEF";
+		for (auto c : bytes) {
+			auto b = static_cast<uint8_t>(c);
+			char tmp[6] {'0', 'x', hex[b >> 4], hex[b & 0xF], ',', ' '};
+			buf.append(tmp, sizeof(tmp));
+		}
+	}
+
+	void write(const char *path) const {
+		auto file = fopen(path, "wb");
+		if (!file)
+			ERROR("Failed to open %s", path);
+		bool ok = fwrite(buf.data(), 1, buf.size(), file) == buf.size();
+		ok = fclose(file) == 0 && ok;
+		if (!ok)
+			ERROR("Failed to write %s", path);
+	}
+};
+
+/**
+ *  Section names in the order of their first use
+ */
+class SectionList {
+	std::vector<std::string> names;
+
+public:
+	void add(const PlistValue *name) {
+		if (!name)
+			ERROR("Missing Section");
+		for (auto &n : names)
+			if (n == name->text)
+				return;
+		names.push_back(name->text);
+	}
+
+	const std::vector<std::string> &list() const {
+		return names;
+	}
+};
+
+/**
+ *  Append a string or integer value as written, or the default when missing
+ */
+static Output &appendValue(Output &out, const PlistValue *value, const char *def) {
+	if (!value)
+		return out << def;
+	if (value->type == PlistValue::Type::Integer)
+		return out << std::to_string(strtoll(value->text.c_str(), nullptr, 0));
+	return out << value->text;
+}
+
+static bool isDisabled(const PlistValue &entry) {
+	return entry.get("Disable") != nullptr;
+}
+
+/**
+ *  How patch bytes are laid out in the generated source
+ */
+enum class PatchLayout {
+	Arrays, // one patchBuf array per find/replace, like the original Cocoa converter
+	Shared, // identical patchBuf arrays emitted once
+	Blob    // one patchBlob array, patches point at 8-byte aligned offsets inside it
+};
+
+class PatchWriter {
+	Output &out;
+	PatchLayout layout;
+	size_t patchIndex {0};
+	size_t patchBufIndex {0};
+	std::map<std::string, std::string> patchBufs;
+	std::string blob;
+
+	size_t fieldCount {0};
+	size_t arrayBytes {0};
+
+	static bool isValid(const PlistValue &p) {
+		auto find = p.get("Find"), replace = p.get("Replace");
+		return find && replace && find->text.size() == replace->text.size();
+	}
+
+	static size_t alignUp(size_t size) {
+		return (size + 7) & ~static_cast<size_t>(7);
+	}
+
+	/**
+	 *  Place bytes into the blob, reusing any aligned position already holding them.
+	 *  A tail that matches only partially is extended in place, so repeated prefixes cost nothing.
+	 *
+	 *  @param bytes  array contents
+	 *
+	 *  @return blob offset
+	 */
+	size_t placeInBlob(const std::string &bytes) {
+		for (size_t off = 0; off < blob.size(); off += 8) {
+			size_t avail = std::min(bytes.size(), blob.size() - off);
+			if (!memcmp(blob.data() + off, bytes.data(), avail)) {
+				blob.append(bytes, avail, std::string::npos);
+				return off;
+			}
+		}
+
+		size_t off = alignUp(blob.size());
+		blob.resize(off);
+		blob += bytes;
+		return off;
+	}
+
+	/**
+	 *  Emit a byte array unless an identical one was already emitted
+	 *
+	 *  @param bytes  array contents
+	 *
+	 *  @return expression referencing the bytes
+	 */
+	std::string emitBuffer(const std::string &bytes) {
+		if (layout != PatchLayout::Arrays) {
+			auto it = patchBufs.find(bytes);
+			if (it != patchBufs.end())
+				return it->second;
+		}
+
+		std::string ref = "patchBuf" + std::to_string(patchBufIndex++);
+		out << "alignas(8) static const uint8_t " << ref << "[] { ";
+		out.appendBytes(bytes);
+		out << "};\n";
+		if (layout != PatchLayout::Arrays)
+			patchBufs.emplace(bytes, ref);
+		return ref;
+	}
+
+	std::string reference(const std::string &bytes) {
+		if (layout == PatchLayout::Blob) {
+			auto it = patchBufs.find(bytes);
+			if (it == patchBufs.end())
+				ERROR("Patch bytes missing from the blob");
+			return it->second;
+		}
+		return emitBuffer(bytes);
+	}
+
+public:
+	PatchWriter(Output &out, PatchLayout layout) : out(out), layout(layout) {}
+
+	/**
+	 *  Pack the bytes of every patch into the blob and emit it, only used with PatchLayout::Blob
+	 *
+	 *  @param modInfos  Patches array
+	 */
+	void generateBlob(const PlistValue &modInfos) {
+		for (auto &entry : modInfos.items) {
+			auto patches = entry.get("Patches");
+			if (isDisabled(entry) || !patches)
+				continue;
+			for (auto &p : patches->items) {
+				if (isDisabled(p) || !isValid(p))
+					continue;
+				for (auto field : {p.get("Find"), p.get("Replace")}) {
+					fieldCount++;
+					arrayBytes += alignUp(field->text.size());
+					if (!patchBufs.count(field->text))
+						patchBufs.emplace(field->text, "patchBlob + " + std::to_string(placeInBlob(field->text)));
+				}
+			}
+		}
+
+		out << "alignas(8) static const uint8_t patchBlob[] {";
+		for (size_t off = 0; off < blob.size(); off += 16) {
+			out << "\n\t";
+			out.appendBytes(blob.substr(off, 16));
+		}
+		out << "\n};\n\n";
+	}
+
+	/**
+	 *  Print the blob size against separate arrays, cold cache lines stand for the load cost
+	 *  as the data is only paged in when the patcher first reads it.
+	 */
+	void report() const {
+		SYSLOG("%zu patch fields in %zu bytes (%zu cache lines) as arrays, %zu bytes (%zu cache lines) as blob",
+			   fieldCount, arrayBytes, (arrayBytes + 63) / 64, blob.size(), (blob.size() + 63) / 64);
+	}
+
+	/**
+	 *  Emit the byte arrays and the patch array of one binary mod
+	 *
+	 *  @param patches  Patches array, may be nullptr
+	 *
+	 *  @return array name and entry count for the BinaryModInfo initialiser
+	 */
+	std::string generatePatchEntries(const PlistValue *patches) {
+		if (!patches)
+			return "nullptr, 0";
+
+		// Byte arrays precede the patch array, which references them by name.
+		std::vector<std::string> refs;
+		for (auto &p : patches->items) {
+			if (isDisabled(p) || !isValid(p))
+				continue;
+			refs.push_back(reference(p.get("Find")->text));
+			refs.push_back(reference(p.get("Replace")->text));
+		}
+
+		out << "static UserPatcher::BinaryModPatch patches" << patchIndex << "[] {\n";
+		size_t count = 0;
+		for (auto &p : patches->items) {
+			if (isDisabled(p))
+				continue;
+
+			if (!isValid(p)) {
+				out << "#error not matching patch lengths\n";
+				continue;
+			}
+
+			out << "\t{ ";
+			appendValue(out, p.get("CPU"), "") << ", ";
+			appendValue(out, p.get("Flags"), "0") << ", " << refs[count * 2] << ", " << refs[count * 2 + 1] << ", ";
+			out << p.get("Find")->text.size() << ", ";
+			appendValue(out, p.get("Skip"), "0") << ", ";
+			appendValue(out, p.get("Count"), "") << ", UserPatcher::FileSegment::Segment";
+			appendValue(out, p.get("Segment"), "TextText") << ", Section";
+			appendValue(out, p.get("Section"), "") << " },\n";
+			count++;
+		}
+		out << "};\n";
+
+		return "patches" + std::to_string(patchIndex++) + ", " + std::to_string(count);
+	}
+};
+
+static void generateMods(Output &out, const PlistValue *modInfos, SectionList &sections, PatchLayout layout) {
+	if (!modInfos)
+		ERROR("Missing Patches");
+
+	for (auto &entry : modInfos->items) {
+		if (isDisabled(entry))
+			continue;
+
+		auto patches = entry.get("Patches");
+		if (patches)
+			for (auto &patch : patches->items)
+				sections.add(patch.get("Section"));
+	}
+
+	out << "\n// Patch section\n\n";
+
+	PatchWriter writer(out, layout);
+	if (layout == PatchLayout::Blob) {
+		writer.generateBlob(*modInfos);
+		writer.report();
+	}
+
+	std::vector<std::string> mods;
+	for (auto &entry : modInfos->items) {
+		if (isDisabled(entry))
+			continue;
+
+		auto path = entry.get("Path");
+		if (!path)
+			ERROR("Missing Path");
+		mods.push_back("\t{ \"" + path->text + "\", " + writer.generatePatchEntries(entry.get("Patches")) + " },\n");
+	}
+
+	out << "\n// Mod section\n\n";
+	out << "UserPatcher::BinaryModInfo ADDPR(binaryMod)[] {\n";
+	for (auto &mod : mods)
+		out << mod;
+	out << "};\n";
+	out << "\nconst size_t ADDPR(binaryModSize) {" << mods.size() << "};\n";
+}
+
+static void generateComparison(Output &out, const PlistValue *binaries, SectionList &sections, bool modern) {
+	if (!binaries)
+		ERROR("Missing Processes");
+
+	out << "\n// Process list\nusing PF = UserPatcher::ProcInfo::ProcFlags;\n\n";
+	out << "UserPatcher::ProcInfo ADDPR(procInfo" << (modern ? "Modern" : "Legacy") << ")[] {\n";
+
+	size_t procCount = 0;
+	for (auto &entry : binaries->items) {
+		if (isDisabled(entry))
+			continue;
+
+		auto type = entry.get("Type");
+		if (type && type->text != (modern ? "Modern" : "Legacy"))
+			continue;
+
+		auto path = entry.get("Path");
+		if (!path)
+			ERROR("Missing Path");
+
+		sections.add(entry.get("Section"));
+
+		auto prefix = entry.get(modern ? "ModernPrefix" : "LegacyPrefix");
+		out << "\t{ \"";
+		appendValue(out, prefix, "") << path->text << "\", " << (path->text.size() + (prefix ? prefix->text.size() : 0)) << ", Section";
+		appendValue(out, entry.get("Section"), "") << ", ";
+		appendValue(out, entry.get("Flags"), "PF::MatchExact") << " },\n";
+
+		procCount++;
+	}
+	out << "};\n";
+	out << "\nconst size_t ADDPR(procInfo" << (modern ? "Modern" : "Legacy") << "Size) {" << procCount << "};";
+}
+
+static std::string readFile(const std::string &path) {
+	auto file = fopen(path.c_str(), "rb");
+	if (!file)
+		return {};
+
+	std::string data;
+	if (!fseek(file, 0, SEEK_END)) {
+		long size = ftell(file);
+		if (size > 0 && !fseek(file, 0, SEEK_SET)) {
+			data.resize(static_cast<size_t>(size));
+			if (fread(&data[0], 1, data.size(), file) != data.size())
+				data.clear();
+		}
+	}
+	fclose(file);
+	return data;
+}
+
+int main(int argc, const char * argv[]) {
+	auto layout = PatchLayout::Shared;
+	if (argc == 5 && !strcmp(argv[1], "--no-dedup"))
+		layout = PatchLayout::Arrays;
+	else if (argc == 5 && !strcmp(argv[1], "--blob"))
+		layout = PatchLayout::Blob;
+	if (layout != PatchLayout::Shared) {
+		argv++;
+		argc--;
+	}
+
+	if (argc != 4)
+		ERROR("Invalid usage");
+
+	auto plist = readFile(std::string(argv[1]) + "/Patches.plist");
+	if (plist.empty())
+		ERROR("Missing resource data");
+
+	PlistValue patches;
+	PlistParser(plist.data(), plist.size()).parse(patches);
+	if (patches.type != PlistValue::Type::Dict)
+		ERROR("Missing resource data");
+
+	// Every data byte expands to six characters and the rest stays close to the plist size,
+	// so this covers the whole source without regrowing.
+	Output cpp(plist.size() * 4 + 4096);
+	Output hpp(sizeof(ResourcePrivHeader) + 4096);
+	SectionList sections;
+
+	cpp << ResourceHeader;
+	hpp << ResourcePrivHeader;
+	generateMods(cpp, patches.get("Patches"), sections, layout);
+	generateComparison(cpp, patches.get("Processes"), sections, false);
+	generateComparison(cpp, patches.get("Processes"), sections, true);
+
+	hpp << "\n// Section list\n\nenum : uint32_t {\n\tSectionUnused = 0,\n";
+	size_t sectionIndex = 1;
+	for (auto &entry : sections.list())
+		hpp << "\tSection" << entry << " = " << sectionIndex++ << ",\n";
+	hpp << "};\n";
+
+	cpp.write(argv[2]);
+	hpp.write(argv[3]);
+	return 0;
+}
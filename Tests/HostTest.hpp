@@ -0,0 +1,53 @@
+//
+//  HostTest.hpp
+//  WhateverGreen host tests
+//
+//  Minimal checks for the host test executables, each one returns the number of failed checks.
+//
+
+#ifndef HostTest_hpp
+#define HostTest_hpp
+
+#include <chrono>
+#include <cstdio>
+
+namespace HostTest {
+	inline int &failures() {
+		static int count;
+		return count;
+	}
+
+	inline bool check(bool condition, const char *expression, const char *file, int line) {
+		if (!condition) {
+			fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+			failures()++;
+		}
+		return condition;
+	}
+
+	/**
+	 *  Time a callable over a number of iterations and return nanoseconds per iteration
+	 */
+	template <typename F>
+	double measure(size_t iterations, F body) {
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++)
+			body(i);
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / iterations;
+	}
+
+	inline int finish(const char *name) {
+		if (failures() == 0)
+			printf("%s: all checks passed\n", name);
+		else
+			printf("%s: %d checks failed\n", name, failures());
+		return failures() != 0;
+	}
+}
+
+#define CHECK(condition) HostTest::check((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_EQ(a, b) HostTest::check((a) == (b), #a " == " #b, __FILE__, __LINE__)
+
+#endif /* HostTest_hpp */
@@ -0,0 +1,167 @@
+//
+//  IGFXClockTests.cpp
+//  WhateverGreen host tests
+//
+//  Clock related IGFX submodules: symbol routing and the wrappers run against a simulated controller.
+//
+
+#include "HostTest.hpp"
+#include "IGFXSupport.hpp"
+
+static const char *probeCDClockFrequency = "__ZN31AppleIntelFramebufferController21probeCDClockFrequencyEv";
+static const char *disableCDClock = "__ZN31AppleIntelFramebufferController14disableCDClockEv";
+static const char *setCDClockFrequency = "__ZN31AppleIntelFramebufferController19setCDClockFrequencyEy";
+static const char *connectionProbe = "__ZN21AppleIntelFramebuffer15connectionProbeEjj";
+static const char *computeHdmiP0P1P2 = "__ZN31AppleIntelFramebufferController17ComputeHdmiP0P1P2EjP21AppleIntelDisplayPathPNS_10CRTCParamsE";
+
+static constexpr uint32_t ICL_REG_CDCLK_CTL = 0x46000;
+static constexpr uint32_t ICL_REG_DSSM = 0x51004;
+
+static size_t disableCalls;
+static uint64_t programmedPLLFrequency;
+
+static uint32_t orgProbeCDClockFrequency(IGFX::AppleIntelFramebufferController *) {
+	return IGFXSupport::registers()[ICL_REG_CDCLK_CTL] & 0x7FF;
+}
+
+static void orgDisableCDClock(IGFX::AppleIntelFramebufferController *) {
+	disableCalls++;
+}
+
+static void orgSetCDClockFrequency(IGFX::AppleIntelFramebufferController *, unsigned long long frequency) {
+	programmedPLLFrequency = frequency;
+	// CDCLK runs at half the PLL frequency, the decimal field holds it minus 1 MHz in 0.5 MHz units
+	IGFXSupport::registers()[ICL_REG_CDCLK_CTL] = static_cast<uint32_t>((frequency + 500000) / 1000000 - 2);
+}
+
+static IOReturn orgConnectionProbe(IOService *that, unsigned int, unsigned int) {
+	IODisplayTimingRangeV1 range {};
+	range.maxPixelClock = 450000000;
+	that->setProperty(kIOFBTimingRangeKey, &range, sizeof(range));
+	return kIOReturnSuccess;
+}
+
+static int orgComputeHdmiP0P1P2(IGFX::AppleIntelFramebufferController *, uint32_t, void *, void *) {
+	return 0;
+}
+
+static void testRouting() {
+	auto igfx = IGFXSupport::reset();
+	auto &cdc = IGFXSupport::construct(igfx->modCoreDisplayClockFix);
+	auto &mpc = IGFXSupport::construct(igfx->modMaxPixelClockOverride);
+	auto &hdmi = IGFXSupport::construct(igfx->modHDMIDividersCalcFix);
+
+	// Nothing resolves: each submodule reports the failure and leaves its originals unset
+	KernelPatcher missing;
+	cdc.processFramebufferKext(missing, 1, 0, 0);
+	mpc.processFramebufferKext(missing, 1, 0, 0);
+	CHECK(missing.routes.empty());
+	CHECK(cdc.orgProbeCDClockFrequency == nullptr);
+	CHECK(mpc.orgConnectionProbe == nullptr);
+
+	KernelPatcher patcher;
+	patcher.provide(probeCDClockFrequency, orgProbeCDClockFrequency);
+	patcher.provide(disableCDClock, orgDisableCDClock);
+	patcher.provide(setCDClockFrequency, orgSetCDClockFrequency);
+	patcher.provide(connectionProbe, orgConnectionProbe);
+	patcher.provide(computeHdmiP0P1P2, orgComputeHdmiP0P1P2);
+	cdc.processFramebufferKext(patcher, 1, 0, 0);
+	mpc.processFramebufferKext(patcher, 1, 0, 0);
+	hdmi.processFramebufferKext(patcher, 1, 0, 0);
+
+	CHECK_EQ(patcher.routeCount(probeCDClockFrequency), 1);
+	CHECK_EQ(patcher.routeCount(connectionProbe), 1);
+	CHECK_EQ(patcher.routeCount(computeHdmiP0P1P2), 1);
+	CHECK_EQ(patcher.routes.size(), 3);
+	CHECK(cdc.orgProbeCDClockFrequency == orgProbeCDClockFrequency);
+	CHECK(cdc.orgDisableCDClock == orgDisableCDClock);
+	CHECK(cdc.orgSetCDClockFrequency == orgSetCDClockFrequency);
+	CHECK(mpc.orgConnectionProbe == orgConnectionProbe);
+}
+
+static void testEnabling() {
+	auto igfx = IGFXSupport::reset();
+	auto &cdc = IGFXSupport::construct(igfx->modCoreDisplayClockFix);
+	auto &mpc = IGFXSupport::construct(igfx->modMaxPixelClockOverride);
+	KernelPatcher patcher;
+	IORegistryEntry igpu;
+	DeviceInfo info {};
+	info.videoBuiltin = &igpu;
+
+	hostBootArguments = "";
+	cdc.processKernel(patcher, &info);
+	mpc.processKernel(patcher, &info);
+	CHECK(!cdc.enabled);
+	CHECK(!mpc.enabled);
+
+	hostBootArguments = "-igfxcdc";
+	cdc.processKernel(patcher, &info);
+	CHECK(cdc.enabled);
+	hostBootArguments = "";
+
+	uint32_t frequency = 600000000;
+	igpu.setProperty("enable-max-pixel-clock-override", &frequency, sizeof(frequency));
+	igpu.setProperty("max-pixel-clock-frequency", &frequency, sizeof(frequency));
+	mpc.processKernel(patcher, &info);
+	CHECK(mpc.enabled);
+	CHECK_EQ(mpc.maxPixelClockFrequency, 600000000);
+}
+
+static void testCoreDisplayClock() {
+	struct {
+		uint32_t referenceFrequency;
+		uint32_t firmwareFrequency;
+		uint32_t expectedPLLFrequency;
+		size_t expectedDisables;
+	} cases[] = {
+		// 172.8 MHz at 24 MHz, 19.2 MHz and 38.4 MHz references
+		{0x0, 0x158, 24000000 * 54, 1},
+		{0x1, 0x158, 19200000 * 68, 1},
+		{0x2, 0x158, 38400000 * 34, 1},
+		// 652.8 MHz is supported natively and left alone
+		{0x1, 0x518, 0, 0},
+	};
+
+	for (auto &c : cases) {
+		auto igfx = IGFXSupport::reset();
+		auto &cdc = IGFXSupport::construct(igfx->modCoreDisplayClockFix);
+		KernelPatcher patcher;
+		patcher.provide(probeCDClockFrequency, orgProbeCDClockFrequency);
+		patcher.provide(disableCDClock, orgDisableCDClock);
+		patcher.provide(setCDClockFrequency, orgSetCDClockFrequency);
+		cdc.processFramebufferKext(patcher, 1, 0, 0);
+
+		disableCalls = 0;
+		programmedPLLFrequency = 0;
+		IGFXSupport::registers()[ICL_REG_DSSM] = c.referenceFrequency << 29;
+		IGFXSupport::registers()[ICL_REG_CDCLK_CTL] = c.firmwareFrequency;
+		auto frequency = IGFX::CoreDisplayClockFix::wrapProbeCDClockFrequency(nullptr);
+
+		CHECK_EQ(disableCalls, c.expectedDisables);
+		CHECK_EQ(programmedPLLFrequency, c.expectedPLLFrequency);
+		CHECK(frequency == 0x50E || frequency == 0x518);
+	}
+}
+
+static void testMaxPixelClock() {
+	auto igfx = IGFXSupport::reset();
+	auto &mpc = IGFXSupport::construct(igfx->modMaxPixelClockOverride);
+	KernelPatcher patcher;
+	patcher.provide(connectionProbe, orgConnectionProbe);
+	mpc.processFramebufferKext(patcher, 1, 0, 0);
+	mpc.maxPixelClockFrequency = 675000000;
+
+	IOService framebuffer;
+	CHECK_EQ(IGFX::MaxPixelClockOverride::wrapConnectionProbe(&framebuffer, 0, 0), kIOReturnSuccess);
+	auto range = OSDynamicCast(OSData, framebuffer.getProperty(kIOFBTimingRangeKey));
+	if (CHECK(range != nullptr))
+		CHECK_EQ(static_cast<const IODisplayTimingRangeV1 *>(range->getBytesNoCopy())->maxPixelClock, 675000000);
+}
+
+int main() {
+	testRouting();
+	testEnabling();
+	testCoreDisplayClock();
+	testMaxPixelClock();
+	return HostTest::finish("IGFXClockTests");
+}
@@ -0,0 +1,283 @@
+//
+//  IGFXDPCDShadowTests.cpp
+//  WhateverGreen host tests
+//
+//  DPCD shadow of DPCDMaxLinkRateFix: AUX transactions reaching a mock eDP panel, invalidation
+//  on power state changes and failed reads, external framebuffers and the doSetPowerState route.
+//
+
+#include "HostTest.hpp"
+#include "IGFXSupport.hpp"
+
+static const char *readAUX = "__ZN31AppleIntelFramebufferController7ReadAUXEP21AppleIntelFramebufferjtPvP21AppleIntelDisplayPath";
+static const char *doSetPowerState = "__ZN21AppleIntelFramebuffer15doSetPowerStateEj";
+
+/**
+ *  Mock AUX endpoint of a DisplayPort sink, counting every transaction
+ */
+struct Sink {
+	uint8_t dpcd[0x2300] {};
+	size_t transactions {};
+	bool present {true};
+};
+
+/**
+ *  Sinks attached to framebuffers 0 (builtin eDP panel) and 1 (external display)
+ */
+static Sink sinks[2];
+static IORegistryEntry *framebuffers[2];
+static size_t powerStateCalls;
+
+static IOReturn orgReadAUX(IGFX::AppleIntelFramebufferController *, IORegistryEntry *framebuffer, uint32_t address, uint16_t length, void *buffer, void *) {
+	auto &sink = sinks[framebuffer == framebuffers[1]];
+	sink.transactions++;
+	if (!sink.present || address + length > sizeof(sink.dpcd))
+		return kIOReturnError;
+	memcpy(buffer, sink.dpcd + address, length);
+	return kIOReturnSuccess;
+}
+
+static IOReturn orgDoSetPowerState(IOService *, uint32_t) {
+	powerStateCalls++;
+	return kIOReturnSuccess;
+}
+
+/**
+ *  Panels used by the driver: eDP 1.3, eDP 1.4 with a top rate the driver lacks, eDP 1.4 HBR2
+ */
+enum class Panel {
+	EDP13,
+	EDP14Unsupported,
+	EDP14HBR2,
+};
+
+static void attachPanel(Panel panel) {
+	sinks[0] = Sink {};
+	sinks[0].dpcd[0x000] = 0x12;
+	sinks[0].dpcd[0x2200] = 0x12;
+	sinks[0].dpcd[0x700] = panel == Panel::EDP13 ? 0x02 : 0x03;
+	// Link rates in 200 kHz units, 20000 is 4 Gbps and 27000 is HBR2
+	uint16_t rates[8] {8100, 13500, static_cast<uint16_t>(panel == Panel::EDP14HBR2 ? 27000 : 20000)};
+	memcpy(sinks[0].dpcd + 0x010, rates, sizeof(rates));
+
+	sinks[1] = Sink {};
+	sinks[1].dpcd[0x000] = 0x14;
+	sinks[1].dpcd[0x001] = 0x1E;
+	sinks[1].dpcd[0x700] = 0x04;
+}
+
+/**
+ *  Set up MLR for a Coffee Lake framebuffer, routing doSetPowerState unless routePowerState is false
+ */
+static IGFX::DPCDMaxLinkRateFix &setup(KernelPatcher &patcher, bool routePowerState, bool framebufferDebug = false) {
+	auto igfx = IGFXSupport::reset();
+	auto &mlr = IGFXSupport::construct(igfx->modDPCDMaxLinkRateFix);
+	igfx->modFramebufferDebugSupport.enabled = framebufferDebug;
+	mlr.enabled = true;
+	BaseDeviceInfo::get().cpuGeneration = CPUInfo::CpuGeneration::CoffeeLake;
+
+	for (uint32_t i = 0; i < arrsize(framebuffers); i++) {
+		if (framebuffers[i] == nullptr)
+			framebuffers[i] = IGFXSupport::createFramebuffer(i);
+	}
+
+	patcher.provide(readAUX, orgReadAUX);
+	if (routePowerState)
+		patcher.provide(doSetPowerState, orgDoSetPowerState);
+	mlr.processFramebufferKext(patcher, 1, 0, 0);
+	powerStateCalls = 0;
+	return mlr;
+}
+
+static IOReturn read(uint32_t framebuffer, uint32_t address, void *buffer, uint16_t length) {
+	return IGFX::DPCDMaxLinkRateFix::wrapCFLReadAUX(nullptr, framebuffers[framebuffer], address, length, buffer, nullptr);
+}
+
+/**
+ *  Receiver capability reads of the driver, both copies of them per round
+ */
+static size_t readCapabilities(size_t rounds, uint8_t &maxLinkRate) {
+	size_t transactions = sinks[0].transactions;
+	uint8_t caps[16];
+	for (size_t i = 0; i < rounds; i++) {
+		read(0, 0x000, caps, sizeof(caps));
+		read(0, 0x2200, caps, sizeof(caps));
+	}
+	maxLinkRate = caps[1];
+	return sinks[0].transactions - transactions;
+}
+
+/**
+ *  Call doSetPowerState through the wrapper routed by MLR
+ */
+static IOReturn setPowerState(KernelPatcher &patcher, uint32_t state) {
+	auto route = patcher.routes.find(doSetPowerState);
+	if (!CHECK(route != patcher.routes.end()))
+		return kIOReturnError;
+	return reinterpret_cast<IOReturn (*)(IOService *, uint32_t)>(route->second)(nullptr, state);
+}
+
+static void testTransactionCounts() {
+	static const struct {
+		Panel panel;
+		const char *name;
+		size_t unshadowed;
+		size_t shadowed;
+		uint8_t maxLinkRate;
+	} expected[] {
+		{Panel::EDP13, "eDP 1.3", 40, 3, 0x00},
+		{Panel::EDP14Unsupported, "eDP 1.4, unsupported rate", 60, 4, 0x00},
+		{Panel::EDP14HBR2, "eDP 1.4 HBR2", 22, 4, 0x14},
+	};
+
+	for (auto &panel : expected) {
+		// Without a doSetPowerState route the shadow stays off and every read reaches the panel.
+		attachPanel(panel.panel);
+		KernelPatcher unrouted;
+		size_t syslogs = hostSyslogCount;
+		auto &mlr = setup(unrouted, false);
+		CHECK(!mlr.shadowEnabled);
+		CHECK_EQ(hostSyslogCount - syslogs, 1);
+		uint8_t maxLinkRate;
+		size_t unshadowed = readCapabilities(10, maxLinkRate);
+		CHECK_EQ(unshadowed, panel.unshadowed);
+		CHECK_EQ(maxLinkRate, panel.maxLinkRate);
+
+		attachPanel(panel.panel);
+		KernelPatcher patcher;
+		CHECK(setup(patcher, true).shadowEnabled);
+		size_t shadowed = readCapabilities(10, maxLinkRate);
+		CHECK_EQ(shadowed, panel.shadowed);
+		CHECK_EQ(maxLinkRate, panel.maxLinkRate);
+		printf("%s: 20 capability reads, %lu AUX transactions without the shadow, %lu with it\n", panel.name, unshadowed, shadowed);
+	}
+}
+
+static void testPowerStateInvalidation() {
+	attachPanel(Panel::EDP14HBR2);
+	KernelPatcher patcher;
+	setup(patcher, true);
+	uint8_t maxLinkRate;
+	readCapabilities(1, maxLinkRate);
+
+	// Until a power state change the shadow answers, even if the panel changed meanwhile.
+	sinks[0].dpcd[0x000] = 0x14;
+	sinks[0].dpcd[0x700] = 0x04;
+	uint8_t caps[16], version;
+	size_t transactions = sinks[0].transactions;
+	CHECK_EQ(read(0, 0x000, caps, sizeof(caps)), kIOReturnSuccess);
+	CHECK_EQ(read(0, 0x700, &version, 1), kIOReturnSuccess);
+	CHECK_EQ(caps[0], 0x12);
+	CHECK_EQ(version, 0x03);
+	CHECK_EQ(sinks[0].transactions, transactions);
+
+	// Sleep and wake go through the original and drop every range.
+	CHECK_EQ(setPowerState(patcher, 0), kIOReturnSuccess);
+	CHECK_EQ(setPowerState(patcher, 2), kIOReturnSuccess);
+	CHECK_EQ(powerStateCalls, 2);
+	CHECK_EQ(read(0, 0x000, caps, sizeof(caps)), kIOReturnSuccess);
+	CHECK_EQ(caps[0], 0x14);
+	CHECK_EQ(caps[1], 0x14);
+	CHECK_EQ(sinks[0].transactions - transactions, 1);
+
+	// The eDP version is no longer shadowed after the probe result was kept, so it reaches the panel.
+	CHECK_EQ(read(0, 0x700, &version, 1), kIOReturnSuccess);
+	CHECK_EQ(version, 0x04);
+	CHECK_EQ(sinks[0].transactions - transactions, 2);
+	CHECK_EQ(read(0, 0x000, caps, sizeof(caps)), kIOReturnSuccess);
+	CHECK_EQ(sinks[0].transactions - transactions, 2);
+}
+
+static void testFailedReadDrop() {
+	attachPanel(Panel::EDP14HBR2);
+	KernelPatcher patcher;
+	setup(patcher, true);
+	uint8_t maxLinkRate;
+	readCapabilities(1, maxLinkRate);
+
+	// Refill a single range after a wake, then fail the next one.
+	setPowerState(patcher, 2);
+	uint8_t caps[16];
+	CHECK_EQ(read(0, 0x2200, caps, sizeof(caps)), kIOReturnSuccess);
+	sinks[0].present = false;
+	size_t transactions = sinks[0].transactions;
+	CHECK(read(0, 0x000, caps, sizeof(caps)) != kIOReturnSuccess);
+	CHECK_EQ(sinks[0].transactions - transactions, 1);
+
+	// Both the range filled before the failure and the failed one are fetched again.
+	sinks[0].present = true;
+	CHECK_EQ(read(0, 0x2200, caps, sizeof(caps)), kIOReturnSuccess);
+	CHECK_EQ(read(0, 0x000, caps, sizeof(caps)), kIOReturnSuccess);
+	CHECK_EQ(sinks[0].transactions - transactions, 3);
+	CHECK_EQ(caps[0], 0x12);
+	CHECK_EQ(read(0, 0x000, caps, sizeof(caps)), kIOReturnSuccess);
+	CHECK_EQ(sinks[0].transactions - transactions, 3);
+}
+
+static void testBuiltinOnly() {
+	attachPanel(Panel::EDP14HBR2);
+	KernelPatcher patcher;
+	setup(patcher, true);
+	uint8_t maxLinkRate;
+	readCapabilities(1, maxLinkRate);
+
+	// External displays may be replaced at any time: all their reads reach the sink, also of ranges shadowed for the panel.
+	uint8_t caps[16], version;
+	for (size_t i = 0; i < 5; i++) {
+		CHECK_EQ(read(1, 0x000, caps, sizeof(caps)), kIOReturnSuccess);
+		CHECK_EQ(read(1, 0x700, &version, 1), kIOReturnSuccess);
+	}
+	CHECK_EQ(sinks[1].transactions, 10);
+	CHECK_EQ(caps[0], 0x14);
+	CHECK_EQ(caps[1], 0x1E);
+	CHECK_EQ(version, 0x04);
+
+	// Nor do they fill the panel shadow.
+	size_t transactions = sinks[0].transactions;
+	CHECK_EQ(read(0, 0x000, caps, sizeof(caps)), kIOReturnSuccess);
+	CHECK_EQ(caps[0], 0x12);
+	CHECK_EQ(sinks[0].transactions, transactions);
+
+	// Mutable panel registers are never shadowed.
+	uint8_t status[6];
+	for (size_t i = 0; i < 5; i++)
+		read(0, 0x202, status, sizeof(status));
+	CHECK_EQ(sinks[0].transactions - transactions, 5);
+}
+
+static void testSinglePowerStateRoute() {
+	attachPanel(Panel::EDP14HBR2);
+	KernelPatcher patcher;
+	auto &mlr = setup(patcher, true);
+	CHECK_EQ(patcher.routeCount(readAUX), 1);
+	CHECK_EQ(patcher.routeCount(doSetPowerState), 1);
+	CHECK(mlr.orgDoSetPowerState == orgDoSetPowerState);
+
+	// With framebuffer debugging its doSetPowerState wrapper notifies MLR instead of a second route.
+	KernelPatcher shared;
+	auto &debugMLR = setup(shared, true, true);
+	CHECK_EQ(shared.routeCount(readAUX), 1);
+	CHECK_EQ(shared.routeCount(doSetPowerState), 0);
+	CHECK(!debugMLR.shadowEnabled);
+
+	debugMLR.onPowerStateHooked(true);
+	uint8_t maxLinkRate;
+	CHECK_EQ(readCapabilities(10, maxLinkRate), 4);
+	debugMLR.onPowerStateChange(2);
+	CHECK_EQ(readCapabilities(1, maxLinkRate), 2);
+
+	// If the debug route failed the shadow stays off.
+	size_t syslogs = hostSyslogCount;
+	debugMLR.onPowerStateHooked(false);
+	CHECK_EQ(hostSyslogCount - syslogs, 1);
+	CHECK_EQ(readCapabilities(10, maxLinkRate), 20);
+}
+
+int main() {
+	testTransactionCounts();
+	testPowerStateInvalidation();
+	testFailedReadDrop();
+	testBuiltinOnly();
+	testSinglePowerStateRoute();
+	return HostTest::finish("IGFXDPCDShadowTests");
+}
@@ -0,0 +1,240 @@
+//
+//  IGFXHDMIDividersTests.cpp
+//  WhateverGreen host tests
+//
+//  HDMIDividersCalcFix: the narrowed divider search against the original exhaustive loop,
+//  and the cache of recently computed dividers.
+//
+
+#include "HostTest.hpp"
+#include "IGFXSupport.hpp"
+
+/**
+ *  Layout of the CRTC parameter fields written by ComputeHdmiP0P1P2
+ */
+struct CRTCParams {
+	uint8_t uninvestigated[32] {};
+	uint32_t pdiv {};
+	uint32_t qdiv {};
+	uint32_t kdiv {};
+	uint32_t fraction {};
+	uint32_t multiplier {};
+	uint32_t cf15625 {};
+
+	bool operator==(const CRTCParams &other) const {
+		return pdiv == other.pdiv && qdiv == other.qdiv && kdiv == other.kdiv &&
+			fraction == other.fraction && multiplier == other.multiplier && cf15625 == other.cf15625;
+	}
+};
+
+static_assert(sizeof(CRTCParams) == 56, "Invalid size of CRTCParams struct");
+
+/**
+ *  The divider search as it was before the search window, kept as the reference
+ */
+static void referenceComputeHdmiP0P1P2(uint32_t pixelClock, CRTCParams *params) {
+	static constexpr uint32_t dividers[] = {
+		4,  6,  8, 10, 12, 14, 16, 18, 20,
+		24, 28, 30, 32, 36, 40, 42, 44, 48,
+		52, 54, 56, 60, 64, 66, 68, 70, 72,
+		76, 78, 80, 84, 88, 90, 92, 96, 98,
+		3, 5, 7, 9, 15, 21, 35
+	};
+	static constexpr uint64_t centralFrequencies[] = {8400000000ULL, 9000000000ULL, 9600000000ULL};
+
+	uint64_t afeClock = static_cast<uint64_t>(pixelClock) * 5;
+	uint64_t minDeviation = UINT64_MAX, bestCentral = 0, bestFrequency = 0;
+	uint32_t bestDivider = 0;
+
+	for (auto divider : dividers) {
+		for (auto central : centralFrequencies) {
+			uint64_t frequency = divider * afeClock;
+			uint64_t deviation = (frequency > central ? frequency - central : central - frequency) * 10000 / central;
+			if (frequency >= central && deviation >= 100)
+				continue;
+			if (frequency < central && deviation >= 600)
+				continue;
+			if (deviation >= minDeviation)
+				continue;
+			minDeviation = deviation;
+			bestCentral = central;
+			bestFrequency = frequency;
+			bestDivider = divider;
+			if (deviation == 0 && divider % 2 == 0)
+				break;
+		}
+	}
+
+	if (bestDivider == 0)
+		return;
+
+	uint32_t p = bestDivider, p0 = 0, p1 = 0, p2 = 0;
+	if (p % 2 == 0) {
+		uint32_t half = p / 2;
+		if (half == 1 || half == 2 || half == 3 || half == 5) {
+			p0 = 2; p1 = 1; p2 = half;
+		} else if (half % 2 == 0) {
+			p0 = 2; p1 = half / 2; p2 = 2;
+		} else if (half % 3 == 0) {
+			p0 = 3; p1 = half / 3; p2 = 2;
+		} else if (half % 7 == 0) {
+			p0 = 7; p1 = half / 7; p2 = 2;
+		}
+	} else if (p == 3 || p == 9) {
+		p0 = 3; p1 = 1; p2 = p / 3;
+	} else if (p == 5 || p == 7) {
+		p0 = p; p1 = 1; p2 = 1;
+	} else if (p == 15) {
+		p0 = 3; p1 = 1; p2 = 5;
+	} else if (p == 21) {
+		p0 = 7; p1 = 1; p2 = 3;
+	} else if (p == 35) {
+		p0 = 7; p1 = 1; p2 = 5;
+	}
+
+	uint32_t multiplier = static_cast<uint32_t>(bestFrequency / 24000000);
+	params->pdiv = p0;
+	params->qdiv = p1;
+	params->kdiv = p2;
+	params->multiplier = multiplier;
+	params->fraction = static_cast<uint32_t>(bestFrequency - multiplier * 24000000);
+	params->cf15625 = static_cast<uint32_t>(bestCentral / 15625);
+}
+
+static constexpr uint32_t sweepStart = 25000000;
+static constexpr uint32_t sweepEnd = 600000000;
+static constexpr uint32_t sweepStep = 1000;
+static constexpr size_t sweepCount = (sweepEnd - sweepStart) / sweepStep + 1;
+
+static void testSweep() {
+	auto igfx = IGFXSupport::reset();
+	auto &module = IGFXSupport::construct(igfx->modHDMIDividersCalcFix);
+
+	size_t mismatches = 0, unsolved = 0;
+	for (uint32_t pixelClock = sweepStart; pixelClock <= sweepEnd; pixelClock += sweepStep) {
+		CRTCParams expected, actual;
+		referenceComputeHdmiP0P1P2(pixelClock, &expected);
+		IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, pixelClock, nullptr, &actual);
+		if (!(expected == actual)) {
+			if (mismatches++ < 10)
+				fprintf(stderr, "pixel clock %u Hz: expected P0/P1/P2 %u/%u/%u got %u/%u/%u\n", pixelClock,
+						expected.pdiv, expected.qdiv, expected.kdiv, actual.pdiv, actual.qdiv, actual.kdiv);
+		}
+		if (expected.pdiv == 0)
+			unsolved++;
+	}
+
+	CHECK_EQ(mismatches, 0);
+	// Every sampled clock is a miss, the sweep never repeats a pixel clock
+	CHECK_EQ(module.cacheMisses, sweepCount);
+	CHECK_EQ(module.cacheHits, 0);
+	printf("HDMI dividers: %zu pixel clocks compared, %zu without a valid divider\n", sweepCount, unsolved);
+
+	// A known HDMI 2.0 4K@60 clock that Apple's implementation could not solve
+	CRTCParams uhd;
+	IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, 533250000, nullptr, &uhd);
+	CHECK(uhd.pdiv != 0);
+}
+
+static void benchmarkSweep() {
+	auto igfx = IGFXSupport::reset();
+	IGFXSupport::construct(igfx->modHDMIDividersCalcFix);
+
+	CRTCParams params;
+	auto reference = HostTest::measure(sweepCount, [&](size_t i) {
+		referenceComputeHdmiP0P1P2(sweepStart + static_cast<uint32_t>(i) * sweepStep, &params);
+	});
+	auto narrowed = HostTest::measure(sweepCount, [&](size_t i) {
+		IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, sweepStart + static_cast<uint32_t>(i) * sweepStep, nullptr, &params);
+	});
+	printf("HDMI dividers: exhaustive %.1f ns, narrowed %.1f ns per pixel clock (%.1fx)\n", reference, narrowed, reference / narrowed);
+}
+
+static bool isCached(IGFX::HDMIDividersCalcFix &module, uint32_t pixelClock) {
+	// Peeking must not change the eviction order
+	uint32_t lastUse[IGFX::HDMIDividersCalcFix::DividersCacheSize];
+	for (size_t i = 0; i < arrsize(lastUse); i++)
+		lastUse[i] = module.dividersCache[i].lastUse;
+	auto clock = module.cacheClock;
+
+	IGFX::HDMIDividersCalcFix::CachedDividers entry;
+	bool cached = module.lookupDividers(pixelClock, entry);
+
+	for (size_t i = 0; i < arrsize(lastUse); i++)
+		module.dividersCache[i].lastUse = lastUse[i];
+	module.cacheClock = clock;
+	return cached;
+}
+
+static void testEviction() {
+	auto igfx = IGFXSupport::reset();
+	auto &module = IGFXSupport::construct(igfx->modHDMIDividersCalcFix);
+	constexpr auto size = IGFX::HDMIDividersCalcFix::DividersCacheSize;
+
+	// Fill every entry, then use the first clock again so that the second one becomes the oldest
+	CRTCParams params;
+	for (uint32_t i = 0; i < size; i++)
+		IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, 148500000 + i * 1000, nullptr, &params);
+	for (uint32_t i = 0; i < size; i++)
+		CHECK(isCached(module, 148500000 + i * 1000));
+	IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, 148500000, nullptr, &params);
+	CHECK_EQ(module.cacheHits, 1);
+
+	// One more clock evicts the least recently used entry only
+	IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, 297000000, nullptr, &params);
+	CHECK(isCached(module, 297000000));
+	CHECK(isCached(module, 148500000));
+	CHECK(!isCached(module, 148501000));
+	for (uint32_t i = 2; i < size; i++)
+		CHECK(isCached(module, 148500000 + i * 1000));
+
+	// Clocks without a valid divider and a zero clock are never cached
+	IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, 0, nullptr, &params);
+	CHECK(!isCached(module, 0));
+	CHECK_EQ(module.cacheMisses, size + 2);
+
+	// A hit returns exactly what the miss computed
+	CRTCParams computed, cached;
+	IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, 297000000, nullptr, &cached);
+	referenceComputeHdmiP0P1P2(297000000, &computed);
+	CHECK(cached == computed);
+	CHECK_EQ(module.cacheHits, 2);
+}
+
+static void testStatistics() {
+	auto igfx = IGFXSupport::reset();
+	auto &module = IGFXSupport::construct(igfx->modHDMIDividersCalcFix);
+	KernelPatcher patcher;
+	IORegistryEntry igpu;
+	DeviceInfo info {};
+	info.videoBuiltin = &igpu;
+	hostBootArguments = "-igfxhdmidivs";
+	module.processKernel(patcher, &info);
+	hostBootArguments = "";
+	CHECK(module.enabled);
+
+	auto stats = OSDynamicCast(OSDictionary, igpu.getProperty("fw-hdmi-dividers-cache"));
+	if (!CHECK(stats != nullptr))
+		return;
+	auto hits = OSDynamicCast(OSNumber, stats->getObject("Hits"));
+	auto misses = OSDynamicCast(OSNumber, stats->getObject("Misses"));
+	if (!CHECK(hits != nullptr && misses != nullptr))
+		return;
+
+	// Hits are published as they happen, not only with the next miss
+	CRTCParams params;
+	IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, 148500000, nullptr, &params);
+	for (int i = 0; i < 5; i++)
+		IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(nullptr, 148500000, nullptr, &params);
+	CHECK_EQ(misses->unsigned32BitValue(), 1);
+	CHECK_EQ(hits->unsigned32BitValue(), 5);
+	CHECK(igpu.getProperty("fw-hdmi-dividers-cache") == stats);
+}
+
+int main() {
+	testSweep();
+	testEviction();
+	testStatistics();
+	benchmarkSweep();
+	return HostTest::finish("IGFXHDMIDividersTests");
+}
@@ -0,0 +1,242 @@
+//
+//  IGFXI2COverAUXTests.cpp
+//  WhateverGreen host tests
+//
+//  Advanced I2C-over-AUX transfers against a scripted I2C slave: returned and written data,
+//  transaction counts, verbose logging around every AUX transaction and the achieved throughput.
+//
+
+#include "HostTest.hpp"
+#include "IGFXSupport.hpp"
+#include <string>
+#include <vector>
+
+static const char *readI2COverAUX = "__ZN31AppleIntelFramebufferController14ReadI2COverAUXEP21AppleIntelFramebufferP21AppleIntelDisplayPathjtPhbh";
+static const char *writeI2COverAUX = "__ZN31AppleIntelFramebufferController15WriteI2COverAUXEP21AppleIntelFramebufferP21AppleIntelDisplayPathjtPhb";
+
+static constexpr uint32_t EDIDAddress = 0x50;
+
+/**
+ *  Scripted I2C slave behind the AUX channel, such as the EDID EEPROM of a display
+ */
+struct Slave {
+	uint8_t memory[256] {};
+	uint8_t pointer {};
+	bool open {};
+	bool started {};
+	size_t transactions {};
+	size_t stops {};
+	size_t wireBytes {};
+	size_t failAt {SIZE_MAX};
+};
+
+static Slave slave;
+
+/**
+ *  Every log line and AUX transaction in the order they happen, the latter as "AUX"
+ */
+static std::vector<std::string> events;
+static bool recordEvents;
+
+static void recordLine(const char *line) {
+	if (recordEvents)
+		events.push_back(line);
+}
+
+/**
+ *  Account a transaction, failing it if the script says so
+ */
+static bool transact(uint32_t address, size_t requestBytes, size_t replyBytes, bool intermediate) {
+	if (recordEvents)
+		events.push_back("AUX");
+	slave.wireBytes += requestBytes + replyBytes;
+	bool fail = address != EDIDAddress || slave.transactions == slave.failAt;
+	slave.transactions++;
+	slave.stops += !intermediate;
+	slave.open = intermediate && !fail;
+	return !fail;
+}
+
+static IOReturn orgReadI2COverAUX(void *, IORegistryEntry *, void *, uint32_t address, uint16_t length, uint8_t *buffer, bool intermediate, uint8_t) {
+	if (!transact(address, 3, 1 + length, intermediate))
+		return kIOReturnError;
+	slave.started = false;
+	for (uint16_t i = 0; i < length; i++)
+		buffer[i] = slave.memory[slave.pointer++];
+	return kIOReturnSuccess;
+}
+
+static IOReturn orgWriteI2COverAUX(void *, IORegistryEntry *, void *, uint32_t address, uint16_t length, uint8_t *buffer, bool intermediate) {
+	if (!transact(address, 4 + length, 1, intermediate))
+		return kIOReturnError;
+	// An empty write starts the transaction, the first byte written after it sets the pointer
+	for (uint16_t i = 0; i < length; i++) {
+		if (slave.started)
+			slave.pointer = buffer[i];
+		else
+			slave.memory[slave.pointer++] = buffer[i];
+		slave.started = false;
+	}
+	if (length == 0)
+		slave.started = intermediate;
+	return kIOReturnSuccess;
+}
+
+static IORegistryEntry *framebuffer;
+
+static IGFX::AdvancedI2COverAUXSupport &setup(bool verbose) {
+	auto igfx = IGFXSupport::reset();
+	auto &i2c = IGFXSupport::construct(igfx->modAdvancedI2COverAUXSupport);
+	if (framebuffer == nullptr)
+		framebuffer = IGFXSupport::createFramebuffer(2);
+
+	KernelPatcher patcher;
+	DeviceInfo info {};
+	hostBootArguments = verbose ? "-igfxi2cdbg" : "";
+	i2c.processKernel(patcher, &info);
+	hostBootArguments = "";
+	patcher.provide(readI2COverAUX, orgReadI2COverAUX);
+	patcher.provide(writeI2COverAUX, orgWriteI2COverAUX);
+	i2c.processFramebufferKext(patcher, 1, 0, 0);
+
+	slave = Slave {};
+	for (size_t i = 0; i < sizeof(slave.memory); i++)
+		slave.memory[i] = static_cast<uint8_t>(i * 7 + 1);
+	events.clear();
+	return i2c;
+}
+
+static IOReturn read(uint32_t address, uint32_t offset, uint16_t length, uint8_t *buffer) {
+	return IGFX::AdvancedI2COverAUXSupport::advReadI2COverAUX(nullptr, framebuffer, nullptr, address, offset, length, buffer, 0);
+}
+
+static void testTransfers() {
+	auto &i2c = setup(false);
+	CHECK(!i2c.enabled);
+	CHECK(!i2c.verbose);
+
+	// Seek, one transaction per 16 bytes and the final stop, from any offset.
+	// Middle-of-Transaction stays set until the stop, so the slave keeps streaming.
+	static const uint16_t lengths[] {1, 15, 16, 17, 128, 255, 256};
+	size_t mismatches = 0;
+	for (auto length : lengths) {
+		for (uint32_t offset : {0, 1, 0x80, 0xFF}) {
+			setup(false);
+			uint8_t buffer[256] {};
+			CHECK_EQ(read(EDIDAddress, offset, length, buffer), kIOReturnSuccess);
+			CHECK_EQ(slave.transactions, 2 + (length + 15) / 16 + 1);
+			CHECK_EQ(slave.stops, 1);
+			CHECK(!slave.open);
+			for (uint16_t i = 0; i < length; i++)
+				mismatches += buffer[i] != slave.memory[(offset + i) & 0xFF];
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+
+	// Writes land at the offset and leave the rest alone.
+	setup(false);
+	uint8_t data[40], expected[256];
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = static_cast<uint8_t>(0xA0 + i);
+	memcpy(expected, slave.memory, sizeof(expected));
+	memcpy(expected + 0x30, data, sizeof(data));
+	CHECK_EQ(IGFX::AdvancedI2COverAUXSupport::advWriteI2COverAUX(nullptr, framebuffer, nullptr, EDIDAddress, 0x30, sizeof(data), data, 0), kIOReturnSuccess);
+	CHECK_EQ(slave.transactions, 2 + 3 + 1);
+	CHECK_EQ(slave.stops, 1);
+	CHECK(!slave.open);
+	CHECK(memcmp(slave.memory, expected, sizeof(expected)) == 0);
+
+	// Invalid requests never reach the channel.
+	uint8_t buffer[16];
+	CHECK_EQ(read(EDIDAddress, 0, 0, buffer), kIOReturnInvalid);
+	CHECK_EQ(read(EDIDAddress, 0, 16, nullptr), kIOReturnInvalid);
+	CHECK_EQ(slave.transactions, 6);
+}
+
+static void testVerboseLogging() {
+	auto &i2c = setup(true);
+	CHECK(i2c.enabled);
+	CHECK(i2c.verbose);
+
+	// Each request is logged right before its transaction, successful ones log nothing else.
+	recordEvents = true;
+	uint8_t edid[256];
+	CHECK_EQ(read(EDIDAddress, 0, sizeof(edid), edid), kIOReturnSuccess);
+	CHECK_EQ(slave.transactions, 19);
+	CHECK_EQ(events.size(), 2 * slave.transactions);
+	size_t misplaced = 0;
+	for (size_t i = 0; i + 1 < events.size(); i += 2)
+		misplaced += events[i] == "AUX" || events[i + 1] != "AUX";
+	CHECK_EQ(misplaced, 0);
+	CHECK_EQ(events[0], "igfx: I2C: WriteI2COverAUX() FB2: Addr = 0x50; Len = 00; MOT = 1; Flags = 0.");
+	CHECK_EQ(events[4], "igfx: I2C:  ReadI2COverAUX() FB2: Addr = 0x50; Len = 16; MOT = 1; Flags = 0.");
+	CHECK_EQ(events[36], "igfx: I2C:  ReadI2COverAUX() FB2: Addr = 0x50; Len = 00; MOT = 0; Flags = 0.");
+
+	// A failed chunk adds its result after the transaction, then the stop is logged and sent.
+	setup(true);
+	slave.failAt = 5;
+	CHECK_EQ(read(EDIDAddress, 0, sizeof(edid), edid), kIOReturnError);
+	CHECK_EQ(slave.transactions, 7);
+	CHECK(!slave.open);
+	char failed[64];
+	if (CHECK_EQ(events.size(), 2 * 7 + 1)) {
+		CHECK_EQ(events[10], "igfx: I2C:  ReadI2COverAUX() FB2: Addr = 0x50; Len = 16; MOT = 1; Flags = 0.");
+		CHECK_EQ(events[11], "AUX");
+		snprintf(failed, sizeof(failed), "igfx: I2C:  ReadI2COverAUX() FB2: Failed with 0x%x.", kIOReturnError);
+		CHECK_EQ(events[12], failed);
+		CHECK_EQ(events[13], "igfx: I2C:  ReadI2COverAUX() FB2: Addr = 0x50; Len = 00; MOT = 0; Flags = 0.");
+		CHECK_EQ(events[14], "AUX");
+	}
+
+	// Nor is a failed start followed by more transactions, only by the errors of the seek and the read.
+	setup(true);
+	size_t syslogs = hostSyslogCount;
+	CHECK(read(0x37, 0, sizeof(edid), edid) != kIOReturnSuccess);
+	CHECK_EQ(slave.transactions, 1);
+	CHECK_EQ(hostSyslogCount - syslogs, 2);
+	if (CHECK_EQ(events.size(), 3 + 2)) {
+		CHECK_EQ(events[0], "igfx: I2C: WriteI2COverAUX() FB2: Addr = 0x37; Len = 00; MOT = 1; Flags = 0.");
+		CHECK_EQ(events[1], "AUX");
+		snprintf(failed, sizeof(failed), "igfx: I2C: WriteI2COverAUX() FB2: Failed with 0x%x.", kIOReturnError);
+		CHECK_EQ(events[2], failed);
+	}
+	recordEvents = false;
+}
+
+/**
+ *  AUX wire time of a transaction, in microseconds: 1 Mbit/s Manchester coded bytes, a sync
+ *  pattern on both the request and the reply and the turnaround in between
+ */
+static double wireMicroseconds(size_t bytes, size_t transactions) {
+	return bytes * 8.0 + transactions * (2 * 20.0 + 10.0);
+}
+
+static void benchmarkThroughput() {
+	// Bytes per second of EDID reads, the host time spent in the transfer code added to the modelled wire time.
+	const size_t iterations = 20000;
+	for (bool verbose : {false, true}) {
+		setup(verbose);
+		recordEvents = verbose;
+		uint8_t edid[256];
+		size_t failures = 0;
+		double host = HostTest::measure(iterations, [&](size_t) {
+			events.clear();
+			failures += read(EDIDAddress, 0, sizeof(edid), edid) != kIOReturnSuccess || memcmp(edid, slave.memory, sizeof(edid)) != 0;
+		});
+		recordEvents = false;
+		CHECK_EQ(failures, 0);
+
+		double wire = wireMicroseconds(slave.wireBytes, slave.transactions) / iterations;
+		double total = wire + host / 1000;
+		printf("%s: %lu AUX transactions per 256-byte EDID, host %.2f us, wire %.1f us, %.1f KB/s\n",
+			verbose ? "verbose" : "quiet", slave.transactions / iterations, host / 1000, wire, sizeof(edid) / total * 1e6 / 1024);
+	}
+}
+
+int main() {
+	hostLogSink = recordLine;
+	testTransfers();
+	testVerboseLogging();
+	benchmarkThroughput();
+	return HostTest::finish("IGFXI2COverAUXTests");
+}
@@ -0,0 +1,412 @@
+//
+//  IGFXPlatformTests.cpp
+//  WhateverGreen host tests
+//
+//  gPlatformInformationList edits: the compiled plan against the sequential flow it replaced,
+//  on synthetic platform lists with the frame layout of each generation.
+//
+
+#include "HostTest.hpp"
+#include "IGFXSupport.hpp"
+#include <vector>
+
+static constexpr uint32_t UnknownFramebufferId = 0x12345678;
+
+/**
+ *  IGFX::sandyPlatformId, the IGFX under test lives in zeroed storage without its initialisers
+ */
+static constexpr uint32_t sandyPlatformId[IGFX::SandyPlatformNum] {
+	0x00010000, 0x00020000, 0x00030010, 0x00030030, 0x00040000, 0xFFFFFFFF, 0xFFFFFFFF, 0x00030020, 0x00050000
+};
+
+/**
+ *  Deterministic filler, small values keep frame ids and patch anchors rare in the data
+ */
+struct Random {
+	uint32_t state;
+
+	uint32_t next() {
+		state = state * 1664525U + 1013904223U;
+		return state >> 16;
+	}
+};
+
+/**
+ *  One generation worth of platform list and device property patches
+ */
+struct Scenario {
+	const char *name;
+	CPUInfo::CpuGeneration generation;
+	bool snb;
+	size_t frameSize;
+	size_t frameNum;
+	size_t idOffset;
+	std::vector<uint8_t> list;
+	std::vector<uint32_t> ids;
+	uint32_t selected;
+
+	struct Patch {
+		uint32_t framebufferId;
+		std::vector<uint8_t> find;
+		std::vector<uint8_t> replace;
+		size_t count;
+	};
+	std::vector<Patch> patches;
+};
+
+static KernelPatcher::KextInfo loadedFramebuffer {"com.apple.driver.AppleIntelFramebuffer", nullptr, 0, {}, false, 1};
+
+/**
+ *  Build a platform list of frameNum frames followed by its terminator
+ *
+ *  @param idOffset  where each frame carries its id, Sandy Bridge frames have none and only match by chance
+ */
+template <typename T>
+static Scenario makeScenario(const char *name, CPUInfo::CpuGeneration generation, size_t frameNum, uint32_t seed, size_t idOffset = 0) {
+	bool snb = generation == CPUInfo::CpuGeneration::SandyBridge;
+	Scenario s {name, generation, snb, sizeof(T), frameNum, idOffset};
+
+	// Patches are clamped to the framebuffer image, keep a second page after the list like the kext has.
+	Random random {seed};
+	s.list.resize(2 * PAGE_SIZE);
+	for (auto &b : s.list)
+		b = random.next() % 7;
+
+	auto frames = reinterpret_cast<T *>(s.list.data());
+	for (size_t i = 0; i < frameNum; i++) {
+		uint32_t id = snb ? sandyPlatformId[i] : 0x3E920000 + static_cast<uint32_t>(i) * 0x10003;
+		*reinterpret_cast<uint32_t *>(reinterpret_cast<uint8_t *>(&frames[i]) + idOffset) = id;
+		for (size_t j = 0; j < arrsize(frames[i].connectors); j++)
+			frames[i].connectors[j].type = (i + j) % 3 == 0 ? ConnectorDP : ConnectorHDMI;
+		s.ids.push_back(id);
+	}
+
+	auto terminator = reinterpret_cast<uint32_t *>(&frames[frameNum]);
+	terminator[0] = snb ? 0 : 0xFFFFFFFF;
+	terminator[1] = snb ? 0x0C0C0C00 : 0;
+
+	s.selected = s.ids[frameNum - 2];
+	size_t selectedOffset = (frameNum - 2) * sizeof(T);
+	size_t otherOffset = sizeof(T);
+
+	auto bytes = [&](size_t offset, size_t size) {
+		return std::vector<uint8_t>(s.list.begin() + offset, s.list.begin() + offset + size);
+	};
+	auto flip = [](std::vector<uint8_t> data, size_t index) {
+		data[index] ^= 0x80;
+		return data;
+	};
+
+	// A chained pair, a batch for another frame, a length mismatch, an unknown framebuffer and
+	// a second batch for the selected frame after the others. The selected frame's patches target
+	// its tail, away from the fields and connectors edited before them. The second patch of the
+	// pair starts two bytes before the first one and only matches once the first one is applied.
+	auto first = bytes(selectedOffset + sizeof(T) - 10, 6);
+	auto chained = bytes(selectedOffset + sizeof(T) - 12, 2);
+	chained.insert(chained.end(), first.begin(), first.begin() + 4);
+	chained[4] ^= 0x80;
+	s.patches.push_back({s.selected, first, flip(first, 2), 1});
+	s.patches.push_back({s.selected, chained, flip(chained, 0), 1});
+	auto other = bytes(otherOffset + 24, 6);
+	s.patches.push_back({s.ids[1], other, flip(other, 0), 2});
+	s.patches.push_back({s.ids[1], bytes(otherOffset + 40, 4), bytes(otherOffset + 40, 5), 1});
+	s.patches.push_back({UnknownFramebufferId, other, flip(other, 1), 1});
+	auto last = bytes(selectedOffset + sizeof(T) - 4, 4);
+	s.patches.push_back({s.selected, last, flip(last, 2), 3});
+	return s;
+}
+
+/**
+ *  Point the IGFX at a copy of the platform list and load the find / replace patches again
+ */
+static void rearm(IGFX *igfx, const Scenario &s, std::vector<uint8_t> &list) {
+	igfx->gPlatformInformationList = list.data();
+	igfx->framebufferStart = list.data();
+	igfx->framebufferSize = list.size();
+	igfx->framebufferIndexBuilt = false;
+	memset(igfx->framebufferIndex, 0, sizeof(igfx->framebufferIndex));
+
+	// Leave a hole in the patch array, loadPatchesFromDevice does so for unset indices.
+	for (size_t i = 0; i < s.patches.size(); i++) {
+		auto &patch = igfx->framebufferPatches[i < 3 ? i : i + 1];
+		patch.framebufferId = s.patches[i].framebufferId;
+		patch.find = OSData::withBytes(s.patches[i].find.data(), static_cast<unsigned>(s.patches[i].find.size()));
+		patch.replace = OSData::withBytes(s.patches[i].replace.data(), static_cast<unsigned>(s.patches[i].replace.size()));
+		patch.count = s.patches[i].count;
+	}
+}
+
+/**
+ *  Set up the IGFX state loadPatchesFromDevice and processKext leave behind
+ */
+static IGFX *prepare(const Scenario &s, std::vector<uint8_t> &list) {
+	auto igfx = IGFXSupport::reset();
+	memcpy(igfx->sandyPlatformId, sandyPlatformId, sizeof(sandyPlatformId));
+
+	BaseDeviceInfo::get().cpuGeneration = s.generation;
+	igfx->currentFramebuffer = &loadedFramebuffer;
+	igfx->gPlatformListIsSNB = s.snb;
+
+	igfx->framebufferPatch.framebufferId = s.selected;
+	igfx->framebufferPatch.fMobile = 1;
+	igfx->framebufferPatch.fPortCount = 3;
+	igfx->framebufferPatch.connectors[0].busId = 5;
+	igfx->framebufferPatch.connectors[1].type = ConnectorHDMI;
+	igfx->framebufferPatchFlags.bits.FPFMobile = 1;
+	igfx->framebufferPatchFlags.bits.FPFPortCount = 1;
+	igfx->connectorPatchFlags[0].bits.CPFBusId = 1;
+	igfx->connectorPatchFlags[1].bits.CPFType = 1;
+
+	rearm(igfx, s, list);
+	return igfx;
+}
+
+static void releasePatches(IGFX *igfx) {
+	for (auto &patch : igfx->framebufferPatches) {
+		OSSafeReleaseNULL(patch.find);
+		OSSafeReleaseNULL(patch.replace);
+	}
+}
+
+/**
+ *  Sequential find / replace as applyPatch did before the single pass, the data is released afterwards
+ */
+static void referencePatch(IGFX *igfx, IGFX::FramebufferPatch &patch, uint8_t *startingAddress) {
+	auto find = static_cast<const uint8_t *>(patch.find->getBytesNoCopy());
+	auto replace = static_cast<const uint8_t *>(patch.replace->getBytesNoCopy());
+	size_t size = patch.find->getLength(), changes = 0;
+	uint8_t *currentAddress = startingAddress;
+	uint8_t *endingAddress = startingAddress + PAGE_SIZE - size;
+	if (endingAddress > igfx->framebufferStart + igfx->framebufferSize)
+		endingAddress = igfx->framebufferStart + igfx->framebufferSize;
+
+	while (currentAddress < endingAddress) {
+		if (memcmp(currentAddress, find, size) == 0) {
+			memcpy(currentAddress, replace, size);
+			if (++changes >= patch.count)
+				break;
+			currentAddress += size;
+		} else {
+			currentAddress++;
+		}
+	}
+
+	patch.find->release();
+	patch.find = nullptr;
+	patch.replace->release();
+	patch.replace = nullptr;
+}
+
+template <typename T>
+static void referenceFields(IGFX *igfx, T &frame) {
+	frame.fMobile = igfx->framebufferPatch.fMobile;
+	frame.fPortCount = igfx->framebufferPatch.fPortCount;
+	frame.connectors[0].busId = igfx->framebufferPatch.connectors[0].busId;
+	frame.connectors[1].type = igfx->framebufferPatch.connectors[1].type;
+}
+
+template <typename T>
+static void referenceDPtoHDMI(T &frame) {
+	for (auto &connector : frame.connectors) {
+		if (connector.type == ConnectorDP)
+			connector.type = ConnectorHDMI;
+	}
+}
+
+/**
+ *  The flow of applyFramebufferPatches and applyHdmiAutopatch: every step scans the list again
+ */
+template <typename T>
+static void referenceFlow(IGFX *igfx, bool patchFramebuffer, bool patchDPtoHDMI) {
+	auto list = static_cast<uint8_t *>(igfx->gPlatformInformationList);
+	auto frames = static_cast<T *>(igfx->gPlatformInformationList);
+	uint32_t framebufferId = igfx->framebufferPatch.framebufferId;
+
+	// Sandy Bridge frames are matched by their position in sandyPlatformId, every match is edited.
+	auto editFrames = [&](auto edit) {
+		if (igfx->gPlatformListIsSNB) {
+			for (size_t i = 0; i < IGFX::SandyPlatformNum; i++) {
+				if (igfx->sandyPlatformId[i] == framebufferId)
+					edit(frames[i]);
+			}
+		} else if (auto frame = reinterpret_cast<T *>(igfx->findFramebufferId(framebufferId, list, PAGE_SIZE))) {
+			edit(*frame);
+		}
+	};
+
+	if (patchDPtoHDMI)
+		editFrames([](T &frame) { referenceDPtoHDMI(frame); });
+	if (!patchFramebuffer)
+		return;
+
+	editFrames([igfx](T &frame) { referenceFields(igfx, frame); });
+
+	uint8_t *platformInformationAddress = igfx->findFramebufferId(framebufferId, list, PAGE_SIZE);
+	if (!platformInformationAddress)
+		return;
+
+	for (auto &patch : igfx->framebufferPatches) {
+		if (!patch.find || !patch.replace)
+			continue;
+		if (patch.framebufferId != framebufferId) {
+			framebufferId = patch.framebufferId;
+			platformInformationAddress = igfx->findFramebufferId(framebufferId, list, PAGE_SIZE);
+		}
+		if (platformInformationAddress && patch.find->getLength() == patch.replace->getLength())
+			referencePatch(igfx, patch, platformInformationAddress);
+	}
+}
+
+template <typename T>
+static void checkGeneration(Scenario &s) {
+	for (int mode = 0; mode < 2; mode++) {
+		bool patchFramebuffer = mode == 0, patchDPtoHDMI = mode == 1;
+
+		auto expected = s.list;
+		auto igfx = prepare(s, expected);
+		referenceFlow<T>(igfx, patchFramebuffer, patchDPtoHDMI);
+		bool released[IGFX::MaxFramebufferPatchCount];
+		for (size_t i = 0; i < IGFX::MaxFramebufferPatchCount; i++)
+			released[i] = igfx->framebufferPatches[i].find == nullptr;
+		releasePatches(igfx);
+
+		auto actual = s.list;
+		igfx = prepare(s, actual);
+		igfx->applyPlatformInformationListPatches(patchFramebuffer, patchDPtoHDMI);
+
+		// Applied patches release their data, skipped ones are left to their owner.
+		for (size_t i = 0; i < IGFX::MaxFramebufferPatchCount; i++)
+			CHECK_EQ(igfx->framebufferPatches[i].find == nullptr, released[i]);
+		releasePatches(igfx);
+
+		if (!CHECK(actual == expected))
+			fprintf(stderr, "%s: %s differs from the sequential flow\n", s.name, patchFramebuffer ? "framebuffer patch" : "hdmi autopatch");
+		CHECK(actual != s.list);
+	}
+
+	// The selected frame got its fields and both batches, the second one overlapping the first.
+	if (s.idOffset != 0 || !s.snb) {
+		auto list = s.list;
+		auto igfx = prepare(s, list);
+		igfx->applyPlatformInformationListPatches(true, false);
+		auto frame = list.data() + (s.frameNum - 2) * sizeof(T);
+		CHECK_EQ(reinterpret_cast<T *>(frame)->fMobile, 1);
+		CHECK_EQ(reinterpret_cast<T *>(frame)->fPortCount, 3);
+		CHECK(memcmp(frame + sizeof(T) - 12, s.patches[1].replace.data(), s.patches[1].replace.size()) == 0);
+		CHECK(memcmp(frame + sizeof(T) - 6, s.patches[0].replace.data() + 4, 2) == 0);
+		CHECK(memcmp(frame + sizeof(T) - 4, s.patches[5].replace.data(), s.patches[5].replace.size()) == 0);
+		if (!s.snb)
+			CHECK(igfx->lookupFramebufferId(s.selected) == frame);
+		CHECK(igfx->lookupFramebufferId(UnknownFramebufferId) == nullptr);
+		releasePatches(igfx);
+	}
+
+	// Timing of a whole application, both flows pay for the same patch setup.
+	const size_t iterations = 20000;
+	auto work = s.list;
+	auto igfx = prepare(s, work);
+	releasePatches(igfx);
+	double sequential = HostTest::measure(iterations, [&](size_t) {
+		memcpy(work.data(), s.list.data(), PAGE_SIZE);
+		rearm(igfx, s, work);
+		referenceFlow<T>(igfx, true, false);
+		releasePatches(igfx);
+	});
+	double planned = HostTest::measure(iterations, [&](size_t) {
+		memcpy(work.data(), s.list.data(), PAGE_SIZE);
+		rearm(igfx, s, work);
+		igfx->applyPlatformInformationListPatches(true, false);
+		releasePatches(igfx);
+	});
+	printf("%s: %lu frames of %lu bytes, sequential %.0f ns, plan %.0f ns\n", s.name, s.frameNum, s.frameSize, sequential, planned);
+}
+
+/**
+ *  Offset of the type of the first connector in a frame
+ */
+template <typename T, typename C>
+static size_t connectorType(C T::*connectors) {
+	T frame {};
+	return reinterpret_cast<uint8_t *>(&(frame.*connectors)[0].type) - reinterpret_cast<uint8_t *>(&frame);
+}
+
+/**
+ *  Frame size and the frame type used for the edits come from the same generation dispatch
+ */
+static void testLayouts() {
+	std::vector<uint8_t> list(2 * PAGE_SIZE);
+	auto igfx = IGFXSupport::reset();
+	igfx->gPlatformInformationList = list.data();
+	KernelPatcher::KextInfo unloadedFramebuffer {};
+	igfx->currentFramebuffer = &loadedFramebuffer;
+	igfx->currentFramebufferOpt = &unloadedFramebuffer;
+
+	struct {
+		CPUInfo::CpuGeneration generation;
+		uint32_t firstFramebufferId;
+		size_t size;
+		size_t typeOffset;
+	} layouts[] {
+		{CPUInfo::CpuGeneration::Westmere, 0, 0, 0},
+		{CPUInfo::CpuGeneration::SandyBridge, 0, sizeof(FramebufferSNB), connectorType(&FramebufferSNB::connectors)},
+		{CPUInfo::CpuGeneration::IvyBridge, 0, sizeof(FramebufferIVB), connectorType(&FramebufferIVB::connectors)},
+		{CPUInfo::CpuGeneration::Haswell, 0, sizeof(FramebufferHSW), connectorType(&FramebufferHSW::connectors)},
+		{CPUInfo::CpuGeneration::Broadwell, 0, sizeof(FramebufferBDW), connectorType(&FramebufferBDW::connectors)},
+		{CPUInfo::CpuGeneration::Skylake, 0, sizeof(FramebufferSKL), connectorType(&FramebufferSKL::connectors)},
+		{CPUInfo::CpuGeneration::KabyLake, 0, sizeof(FramebufferSKL), connectorType(&FramebufferSKL::connectors)},
+		{CPUInfo::CpuGeneration::CoffeeLake, 0x591E0000, sizeof(FramebufferSKL), connectorType(&FramebufferSKL::connectors)},
+		{CPUInfo::CpuGeneration::CoffeeLake, 0x3E9B0007, sizeof(FramebufferCFL), connectorType(&FramebufferCFL::connectors)},
+		{CPUInfo::CpuGeneration::CometLake, 0, sizeof(FramebufferCFL), connectorType(&FramebufferCFL::connectors)},
+		{CPUInfo::CpuGeneration::CannonLake, 0, sizeof(FramebufferCNL), connectorType(&FramebufferCNL::connectors)},
+		{CPUInfo::CpuGeneration::IceLake, 0, sizeof(FramebufferICLLP), connectorType(&FramebufferICLLP::connectors)},
+		{CPUInfo::CpuGeneration::RocketLake, 0, 0, 0},
+	};
+
+	for (auto &layout : layouts) {
+		BaseDeviceInfo::get().cpuGeneration = layout.generation;
+		*reinterpret_cast<uint32_t *>(list.data()) = layout.firstFramebufferId;
+		CHECK_EQ(igfx->platformInformationEntrySize(), layout.size);
+
+		// A DP connector in the first frame becomes HDMI at the offset of that layout.
+		IGFX::FramebufferPlanEntry entry {layout.firstFramebufferId, list.data(), false, true};
+		memset(list.data() + sizeof(uint32_t), 0, list.size() - sizeof(uint32_t));
+		if (layout.size == 0) {
+			CHECK(!igfx->applyPlatformInformationPlan(entry));
+			continue;
+		}
+		if (layout.generation == CPUInfo::CpuGeneration::SandyBridge) {
+			memcpy(igfx->sandyPlatformId, sandyPlatformId, sizeof(sandyPlatformId));
+			entry.framebufferId = sandyPlatformId[0];
+		}
+		*reinterpret_cast<uint32_t *>(list.data() + layout.typeOffset) = ConnectorDP;
+		CHECK(igfx->applyPlatformInformationPlan(entry));
+		CHECK_EQ(*reinterpret_cast<uint32_t *>(list.data() + layout.typeOffset), ConnectorHDMI);
+	}
+
+	// Ice Lake picks the layout of whichever framebuffer kext is loaded.
+	BaseDeviceInfo::get().cpuGeneration = CPUInfo::CpuGeneration::IceLake;
+	igfx->currentFramebuffer = &unloadedFramebuffer;
+	igfx->currentFramebufferOpt = &loadedFramebuffer;
+	CHECK_EQ(igfx->platformInformationEntrySize(), sizeof(FramebufferICLHP));
+	igfx->currentFramebufferOpt = &unloadedFramebuffer;
+	CHECK_EQ(igfx->platformInformationEntrySize(), 0);
+}
+
+int main() {
+	testLayouts();
+
+	// The word scan finds Sandy Bridge ids anywhere, also in the fields the framebuffer patch rewrites.
+	auto snb = makeScenario<FramebufferSNB>("SNB", CPUInfo::CpuGeneration::SandyBridge, IGFX::SandyPlatformNum, 1, offsetof(FramebufferSNB, fBacklightMax));
+	checkGeneration<FramebufferSNB>(snb);
+	auto snbFields = makeScenario<FramebufferSNB>("SNB fields", CPUInfo::CpuGeneration::SandyBridge, IGFX::SandyPlatformNum, 6);
+	checkGeneration<FramebufferSNB>(snbFields);
+	auto ivb = makeScenario<FramebufferIVB>("IVB", CPUInfo::CpuGeneration::IvyBridge, 14, 2);
+	checkGeneration<FramebufferIVB>(ivb);
+	auto hsw = makeScenario<FramebufferHSW>("HSW", CPUInfo::CpuGeneration::Haswell, 29, 3);
+	checkGeneration<FramebufferHSW>(hsw);
+	auto skl = makeScenario<FramebufferSKL>("SKL", CPUInfo::CpuGeneration::Skylake, 22, 4);
+	checkGeneration<FramebufferSKL>(skl);
+	auto icl = makeScenario<FramebufferICLLP>("ICL", CPUInfo::CpuGeneration::IceLake, 14, 5);
+	checkGeneration<FramebufferICLLP>(icl);
+	return HostTest::finish("IGFXPlatformTests");
+}
@@ -0,0 +1,62 @@
+//
+//  IGFXSupport.cpp
+//  WhateverGreen host tests
+//
+//  Definitions normally provided by kern_igfx.cpp, which is not part of the host build.
+//
+
+#include "IGFXSupport.hpp"
+
+alignas(IGFX) static uint8_t igfxStorage[sizeof(IGFX)];
+
+IGFX *IGFX::callbackIGFX;
+
+std::map<uint32_t, uint32_t> &IGFXSupport::registers() {
+	static std::map<uint32_t, uint32_t> file;
+	return file;
+}
+
+static uint32_t readRegister32(void *, uint32_t address) {
+	auto reg = IGFXSupport::registers().find(address);
+	return reg != IGFXSupport::registers().end() ? reg->second : 0;
+}
+
+static void writeRegister32(void *, uint32_t address, uint32_t value) {
+	IGFXSupport::registers()[address] = value;
+}
+
+IGFX *IGFXSupport::reset() {
+	memset(igfxStorage, 0, sizeof(igfxStorage));
+	registers().clear();
+	IGFX::callbackIGFX = reinterpret_cast<IGFX *>(igfxStorage);
+	IGFX::callbackIGFX->modMMIORegistersReadSupport.orgReadRegister32 = readRegister32;
+	IGFX::callbackIGFX->modMMIORegistersWriteSupport.orgWriteRegister32 = writeRegister32;
+	return IGFX::callbackIGFX;
+}
+
+IORegistryEntry *IGFXSupport::createFramebuffer(uint32_t index) {
+	auto framebuffer = new IORegistryEntry;
+	framebuffer->setProperty("IOFBDependentIndex", index, 32);
+	return framebuffer;
+}
+
+bool IGFX::setDictUInt32(OSDictionary *dict, const char *key, UInt32 value) {
+	auto *num = OSNumber::withNumber(value, sizeof(UInt32));
+	if (!num)
+		return false;
+
+	bool success = dict->setObject(key, num);
+	num->release();
+	return success;
+}
+
+bool IGFX::AppleIntelFramebufferExplorer::getIndex(IORegistryEntry *framebuffer, uint32_t &index) {
+	if (framebuffer == nullptr)
+		return false;
+
+	auto idxnum = OSDynamicCast(OSNumber, framebuffer->getProperty("IOFBDependentIndex"));
+	if (idxnum == nullptr)
+		return false;
+	index = idxnum->unsigned32BitValue();
+	return true;
+}
@@ -0,0 +1,44 @@
+//
+//  IGFXSupport.hpp
+//  WhateverGreen host tests
+//
+//  The IGFX instance seen by the submodules under test. Only the tested submodules are
+//  compiled, so IGFX itself is never constructed: it lives in zeroed storage and each
+//  test constructs the submodules it exercises in place.
+//
+
+#ifndef IGFXSupport_hpp
+#define IGFXSupport_hpp
+
+#include "kern_igfx.hpp"
+#include <map>
+#include <new>
+
+namespace IGFXSupport {
+	/**
+	 *  Zero the IGFX storage, point callbackIGFX at it and clear the simulated MMIO registers
+	 *
+	 *  @note The MMIO read and write accessors of the instance are routed to the simulated registers.
+	 */
+	IGFX *reset();
+
+	/**
+	 *  Simulated MMIO register file, unwritten registers read as zero
+	 */
+	std::map<uint32_t, uint32_t> &registers();
+
+	/**
+	 *  Construct a submodule of the current IGFX instance in place
+	 */
+	template <typename T>
+	T &construct(T &submodule) {
+		return *new (&submodule) T();
+	}
+
+	/**
+	 *  Framebuffer registry entry with the given IOFBDependentIndex
+	 */
+	IORegistryEntry *createFramebuffer(uint32_t index);
+}
+
+#endif /* IGFXSupport_hpp */
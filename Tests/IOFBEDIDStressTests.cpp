@@ -0,0 +1,143 @@
+//
+//  IOFBEDIDStressTests.cpp
+//  WhateverGreen host tests
+//
+//  EDID override sets: getDDCBlock readers racing setEDIDOverride, retired sets being freed,
+//  and framebuffers rematching once their override went stale. Built with AddressSanitizer
+//  where available, so a reader touching a freed set fails the test.
+//
+
+#include "IOFBSupport.hpp"
+#include "HostTest.hpp"
+#include <atomic>
+#include <random>
+#include <thread>
+
+static constexpr size_t Readers = 4;
+static constexpr size_t WriterOperations = 20000;
+
+/**
+ *  Whether every block of an EDID has a valid checksum and the extension count matches its length
+ */
+static bool isValidEDID(const std::vector<UInt8> &edid) {
+	if (edid.size() < 128 || edid.size() % 128 || edid.size() / 128 != edid[126] + 1U)
+		return false;
+	for (size_t offset = 0; offset < edid.size(); offset += 128) {
+		UInt8 sum = 0;
+		for (size_t i = 0; i < 128; i++)
+			sum += edid[offset + i];
+		if (sum)
+			return false;
+	}
+	return true;
+}
+
+static void testConcurrentOverrides() {
+	auto iofb = IOFBSupport::reset();
+	size_t baseline = hostAllocations;
+
+	IOFBSupport::Panel panels[Readers];
+	IOFramebuffer *services[Readers];
+	for (size_t i = 0; i < Readers; i++) {
+		panels[i].edid = IOFBSupport::makeEDID(i % 3, static_cast<uint32_t>(100 + i));
+		services[i] = IOFBSupport::createFramebuffer(&panels[i]);
+	}
+
+	std::atomic<bool> stop {false};
+	std::atomic<size_t> reads {0}, overridden {0}, invalid {0};
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < Readers; i++) {
+		threads.emplace_back([&, i] {
+			while (!stop.load(std::memory_order_relaxed)) {
+				auto edid = IOFBSupport::readEDID(services[i]);
+				if (!isValidEDID(edid))
+					invalid++;
+				else if (edid != panels[i].edid)
+					overridden++;
+				reads++;
+			}
+		});
+	}
+
+	// Overrides for the panels being read are mixed with unrelated ones, so sets keep growing and shrinking.
+	std::mt19937 random(14);
+	std::vector<std::vector<UInt8>> unrelated;
+	for (size_t i = 0; i < 64; i++)
+		unrelated.push_back(IOFBSupport::makeEDID(i % 4, static_cast<uint32_t>(1000 + i)));
+	size_t failedWrites = 0;
+	for (size_t operation = 0; operation < WriterOperations; operation++) {
+		auto &org = random() % 2 ? panels[random() % Readers].edid : unrelated[random() % unrelated.size()];
+		UInt32 orgSize = random() % 4 ? 128 : static_cast<UInt32>(org.size());
+		IOReturn result;
+		if (operation % 3 == 0) {
+			result = iofb->setEDIDOverride(org.data(), orgSize, nullptr, 0);
+		} else {
+			auto repl = IOFBSupport::makeEDID(random() % 3, static_cast<uint32_t>(operation));
+			result = iofb->setEDIDOverride(org.data(), orgSize, repl.data(), static_cast<UInt32>(repl.size()));
+		}
+		if (result != kIOReturnSuccess)
+			failedWrites++;
+		if (operation % 1000 == 0)
+			std::this_thread::yield();
+	}
+	stop = true;
+	for (auto &thread : threads)
+		thread.join();
+
+	CHECK_EQ(failedWrites, 0);
+	CHECK_EQ(invalid.load(), 0);
+	CHECK(reads.load() > 0);
+	printf("stress: %zu set/delete operations, %zu EDID reads, %zu overridden\n", WriterOperations, reads.load(), overridden.load());
+
+	// Without readers every replaced set is freed by the next change.
+	CHECK_EQ(iofb->iofbedidReaders, 0);
+	CHECK_EQ(iofb->setEDIDOverride(nullptr, 0, nullptr, 0), kIOReturnSuccess);
+	CHECK(iofb->iofbedidSet == nullptr);
+	CHECK(iofb->iofbedidRetired == nullptr);
+
+	// Clearing the framebuffer settings frees the remaining private override copies and EDID buffers.
+	IOFBSupport::reset();
+	CHECK_EQ(hostAllocations, baseline);
+}
+
+static void testStaleOverride() {
+	auto iofb = IOFBSupport::reset();
+	IOFBSupport::Panel panel;
+	panel.edid = IOFBSupport::makeEDID(1, 200);
+	auto service = IOFBSupport::createFramebuffer(&panel);
+
+	auto repl = IOFBSupport::makeEDID(0, 201);
+	CHECK_EQ(iofb->setEDIDOverride(panel.edid.data(), 128, repl.data(), static_cast<UInt32>(repl.size())), kIOReturnSuccess);
+	CHECK(IOFBSupport::readEDID(service) == repl);
+	CHECK_EQ(panel.reads(), 1);
+
+	// The same generation keeps serving the private copy.
+	CHECK(IOFBSupport::readEDID(service) == repl);
+	CHECK_EQ(panel.reads(), 1);
+
+	// An unrelated change makes the copy stale, the base block is read and matched again.
+	auto other = IOFBSupport::makeEDID(0, 202);
+	CHECK_EQ(iofb->setEDIDOverride(other.data(), 128, other.data(), 128), kIOReturnSuccess);
+	CHECK(IOFBSupport::readEDID(service) == repl);
+	CHECK_EQ(panel.reads(), 2);
+	CHECK(IOFBSupport::readEDID(service) == repl);
+	CHECK_EQ(panel.reads(), 2);
+
+	// A different framebuffer at the same address does not inherit the override.
+	service->entryID++;
+	CHECK(IOFBSupport::readEDID(service) == repl);
+	CHECK_EQ(panel.reads(), 3);
+
+	// Removing the override leaves the panel EDID on the next read.
+	CHECK_EQ(iofb->setEDIDOverride(panel.edid.data(), 128, nullptr, 0), kIOReturnSuccess);
+	CHECK(IOFBSupport::readEDID(service) == panel.edid);
+	CHECK_EQ(panel.reads(), 5);
+	CHECK(IOFB::getIOFBVars(service)->edidOverrideCopy.newEDID == nullptr);
+}
+
+int main() {
+	testConcurrentOverrides();
+	testStaleOverride();
+	IOFBSupport::reset();
+	return HostTest::finish("IOFBEDIDStressTests");
+}
@@ -0,0 +1,210 @@
+//
+//  IOFBEDIDTests.cpp
+//  WhateverGreen host tests
+//
+//  EDID overrides: the hashed matcher against the linear scan it replaced, extension block
+//  reads while matching, and the IOFBEDIDn property published by getDDCBlock.
+//
+
+#include "IOFBSupport.hpp"
+#include "HostTest.hpp"
+#include <random>
+
+/**
+ *  Override registered through setEDIDOverride, in registration order
+ */
+struct ReferenceOverride {
+	std::vector<UInt8> org;
+	std::vector<UInt8> repl;
+};
+
+/**
+ *  Register or replace an override the way setEDIDOverride does
+ */
+static void setReference(std::vector<ReferenceOverride> &reference, const std::vector<UInt8> &org, const std::vector<UInt8> &repl) {
+	for (auto &ov : reference) {
+		if (ov.org == org) {
+			ov.repl = repl;
+			return;
+		}
+	}
+	reference.push_back({org, repl});
+}
+
+/**
+ *  Linear scan used before the overrides were hashed: the first registered override whose EDID is a prefix of the panel EDID
+ */
+static const ReferenceOverride *matchReference(const std::vector<ReferenceOverride> &reference, const std::vector<UInt8> &edid) {
+	for (auto &ov : reference)
+		if (ov.org.size() <= edid.size() && std::equal(ov.org.begin(), ov.org.end(), edid.begin()))
+			return &ov;
+	return nullptr;
+}
+
+static void testMatcher() {
+	auto iofb = IOFBSupport::reset();
+	std::mt19937 random(13);
+	std::vector<ReferenceOverride> reference;
+	std::vector<std::vector<UInt8>> panels;
+
+	for (size_t i = 0; i < 500; i++) {
+		std::vector<UInt8> org;
+		if (i % 50 == 7) {
+			// Short overrides only compare the start of the base block.
+			org = panels[random() % panels.size()];
+			org.resize(64);
+		} else if (i % 50 == 8) {
+			// Registered after the short override above, which has to keep winning.
+			org = IOFBSupport::makeEDID(random() % 4, static_cast<uint32_t>(random()));
+			memcpy(org.data(), panels[i - 1].data(), 64);
+			org[126] = static_cast<UInt8>(org.size() / 128 - 1);
+		} else if (i % 10 == 3 && i > 10) {
+			// Same base block as an earlier override, differing in the last extension byte.
+			org = panels[i - 5];
+			if (org.size() > 128)
+				org.back() ^= 1;
+		} else if (i % 25 == 11) {
+			// Exact duplicate, replaces the earlier replacement EDID.
+			org = reference[random() % reference.size()].org;
+		} else {
+			org = IOFBSupport::makeEDID(random() % 4, static_cast<uint32_t>(random()));
+			// Few distinct bytes make partial matches likely.
+			for (auto &byte : org)
+				byte &= 3;
+			org[126] = static_cast<UInt8>(org.size() / 128 - 1);
+		}
+		panels.push_back(org);
+
+		auto repl = IOFBSupport::makeEDID(random() % 3, static_cast<uint32_t>(i));
+		CHECK_EQ(iofb->setEDIDOverride(org.data(), static_cast<UInt32>(org.size()), repl.data(), static_cast<UInt32>(repl.size())), kIOReturnSuccess);
+		setReference(reference, org, repl);
+	}
+
+	CHECK_EQ(static_cast<size_t>(iofb->iofbedidSet->count), reference.size());
+
+	IOFBSupport::Panel panel;
+	auto service = IOFBSupport::createFramebuffer(&panel);
+	auto iofbVars = IOFB::getIOFBVars(service);
+
+	size_t mismatches = 0;
+	size_t matched = 0;
+	size_t maxReads = 0;
+	for (size_t probe = 0; probe < 2000; probe++) {
+		panel.edid = panels[random() % panels.size()];
+		if (panel.edid.size() < 128) {
+			panel.edid.resize(256);
+			panel.edid[126] = 1;
+		}
+		if (probe % 3 == 0)
+			panel.edid[random() % panel.edid.size()] ^= 2;
+		std::fill(panel.blockReads.begin(), panel.blockReads.end(), 0);
+
+		auto expected = matchReference(reference, panel.edid);
+		auto found = IOFB::matchEDIDOverride(iofb->iofbedidSet, iofbVars, service, 0, 0, 0, panel.edid.data(), 128);
+		bool same = expected == nullptr ? found == nullptr :
+			found != nullptr && found->newSize == expected->repl.size() && !memcmp(found->newEDID, expected->repl.data(), found->newSize);
+		if (!same)
+			mismatches++;
+		if (expected)
+			matched++;
+
+		// Extension blocks are read in order, at most once per probe and never the base block.
+		CHECK_EQ(panel.blockReads[1], 0);
+		for (size_t block = 2; block < panel.blockReads.size(); block++)
+			if (!CHECK(panel.blockReads[block] <= 1))
+				break;
+		maxReads = max(maxReads, panel.reads());
+	}
+
+	CHECK_EQ(mismatches, 0);
+	CHECK(matched > 1000);
+	CHECK(maxReads <= IOFB::EDIDOverrideMaxExtensionBytes / 128);
+	printf("matcher: 2000 probes, %zu matched, %zu mismatches, at most %zu extension reads\n", matched, mismatches, maxReads);
+
+	// Whole reads through getDDCBlock return the replacement EDID of the first match.
+	for (size_t probe = 0; probe < 200; probe++) {
+		IOFBSupport::Panel probePanel;
+		probePanel.edid = panels[random() % panels.size()];
+		if (probePanel.edid.size() < 128) {
+			probePanel.edid.resize(128);
+			probePanel.edid[126] = 0;
+		}
+		auto expected = matchReference(reference, probePanel.edid);
+		auto edid = IOFBSupport::readEDID(IOFBSupport::createFramebuffer(&probePanel));
+		if (!CHECK(edid == (expected ? expected->repl : probePanel.edid)))
+			break;
+	}
+}
+
+static void testDDCBlocks() {
+	auto iofb = IOFBSupport::reset();
+	IOFBSupport::Panel panel;
+	panel.edid = IOFBSupport::makeEDID(2, 1);
+	auto service = IOFBSupport::createFramebuffer(&panel);
+
+	// IOFBEDIDn is only published once every block of the EDID was read.
+	UInt8 block[128];
+	for (UInt32 blockNumber = 1; blockNumber <= 3; blockNumber++) {
+		CHECK(service->getProperty("IOFBEDID0") == nullptr);
+		IOByteCount length = sizeof(block);
+		CHECK_EQ(IOFB::wrapgetDDCBlock(service, 0, blockNumber, 0, 0, block, &length), kIOReturnSuccess);
+		CHECK_EQ(length, 128);
+	}
+	auto published = OSDynamicCast(OSData, service->getProperty("IOFBEDID0"));
+	if (CHECK(published != nullptr))
+		CHECK(published->getLength() == panel.edid.size() && !memcmp(published->getBytesNoCopy(), panel.edid.data(), panel.edid.size()));
+
+	// Rereading an extension block does not publish the EDID again.
+	service->removeProperty("IOFBEDID0");
+	IOByteCount length = sizeof(block);
+	CHECK_EQ(IOFB::wrapgetDDCBlock(service, 0, 2, 0, 0, block, &length), kIOReturnSuccess);
+	CHECK(service->getProperty("IOFBEDID0") == nullptr);
+
+	// A matching override is served without reading the panel past the base block.
+	auto repl = IOFBSupport::makeEDID(1, 2);
+	CHECK_EQ(iofb->setEDIDOverride(panel.edid.data(), 128, repl.data(), static_cast<UInt32>(repl.size())), kIOReturnSuccess);
+	std::fill(panel.blockReads.begin(), panel.blockReads.end(), 0);
+	CHECK(IOFBSupport::readEDID(service) == repl);
+	CHECK_EQ(panel.reads(), 1);
+	published = OSDynamicCast(OSData, service->getProperty("IOFBEDID0"));
+	if (CHECK(published != nullptr))
+		CHECK(published->getLength() == repl.size() && !memcmp(published->getBytesNoCopy(), repl.data(), repl.size()));
+
+	// Changing the overrides rematches on the next base block read.
+	auto newer = IOFBSupport::makeEDID(0, 3);
+	CHECK_EQ(iofb->setEDIDOverride(panel.edid.data(), 128, newer.data(), static_cast<UInt32>(newer.size())), kIOReturnSuccess);
+	CHECK(IOFBSupport::readEDID(service) == newer);
+
+	CHECK_EQ(iofb->setEDIDOverride(nullptr, 0, nullptr, 0), kIOReturnSuccess);
+	CHECK(iofb->iofbedidSet == nullptr);
+	CHECK(IOFBSupport::readEDID(service) == panel.edid);
+
+	// Another connection keeps its own EDID.
+	CHECK(IOFBSupport::readEDID(service, 1) == panel.edid);
+	CHECK(service->getProperty("IOFBEDID1") != nullptr);
+}
+
+static void testOverrideLength() {
+	auto iofb = IOFBSupport::reset();
+	std::vector<UInt8> longest = IOFBSupport::makeEDID(IOFB::EDIDOverrideMaxExtensionBytes / 128, 4);
+	std::vector<UInt8> tooLong = IOFBSupport::makeEDID(IOFB::EDIDOverrideMaxExtensionBytes / 128 + 1, 5);
+	auto repl = IOFBSupport::makeEDID(0, 6);
+
+	CHECK_EQ(iofb->setEDIDOverride(tooLong.data(), static_cast<UInt32>(tooLong.size()), repl.data(), static_cast<UInt32>(repl.size())), kIOReturnBadArgument);
+	CHECK(iofb->iofbedidSet == nullptr);
+	CHECK_EQ(iofb->setEDIDOverride(longest.data(), static_cast<UInt32>(longest.size()), repl.data(), static_cast<UInt32>(repl.size())), kIOReturnSuccess);
+
+	// The longest supported override still matches a panel with that many extension blocks.
+	IOFBSupport::Panel panel;
+	panel.edid = longest;
+	CHECK(IOFBSupport::readEDID(IOFBSupport::createFramebuffer(&panel)) == repl);
+	CHECK_EQ(panel.reads(), longest.size() / 128);
+}
+
+int main() {
+	testMatcher();
+	testDDCBlocks();
+	testOverrideLength();
+	IOFBSupport::reset();
+	return HostTest::finish("IOFBEDIDTests");
+}
@@ -0,0 +1,171 @@
+//
+//  IOFBPointerMapTests.cpp
+//  WhateverGreen host tests
+//
+//  IOFB::PointerMap: lookups across table growth, concurrent readers and the lookup cost
+//  compared with the linear scan it replaced.
+//
+
+#include <Headers/kern_api.hpp>
+#include <Headers/kern_devinfo.hpp>
+#include "kern_iofbdebug.hpp"
+#include "HostTest.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+struct Vars {
+	uintptr_t key;
+};
+
+using VarsMap = IOFB::PointerMap<Vars>;
+
+/**
+ *  Keys spaced like kernel objects, a multiple of 16 bytes apart
+ */
+static uintptr_t keyOf(size_t i) {
+	return 0xffffff8012340000ULL + i * 0x1a0;
+}
+
+static void testInsertAndGrowth() {
+	VarsMap map;
+	CHECK(map.find(keyOf(0)) == nullptr);
+	if (!CHECK(map.init()))
+		return;
+
+	std::vector<Vars *> values;
+	for (size_t i = 0; i < 1000; i++) {
+		auto value = new Vars {keyOf(i)};
+		values.push_back(value);
+		CHECK(map.insert(keyOf(i), value) == value);
+
+		// Earlier keys stay reachable after every growth
+		if ((i & (i + 1)) == 0) {
+			for (size_t j = 0; j <= i; j++)
+				CHECK(map.find(keyOf(j)) == values[j]);
+		}
+	}
+	CHECK(map.find(keyOf(1000)) == nullptr);
+
+	// The first object stored for a key wins
+	Vars duplicate {keyOf(5)};
+	CHECK(map.insert(keyOf(5), &duplicate) == values[5]);
+
+	// Load factor stays at or below one half
+	CHECK(map.table->count == 1000);
+	CHECK(map.table->capacity >= 2000);
+
+	map.deleteValues();
+	map.deinit();
+	CHECK_EQ(hostAllocations, 0);
+}
+
+static void testRetiredTables() {
+	VarsMap map;
+	map.init();
+	Vars values[64];
+	for (size_t i = 0; i < 8; i++) {
+		values[i].key = keyOf(i);
+		map.insert(keyOf(i), &values[i]);
+	}
+
+	// A reader that loaded the table before a growth can finish its probe on it
+	auto old = map.table;
+	auto oldCapacity = old->capacity;
+	for (size_t i = 8; i < 64; i++) {
+		values[i].key = keyOf(i);
+		map.insert(keyOf(i), &values[i]);
+	}
+	CHECK(map.table != old);
+	CHECK_EQ(old->capacity, oldCapacity);
+	for (size_t i = 0; i < 8; i++) {
+		size_t slot = VarsMap::slotOf(keyOf(i), old->capacity);
+		while (old->keys[slot] != keyOf(i) && old->keys[slot] != 0)
+			slot = (slot + 1) & (old->capacity - 1);
+		CHECK(old->values[slot] == &values[i]);
+	}
+
+	map.deinit();
+	CHECK_EQ(hostAllocations, 0);
+}
+
+static void testConcurrentReaders() {
+	VarsMap map;
+	map.init();
+	constexpr size_t count = 4096;
+	static Vars values[count];
+	for (size_t i = 0; i < count; i++)
+		values[i].key = keyOf(i);
+
+	std::atomic<size_t> inserted {0};
+	std::atomic<size_t> wrong {0};
+	std::vector<std::thread> readers;
+	for (size_t r = 0; r < 4; r++) {
+		readers.emplace_back([&, r] {
+			size_t seed = r + 1;
+			while (inserted.load(std::memory_order_acquire) < count) {
+				size_t limit = inserted.load(std::memory_order_acquire);
+				if (limit == 0)
+					continue;
+				seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+				size_t i = (seed >> 33) % limit;
+				// Everything inserted so far must be found, and only with its own value
+				if (map.find(keyOf(i)) != &values[i])
+					wrong++;
+			}
+		});
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		map.insert(keyOf(i), &values[i]);
+		inserted.store(i + 1, std::memory_order_release);
+	}
+	for (auto &reader : readers)
+		reader.join();
+
+	CHECK_EQ(wrong.load(), 0);
+	map.deinit();
+	CHECK_EQ(hostAllocations, 0);
+}
+
+static void benchmarkLookup() {
+	for (size_t framebuffers : {8, 16, 64}) {
+		VarsMap map;
+		map.init();
+		std::vector<Vars> values(framebuffers);
+		for (size_t i = 0; i < framebuffers; i++) {
+			values[i].key = keyOf(i);
+			map.insert(keyOf(i), &values[i]);
+		}
+
+		// The old lookup scanned the array of per-framebuffer objects in order
+		std::vector<Vars *> array;
+		for (auto &value : values)
+			array.push_back(&value);
+
+		constexpr size_t iterations = 10000000;
+		volatile uintptr_t sink = 0;
+		auto linear = HostTest::measure(iterations, [&](size_t i) {
+			uintptr_t key = keyOf((i * 7) % framebuffers);
+			for (auto value : array) {
+				if (value->key == key) {
+					sink = sink + value->key;
+					break;
+				}
+			}
+		});
+		auto hashed = HostTest::measure(iterations, [&](size_t i) {
+			sink = sink + map.find(keyOf((i * 7) % framebuffers))->key;
+		});
+		printf("PointerMap: %zu framebuffers, linear %.1f ns, hashed %.1f ns per lookup\n", framebuffers, linear, hashed);
+		map.deinit();
+	}
+}
+
+int main() {
+	testInsertAndGrowth();
+	testRetiredTables();
+	testConcurrentReaders();
+	benchmarkLookup();
+	return HostTest::finish("IOFBPointerMapTests");
+}
@@ -0,0 +1,142 @@
+//
+//  IOFBSupport.cpp
+//  WhateverGreen host tests
+//
+//  Definitions normally provided by kern_iofbdebug.cpp, which is not part of the host build.
+//
+
+#include "IOFBSupport.hpp"
+#include <cstdarg>
+#include <map>
+#include <mutex>
+
+IOFB *IOFB::callbackIOFB;
+
+static std::mutex panelsLock;
+static std::map<IOFramebuffer *, IOFBSupport::Panel *> panels;
+
+static IOReturn panelGetDDCBlock(IOFramebuffer *service, IOIndex connectIndex, UInt32 blockNumber, IOSelect blockType, IOOptionBits options, UInt8 *data, IOByteCount *length) {
+	IOFBSupport::Panel *panel;
+	{
+		std::lock_guard<std::mutex> guard(panelsLock);
+		panel = panels[service];
+	}
+	if (panel == nullptr || blockNumber < 1 || blockNumber >= panel->blockReads.size())
+		return kIOReturnBadArgument;
+	panel->blockReads[blockNumber]++;
+
+	size_t offset = (blockNumber - 1) * 128;
+	if (offset >= panel->edid.size())
+		return kIOReturnNotFound;
+	size_t copyLength = min<size_t>(length ? *length : 128, panel->edid.size() - offset);
+	memcpy(data, panel->edid.data() + offset, copyLength);
+	if (length)
+		*length = copyLength;
+	return kIOReturnSuccess;
+}
+
+static IOFB::IOFBvtable panelVtable = [] {
+	IOFB::IOFBvtable vtable;
+	vtable.orggetDDCBlock = panelGetDDCBlock;
+	return vtable;
+}();
+
+IOFB::IOFBVars *IOFB::getIOFBVars(IOFramebuffer *service) {
+	IOFBVars *iofbVars = callbackIOFB->iofbvars.find(reinterpret_cast<uintptr_t>(service));
+	if (iofbVars)
+		return iofbVars;
+
+	IOFBVars *created = new IOFBVars;
+	created->fb = service;
+	created->iofbvtable = &panelVtable;
+	created->index = __atomic_fetch_add(&callbackIOFB->iofbvarsCount, 1, __ATOMIC_RELAXED);
+	iofbVars = callbackIOFB->iofbvars.insert(reinterpret_cast<uintptr_t>(service), created);
+	if (iofbVars != created)
+		delete created;
+	return iofbVars;
+}
+
+IOFB *IOFBSupport::reset() {
+	if (auto previous = IOFB::callbackIOFB) {
+		IOLockLock(previous->iofbedidLock);
+		previous->publishEDIDOverrideSet(nullptr);
+		IOLockUnlock(previous->iofbedidLock);
+		IOLockFree(previous->iofbedidLock);
+		previous->iofbvars.deleteValues();
+		previous->iofbvars.deinit();
+		delete previous;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(panelsLock);
+		for (auto &panel : panels)
+			panel.first->release();
+		panels.clear();
+	}
+
+	auto iofb = new IOFB;
+	iofb->iofbvars.init();
+	iofb->iofbedidLock = IOLockAlloc();
+	IOFB::callbackIOFB = iofb;
+	return iofb;
+}
+
+IOFramebuffer *IOFBSupport::createFramebuffer(Panel *panel) {
+	auto service = new IOFramebuffer;
+	std::lock_guard<std::mutex> guard(panelsLock);
+	panels[service] = panel;
+	return service;
+}
+
+std::vector<UInt8> IOFBSupport::readEDID(IOFramebuffer *service, IOIndex connectIndex) {
+	std::vector<UInt8> edid;
+	UInt8 block[128];
+	size_t blocks = 1;
+	for (UInt32 blockNumber = 1; blockNumber <= blocks; blockNumber++) {
+		IOByteCount length = sizeof(block);
+		if (IOFB::wrapgetDDCBlock(service, connectIndex, blockNumber, 0, 0, block, &length) != kIOReturnSuccess)
+			return {};
+		edid.insert(edid.end(), block, block + length);
+		if (blockNumber == 1 && length == 128)
+			blocks += block[126];
+	}
+	return edid;
+}
+
+std::vector<UInt8> IOFBSupport::makeEDID(size_t extensions, uint32_t seed) {
+	std::vector<UInt8> edid((extensions + 1) * 128);
+	for (auto &byte : edid) {
+		seed = seed * 1103515245 + 12345;
+		byte = static_cast<UInt8>(seed >> 16);
+	}
+	edid[126] = static_cast<UInt8>(extensions);
+	for (size_t offset = 0; offset < edid.size(); offset += 128) {
+		UInt8 sum = 0;
+		for (size_t i = 0; i < 127; i++)
+			sum += edid[offset + i];
+		edid[offset + 127] = static_cast<UInt8>(-sum);
+	}
+	return edid;
+}
+
+int bprintf(char *buf, size_t bufSize, const char *format, ...) {
+	va_list va;
+	va_start(va, format);
+	int len = vsnprintf(buf, bufSize, format, va);
+	va_end(va);
+	return len > static_cast<int>(bufSize) ? static_cast<int>(bufSize) : len;
+}
+
+char *HEX(char *buf, size_t bufSize, void *bytes, size_t byteslen) {
+	buf[0] = '\0';
+	for (size_t i = 0; bytes && i < byteslen && (i + 1) * 2 < bufSize; i++)
+		snprintf(buf + i * 2, 3, "%02x", static_cast<UInt8 *>(bytes)[i]);
+	return buf;
+}
+
+char *DumpOneReturn(char *buf, size_t bufSize, IOReturn val) {
+	buf[0] = '\0';
+	if (val != kIOReturnSuccess)
+		bprintf(buf, bufSize, " result:0x%x", val);
+	return buf;
+}
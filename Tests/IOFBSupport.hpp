@@ -0,0 +1,61 @@
+//
+//  IOFBSupport.hpp
+//  WhateverGreen host tests
+//
+//  The IOFB instance seen by the EDID code under test. kern_iofbdebug.cpp is not part of the
+//  host build, so the per-framebuffer bookkeeping is set up here and every framebuffer reads
+//  its DDC blocks from a simulated panel.
+//
+
+#ifndef IOFBSupport_hpp
+#define IOFBSupport_hpp
+
+#include <Headers/kern_api.hpp>
+#include <Headers/kern_devinfo.hpp>
+#include "kern_iofbdebug.hpp"
+#include <vector>
+
+namespace IOFBSupport {
+	/**
+	 *  Display answering DDC block reads
+	 */
+	struct Panel {
+		std::vector<UInt8> edid;
+
+		/**
+		 *  Reads per block number, block numbers start at 1
+		 */
+		std::vector<size_t> blockReads = std::vector<size_t>(256);
+
+		size_t reads() const {
+			size_t total = 0;
+			for (auto count : blockReads)
+				total += count;
+			return total;
+		}
+	};
+
+	/**
+	 *  Replace the IOFB instance with a fresh one, freeing the EDID overrides, framebuffer settings and framebuffers
+	 */
+	IOFB *reset();
+
+	/**
+	 *  Framebuffer reading its DDC blocks from the given panel
+	 */
+	IOFramebuffer *createFramebuffer(Panel *panel);
+
+	/**
+	 *  Read a whole EDID block by block through IOFB::wrapgetDDCBlock
+	 *
+	 *  @return the bytes returned to the caller, empty on a read error
+	 */
+	std::vector<UInt8> readEDID(IOFramebuffer *service, IOIndex connectIndex = 0);
+
+	/**
+	 *  EDID with the given number of extension blocks and pseudo random contents, every block has a valid checksum
+	 */
+	std::vector<UInt8> makeEDID(size_t extensions, uint32_t seed);
+}
+
+#endif /* IOFBSupport_hpp */
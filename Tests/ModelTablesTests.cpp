@@ -0,0 +1,166 @@
+//
+//  ModelTablesTests.cpp
+//  WhateverGreen host tests
+//
+//  Tools/ModelTables: an empty pci.ids reproduces kern_model.cpp byte for byte, and new
+//  subsystems are inserted as single lines without touching the rest of the source.
+//
+//  Usage: ModelTablesTests path/to/modeltables path/to/kern_model.cpp
+//
+
+#include "HostTest.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::string tool;
+static std::string modelSource;
+
+static std::string readFile(const std::string &path) {
+	std::ifstream in(path, std::ios::binary);
+	std::stringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+static void writeFile(const std::string &path, const std::string &contents) {
+	std::ofstream out(path, std::ios::binary);
+	out << contents;
+}
+
+static std::vector<std::string> splitLines(const std::string &contents) {
+	std::vector<std::string> lines;
+	std::stringstream in(contents);
+	std::string line;
+	while (std::getline(in, line))
+		lines.push_back(line);
+	return lines;
+}
+
+/**
+ *  Run the generator and return its output, the report goes to report
+ */
+static std::string runTool(const std::string &ids, const std::string &source, std::string &report) {
+	writeFile("modeltables.ids", ids);
+	std::string command = "\"" + tool + "\" modeltables.ids \"" + source + "\" modeltables.out 2> modeltables.log";
+	if (!CHECK_EQ(std::system(command.c_str()), 0))
+		return {};
+	report = readFile("modeltables.log");
+	return readFile("modeltables.out");
+}
+
+static void testNoop() {
+	std::string report;
+	auto output = runTool("# Version: 2024.01.01\n", modelSource, report);
+	CHECK(output == readFile(modelSource));
+	CHECK(report.find("0 added, 0 renamed, 0 intel candidates") != std::string::npos);
+}
+
+static void testInsertions() {
+	std::string ids =
+		"# Version: 2024.01.01\n"
+		"1002  Advanced Micro Devices, Inc. [AMD/ATI]\n"
+		"\t6640  Saturn XT [FirePro M6100]\n"
+		"\t\t1028 04a4  FirePro M6100 Renamed\n"
+		"\t\t1043 1234  Radeon R9 M999X 2GB\n"
+		"\t6641  Saturn PRO [Radeon HD 8930M]\n"
+		"\t\t103c 0001  Generic Board\n"
+		"\t\t103c 0002  Radeon HD 8930M\n"
+		"\t1234  Not in the tables\n"
+		"\t\t1043 0001  Radeon HD 9999\n"
+		"8086  Intel Corporation\n"
+		"\t0bd1  Broadwell GT2 Graphics\n"
+		"\t9a49  TigerLake-LP GT2 [Iris Xe Graphics]\n"
+		"C 03  Display controller\n"
+		"\t00  VGA compatible controller\n";
+	std::string report;
+	auto output = splitLines(runTool(ids, modelSource, report));
+	auto source = splitLines(readFile(modelSource));
+
+	// Exactly the two new subsystems are inserted, each in subsystem order in front of the default entry.
+	CHECK_EQ(output.size(), source.size() + 2);
+	std::vector<std::string> expected = source;
+	for (size_t i = 0; i < expected.size(); i++) {
+		if (expected[i].find("0x106b, 0x014b, 0x0000, \"AMD Radeon R9 M380\"") != std::string::npos) {
+			expected.insert(expected.begin() + i, "\t{Model::DetectSub, 0x1043, 0x1234, 0x0000, \"AMD Radeon R9 M999X\"},");
+			i++;
+		} else if (expected[i] == "\t{Model::DetectDef, 0x0000, 0x0000, 0x0000, \"AMD Radeon HD 8930M\"}") {
+			expected.insert(expected.begin() + i, "\t{Model::DetectSub, 0x103c, 0x0002, 0x0000, \"AMD Radeon HD 8930M\"},");
+			i++;
+		}
+	}
+	CHECK(output == expected);
+
+	// Renamed curated entries and commented out reserved Intel ids are left alone.
+	CHECK(report.find("renamed 6640 1028:04a4") != std::string::npos);
+	CHECK(report.find("intel   9a49 \"Intel Iris Xe Graphics\"") != std::string::npos);
+	CHECK(report.find("0bd1") == std::string::npos);
+	CHECK(report.find("2 added, 1 renamed, 1 intel candidates") != std::string::npos);
+}
+
+static void testAppend() {
+	// A table made of subsystems only gets the new last entry after a comma.
+	std::string source =
+		"static constexpr Model dev6640[] {\n"
+		"\t{Model::DetectSub, 0x1028, 0x04A4, 0x0000, \"AMD FirePro M6100\"}\n"
+		"};\n"
+		"\n"
+		"static constexpr BuiltinModel devIntel[] {\n"
+		"\t{ 0x0106, 0x0000, \"Intel HD Graphics 2000\" },\n"
+		"};\n";
+	writeFile("modeltables.cpp", source);
+	std::string report;
+	auto output = runTool("1002  AMD\n\t6640  Saturn\n\t\t106b 014b  Radeon R9 M380\n", "modeltables.cpp", report);
+	CHECK(output ==
+		"static constexpr Model dev6640[] {\n"
+		"\t{Model::DetectSub, 0x1028, 0x04A4, 0x0000, \"AMD FirePro M6100\"},\n"
+		"\t{Model::DetectSub, 0x106b, 0x014b, 0x0000, \"AMD Radeon R9 M380\"}\n"
+		"};\n"
+		"\n"
+		"static constexpr BuiltinModel devIntel[] {\n"
+		"\t{ 0x0106, 0x0000, \"Intel HD Graphics 2000\" },\n"
+		"};\n");
+}
+
+static void testLargeDatabase() {
+	// pci.ids is about 1.5 MB, most of it vendors the generator skips.
+	std::string ids = "# Version: 2024.01.01\n";
+	for (unsigned vendor = 0x1000; ids.size() < 2000000; vendor++) {
+		char line[128];
+		snprintf(line, sizeof(line), "%04x  Vendor %u\n", vendor, vendor);
+		ids += line;
+		for (unsigned dev = 0; dev < 16; dev++) {
+			snprintf(line, sizeof(line), "\t%04x  Device %u [Radeon RX %u]\n", 0x6700 + dev * 0x10, dev, dev);
+			ids += line;
+			for (unsigned sub = 0; sub < 8; sub++) {
+				snprintf(line, sizeof(line), "\t\t%04x %04x  Board %u Radeon RX %u 8GB\n", 0x1000 + sub, vendor, sub, dev);
+				ids += line;
+			}
+		}
+	}
+
+	std::string report;
+	auto start = std::chrono::steady_clock::now();
+	auto output = runTool(ids, modelSource, report);
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	CHECK(!output.empty());
+	CHECK(report.find(" 0 added") == std::string::npos);
+	printf("modeltables: %zu KB pci.ids in %.1f ms\n", ids.size() / 1024, ms);
+}
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		fprintf(stderr, "usage: %s modeltables kern_model.cpp\n", argv[0]);
+		return 1;
+	}
+	tool = argv[1];
+	modelSource = argv[2];
+
+	testNoop();
+	testInsertions();
+	testAppend();
+	testLargeDatabase();
+	return HostTest::finish("ModelTablesTests");
+}
@@ -0,0 +1,143 @@
+//
+//  ModelTests.cpp
+//  WhateverGreen host tests
+//
+//  GPU model names: the binary searches in kern_model.cpp against the linear scans they
+//  replaced, over every Intel device id and every Radeon table entry, plus the lookup cost.
+//  kern_model.cpp is included directly so the reference scans can walk its static tables.
+//
+
+#include "../WhateverGreen/kern_model.cpp"
+#include "HostTest.hpp"
+#include <set>
+#include <vector>
+
+/**
+ *  getIntelModel before the sorted copy of devIntel: first entry in source order
+ */
+static const char *linearIntelModel(uint32_t dev, uint32_t &fakeId) {
+	fakeId = 0;
+	for (size_t i = 0; i < arrsize(devIntel); i++) {
+		if (devIntel[i].device == dev) {
+			fakeId = devIntel[i].fake;
+			return devIntel[i].name;
+		}
+	}
+
+	return nullptr;
+}
+
+/**
+ *  getRadeonModel before the binary search of devices
+ */
+static const char *linearRadeonModel(uint16_t dev, uint16_t rev, uint16_t subven, uint16_t sub) {
+	for (auto &device : devices) {
+		if (device.dev == dev) {
+			for (size_t j = 0; j < device.modelNum; j++) {
+				auto &model = device.models[j];
+
+				if (model.mode & Model::DetectSub && (model.subven != subven || model.sub != sub))
+					continue;
+
+				if (model.mode & Model::DetectRev && (model.rev != rev))
+					continue;
+
+				return model.name;
+			}
+			break;
+		}
+	}
+
+	return nullptr;
+}
+
+static void testIntel() {
+	WEG weg;
+	size_t mismatches = 0, named = 0;
+	for (uint32_t dev = 0; dev <= 0xFFFF; dev++) {
+		uint32_t fakeId = 0xFFFFFFFF, linearFakeId = 0xFFFFFFFF;
+		auto name = weg.getIntelModel(dev, fakeId);
+		auto linearName = linearIntelModel(dev, linearFakeId);
+		if (name != linearName || fakeId != linearFakeId)
+			mismatches++;
+		if (name)
+			named++;
+	}
+	CHECK_EQ(mismatches, 0);
+
+	// Every table entry is reachable, duplicates would have been rejected at compile time.
+	size_t found = 0;
+	for (auto &model : devIntel) {
+		uint32_t fakeId;
+		weg.getIntelModel(model.device, fakeId);
+		if (fakeId == model.fake)
+			found++;
+	}
+	CHECK_EQ(found, arrsize(devIntel));
+	printf("intel: 65536 device ids, %zu named, %zu mismatches\n", named, mismatches);
+}
+
+static void testRadeon() {
+	WEG weg;
+	size_t mismatches = 0, lookups = 0;
+
+	// Unknown devices and plain lookups for every device id.
+	for (uint32_t dev = 0; dev <= 0xFFFF; dev++) {
+		lookups++;
+		if (weg.getRadeonModel(dev, 0, 0, 0) != linearRadeonModel(dev, 0, 0, 0))
+			mismatches++;
+	}
+
+	// Every revision against every subsystem of a device, plus subsystems it does not list.
+	for (auto &device : devices) {
+		std::set<std::pair<uint16_t, uint16_t>> subsystems {{0, 0}, {0x1002, 0xFFFF}, {0x106B, 0x0000}};
+		for (size_t j = 0; j < device.modelNum; j++) {
+			auto &model = device.models[j];
+			subsystems.insert({model.subven, model.sub});
+			subsystems.insert({model.subven, static_cast<uint16_t>(model.sub + 1)});
+		}
+		for (uint32_t rev = 0; rev <= 0xFF; rev++) {
+			for (auto &subsystem : subsystems) {
+				lookups++;
+				if (weg.getRadeonModel(device.dev, rev, subsystem.first, subsystem.second) != linearRadeonModel(device.dev, rev, subsystem.first, subsystem.second))
+					mismatches++;
+			}
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+	printf("radeon: %zu lookups, %zu mismatches\n", lookups, mismatches);
+}
+
+static void benchmark() {
+	WEG weg;
+	std::vector<uint16_t> queries;
+	for (size_t i = 0; i < 4096; i++)
+		queries.push_back(devices[(i * 7919) % arrsize(devices)].dev);
+
+	const char *volatile sink;
+	constexpr size_t Iterations = 2000000;
+	double linear = HostTest::measure(Iterations, [&](size_t i) {
+		sink = linearRadeonModel(queries[i % queries.size()], 0, 0x1002, 0);
+	});
+	double search = HostTest::measure(Iterations, [&](size_t i) {
+		sink = weg.getRadeonModel(queries[i % queries.size()], 0, 0x1002, 0);
+	});
+	printf("radeon lookup: linear %.1f ns, binary search %.1f ns\n", linear, search);
+
+	uint32_t fakeId;
+	linear = HostTest::measure(Iterations, [&](size_t i) {
+		sink = linearIntelModel(devIntel[(i * 7919) % arrsize(devIntel)].device, fakeId);
+	});
+	search = HostTest::measure(Iterations, [&](size_t i) {
+		sink = weg.getIntelModel(devIntel[(i * 7919) % arrsize(devIntel)].device, fakeId);
+	});
+	printf("intel lookup: linear %.1f ns, binary search %.1f ns\n", linear, search);
+	(void)sink;
+}
+
+int main() {
+	testIntel();
+	testRadeon();
+	benchmark();
+	return HostTest::finish("ModelTests");
+}
@@ -0,0 +1,180 @@
+//
+//  NGFXTeamIdTests.cpp
+//  WhateverGreen host tests
+//
+//  NGFX::wrapCsfgGetPlatformBinary: team ID matches against strcmp, reads bounded by the team
+//  ID length, the statistics of a mixed call sequence and the compare cost.
+//
+
+#include "kern_ngfx.hpp"
+#include "HostTest.hpp"
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+NGFX *NGFX::callbackNGFX;
+
+/**
+ *  Codesign information of a binary as seen through the csfg accessors
+ */
+struct Fileglob {
+	int platform;
+	const char *teamId;
+};
+
+static size_t teamIdLookups;
+
+static int orgCsfgGetPlatformBinary(void *fg) {
+	return static_cast<Fileglob *>(fg)->platform;
+}
+
+static const char *orgCsfgGetTeamId(void *fg) {
+	teamIdLookups++;
+	return static_cast<Fileglob *>(fg)->teamId;
+}
+
+static NGFX *reset() {
+	static NGFX ngfx;
+	ngfx = NGFX {};
+	ngfx.orgCsfgGetPlatformBinary = reinterpret_cast<mach_vm_address_t>(orgCsfgGetPlatformBinary);
+	ngfx.orgCsfgGetTeamId = orgCsfgGetTeamId;
+	NGFX::callbackNGFX = &ngfx;
+	teamIdLookups = 0;
+	return &ngfx;
+}
+
+/**
+ *  Team IDs of other developers, NVIDIA with one character changed, cut short or extended
+ */
+static std::vector<std::string> makeTeamIds(size_t count, uint32_t seed) {
+	static const char alphabet[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	std::mt19937 random(seed);
+	std::string nvidia = NGFX::NvidiaTeamId;
+
+	std::vector<std::string> teamIds;
+	for (size_t i = 0; i < count; i++) {
+		std::string teamId = nvidia;
+		switch (random() % 5) {
+			case 0:
+				break;
+			case 1:
+				teamId[random() % teamId.size()] = alphabet[random() % (sizeof(alphabet) - 1)];
+				break;
+			case 2:
+				teamId.resize(random() % teamId.size());
+				break;
+			case 3:
+				teamId += alphabet[random() % (sizeof(alphabet) - 1)];
+				break;
+			default:
+				for (auto &c : teamId)
+					c = alphabet[random() % (sizeof(alphabet) - 1)];
+				break;
+		}
+		teamIds.push_back(teamId);
+	}
+	return teamIds;
+}
+
+static void testTeamIds() {
+	static const char *edges[] {
+		"", "6", "6KR3T733E", "6KR3T733EC", "6KR3T733EC0", "6KR3T733ED", "7KR3T733EC", "6kr3t733ec", "6KR3T733EC\n",
+	};
+
+	size_t mismatches = 0;
+	for (auto teamId : edges)
+		mismatches += NGFX::isNvidiaTeamId(teamId) != (strcmp(teamId, NGFX::NvidiaTeamId) == 0);
+	for (auto &teamId : makeTeamIds(20000, 1))
+		mismatches += NGFX::isNvidiaTeamId(teamId.c_str()) != (teamId == NGFX::NvidiaTeamId);
+	CHECK_EQ(mismatches, 0);
+}
+
+static void testBoundedReads() {
+	// Team IDs ending right before an inaccessible page, without a terminator past TeamIdLength + 1 bytes.
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	auto pages = static_cast<char *>(mmap(nullptr, 2 * pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	if (!CHECK(pages != MAP_FAILED) || !CHECK(mprotect(pages + pageSize, pageSize, PROT_NONE) == 0))
+		return;
+
+	auto end = pages + pageSize;
+	memcpy(end - NGFX::TeamIdLength - 1, NGFX::NvidiaTeamId, NGFX::TeamIdLength);
+	end[-1] = 'X';
+	CHECK(!NGFX::isNvidiaTeamId(end - NGFX::TeamIdLength - 1));
+	end[-1] = '\0';
+	CHECK(NGFX::isNvidiaTeamId(end - NGFX::TeamIdLength - 1));
+
+	for (size_t length = 0; length < NGFX::TeamIdLength; length++) {
+		memcpy(end - length - 1, NGFX::NvidiaTeamId, length);
+		end[-1] = '\0';
+		CHECK(!NGFX::isNvidiaTeamId(end - length - 1));
+	}
+
+	munmap(pages, 2 * pageSize);
+}
+
+static void testPlatformBinaryCalls() {
+	auto ngfx = reset();
+	auto teamIds = makeTeamIds(4096, 2);
+	std::mt19937 random(3);
+
+	// Platform binaries, binaries without a team ID and team IDs of every kind.
+	const size_t calls = 100000;
+	size_t mismatches = 0, checks = 0, overrides = 0;
+	for (size_t i = 0; i < calls; i++) {
+		Fileglob fg {random() % 4 == 0, nullptr};
+		if (random() % 8 != 0)
+			fg.teamId = teamIds[random() % teamIds.size()].c_str();
+
+		bool nvidia = fg.teamId && strcmp(fg.teamId, NGFX::NvidiaTeamId) == 0;
+		checks += !fg.platform;
+		overrides += !fg.platform && nvidia;
+
+		int result = NGFX::wrapCsfgGetPlatformBinary(&fg);
+		mismatches += result != (fg.platform || nvidia);
+	}
+
+	CHECK_EQ(mismatches, 0);
+	CHECK(overrides > 0);
+
+	// Platform binaries never get their team ID looked up.
+	CHECK_EQ(teamIdLookups, checks);
+	CHECK_EQ(ngfx->platformBinaryStats.calls, calls);
+	CHECK_EQ(ngfx->platformBinaryStats.teamIdChecks, checks);
+	CHECK_EQ(ngfx->platformBinaryStats.overrides, overrides);
+}
+
+static void benchmarkCompare() {
+	auto teamIds = makeTeamIds(4096, 4);
+	std::vector<const char *> strings;
+	for (auto &teamId : teamIds)
+		strings.push_back(teamId.c_str());
+
+	const size_t iterations = 4000000;
+	size_t matches = 0, referenceMatches = 0;
+	double compare = HostTest::measure(iterations, [&](size_t i) {
+		matches += NGFX::isNvidiaTeamId(strings[i % strings.size()]);
+	});
+	double reference = HostTest::measure(iterations, [&](size_t i) {
+		referenceMatches += strcmp(strings[i % strings.size()], NGFX::NvidiaTeamId) == 0;
+	});
+	CHECK_EQ(matches, referenceMatches);
+
+	Fileglob fg {0, strings[0]};
+	reset();
+	double wrapper = HostTest::measure(iterations, [&](size_t i) {
+		fg.teamId = strings[i % strings.size()];
+		NGFX::wrapCsfgGetPlatformBinary(&fg);
+	});
+
+	printf("team id: isNvidiaTeamId %.1f ns, strcmp %.1f ns, wrapCsfgGetPlatformBinary %.1f ns\n", compare, reference, wrapper);
+}
+
+int main() {
+	testTeamIds();
+	testBoundedReads();
+	testPlatformBinaryCalls();
+	benchmarkCompare();
+	return HostTest::finish("NGFXTeamIdTests");
+}
@@ -0,0 +1,40 @@
+#
+#  CompareGolden.cmake
+#  WhateverGreen host tests
+#
+#  Runs ResourceConverter on Resources/Patches.plist in one mode and compares the generated
+#  kern_resources.cpp/.hpp with the golden copies next to this script.
+#
+#  cmake -DCONVERTER=<ResourceConverter> -DMODE=<no-dedup|default|blob> -DRESOURCES=<Resources>
+#        -DOUTPUT=<scratch directory> -P CompareGolden.cmake
+#
+
+set(GOLDEN ${CMAKE_CURRENT_LIST_DIR}/${MODE})
+set(OUT ${OUTPUT}/${MODE})
+file(REMOVE_RECURSE ${OUT})
+file(MAKE_DIRECTORY ${OUT})
+
+if(MODE STREQUAL "default")
+	set(FLAGS)
+else()
+	set(FLAGS --${MODE})
+endif()
+
+execute_process(
+	COMMAND ${CONVERTER} ${FLAGS} ${RESOURCES} ${OUT}/kern_resources.cpp ${OUT}/kern_resources.hpp
+	RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "ResourceConverter ${FLAGS} failed: ${result}")
+endif()
+
+foreach(name kern_resources.cpp kern_resources.hpp)
+	execute_process(
+		COMMAND ${CMAKE_COMMAND} -E compare_files ${GOLDEN}/${name} ${OUT}/${name}
+		RESULT_VARIABLE result
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "${OUT}/${name} differs from ${GOLDEN}/${name}, "
+			"copy it over if Patches.plist or the converter changed on purpose")
+	endif()
+endforeach()
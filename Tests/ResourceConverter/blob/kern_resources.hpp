@@ -0,0 +1,40 @@
+//                                                   
+//  kern_resources.hpp                               
+//  WhateverGreen                                    
+//                                                   
+//  Copyright © 2018 vit9696. All rights reserved.   
+//                                                   
+//  This is an autogenerated file!                   
+//  Please avoid any modifications!                  
+//                                                   
+
+#include <Headers/kern_user.hpp>                     
+#include <stdint.h>                                  
+
+extern UserPatcher::BinaryModInfo ADDPR(binaryMod)[];
+extern const size_t ADDPR(binaryModSize);            
+
+extern UserPatcher::ProcInfo ADDPR(procInfoModern)[];
+extern const size_t ADDPR(procInfoModernSize);       
+
+extern UserPatcher::ProcInfo ADDPR(procInfoLegacy)[];
+extern const size_t ADDPR(procInfoLegacySize);       
+
+
+// Section list
+
+enum : uint32_t {
+	SectionUnused = 0,
+	SectionNDRMI = 1,
+	SectionEXTSLOTS = 2,
+	SectionFCPUID = 3,
+	SectionLEGACYHWDRMID = 4,
+	SectionLEGACYSWDRMID = 5,
+	SectionOFFLINE = 6,
+	SectionBGRA = 7,
+	SectionCOMPATRENDERER = 8,
+	SectionBOARDID = 9,
+	SectionHWDRMID = 10,
+	SectionWHITELIST = 11,
+	SectionNSTREAM = 12,
+};
@@ -0,0 +1,26 @@
+//
+//  kern_api.hpp
+//  WhateverGreen host tests
+//
+
+#ifndef kern_api_hpp
+#define kern_api_hpp
+
+#include <Headers/kern_patcher.hpp>
+
+class LiluAPI {
+public:
+	enum RunningMode {
+		RunningNormal = 1,
+		RunningInstallerRecovery = 2,
+		RunningSafeMode = 4,
+	};
+
+	uint32_t getRunMode() const {
+		return RunningNormal;
+	}
+};
+
+extern LiluAPI lilu;
+
+#endif /* kern_api_hpp */
@@ -0,0 +1,33 @@
+//
+//  kern_cpu.hpp
+//  WhateverGreen host tests
+//
+
+#ifndef kern_cpu_hpp
+#define kern_cpu_hpp
+
+#include <Headers/kern_util.hpp>
+
+namespace CPUInfo {
+	enum class CpuGeneration {
+		Unknown,
+		Penryn,
+		Nehalem,
+		Westmere,
+		SandyBridge,
+		IvyBridge,
+		Haswell,
+		Broadwell,
+		Skylake,
+		KabyLake,
+		CoffeeLake,
+		CannonLake,
+		IceLake,
+		CometLake,
+		RocketLake,
+		AlderLake,
+		MaxGeneration
+	};
+}
+
+#endif /* kern_cpu_hpp */
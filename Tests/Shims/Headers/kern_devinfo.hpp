@@ -0,0 +1,30 @@
+//
+//  kern_devinfo.hpp
+//  WhateverGreen host tests
+//
+
+#ifndef kern_devinfo_hpp
+#define kern_devinfo_hpp
+
+#include <Headers/kern_cpu.hpp>
+#include <Headers/kern_iokit.hpp>
+#include <IOKit/IOService.h>
+
+class DeviceInfo {
+public:
+	IORegistryEntry *videoBuiltin {nullptr};
+	uint32_t reportedFramebufferId {0};
+};
+
+class BaseDeviceInfo {
+public:
+	CPUInfo::CpuGeneration cpuGeneration {CPUInfo::CpuGeneration::Unknown};
+	char modelIdentifier[48] {};
+
+	static BaseDeviceInfo &get() {
+		static BaseDeviceInfo info;
+		return info;
+	}
+};
+
+#endif /* kern_devinfo_hpp */
@@ -0,0 +1,38 @@
+//
+//  kern_disasm.hpp
+//  WhateverGreen host tests
+//
+
+#ifndef kern_disasm_hpp
+#define kern_disasm_hpp
+
+#include <Headers/kern_util.hpp>
+
+struct hde64s {
+	uint8_t len, p_rep, p_lock, p_seg, p_66, p_67, rex, rex_w, rex_r, rex_x, rex_b;
+	uint8_t opcode, opcode2, modrm, modrm_mod, modrm_reg, modrm_rm, sib, sib_scale, sib_index, sib_base;
+	union {
+		uint8_t imm8;
+		uint16_t imm16;
+		uint32_t imm32;
+		uint64_t imm64;
+	} imm;
+	union {
+		uint8_t disp8;
+		uint16_t disp16;
+		uint32_t disp32;
+	} disp;
+	uint32_t flags;
+};
+
+class Disassembler {
+public:
+	using hde_t = hde64s;
+
+	static size_t hdeDisasm(mach_vm_address_t, hde_t *handle) {
+		handle->flags = 1;
+		return 0;
+	}
+};
+
+#endif /* kern_disasm_hpp */
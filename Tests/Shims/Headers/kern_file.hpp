@@ -0,0 +1,11 @@
+//
+//  kern_file.hpp
+//  WhateverGreen host tests
+//
+
+#ifndef kern_file_hpp
+#define kern_file_hpp
+
+#include <Headers/kern_user.hpp>
+
+#endif /* kern_file_hpp */
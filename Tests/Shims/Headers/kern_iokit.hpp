@@ -0,0 +1,39 @@
+//
+//  kern_iokit.hpp
+//  WhateverGreen host tests
+//
+
+#ifndef kern_iokit_hpp
+#define kern_iokit_hpp
+
+#include <Headers/kern_util.hpp>
+#include <IOKit/IOService.h>
+
+namespace WIOKit {
+	template <typename T, typename AS>
+	inline bool getOSDataValue(const OSObject *obj, const char *name, AS &value) {
+		auto data = OSDynamicCast(OSData, obj);
+		if (data != nullptr && data->getLength() == sizeof(T)) {
+			value = *static_cast<const T *>(data->getBytesNoCopy());
+			return true;
+		}
+		return false;
+	}
+
+	template <typename T>
+	inline bool getOSDataValue(const OSObject *obj, const char *name, T &value) {
+		return getOSDataValue<T, T>(obj, name, value);
+	}
+
+	template <typename T, typename AS>
+	inline bool getOSDataValue(const IORegistryEntry *sect, const char *name, AS &value) {
+		return getOSDataValue<T, AS>(sect->getProperty(name), name, value);
+	}
+
+	template <typename T>
+	inline bool getOSDataValue(const IORegistryEntry *sect, const char *name, T &value) {
+		return getOSDataValue<T, T>(sect->getProperty(name), name, value);
+	}
+}
+
+#endif /* kern_iokit_hpp */
@@ -0,0 +1,25 @@
+//
+//  kern_mach.hpp
+//  WhateverGreen host tests
+//
+
+#ifndef kern_mach_hpp
+#define kern_mach_hpp
+
+#include <Headers/kern_util.hpp>
+
+class MachInfo {
+public:
+	/**
+	 *  Number of times kernel writing was enabled, tests use it to count page writes
+	 */
+	static size_t writeEnables;
+
+	static kern_return_t setKernelWriting(bool enable, void *lock) {
+		if (enable)
+			writeEnables++;
+		return KERN_SUCCESS;
+	}
+};
+
+#endif /* kern_mach_hpp */
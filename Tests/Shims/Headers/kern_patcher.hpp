@@ -0,0 +1,161 @@
+//
+//  kern_patcher.hpp
+//  WhateverGreen host tests
+//
+//  Host shim of the Lilu kernel patcher. Routing resolves symbols from a table filled by the test
+//  and records every route, so tests can call the wrappers and check what was routed.
+//
+
+#ifndef kern_patcher_hpp
+#define kern_patcher_hpp
+
+#include <Headers/kern_util.hpp>
+#include <Headers/kern_mach.hpp>
+#include <Headers/kern_disasm.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+class KernelPatcher {
+public:
+	enum class Error {
+		NoError,
+		NoSymbolFound,
+		AlreadyDone,
+	};
+
+	static constexpr size_t KernelID = 0;
+
+	struct KextInfo {
+		static constexpr size_t Unloaded {0};
+		const char *id;
+		const char **paths;
+		size_t pathNum;
+		bool sys[4];
+		bool user;
+		size_t loadIndex;
+	};
+
+	struct LookupPatch {
+		KextInfo *kext;
+		const uint8_t *find;
+		const uint8_t *replace;
+		size_t size;
+		size_t count;
+		const uint8_t *maskFind {nullptr};
+		const uint8_t *maskReplace {nullptr};
+	};
+
+	struct RouteRequest {
+		const char *symbol {nullptr};
+		mach_vm_address_t to {0};
+		mach_vm_address_t *org {nullptr};
+
+		template <typename T>
+		RouteRequest(const char *s, T t) : symbol(s), to(reinterpret_cast<mach_vm_address_t>(t)) {}
+
+		template <typename T, typename O>
+		RouteRequest(const char *s, T t, O &o) : symbol(s), to(reinterpret_cast<mach_vm_address_t>(t)), org(reinterpret_cast<mach_vm_address_t *>(&o)) {}
+	};
+
+	struct SolveRequest {
+		const char *symbol {nullptr};
+		mach_vm_address_t *address {nullptr};
+
+		template <typename T>
+		SolveRequest(const char *s, T &addr) : symbol(s), address(reinterpret_cast<mach_vm_address_t *>(&addr)) {}
+	};
+
+	/**
+	 *  Symbols resolvable by the shim, mapped to the original implementations provided by the test
+	 */
+	std::map<std::string, mach_vm_address_t> symbols;
+
+	/**
+	 *  Every successful route, mapped to its wrapper
+	 */
+	std::multimap<std::string, mach_vm_address_t> routes;
+
+	template <typename T>
+	void provide(const char *symbol, T original) {
+		symbols[symbol] = reinterpret_cast<mach_vm_address_t>(original);
+	}
+
+	size_t routeCount(const char *symbol) const {
+		return routes.count(symbol);
+	}
+
+	bool routeMultiple(size_t id, RouteRequest *requests, size_t num, mach_vm_address_t start = 0, size_t size = 0, bool kernelRoute = true, bool force = false) {
+		bool result = true;
+		for (size_t i = 0; i < num; i++) {
+			auto symbol = symbols.find(requests[i].symbol);
+			if (symbol == symbols.end()) {
+				error = Error::NoSymbolFound;
+				result = false;
+				if (!force)
+					return false;
+				continue;
+			}
+			if (requests[i].org != nullptr)
+				*requests[i].org = symbol->second;
+			routes.emplace(requests[i].symbol, requests[i].to);
+		}
+		return result;
+	}
+
+	template <size_t N>
+	bool routeMultiple(size_t id, RouteRequest (&requests)[N], mach_vm_address_t start = 0, size_t size = 0, bool kernelRoute = true, bool force = false) {
+		return routeMultiple(id, requests, N, start, size, kernelRoute, force);
+	}
+
+	bool routeMultipleLong(size_t id, RouteRequest *requests, size_t num, mach_vm_address_t start = 0, size_t size = 0, bool kernelRoute = true, bool force = false) {
+		return routeMultiple(id, requests, num, start, size, kernelRoute, force);
+	}
+
+	template <size_t N>
+	bool routeMultipleLong(size_t id, RouteRequest (&requests)[N], mach_vm_address_t start = 0, size_t size = 0, bool kernelRoute = true, bool force = false) {
+		return routeMultiple(id, requests, N, start, size, kernelRoute, force);
+	}
+
+	bool solveMultiple(size_t id, SolveRequest *requests, size_t num, mach_vm_address_t start = 0, size_t size = 0, bool crash = false, bool force = false) {
+		for (size_t i = 0; i < num; i++) {
+			auto symbol = symbols.find(requests[i].symbol);
+			if (symbol == symbols.end()) {
+				error = Error::NoSymbolFound;
+				if (!force)
+					return false;
+				continue;
+			}
+			*requests[i].address = symbol->second;
+		}
+		return error == Error::NoError;
+	}
+
+	template <size_t N>
+	bool solveMultiple(size_t id, SolveRequest (&requests)[N], mach_vm_address_t start = 0, size_t size = 0, bool crash = false, bool force = false) {
+		return solveMultiple(id, requests, N, start, size, crash, force);
+	}
+
+	mach_vm_address_t solveSymbol(size_t id, const char *symbol) {
+		auto it = symbols.find(symbol);
+		if (it != symbols.end())
+			return it->second;
+		error = Error::NoSymbolFound;
+		return 0;
+	}
+
+	Error getError() const {
+		return error;
+	}
+
+	void clearError() {
+		error = Error::NoError;
+	}
+
+	static void *kernelWriteLock;
+
+private:
+	Error error {Error::NoError};
+};
+
+#endif /* kern_patcher_hpp */
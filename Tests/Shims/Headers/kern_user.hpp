@@ -0,0 +1,47 @@
+//
+//  kern_user.hpp
+//  WhateverGreen host tests
+//
+
+#ifndef kern_user_hpp
+#define kern_user_hpp
+
+#include <Headers/kern_patcher.hpp>
+
+/**
+ *  Files are identified by their vnode and its id like in the kernel
+ */
+struct vnode {
+	uint32_t vid;
+	const char *path;
+};
+
+typedef struct vnode *vnode_t;
+
+inline uint32_t vnode_vid(vnode_t vp) {
+	return vp->vid;
+}
+
+/**
+ *  Number of vn_getpath calls, tests use it to count path resolutions
+ */
+extern size_t hostGetPathCount;
+
+inline int vn_getpath(vnode_t vp, char *pathbuf, int *len) {
+	hostGetPathCount++;
+	if (vp->path == nullptr || static_cast<int>(strlen(vp->path)) >= *len)
+		return 1;
+	strcpy(pathbuf, vp->path);
+	*len = static_cast<int>(strlen(vp->path)) + 1;
+	return 0;
+}
+
+class UserPatcher {
+public:
+	static bool matchSharedCachePath(const char *path) {
+		return strncmp(path, "/System/Library/dyld/dyld_shared_cache_", strlen("/System/Library/dyld/dyld_shared_cache_")) == 0 ||
+			strncmp(path, "/private/var/db/dyld/dyld_shared_cache_", strlen("/private/var/db/dyld/dyld_shared_cache_")) == 0;
+	}
+};
+
+#endif /* kern_user_hpp */
@@ -0,0 +1,188 @@
+//
+//  kern_util.hpp
+//  WhateverGreen host tests
+//
+//  Host shim of the Lilu utility header, only what the tested sources use.
+//
+
+#ifndef kern_util_hpp
+#define kern_util_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mach/mach_types.h>
+
+#define DBGLOG(module, str, ...) do { if (ADDPR(debugEnabled) || hostLogSink) hostLog(module, str, ## __VA_ARGS__); } while (0)
+#define SYSLOG(module, str, ...) do { hostSyslogCount++; if (ADDPR(debugEnabled) || hostLogSink) hostLog(module, str, ## __VA_ARGS__); } while (0)
+#define DBGLOG_COND(cond, module, str, ...) do { if (cond) DBGLOG(module, str, ## __VA_ARGS__); } while (0)
+#define SYSLOG_COND(cond, module, str, ...) do { if (cond) SYSLOG(module, str, ## __VA_ARGS__); } while (0)
+#define PANIC(module, str, ...) do { fprintf(stderr, "%s: PANIC: " str "\n", module, ## __VA_ARGS__); abort(); } while (0)
+#define PANIC_COND(cond, module, str, ...) do { if (cond) PANIC(module, str, ## __VA_ARGS__); } while (0)
+
+#ifndef __printflike
+#define __printflike(fmtarg, firstvararg) __attribute__((format(printf, fmtarg, firstvararg)))
+#endif
+
+#define ADDPR(x) lilu_##x
+#define EXPORT
+#define NONNULL
+#define PACKED __attribute__((packed))
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+/**
+ *  Enables DBGLOG output, off by default to keep test logs readable
+ */
+extern bool ADDPR(debugEnabled);
+
+/**
+ *  Number of SYSLOG messages, which are printed together with DBGLOG only
+ */
+extern size_t hostSyslogCount;
+
+/**
+ *  Receives every DBGLOG and SYSLOG line when set, whether or not they are printed
+ */
+extern void (*hostLogSink)(const char *line);
+
+/**
+ *  Print a log line if DBGLOG output is enabled and pass it to hostLogSink
+ */
+void hostLog(const char *module, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+template <typename T, size_t N>
+constexpr size_t arrsize(const T (&)[N]) {
+	return N;
+}
+
+template <typename T>
+constexpr T min(T a, T b) {
+	return a < b ? a : b;
+}
+
+template <typename T>
+constexpr T max(T a, T b) {
+	return a > b ? a : b;
+}
+
+template <typename T, typename Y>
+struct ppair {
+	T first;
+	Y second;
+};
+
+template <typename T>
+inline T FunctionCast(T, uintptr_t org) {
+	return reinterpret_cast<T>(org);
+}
+
+inline void *lilu_os_memcpy(void *dst, const void *src, size_t len) {
+	return memcpy(dst, src, len);
+}
+
+inline void *lilu_os_memset(void *dst, int c, size_t len) {
+	return memset(dst, c, len);
+}
+
+inline char *lilu_os_strncpy(char *dst, const char *src, size_t len) {
+	return strncpy(dst, src, len);
+}
+
+inline size_t lilu_os_strlen(const char *s) {
+	return strlen(s);
+}
+
+/**
+ *  Number of live kern_os_malloc allocations
+ */
+extern size_t hostAllocations;
+
+inline void *kern_os_malloc(size_t size) {
+	auto memory = malloc(size);
+	if (memory != nullptr)
+		__atomic_fetch_add(&hostAllocations, 1, __ATOMIC_RELAXED);
+	return memory;
+}
+
+inline void kern_os_free(void *addr) {
+	if (addr != nullptr)
+		__atomic_fetch_sub(&hostAllocations, 1, __ATOMIC_RELAXED);
+	free(addr);
+}
+
+/**
+ *  Boot arguments seen by checkKernelArgument, set by the tests
+ */
+extern const char *hostBootArguments;
+
+inline bool checkKernelArgument(const char *name) {
+	return hostBootArguments != nullptr && strstr(hostBootArguments, name) != nullptr;
+}
+
+enum KernelVersion {
+	SnowLeopard   = 10,
+	Lion          = 11,
+	MountainLion  = 12,
+	Mavericks     = 13,
+	Yosemite      = 14,
+	ElCapitan     = 15,
+	Sierra        = 16,
+	HighSierra    = 17,
+	Mojave        = 18,
+	Catalina      = 19,
+	BigSur        = 20,
+	Monterey      = 21,
+	Ventura       = 22,
+};
+
+/**
+ *  Kernel version reported by getKernelVersion, set by the tests
+ */
+extern KernelVersion hostKernelVersion;
+
+inline KernelVersion getKernelVersion() {
+	return hostKernelVersion;
+}
+
+template <typename T>
+inline T &getMember(void *that, size_t off) {
+	return *reinterpret_cast<T *>(static_cast<uint8_t *>(that) + off);
+}
+
+template <typename T>
+class Value {
+	const T &value;
+	explicit Value(const T &value) : value(value) {}
+
+public:
+	static Value<T> of(const T &value) {
+		return Value<T>(value);
+	}
+
+	template <typename... Ts>
+	bool isOneOf(const Ts &...others) const {
+		return ((value == others) || ...);
+	}
+
+	template <typename... Ts>
+	bool isNotOneOf(const Ts &...others) const {
+		return !isOneOf(others...);
+	}
+};
+
+namespace Buffer {
+	template <typename T>
+	inline T *create(size_t size) {
+		return static_cast<T *>(calloc(size, sizeof(T)));
+	}
+
+	template <typename T>
+	inline void deleter(T *ptr) {
+		free(ptr);
+	}
+}
+
+#endif /* kern_util_hpp */
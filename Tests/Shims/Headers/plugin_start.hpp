@@ -0,0 +1,11 @@
+//
+//  plugin_start.hpp
+//  WhateverGreen host tests
+//
+
+#ifndef plugin_start_hpp
+#define plugin_start_hpp
+
+#include <Headers/kern_api.hpp>
+
+#endif /* plugin_start_hpp */
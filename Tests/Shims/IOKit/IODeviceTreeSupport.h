@@ -0,0 +1,13 @@
+//
+//  IODeviceTreeSupport.h
+//  WhateverGreen host tests
+//
+
+#ifndef shim_IODeviceTreeSupport_h
+#define shim_IODeviceTreeSupport_h
+
+#include <IOKit/IOService.h>
+
+extern const char *gIODTPlane;
+
+#endif /* shim_IODeviceTreeSupport_h */
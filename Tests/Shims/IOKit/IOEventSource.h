@@ -0,0 +1,45 @@
+//
+//  IOEventSource.h
+//  WhateverGreen host tests
+//
+
+#ifndef shim_IOEventSource_h
+#define shim_IOEventSource_h
+
+#include <IOKit/IOService.h>
+
+class IOEventSource : public OSObject {
+protected:
+	OSObject *owner {nullptr};
+
+	virtual bool checkForWork() {
+		return false;
+	}
+
+public:
+	virtual bool init(OSObject *newOwner) {
+		owner = newOwner;
+		return true;
+	}
+
+	void signalWorkAvailable() {
+		while (checkForWork());
+	}
+};
+
+class IOWorkLoop : public OSObject {
+public:
+	static IOWorkLoop *workLoop() {
+		return new IOWorkLoop;
+	}
+
+	IOReturn addEventSource(IOEventSource *) {
+		return kIOReturnSuccess;
+	}
+
+	IOReturn removeEventSource(IOEventSource *) {
+		return kIOReturnSuccess;
+	}
+};
+
+#endif /* shim_IOEventSource_h */
@@ -0,0 +1,29 @@
+//
+//  IOLocks.h
+//  WhateverGreen host tests
+//
+
+#ifndef shim_IOLocks_h
+#define shim_IOLocks_h
+
+#include <mutex>
+
+typedef std::mutex IOLock;
+
+inline IOLock *IOLockAlloc() {
+	return new IOLock;
+}
+
+inline void IOLockFree(IOLock *lock) {
+	delete lock;
+}
+
+inline void IOLockLock(IOLock *lock) {
+	lock->lock();
+}
+
+inline void IOLockUnlock(IOLock *lock) {
+	lock->unlock();
+}
+
+#endif /* shim_IOLocks_h */
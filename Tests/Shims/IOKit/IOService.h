@@ -0,0 +1,232 @@
+//
+//  IOService.h
+//  WhateverGreen host tests
+//
+//  Host shim of the libkern/IOKit object model used by the tested sources.
+//  Objects are reference counted and properties live in a plain map.
+//
+
+#ifndef shim_IOService_h
+#define shim_IOService_h
+
+#include <mach/mach_types.h>
+#include <map>
+#include <string>
+
+#define kIOReturnSuccess      0
+#define kIOReturnError        ((IOReturn)0xe00002bc)
+#define kIOReturnNoMemory     ((IOReturn)0xe00002bd)
+#define kIOReturnBadArgument  ((IOReturn)0xe00002c2)
+#define kIOReturnUnsupported  ((IOReturn)0xe00002c7)
+#define kIOReturnInvalid      ((IOReturn)0xe00002c9)
+#define kIOReturnNotReady     ((IOReturn)0xe00002d8)
+#define kIOReturnTimeout      ((IOReturn)0xe00002d6)
+#define kIOReturnNotFound     ((IOReturn)0xe00002f0)
+
+#define OSDeclareDefaultStructors(className) public: className() = default; private:
+#define OSDefineMetaClassAndStructors(className, superName)
+#define OSDynamicCast(type, inst) dynamic_cast<type *>(const_cast<OSObject *>(static_cast<const OSObject *>(inst)))
+#define OSSafeReleaseNULL(inst) do { if (inst) (inst)->release(); (inst) = nullptr; } while (0)
+
+class OSObject {
+	mutable int refs {1};
+
+public:
+	virtual ~OSObject() = default;
+
+	void retain() const {
+		refs++;
+	}
+
+	void release() const {
+		if (--refs == 0)
+			delete this;
+	}
+
+	int getRetainCount() const {
+		return refs;
+	}
+
+	virtual bool init() {
+		return true;
+	}
+
+	virtual void free() {}
+};
+
+class OSNumber : public OSObject {
+	unsigned long long value {0};
+	unsigned int bits {0};
+
+public:
+	static OSNumber *withNumber(unsigned long long value, unsigned int numberOfBits) {
+		auto number = new OSNumber;
+		number->value = value;
+		number->bits = numberOfBits;
+		return number;
+	}
+
+	void setValue(unsigned long long newValue) {
+		value = newValue;
+	}
+
+	uint32_t unsigned32BitValue() const {
+		return static_cast<uint32_t>(value);
+	}
+
+	uint64_t unsigned64BitValue() const {
+		return value;
+	}
+
+	unsigned int numberOfBits() const {
+		return bits;
+	}
+};
+
+class OSData : public OSObject {
+	std::string bytes;
+
+public:
+	static OSData *withBytes(const void *data, unsigned int length) {
+		auto object = new OSData;
+		object->bytes.assign(static_cast<const char *>(data), length);
+		return object;
+	}
+
+	const void *getBytesNoCopy() const {
+		return bytes.data();
+	}
+
+	unsigned int getLength() const {
+		return static_cast<unsigned int>(bytes.size());
+	}
+};
+
+class OSString : public OSObject {
+	std::string string;
+
+public:
+	static OSString *withCString(const char *cString) {
+		auto object = new OSString;
+		object->string = cString;
+		return object;
+	}
+
+	const char *getCStringNoCopy() const {
+		return string.c_str();
+	}
+};
+
+/**
+ *  Holds a reference to each stored value like the kernel class
+ */
+class OSDictionary : public OSObject {
+	std::map<std::string, OSObject *> objects;
+
+public:
+	~OSDictionary() override {
+		for (auto &object : objects)
+			object.second->release();
+	}
+
+	static OSDictionary *withCapacity(unsigned int) {
+		return new OSDictionary;
+	}
+
+	bool setObject(const char *key, const OSObject *object) {
+		if (object == nullptr)
+			return false;
+		object->retain();
+		auto &slot = objects[key];
+		if (slot != nullptr)
+			slot->release();
+		slot = const_cast<OSObject *>(object);
+		return true;
+	}
+
+	void removeObject(const char *key) {
+		auto it = objects.find(key);
+		if (it != objects.end()) {
+			it->second->release();
+			objects.erase(it);
+		}
+	}
+
+	OSObject *getObject(const char *key) const {
+		auto it = objects.find(key);
+		return it != objects.end() ? it->second : nullptr;
+	}
+
+	unsigned int getCount() const {
+		return static_cast<unsigned int>(objects.size());
+	}
+};
+
+class IORegistryEntry : public OSObject {
+	OSDictionary properties;
+	uint64_t entryID {0};
+	const char *name {"IORegistryEntry"};
+
+public:
+	IORegistryEntry() {
+		static uint64_t lastEntryID;
+		entryID = ++lastEntryID;
+	}
+
+	OSObject *getProperty(const char *key) const {
+		return properties.getObject(key);
+	}
+
+	bool setProperty(const char *key, OSObject *object) {
+		return properties.setObject(key, object);
+	}
+
+	bool setProperty(const char *key, const void *bytes, unsigned int length) {
+		auto data = OSData::withBytes(bytes, length);
+		bool result = properties.setObject(key, data);
+		data->release();
+		return result;
+	}
+
+	bool setProperty(const char *key, unsigned long long value, unsigned int numberOfBits) {
+		auto number = OSNumber::withNumber(value, numberOfBits);
+		bool result = properties.setObject(key, number);
+		number->release();
+		return result;
+	}
+
+	void removeProperty(const char *key) {
+		properties.removeObject(key);
+	}
+
+	/**
+	 *  Device tree root set by the tests, the only entry found by fromPath
+	 */
+	static IORegistryEntry *deviceTreeRoot;
+
+	/**
+	 *  Device tree lookups other than the root always fail on the host
+	 */
+	static IORegistryEntry *fromPath(const char *path, const char *plane = nullptr) {
+		if (deviceTreeRoot == nullptr || plane == nullptr || strcmp(path, "/") != 0)
+			return nullptr;
+		deviceTreeRoot->retain();
+		return deviceTreeRoot;
+	}
+
+	uint64_t getRegistryEntryID() const {
+		return entryID;
+	}
+
+	void setName(const char *newName) {
+		name = newName;
+	}
+
+	const char *getName() const {
+		return name;
+	}
+};
+
+class IOService : public IORegistryEntry {};
+
+#endif /* shim_IOService_h */
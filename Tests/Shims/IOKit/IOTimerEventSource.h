@@ -0,0 +1,43 @@
+//
+//  IOTimerEventSource.h
+//  WhateverGreen host tests
+//
+
+#ifndef shim_IOTimerEventSource_h
+#define shim_IOTimerEventSource_h
+
+#include <IOKit/IOEventSource.h>
+
+class IOTimerEventSource : public IOEventSource {
+public:
+	typedef void (*Action)(OSObject *owner, IOTimerEventSource *sender);
+
+	static IOTimerEventSource *timerEventSource(OSObject *owner, Action action) {
+		auto timer = new IOTimerEventSource;
+		timer->init(owner);
+		timer->action = action;
+		return timer;
+	}
+
+	IOReturn setTimeoutMS(uint32_t) {
+		return kIOReturnSuccess;
+	}
+
+	IOReturn setTimeoutUS(uint32_t) {
+		return kIOReturnSuccess;
+	}
+
+	void cancelTimeout() {}
+
+	/**
+	 *  Run the timer action now, the tests drive time themselves
+	 */
+	void fire() {
+		action(owner, this);
+	}
+
+private:
+	Action action {nullptr};
+};
+
+#endif /* shim_IOTimerEventSource_h */
@@ -0,0 +1,54 @@
+//
+//  IOUserClient.h
+//  WhateverGreen host tests
+//
+//  Host shim of the IOKit and IOGraphics types named by the IOFB declarations. Most are
+//  opaque, as the tested IOFB code only passes them through.
+//
+
+#ifndef shim_IOUserClient_h
+#define shim_IOUserClient_h
+
+#include <IOKit/IOService.h>
+#include <IOKit/IOLocks.h>
+#include <IOKit/graphics/IOGraphicsTypes.h>
+
+#ifndef __deprecated
+#define __deprecated __attribute__((deprecated))
+#endif
+
+typedef uint8_t UInt8;
+typedef uint16_t UInt16;
+typedef int16_t SInt16;
+typedef int32_t SInt32;
+typedef int64_t SInt64;
+typedef SInt32 IOIndex;
+typedef UInt32 IOSelect;
+typedef UInt32 IOItemCount;
+typedef uint64_t IOByteCount;
+typedef SInt32 IODisplayModeID;
+typedef uint64_t AbsoluteTime;
+typedef uint64_t IOPhysicalAddress64;
+typedef uint64_t IOPhysicalLength64;
+typedef SInt32 IOPixelAperture;
+
+struct IOGPoint {
+	SInt16 x;
+	SInt16 y;
+};
+
+struct IOGBounds {
+	SInt16 minx;
+	SInt16 maxx;
+	SInt16 miny;
+	SInt16 maxy;
+};
+
+struct IOExternalMethodArguments;
+
+class OSArray : public OSObject {};
+class OSSerialize : public OSObject {};
+class IODeviceMemory : public OSObject {};
+class IOUserClient : public IOService {};
+
+#endif /* shim_IOUserClient_h */
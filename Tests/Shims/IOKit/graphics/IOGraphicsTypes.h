@@ -0,0 +1,28 @@
+//
+//  IOGraphicsTypes.h
+//  WhateverGreen host tests
+//
+
+#ifndef shim_IOGraphicsTypes_h
+#define shim_IOGraphicsTypes_h
+
+#include <mach/mach_types.h>
+
+#define kIOFBTimingRangeKey "IOFBTimingRange"
+
+typedef uint32_t UInt32;
+typedef unsigned long long UInt64;
+
+struct IODisplayTimingRangeV1 {
+	UInt32 version;
+	UInt32 reserved;
+	UInt64 minPixelClock;
+	UInt64 maxPixelClock;
+	UInt32 reservedA[64];
+};
+
+struct IODetailedTimingInformationV2 {
+	UInt32 reserved[44];
+};
+
+#endif /* shim_IOGraphicsTypes_h */
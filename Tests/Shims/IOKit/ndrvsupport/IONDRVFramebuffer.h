@@ -0,0 +1,30 @@
+//
+//  IONDRVFramebuffer.h
+//  WhateverGreen host tests
+//
+//  Host shim of the framebuffer classes, only their names are needed by the IOFB declarations.
+//
+
+#ifndef shim_IONDRVFramebuffer_h
+#define shim_IONDRVFramebuffer_h
+
+#include <IOKit/IOUserClient.h>
+
+struct IOI2CBusTiming;
+struct IOI2CRequest;
+struct IODisplayModeInformation;
+struct IOTimingInformation;
+struct IOPixelInformation;
+struct IOHardwareCursorInfo;
+struct IOHardwareCursorDescriptor;
+struct IOColorEntry;
+struct VDDetailedTimingRec;
+
+typedef void *IOTVector;
+typedef void (*IOFBInterruptProc)(OSObject *target, void *ref);
+
+class IOGraphicsDevice : public IOService {};
+class IOFramebuffer : public IOGraphicsDevice {};
+class IONDRVFramebuffer : public IOFramebuffer {};
+
+#endif /* shim_IONDRVFramebuffer_h */
@@ -0,0 +1,24 @@
+//
+//  kern_weg_shim.hpp
+//  WhateverGreen host tests
+//
+//  Force-included before kern_model.cpp and kern_unfair.cpp in place of kern_weg.hpp,
+//  which pulls in every module. Declares only what those sources use from WEG.
+//
+
+#ifndef kern_weg_hpp
+#define kern_weg_hpp
+
+#include <Headers/kern_iokit.hpp>
+#include <Headers/kern_devinfo.hpp>
+
+class WEG {
+public:
+	static bool getVideoArgument(DeviceInfo *info, const char *name, void *bootarg, int size);
+
+	const char *getIntelModel(uint32_t dev, uint32_t &fakeId);
+
+	const char *getRadeonModel(uint16_t dev, uint16_t rev, uint16_t subven, uint16_t sub);
+};
+
+#endif /* kern_weg_hpp */
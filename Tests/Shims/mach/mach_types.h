@@ -0,0 +1,32 @@
+//
+//  mach_types.h
+//  WhateverGreen host tests
+//
+//  Host shim of the Mach kernel types used by the tested sources.
+//
+
+#ifndef shim_mach_types_h
+#define shim_mach_types_h
+
+#include <limits.h>
+#include <stdint.h>
+
+// Like on macOS, addresses are unsigned long long and thus distinct from size_t,
+// which the array overloads of the patcher rely on to be picked
+typedef unsigned long long mach_vm_address_t;
+typedef unsigned long vm_address_t;
+typedef int kern_return_t;
+typedef uint64_t memory_object_offset_t;
+typedef void *memory_object_t;
+typedef uint32_t IOOptionBits;
+typedef uint32_t semaphore_t;
+typedef int IOReturn;
+
+#define KERN_SUCCESS 0
+#define KERN_FAILURE 5
+
+#ifndef PAGE_SIZE
+#define PAGE_SIZE 4096UL
+#endif
+
+#endif /* shim_mach_types_h */
@@ -0,0 +1,50 @@
+//
+//  shims.cpp
+//  WhateverGreen host tests
+//
+//  Storage for the globals declared by the host shims.
+//
+
+#include <Headers/kern_api.hpp>
+#include <Headers/kern_patcher.hpp>
+#include <Headers/kern_user.hpp>
+#include <IOKit/IODeviceTreeSupport.h>
+#include <stdarg.h>
+
+bool ADDPR(debugEnabled) = getenv("WEG_HOST_DEBUG") != nullptr;
+
+size_t hostSyslogCount;
+
+void (*hostLogSink)(const char *line);
+
+size_t hostAllocations;
+
+size_t hostGetPathCount;
+
+const char *hostBootArguments;
+
+KernelVersion hostKernelVersion = KernelVersion::Monterey;
+
+LiluAPI lilu;
+
+const char *gIODTPlane = "IODeviceTree";
+
+IORegistryEntry *IORegistryEntry::deviceTreeRoot;
+
+void *KernelPatcher::kernelWriteLock;
+
+size_t MachInfo::writeEnables;
+
+void hostLog(const char *module, const char *format, ...) {
+	char line[1024];
+	int prefix = snprintf(line, sizeof(line), "%s: ", module);
+	va_list args;
+	va_start(args, format);
+	vsnprintf(line + prefix, sizeof(line) - prefix, format, args);
+	va_end(args);
+
+	if (ADDPR(debugEnabled))
+		fprintf(stderr, "%s\n", line);
+	if (hostLogSink)
+		hostLogSink(line);
+}
@@ -0,0 +1,216 @@
+//
+//  UNFAIRRewriteTests.cpp
+//  WhateverGreen host tests
+//
+//  UNFAIR page rewrites: patterns split across page edges in both validation orders, pages
+//  validated again, and single pages against sequential memmem based find / replace.
+//
+
+#include "HostTest.hpp"
+#include "UNFAIRSupport.hpp"
+#include <random>
+
+static constexpr memory_object_offset_t FileOffset = 16 * PAGE_SIZE;
+
+/**
+ *  Rewrite sets of the current instance with a binary each of them applies to
+ */
+struct RewriteKind {
+	const UNFAIR::PageRewriteSet *set;
+	const char *path;
+};
+
+static std::vector<RewriteKind> rewriteKinds(UNFAIR *unfair) {
+	return {
+		{&unfair->sharedCacheRewrites, UNFAIRSupport::sharedCachePaths[0]},
+		{&unfair->coreLSKDRewrites, UNFAIRSupport::coreLSKDPaths[0]},
+	};
+}
+
+/**
+ *  Validate the two pages of a file in the given order, each from its own copy as the pager hands them out
+ */
+static void validatePair(vnode *vp, std::vector<uint8_t> &file, bool nextFirst) {
+	if (nextFirst) {
+		UNFAIRSupport::validate(vp, FileOffset + PAGE_SIZE, file.data() + PAGE_SIZE);
+		UNFAIRSupport::validate(vp, FileOffset, file.data());
+	} else {
+		UNFAIRSupport::validate(vp, FileOffset, file.data());
+		UNFAIRSupport::validate(vp, FileOffset + PAGE_SIZE, file.data() + PAGE_SIZE);
+	}
+}
+
+static void testPageEdgeSplits() {
+	auto unfair = UNFAIRSupport::reset(7);
+	uint32_t vid = 100;
+
+	for (auto &kind : rewriteKinds(unfair)) {
+		for (size_t r = 0; r < kind.set->num; r++) {
+			auto &rewrite = kind.set->rewrites[r];
+
+			// Every split with k bytes in the first page, after both validation orders.
+			for (size_t k = 1; k < rewrite.findSize; k++) {
+				for (int nextFirst = 0; nextFirst < 2; nextFirst++) {
+					vnode node {vid++, kind.path};
+					std::vector<uint8_t> file(2 * PAGE_SIZE);
+					memcpy(file.data() + PAGE_SIZE - k, rewrite.find, rewrite.findSize);
+					auto expected = file;
+
+					// Only a replacement ending in the first page is written, and only when the next page was seen first.
+					size_t writes = MachInfo::writeEnables;
+					validatePair(&node, file, nextFirst);
+					bool rewritten = nextFirst && rewrite.replaceSize <= k;
+					if (rewritten)
+						memcpy(expected.data() + PAGE_SIZE - k, rewrite.replace, rewrite.replaceSize);
+					if (!CHECK(file == expected))
+						fprintf(stderr, "%s split %lu/%lu %s\n", rewrite.name, k, rewrite.findSize - k, nextFirst ? "next first" : "in order");
+					CHECK_EQ(MachInfo::writeEnables - writes, rewritten ? 1 : 0);
+				}
+			}
+		}
+	}
+}
+
+static void testRevalidation() {
+	auto unfair = UNFAIRSupport::reset(7);
+	auto &rewrite = unfair->sharedCacheRewrites.rewrites[1];
+	const size_t k = rewrite.replaceSize + 2;
+
+	std::vector<uint8_t> original(2 * PAGE_SIZE);
+	memcpy(original.data() + PAGE_SIZE - k, rewrite.find, rewrite.findSize);
+	auto rewritten = original;
+	memcpy(rewritten.data() + PAGE_SIZE - k, rewrite.replace, rewrite.replaceSize);
+
+	vnode node {1, UNFAIRSupport::sharedCachePaths[1]};
+	auto file = original;
+	validatePair(&node, file, true);
+	CHECK(file == rewritten);
+
+	// Pages paged in again come from disk: the first one is rewritten the same way, the next one stays
+	// original since its edge is matched against the original first page.
+	file = original;
+	UNFAIRSupport::validate(&node, FileOffset, file.data());
+	CHECK(file == rewritten);
+	file = original;
+	UNFAIRSupport::validate(&node, FileOffset + PAGE_SIZE, file.data() + PAGE_SIZE);
+	UNFAIRSupport::validate(&node, FileOffset, file.data());
+	CHECK(file == rewritten);
+
+	// The edge of the next page belongs to its vnode and id: not after a recycle, not in another file.
+	file = original;
+	UNFAIRSupport::validate(&node, FileOffset + PAGE_SIZE, file.data() + PAGE_SIZE);
+	node.vid++;
+	UNFAIRSupport::validate(&node, FileOffset, file.data());
+	CHECK(file == original);
+
+	vnode other {1, UNFAIRSupport::sharedCachePaths[0]};
+	UNFAIRSupport::validate(&other, FileOffset, file.data());
+	CHECK(file == original);
+
+	// Nor once other pages took over its cache slot.
+	UNFAIRSupport::validate(&node, FileOffset + PAGE_SIZE, file.data() + PAGE_SIZE);
+	std::vector<uint8_t> filler(PAGE_SIZE);
+	for (size_t i = 0; i < UNFAIR::PageEdgeCacheSize; i++)
+		UNFAIRSupport::validate(&other, i * PAGE_SIZE, filler.data());
+	UNFAIRSupport::validate(&node, FileOffset, file.data());
+	CHECK(file == original);
+}
+
+static void testPageOrder() {
+	auto unfair = UNFAIRSupport::reset(7);
+	auto &drm = unfair->sharedCacheRewrites.rewrites[0];
+	auto &hwgva = unfair->sharedCacheRewrites.rewrites[1];
+	vnode node {1, UNFAIRSupport::sharedCachePaths[0]};
+
+	// Each rewrite applies to its first match only, in whatever order the patterns appear.
+	std::vector<uint8_t> page(PAGE_SIZE), expected;
+	memcpy(page.data() + 100, hwgva.find, hwgva.findSize);
+	memcpy(page.data() + 200, drm.find, drm.findSize);
+	memcpy(page.data() + 300, hwgva.find, hwgva.findSize);
+	memcpy(page.data() + 400, drm.find, drm.findSize);
+	expected = page;
+	memcpy(expected.data() + 100, hwgva.replace, hwgva.replaceSize);
+	memcpy(expected.data() + 200, drm.replace, drm.replaceSize);
+	UNFAIRSupport::validate(&node, 0, page.data());
+	CHECK(page == expected);
+
+	// A pattern ending exactly at the page end is matched within the page.
+	std::fill(page.begin(), page.end(), 0);
+	memcpy(page.data() + PAGE_SIZE - drm.findSize, drm.find, drm.findSize);
+	expected = page;
+	memcpy(expected.data() + PAGE_SIZE - drm.findSize, drm.replace, drm.replaceSize);
+	UNFAIRSupport::validate(&node, PAGE_SIZE, page.data());
+	CHECK(page == expected);
+
+	// Patterns longer than a page edge are refused.
+	UNFAIR::PageRewriteSet set;
+	uint8_t longFind[UNFAIR::PageEdgeSize + 2] {};
+	size_t syslogs = hostSyslogCount;
+	set.add({longFind, sizeof(longFind), longFind, 1, "long"});
+	CHECK_EQ(set.num, 0);
+	CHECK_EQ(hostSyslogCount - syslogs, 1);
+}
+
+/**
+ *  Sequential find / replace of the first match of every rewrite, as findAndReplace did
+ */
+static void referenceRewrite(const UNFAIR::PageRewriteSet &set, uint8_t *page) {
+	for (size_t r = 0; r < set.num; r++) {
+		auto &rewrite = set.rewrites[r];
+		auto match = static_cast<uint8_t *>(memmem(page, PAGE_SIZE, rewrite.find, rewrite.findSize));
+		if (match)
+			memcpy(match, rewrite.replace, rewrite.replaceSize);
+	}
+}
+
+static void testMemmemFuzz() {
+	auto unfair = UNFAIRSupport::reset(7);
+	auto kinds = rewriteKinds(unfair);
+	std::mt19937 random(1);
+
+	const size_t pages = 20000;
+	size_t mismatches = 0, rewrittenPages = 0;
+	size_t writes = MachInfo::writeEnables;
+	std::vector<uint8_t> page(PAGE_SIZE), expected;
+	for (size_t p = 0; p < pages; p++) {
+		auto &kind = kinds[p % kinds.size()];
+		auto &set = *kind.set;
+
+		// Bytes of the patterns themselves make partial matches common.
+		std::vector<uint8_t> alphabet;
+		for (size_t r = 0; r < set.num; r++)
+			alphabet.insert(alphabet.end(), set.rewrites[r].find, set.rewrites[r].find + set.rewrites[r].findSize);
+		for (auto &b : page)
+			b = alphabet[random() % alphabet.size()];
+
+		// Whole patterns, prefixes cut short and copies running off the page end.
+		for (size_t n = random() % 6; n > 0; n--) {
+			auto &rewrite = set.rewrites[random() % set.num];
+			size_t size = random() % 3 == 0 ? 1 + random() % rewrite.findSize : rewrite.findSize;
+			size_t position = random() % PAGE_SIZE;
+			memcpy(page.data() + position, rewrite.find, min(size, PAGE_SIZE - position));
+		}
+
+		expected = page;
+		referenceRewrite(set, expected.data());
+		rewrittenPages += expected != page;
+
+		// Every page is its own file, so no page edge is known.
+		vnode node {static_cast<uint32_t>(p), kind.path};
+		UNFAIRSupport::validate(&node, FileOffset, page.data());
+		mismatches += page != expected;
+	}
+
+	CHECK_EQ(mismatches, 0);
+	CHECK_EQ(MachInfo::writeEnables - writes, rewrittenPages);
+	CHECK(rewrittenPages > pages / 4);
+	printf("fuzz: %lu pages, %lu rewritten\n", pages, rewrittenPages);
+}
+
+int main() {
+	testPageEdgeSplits();
+	testRevalidation();
+	testPageOrder();
+	testMemmemFuzz();
+	return HostTest::finish("UNFAIRRewriteTests");
+}
@@ -0,0 +1,122 @@
+//
+//  UNFAIRSupport.cpp
+//  WhateverGreen host tests
+//
+//  Definitions normally provided by kern_weg.cpp and the kernel, which are not part of the host build.
+//
+
+#include "UNFAIRSupport.hpp"
+#include <Headers/kern_user.hpp>
+#include <IOKit/IODeviceTreeSupport.h>
+#include <random>
+
+static uint32_t hostUnfairGva;
+
+bool WEG::getVideoArgument(DeviceInfo *, const char *name, void *bootarg, int size) {
+	if (strcmp(name, "unfairgva") != 0 || size != sizeof(hostUnfairGva))
+		return false;
+	memcpy(bootarg, &hostUnfairGva, sizeof(hostUnfairGva));
+	return true;
+}
+
+size_t &UNFAIRSupport::validations() {
+	static size_t count;
+	return count;
+}
+
+static void orgCsValidatePage(vnode *, memory_object_t, memory_object_offset_t, const void *, int *validated_p, int *, int *) {
+	UNFAIRSupport::validations()++;
+	*validated_p = 1;
+}
+
+UNFAIR *UNFAIRSupport::reset(uint32_t unfairGva) {
+	static UNFAIR *unfair;
+	delete unfair;
+	unfair = new UNFAIR;
+
+	if (IORegistryEntry::deviceTreeRoot == nullptr)
+		IORegistryEntry::deviceTreeRoot = new IORegistryEntry;
+	strcpy(BaseDeviceInfo::get().modelIdentifier, "iMacPro1,1");
+
+	hostUnfairGva = unfairGva;
+	unfair->init();
+
+	KernelPatcher patcher;
+	patcher.provide("_cs_validate_page", orgCsValidatePage);
+	DeviceInfo info;
+	unfair->processKernel(patcher, &info);
+	return unfair;
+}
+
+void UNFAIRSupport::validate(vnode *vp, memory_object_offset_t offset, uint8_t *page) {
+	int validated = 0, tainted = 0, nx = 0;
+	UNFAIR::csValidatePage(vp, nullptr, offset, page, &validated, &tainted, &nx);
+}
+
+void UNFAIRSupport::File::recycle(const std::string &newPath) {
+	node.vid++;
+	path = newPath;
+	node.path = path.c_str();
+}
+
+vnode *UNFAIRSupport::Trace::prepare(const Event &event) {
+	auto &file = files[event.file];
+	if (event.recyclePath)
+		file.recycle(event.recyclePath);
+	return &file.node;
+}
+
+const char *UNFAIRSupport::sharedCachePaths[2] {
+	"/System/Library/dyld/dyld_shared_cache_x86_64h",
+	"/private/var/db/dyld/dyld_shared_cache_x86_64",
+};
+
+const char *UNFAIRSupport::coreLSKDPaths[2] {
+	"/System/Library/PrivateFrameworks/CoreLSKD.framework/Versions/A/CoreLSKD",
+	"/System/Library/PrivateFrameworks/CoreLSKDMSE.framework/Versions/A/CoreLSKDMSE",
+};
+
+static std::string frameworkPath(size_t index) {
+	return "/System/Library/Frameworks/Framework" + std::to_string(index) + ".framework/Versions/A/Framework" + std::to_string(index);
+}
+
+UNFAIRSupport::Trace UNFAIRSupport::makeTrace(size_t events, size_t files, size_t recycleEvery, uint32_t seed) {
+	Trace trace;
+	std::mt19937 random(seed);
+
+	// Files never move, their vnodes stand for zone elements the cache is keyed by.
+	trace.files.reserve(files);
+	for (size_t i = 0; i < files; i++) {
+		trace.files.push_back({{static_cast<uint32_t>(random()), nullptr}, frameworkPath(i)});
+		if (i < arrsize(sharedCachePaths))
+			trace.files[i].path = sharedCachePaths[i];
+		else if (i < arrsize(sharedCachePaths) + arrsize(coreLSKDPaths))
+			trace.files[i].path = coreLSKDPaths[i - arrsize(sharedCachePaths)];
+	}
+	for (auto &file : trace.files)
+		file.node.path = file.path.c_str();
+
+	// Recycled vnodes alternate between unrelated binaries and the patched ones.
+	trace.recyclePaths.reserve(recycleEvery ? events / recycleEvery + 1 : 0);
+	trace.events.reserve(events);
+	std::uniform_real_distribution<double> unit(0, 1);
+	while (trace.events.size() < events) {
+		// Popularity falls off quickly with the file index, the patched binaries are among the popular ones.
+		auto file = static_cast<size_t>(files * unit(random) * unit(random) * unit(random));
+		auto run = 1 + random() % 16;
+		memory_object_offset_t offset = (random() % 4096) * PAGE_SIZE;
+		for (size_t i = 0; i < run && trace.events.size() < events; i++) {
+			const char *recyclePath = nullptr;
+			if (recycleEvery && trace.events.size() % recycleEvery == recycleEvery - 1) {
+				size_t n = trace.recyclePaths.size();
+				trace.recyclePaths.push_back(n % 2 ? coreLSKDPaths[n / 2 % 2] : frameworkPath(files + n));
+				if (n % 4 == 1)
+					trace.recyclePaths.back() = sharedCachePaths[n / 4 % 2];
+				recyclePath = trace.recyclePaths.back().c_str();
+			}
+			trace.events.push_back({file, offset + i * PAGE_SIZE, recyclePath});
+		}
+	}
+
+	return trace;
+}
@@ -0,0 +1,87 @@
+//
+//  UNFAIRSupport.hpp
+//  WhateverGreen host tests
+//
+//  The UNFAIR instance seen by the page validation code under test, configured through
+//  processKernel, and synthetic traces of the pages the kernel validates.
+//
+
+#ifndef UNFAIRSupport_hpp
+#define UNFAIRSupport_hpp
+
+#include "kern_unfair.hpp"
+#include <string>
+#include <vector>
+
+namespace UNFAIRSupport {
+	/**
+	 *  Replace the UNFAIR instance with a fresh one set up by processKernel, routing csValidatePage
+	 *
+	 *  @param unfairGva  unfairgva bitmask
+	 */
+	UNFAIR *reset(uint32_t unfairGva);
+
+	/**
+	 *  Pages seen by the original cs_validate_page
+	 */
+	size_t &validations();
+
+	/**
+	 *  Validate a page through the routed UNFAIR::csValidatePage like the kernel does
+	 */
+	void validate(vnode *vp, memory_object_offset_t offset, uint8_t *page);
+
+	/**
+	 *  Binary whose pages get validated, the vnode path points at path
+	 */
+	struct File {
+		vnode node;
+		std::string path;
+
+		/**
+		 *  Reuse the vnode for another binary, the kernel bumps the vnode id when it does so
+		 */
+		void recycle(const std::string &newPath);
+	};
+
+	/**
+	 *  Page validation, recyclePath is set when the vnode gets recycled just before it
+	 */
+	struct Event {
+		size_t file;
+		memory_object_offset_t offset;
+		const char *recyclePath;
+	};
+
+	/**
+	 *  Page validations in kernel order: runs of consecutive pages, mostly of a few popular binaries
+	 */
+	struct Trace {
+		std::vector<File> files;
+		std::vector<Event> events;
+		std::vector<std::string> recyclePaths;
+
+		/**
+		 *  Apply a recycle of the event, if any, and return its vnode
+		 */
+		vnode *prepare(const Event &event);
+	};
+
+	/**
+	 *  Dyld shared cache and CoreLSKD paths patched by UNFAIR
+	 */
+	extern const char *sharedCachePaths[2];
+	extern const char *coreLSKDPaths[2];
+
+	/**
+	 *  Build a trace over files binaries, two of each patched kind among them
+	 *
+	 *  @param events        number of page validations
+	 *  @param files         number of binaries
+	 *  @param recycleEvery  events between vnode recycles, 0 for none
+	 *  @param seed          trace seed
+	 */
+	Trace makeTrace(size_t events, size_t files, size_t recycleEvery, uint32_t seed);
+}
+
+#endif /* UNFAIRSupport_hpp */
@@ -0,0 +1,203 @@
+//
+//  UNFAIRVerdictTests.cpp
+//  WhateverGreen host tests
+//
+//  Per-vnode page verdicts of UNFAIR::csValidatePage: routing of every page of a synthetic
+//  validation trace, vnode recycling, concurrent slot updates and a replay benchmark.
+//
+
+#include "HostTest.hpp"
+#include "UNFAIRSupport.hpp"
+#include <atomic>
+#include <random>
+#include <thread>
+
+static constexpr size_t SharedCachePattern = 512;
+static constexpr size_t CoreLSKDPattern = 1024;
+
+/**
+ *  Page carrying the first pattern of both rewrite sets away from its edges
+ */
+static void fillPage(UNFAIR *unfair, uint8_t *page) {
+	memset(page, 0, PAGE_SIZE);
+	auto &shared = unfair->sharedCacheRewrites.rewrites[0];
+	auto &coreLSKD = unfair->coreLSKDRewrites.rewrites[0];
+	memcpy(page + SharedCachePattern, shared.find, shared.findSize);
+	memcpy(page + CoreLSKDPattern, coreLSKD.find, coreLSKD.findSize);
+}
+
+static void testTraceRouting() {
+	auto unfair = UNFAIRSupport::reset(7);
+	CHECK_EQ(unfair->sharedCacheRewrites.num, 2);
+	CHECK_EQ(unfair->coreLSKDRewrites.num, 1);
+
+	auto trace = UNFAIRSupport::makeTrace(200000, 600, 5000, 1);
+	auto &shared = unfair->sharedCacheRewrites.rewrites[0];
+	auto &coreLSKD = unfair->coreLSKDRewrites.rewrites[0];
+
+	size_t validations = UNFAIRSupport::validations();
+	size_t getPaths = hostGetPathCount;
+	size_t misrouted = 0, recycles = 0;
+	uint8_t page[PAGE_SIZE];
+	for (auto &event : trace.events) {
+		recycles += event.recyclePath != nullptr;
+		auto vp = trace.prepare(event);
+		fillPage(unfair, page);
+		UNFAIRSupport::validate(vp, event.offset, page);
+
+		// A recycled vnode must never reuse the verdict of the binary it was before.
+		auto expected = unfair->classifyPath(vp->path);
+		bool sharedRewritten = memcmp(page + SharedCachePattern, shared.replace, shared.replaceSize) == 0;
+		bool coreLSKDRewritten = memcmp(page + CoreLSKDPattern, coreLSKD.replace, coreLSKD.replaceSize) == 0;
+		if (sharedRewritten != (expected == UNFAIR::PageVerdict::SharedCache) ||
+			coreLSKDRewritten != (expected == UNFAIR::PageVerdict::CoreLSKD) ||
+			unfair->lookupVerdict(vp, vp->vid) != expected)
+			misrouted++;
+	}
+	CHECK_EQ(misrouted, 0);
+	CHECK(recycles > 0);
+	CHECK_EQ(UNFAIRSupport::validations() - validations, trace.events.size());
+
+	// Paths are only resolved for vnodes missing from the cache.
+	getPaths = hostGetPathCount - getPaths;
+	CHECK(getPaths * 20 < trace.events.size());
+	printf("trace: %lu pages, %lu path lookups, %lu recycles\n", trace.events.size(), getPaths, recycles);
+}
+
+static void testUnpatchedModes() {
+	// Without any shared cache rewrite its pages are not interesting either.
+	auto unfair = UNFAIRSupport::reset(UNFAIR::UnfairAllowHardwareDrmStreamDecoderOnOldCpuid);
+	CHECK_EQ(unfair->classifyPath(UNFAIRSupport::sharedCachePaths[0]), UNFAIR::PageVerdict::Ignore);
+	CHECK_EQ(unfair->classifyPath(UNFAIRSupport::coreLSKDPaths[1]), UNFAIR::PageVerdict::CoreLSKD);
+
+	unfair = UNFAIRSupport::reset(UNFAIR::UnfairRelaxHdcpRequirements);
+	CHECK_EQ(unfair->classifyPath(UNFAIRSupport::sharedCachePaths[1]), UNFAIR::PageVerdict::SharedCache);
+	CHECK_EQ(unfair->classifyPath(UNFAIRSupport::coreLSKDPaths[0]), UNFAIR::PageVerdict::Ignore);
+
+	// A path that cannot be resolved is neither cached nor patched.
+	vnode unnamed {1, nullptr};
+	uint8_t page[PAGE_SIZE] {};
+	UNFAIRSupport::validate(&unnamed, 0, page);
+	CHECK_EQ(unfair->lookupVerdict(&unnamed, unnamed.vid), UNFAIR::PageVerdict::Unknown);
+}
+
+static vnode nodes[UNFAIR::VerdictCacheSize * 16];
+
+static uint32_t vidOf(size_t i) {
+	return static_cast<uint32_t>(i * 7);
+}
+
+static UNFAIR::PageVerdict verdictOf(size_t i) {
+	return static_cast<UNFAIR::PageVerdict>(1 + i % 3);
+}
+
+/**
+ *  Indices of nodes sharing the cache slot of nodes[0], found by watching them evict it
+ */
+static std::vector<size_t> collidingNodes(UNFAIR *unfair) {
+	std::vector<size_t> colliding {0};
+	for (size_t i = 1; i < arrsize(nodes); i++) {
+		unfair->storeVerdict(&nodes[0], vidOf(0), verdictOf(0));
+		unfair->storeVerdict(&nodes[i], vidOf(i), verdictOf(i));
+		if (unfair->lookupVerdict(&nodes[0], vidOf(0)) == UNFAIR::PageVerdict::Unknown)
+			colliding.push_back(i);
+	}
+	return colliding;
+}
+
+static void testSlotKeys() {
+	auto unfair = UNFAIRSupport::reset(7);
+	CHECK_EQ(unfair->lookupVerdict(&nodes[0], vidOf(0)), UNFAIR::PageVerdict::Unknown);
+	unfair->storeVerdict(&nodes[0], vidOf(0), UNFAIR::PageVerdict::SharedCache);
+	CHECK_EQ(unfair->lookupVerdict(&nodes[0], vidOf(0)), UNFAIR::PageVerdict::SharedCache);
+
+	// Neither a recycled vnode nor another vnode landing in the same slot may see the verdict.
+	size_t stale = 0;
+	for (uint32_t vid = 0; vid < 1U << 16; vid++) {
+		if (vid != vidOf(0) && unfair->lookupVerdict(&nodes[0], vid) != UNFAIR::PageVerdict::Unknown)
+			stale++;
+	}
+	for (size_t i = 1; i < arrsize(nodes); i++) {
+		if (unfair->lookupVerdict(&nodes[i], vidOf(0)) != UNFAIR::PageVerdict::Unknown)
+			stale++;
+	}
+	CHECK_EQ(stale, 0);
+
+	// The same vnode with a new id takes over the slot it hashes to.
+	unfair->storeVerdict(&nodes[0], vidOf(0) + 1, UNFAIR::PageVerdict::Ignore);
+	CHECK_EQ(unfair->lookupVerdict(&nodes[0], vidOf(0) + 1), UNFAIR::PageVerdict::Ignore);
+}
+
+static void testConcurrentSlots() {
+	// Writers keep replacing each other in one slot while readers look the nodes up.
+	auto unfair = UNFAIRSupport::reset(7);
+	auto colliding = collidingNodes(unfair);
+	CHECK(colliding.size() > 4);
+
+	std::atomic<size_t> torn {0}, hits {0};
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < 4; t++) {
+		threads.emplace_back([&, t]() {
+			std::mt19937 random(t);
+			for (size_t n = 0; n < 2000000; n++) {
+				size_t i = colliding[random() % colliding.size()];
+				if (n % 2 == t % 2) {
+					unfair->storeVerdict(&nodes[i], vidOf(i), verdictOf(i));
+					continue;
+				}
+
+				auto verdict = unfair->lookupVerdict(&nodes[i], vidOf(i));
+				if (verdict == verdictOf(i))
+					hits++;
+				else if (verdict != UNFAIR::PageVerdict::Unknown)
+					torn++;
+			}
+		});
+	}
+	for (auto &thread : threads)
+		thread.join();
+
+	CHECK_EQ(torn.load(), 0);
+	CHECK(hits.load() > 0);
+}
+
+static void benchmarkReplay() {
+	// Pages of binaries UNFAIR never patches, the bulk of what the kernel validates. The host
+	// vn_getpath is a string copy, the kernel walks the name cache and takes its lock.
+	auto trace = UNFAIRSupport::makeTrace(400000, 600, 0, 2);
+	std::vector<UNFAIRSupport::Event> events;
+	for (auto &event : trace.events) {
+		if (event.file >= arrsize(UNFAIRSupport::sharedCachePaths) + arrsize(UNFAIRSupport::coreLSKDPaths))
+			events.push_back(event);
+	}
+
+	auto unfair = UNFAIRSupport::reset(7);
+	uint8_t page[PAGE_SIZE] {};
+	size_t ignored = 0;
+	double uncached = HostTest::measure(events.size(), [&](size_t i) {
+		auto vp = trace.prepare(events[i]);
+		char path[PATH_MAX];
+		int pathlen = PATH_MAX;
+		if (vn_getpath(vp, path, &pathlen) == 0 && unfair->classifyPath(path) == UNFAIR::PageVerdict::Ignore)
+			ignored++;
+	});
+	CHECK_EQ(ignored, events.size());
+
+	size_t getPaths = hostGetPathCount;
+	double cached = HostTest::measure(events.size(), [&](size_t i) {
+		UNFAIRSupport::validate(trace.prepare(events[i]), events[i].offset, page);
+	});
+	getPaths = hostGetPathCount - getPaths;
+
+	printf("replay: %lu unpatched pages, path per page %.0f ns, verdict cache %.0f ns with %lu path lookups\n",
+		events.size(), uncached, cached, getPaths);
+}
+
+int main() {
+	testTraceRouting();
+	testUnpatchedModes();
+	testSlotKeys();
+	testConcurrentSlots();
+	benchmarkReplay();
+	return HostTest::finish("UNFAIRVerdictTests");
+}
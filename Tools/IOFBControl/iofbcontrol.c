@@ -0,0 +1,84 @@
+//
+// IOFB Control
+// Encoder and decoder for the WhateverGreen 0xFB/0xFB I2C control channel batches.
+//
+
+#include <string.h>
+
+#include <IOKit/graphics/IOGraphicsLib.h>
+#include <IOKit/i2c/IOI2CInterface.h>
+
+#include "iofbcontrol.h"
+
+void IOFBControlBatchInit(IOFBControlBatchRequest *batch) {
+    memset(batch, 0, sizeof(*batch));
+    batch->header.category = kIOFBControlBatch;
+    batch->header.version = kIOFBControlBatchVersion;
+}
+
+int IOFBControlBatchAdd(IOFBControlBatchRequest *batch, uint32_t operation, uint32_t category, uint32_t val1, uint32_t val2, uint32_t val3) {
+    if (batch->header.count >= kIOFBControlBatchMax)
+        return -1;
+    struct IOFBControlCommand *command = &batch->commands[batch->header.count];
+    command->operation = operation;
+    command->category = category;
+    command->val1 = val1;
+    command->val2 = val2;
+    command->val3 = val3;
+    command->reserved = 0;
+    return (int)batch->header.count++;
+}
+
+size_t IOFBControlBatchSize(const IOFBControlBatchRequest *batch) {
+    return sizeof(struct IOFBControlBatchHeader) + batch->header.count * sizeof(struct IOFBControlCommand);
+}
+
+size_t IOFBControlReplySize(const IOFBControlBatchRequest *batch) {
+    return sizeof(struct IOFBControlBatchHeader) + batch->header.count * sizeof(struct IOFBControlResult);
+}
+
+int IOFBControlReplyDecode(const IOFBControlBatchRequest *batch, const void *reply, size_t replyBytes, const struct IOFBControlResult **results) {
+    const struct IOFBControlBatchHeader *header = (const struct IOFBControlBatchHeader *)reply;
+    if (replyBytes < IOFBControlReplySize(batch))
+        return -1;
+    if (header->category != kIOFBControlBatch || header->version != kIOFBControlBatchVersion || header->count != batch->header.count)
+        return -1;
+    if (results)
+        *results = (const struct IOFBControlResult *)(header + 1);
+    return 0;
+}
+
+IOReturn IOFBControlBatchSend(io_service_t framebuffer, const IOFBControlBatchRequest *batch, IOFBControlBatchReply *reply) {
+    io_service_t interface;
+    IOReturn result = IOFBCopyI2CInterfaceForBus(framebuffer, 0, &interface);
+    if (result != kIOReturnSuccess)
+        return result;
+
+    IOI2CConnectRef connect;
+    result = IOI2CInterfaceOpen(interface, kNilOptions, &connect);
+    IOObjectRelease(interface);
+    if (result != kIOReturnSuccess)
+        return result;
+
+    IOI2CRequest request;
+    memset(&request, 0, sizeof(request));
+    request.sendTransactionType = kIOI2CSimpleTransactionType;
+    request.sendAddress = 0xfb;
+    request.sendSubAddress = 0xfb;
+    request.sendBuffer = (vm_address_t)batch;
+    request.sendBytes = (uint32_t)IOFBControlBatchSize(batch);
+    request.replyTransactionType = kIOI2CSimpleTransactionType;
+    request.replyAddress = 0xfb;
+    request.replySubAddress = 0xfb;
+    request.replyBuffer = (vm_address_t)reply;
+    request.replyBytes = (uint32_t)IOFBControlReplySize(batch);
+
+    result = IOI2CSendRequest(connect, kNilOptions, &request);
+    if (result == kIOReturnSuccess)
+        result = request.result;
+    IOI2CInterfaceClose(connect, kNilOptions);
+
+    if (result == kIOReturnSuccess && IOFBControlReplyDecode(batch, reply, request.replyBytes, NULL) != 0)
+        result = kIOReturnBadMessage;
+    return result;
+}
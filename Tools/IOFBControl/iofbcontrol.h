@@ -0,0 +1,42 @@
+//
+// IOFB Control
+// Encoder and decoder for the WhateverGreen 0xFB/0xFB I2C control channel batches.
+//
+
+#ifndef iofbcontrol_h
+#define iofbcontrol_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <IOKit/IOKitLib.h>
+
+#include "../../WhateverGreen/kern_iofbcontrol.hpp"
+
+typedef struct {
+    struct IOFBControlBatchHeader header;
+    struct IOFBControlCommand commands[kIOFBControlBatchMax];
+} IOFBControlBatchRequest;
+
+typedef struct {
+    struct IOFBControlBatchHeader header;
+    struct IOFBControlResult results[kIOFBControlBatchMax];
+} IOFBControlBatchReply;
+
+// Start an empty batch.
+void IOFBControlBatchInit(IOFBControlBatchRequest *batch);
+
+// Append a get or set, returns the index of its result or -1 when the batch is full.
+int IOFBControlBatchAdd(IOFBControlBatchRequest *batch, uint32_t operation, uint32_t category, uint32_t val1, uint32_t val2, uint32_t val3);
+
+// Number of bytes to send and to reserve for the reply.
+size_t IOFBControlBatchSize(const IOFBControlBatchRequest *batch);
+size_t IOFBControlReplySize(const IOFBControlBatchRequest *batch);
+
+// Check that a reply matches the batch it answers, returns 0 on success.
+int IOFBControlReplyDecode(const IOFBControlBatchRequest *batch, const void *reply, size_t replyBytes, const struct IOFBControlResult **results);
+
+// Send the batch to a framebuffer in a single I2C transaction.
+IOReturn IOFBControlBatchSend(io_service_t framebuffer, const IOFBControlBatchRequest *batch, IOFBControlBatchReply *reply);
+
+#endif /* iofbcontrol_h */
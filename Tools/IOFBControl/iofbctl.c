@@ -0,0 +1,86 @@
+//
+// IOFB Control
+// Sends several gets and sets to every framebuffer in one 0xFB batch transaction.
+//
+// Usage: iofbctl OPERATION:CATEGORY:VAL1[:VAL2[:VAL3]] ...
+//   OPERATION is get or set, values are numbers or four character codes.
+//   Example: iofbctl get:iofb:attr get:atfc:0:pscn set:iofb:i2cr:1
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <IOKit/graphics/IOGraphicsLib.h>
+
+#include "iofbcontrol.h"
+
+static uint32_t parseValue(const char *str) {
+    if (strlen(str) == 4 && (str[0] < '0' || str[0] > '9'))
+        return (uint32_t)str[0] << 24 | (uint32_t)str[1] << 16 | (uint32_t)str[2] << 8 | (uint32_t)str[3];
+    return (uint32_t)strtoul(str, NULL, 0);
+}
+
+static int parseCommand(IOFBControlBatchRequest *batch, char *arg) {
+    char *fields[5] = { 0 };
+    int count = 0;
+    for (char *field = strtok(arg, ":"); field && count < 5; field = strtok(NULL, ":"))
+        fields[count++] = field;
+    if (count < 3)
+        return -1;
+
+    uint32_t operation;
+    if (!strcmp(fields[0], "get"))
+        operation = kIOFBControlGet;
+    else if (!strcmp(fields[0], "set"))
+        operation = kIOFBControlSet;
+    else
+        return -1;
+
+    return IOFBControlBatchAdd(batch, operation, parseValue(fields[1]), parseValue(fields[2]),
+        fields[3] ? parseValue(fields[3]) : 0, fields[4] ? parseValue(fields[4]) : 0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s OPERATION:CATEGORY:VAL1[:VAL2[:VAL3]] ...\n", argv[0]);
+        return 1;
+    }
+
+    IOFBControlBatchRequest batch;
+    IOFBControlBatchInit(&batch);
+    for (int i = 1; i < argc; i++) {
+        if (parseCommand(&batch, argv[i]) < 0) {
+            fprintf(stderr, "invalid or too many commands at %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    io_iterator_t iterator;
+    if (IOServiceGetMatchingServices(kIOMasterPortDefault, IOServiceMatching(IOFRAMEBUFFER_CONFORMSTO), &iterator) != KERN_SUCCESS) {
+        fprintf(stderr, "no framebuffers found\n");
+        return 1;
+    }
+
+    int status = 0;
+    io_service_t framebuffer;
+    while ((framebuffer = IOIteratorNext(iterator))) {
+        io_name_t name;
+        if (IORegistryEntryGetName(framebuffer, name) != KERN_SUCCESS)
+            strcpy(name, "?");
+
+        IOFBControlBatchReply reply;
+        IOReturn result = IOFBControlBatchSend(framebuffer, &batch, &reply);
+        if (result != kIOReturnSuccess) {
+            printf("%s: batch failed 0x%x\n", name, result);
+            status = 1;
+        }
+        else {
+            for (uint32_t i = 0; i < batch.header.count; i++)
+                printf("%s: [%u] result:0x%x value:0x%llx\n", name, i, reply.results[i].result, (unsigned long long)reply.results[i].value);
+        }
+        IOObjectRelease(framebuffer);
+    }
+    IOObjectRelease(iterator);
+    return status;
+}
@@ -0,0 +1,190 @@
+//
+// IOFB Trace
+// Drains the WhateverGreen IOFB binary trace ring through the 0xFB I2C channel
+// and formats the records on the host.
+//
+// Usage: iofbtrace [-e | -d] [-f]
+//   -e  enable tracing
+//   -d  disable tracing
+//   -f  keep polling for new records
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <mach/mach_time.h>
+
+#include <IOKit/IOKitLib.h>
+#include <IOKit/graphics/IOGraphicsLib.h>
+#include <IOKit/i2c/IOI2CInterface.h>
+
+#include "../../WhateverGreen/kern_iofbtrace.hpp"
+
+static IOReturn sendCommand(io_service_t framebuffer, uint32_t category, uint32_t val1, uint32_t val2, void *reply, uint32_t replyBytes) {
+    io_service_t interface;
+    IOReturn result = IOFBCopyI2CInterfaceForBus(framebuffer, 0, &interface);
+    if (result != kIOReturnSuccess)
+        return result;
+
+    IOI2CConnectRef connect;
+    result = IOI2CInterfaceOpen(interface, kNilOptions, &connect);
+    IOObjectRelease(interface);
+    if (result != kIOReturnSuccess)
+        return result;
+
+    uint32_t command[4] = { category, val1, val2, 0 };
+    IOI2CRequest request;
+    memset(&request, 0, sizeof(request));
+    request.sendTransactionType = kIOI2CSimpleTransactionType;
+    request.sendAddress = 0xfb;
+    request.sendSubAddress = 0xfb;
+    request.sendBuffer = (vm_address_t)command;
+    request.sendBytes = sizeof(command);
+    if (reply) {
+        request.replyTransactionType = kIOI2CSimpleTransactionType;
+        request.replyAddress = 0xfb;
+        request.replySubAddress = 0xfb;
+        request.replyBuffer = (vm_address_t)reply;
+        request.replyBytes = replyBytes;
+    }
+
+    result = IOI2CSendRequest(connect, kNilOptions, &request);
+    if (result == kIOReturnSuccess)
+        result = request.result;
+    IOI2CInterfaceClose(connect, kNilOptions);
+    return result;
+}
+
+static const char *formatCode(char *buf, size_t size, uint64_t code) {
+    char c[4] = { (char)(code >> 24), (char)(code >> 16), (char)(code >> 8), (char)code };
+    for (int i = 0; i < 4; i++) {
+        if (c[i] < 0x20 || c[i] > 0x7e) {
+            snprintf(buf, size, "0x%llx", (unsigned long long)code);
+            return buf;
+        }
+    }
+    snprintf(buf, size, "'%.4s'", c);
+    return buf;
+}
+
+static void printRecord(const struct IOFBTraceRecord *record, double ticksToNs) {
+    char code[20];
+    double ms = record->timestamp * ticksToNs / 1000000.0;
+
+    switch (record->tag) {
+        case kIOFBTraceGetAttribute:
+        case kIOFBTraceSetAttribute:
+            printf("%12.3f %u fb:0x%llx %s attribute:%s value:0x%llx result:0x%x\n",
+                ms, record->sequence, (unsigned long long)record->service,
+                record->tag == kIOFBTraceGetAttribute ? "getAttribute" : "setAttribute",
+                formatCode(code, sizeof(code), record->args[0]),
+                (unsigned long long)record->args[1], record->result);
+            break;
+        case kIOFBTraceGetAttributeForConnection:
+        case kIOFBTraceSetAttributeForConnection:
+            printf("%12.3f %u fb:0x%llx %s connectIndex:%lld attribute:%s value:0x%llx result:0x%x\n",
+                ms, record->sequence, (unsigned long long)record->service,
+                record->tag == kIOFBTraceGetAttributeForConnection ? "getAttributeForConnection" : "setAttributeForConnection",
+                (long long)record->args[2], formatCode(code, sizeof(code), record->args[0]),
+                (unsigned long long)record->args[1], record->result);
+            break;
+        case kIOFBTraceDoI2CRequest:
+            printf("%12.3f %u fb:0x%llx doI2CRequest bus:%llu send:%llu@0x%llx reply:%llu@0x%llx result:0x%x\n",
+                ms, record->sequence, (unsigned long long)record->service,
+                (unsigned long long)record->args[0],
+                (unsigned long long)(record->args[1] >> 24), (unsigned long long)(record->args[1] & 0xffffff),
+                (unsigned long long)(record->args[2] >> 24), (unsigned long long)(record->args[2] & 0xffffff),
+                record->result);
+            break;
+        default:
+            printf("%12.3f %u fb:0x%llx %s 0x%llx 0x%llx 0x%llx result:0x%x\n",
+                ms, record->sequence, (unsigned long long)record->service,
+                formatCode(code, sizeof(code), record->tag),
+                (unsigned long long)record->args[0], (unsigned long long)record->args[1],
+                (unsigned long long)record->args[2], record->result);
+            break;
+    }
+}
+
+int main(int argc, char **argv) {
+    int enable = -1;
+    int follow = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "edf")) != -1) {
+        switch (opt) {
+            case 'e': enable = 1; break;
+            case 'd': enable = 0; break;
+            case 'f': follow = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-e | -d] [-f]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // The ring is shared by all framebuffers, the first one that answers is enough.
+    io_iterator_t iterator;
+    if (IOServiceGetMatchingServices(kIOMasterPortDefault, IOServiceMatching(IOFRAMEBUFFER_CONFORMSTO), &iterator) != KERN_SUCCESS) {
+        fprintf(stderr, "no framebuffers found\n");
+        return 1;
+    }
+
+    io_service_t framebuffer = IO_OBJECT_NULL;
+    io_service_t candidate;
+    while ((candidate = IOIteratorNext(iterator))) {
+        uint32_t state = 0;
+        if (framebuffer == IO_OBJECT_NULL && sendCommand(candidate, 'iofb', 'trce', 0, &state, sizeof(state)) == kIOReturnSuccess)
+            framebuffer = candidate;
+        else
+            IOObjectRelease(candidate);
+    }
+    IOObjectRelease(iterator);
+
+    if (framebuffer == IO_OBJECT_NULL) {
+        fprintf(stderr, "no framebuffer answers the 0xFB channel, boot with -iofbon\n");
+        return 1;
+    }
+
+    if (enable >= 0) {
+        IOReturn result = sendCommand(framebuffer, 'iofb', 'trce', enable, NULL, 0);
+        if (result != kIOReturnSuccess) {
+            fprintf(stderr, "cannot change tracing state: 0x%x\n", result);
+            IOObjectRelease(framebuffer);
+            return 1;
+        }
+    }
+
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    double ticksToNs = (double)timebase.numer / timebase.denom;
+
+    // Larger replies are rejected by IOI2CSendRequest, so the ring is read in chunks until drained.
+    static uint8_t reply[sizeof(struct IOFBTraceReply) + kIOFBTraceMaxReplyRecords * sizeof(struct IOFBTraceRecord)];
+    uint32_t sequence = 0;
+    for (;;) {
+        IOReturn result = sendCommand(framebuffer, 'trce', sequence, 0, reply, sizeof(reply));
+        if (result != kIOReturnSuccess) {
+            fprintf(stderr, "cannot read trace: 0x%x\n", result);
+            IOObjectRelease(framebuffer);
+            return 1;
+        }
+
+        const struct IOFBTraceReply *header = (const struct IOFBTraceReply *)reply;
+        const struct IOFBTraceRecord *records = (const struct IOFBTraceRecord *)(header + 1);
+        if (header->firstSequence != sequence && sequence != 0)
+            printf("(%u records lost)\n", header->firstSequence - sequence);
+        for (uint32_t i = 0; i < header->count; i++)
+            printRecord(&records[i], ticksToNs);
+
+        int drained = header->nextSequence == sequence;
+        sequence = header->nextSequence;
+        if (drained) {
+            if (!follow)
+                break;
+            usleep(100000);
+        }
+    }
+
+    IOObjectRelease(framebuffer);
+    return 0;
+}
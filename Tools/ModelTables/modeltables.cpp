@@ -0,0 +1,308 @@
+//
+// Model Tables
+// Updates the Model tables of kern_model.cpp from a local pci.ids.
+//
+// Usage: modeltables pci.ids kern_model.cpp [output.cpp]
+//
+// The curated tables in kern_model.cpp stay authoritative, pci.ids only contributes what they lack:
+//  - Radeon device ids are limited to the ones already present (rule 1, ids found in Apple kexts).
+//  - Subsystems missing from a known device are added as DetectSub entries named per rule 2 and 4.
+//  - Curated names that pci.ids spells differently are reported as renamed but kept.
+//  - Intel device ids missing from devIntel are reported only, they need a fake id picked by hand.
+// The output is kern_model.cpp itself with the new entries inserted in subsystem order. Every other
+// line is copied verbatim, so an empty pci.ids reproduces the source byte for byte and reruns diff cleanly.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct ModelEntry {
+    std::string mode;
+    unsigned subven;
+    unsigned sub;
+    unsigned rev;
+    std::string name;
+    size_t line; // index into sourceLines
+};
+
+struct PciDevice {
+    std::string name;
+    std::map<std::pair<unsigned, unsigned>, std::string> subsystems;
+};
+
+// Source lines including their line endings, written back unchanged.
+static std::vector<std::string> sourceLines;
+static std::map<unsigned, std::vector<ModelEntry>> radeonTables;
+// Intel ids in devIntel, including the commented out reserved ones.
+static std::set<unsigned> intelKnown;
+static std::map<unsigned, PciDevice> pciAMD;
+static std::map<unsigned, std::string> pciIntel;
+static std::string pciVersion;
+
+static bool parseModelSource(const char *path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::stringstream contents;
+    contents << in.rdbuf();
+    std::string source = contents.str();
+    for (size_t pos = 0; pos < source.size();) {
+        size_t next = source.find('\n', pos);
+        next = next == std::string::npos ? source.size() : next + 1;
+        sourceLines.push_back(source.substr(pos, next - pos));
+        pos = next;
+    }
+
+    static const std::regex tableStart(R"(^static constexpr Model dev([0-9a-fA-F]{4})\[\] \{)");
+    static const std::regex modelLine(R"(^\s*\{Model::(Detect[A-Za-z]+), 0x([0-9a-fA-F]+), 0x([0-9a-fA-F]+), 0x([0-9a-fA-F]+), \"(.*)\"\},?\s*$)");
+    static const std::regex intelLine(R"(^\s*(// )?\{ 0x([0-9a-fA-F]+), 0x([0-9a-fA-F]+), (nullptr|\"(.*)\") \},?\s*$)");
+
+    std::vector<ModelEntry> *current = nullptr;
+    bool inIntel = false;
+    std::smatch m;
+    for (size_t i = 0; i < sourceLines.size(); i++) {
+        const std::string &line = sourceLines[i];
+        if (std::regex_search(line, m, tableStart)) {
+            current = &radeonTables[std::stoul(m[1], nullptr, 16)];
+            continue;
+        }
+        if (line.rfind("static constexpr BuiltinModel devIntel[]", 0) == 0) {
+            inIntel = true;
+            continue;
+        }
+        if (line.rfind("};", 0) == 0) {
+            current = nullptr;
+            inIntel = false;
+            continue;
+        }
+        if (current && std::regex_match(line, m, modelLine)) {
+            current->push_back({m[1], (unsigned)std::stoul(m[2], nullptr, 16), (unsigned)std::stoul(m[3], nullptr, 16),
+                (unsigned)std::stoul(m[4], nullptr, 16), m[5], i});
+        }
+        else if (inIntel && std::regex_match(line, m, intelLine)) {
+            intelKnown.insert((unsigned)std::stoul(m[2], nullptr, 16));
+        }
+    }
+    return !radeonTables.empty() && !intelKnown.empty();
+}
+
+static bool isHex(const char *s, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        if (!isxdigit((unsigned char)s[i]))
+            return false;
+    return true;
+}
+
+// pci.ids is large, read it line by line with a small state machine and keep only AMD/Intel display entries.
+static bool parsePciIds(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    char buf[1024];
+    unsigned vendor = 0;
+    PciDevice *device = nullptr;
+    while (fgets(buf, sizeof(buf), f)) {
+        buf[strcspn(buf, "\r\n")] = '\0';
+        if (buf[0] == '#') {
+            const char *version = strstr(buf, "Version:");
+            if (version && pciVersion.empty())
+                pciVersion = version + 9;
+            continue;
+        }
+        // Device classes follow the vendor list and are of no interest.
+        if (buf[0] == 'C' && buf[1] == ' ')
+            break;
+
+        if (buf[0] != '\t' && isHex(buf, 4)) {
+            vendor = (unsigned)strtoul(buf, nullptr, 16);
+            device = nullptr;
+        }
+        else if (buf[0] == '\t' && buf[1] != '\t' && isHex(buf + 1, 4)) {
+            unsigned dev = (unsigned)strtoul(buf + 1, nullptr, 16);
+            const char *name = buf + 7;
+            device = nullptr;
+            if (vendor == 0x1002 && radeonTables.count(dev)) {
+                device = &pciAMD[dev];
+                device->name = name;
+            }
+            else if (vendor == 0x8086 && strstr(name, "Graphics")) {
+                pciIntel[dev] = name;
+            }
+        }
+        else if (buf[0] == '\t' && buf[1] == '\t' && isHex(buf + 2, 4) && buf[6] == ' ' && isHex(buf + 7, 4) && device) {
+            unsigned subven = (unsigned)strtoul(buf + 2, nullptr, 16);
+            unsigned sub = (unsigned)strtoul(buf + 7, nullptr, 16);
+            device->subsystems[{subven, sub}] = buf + 13;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Naming rules 2 and 4 from kern_model.cpp: Apple style vendor prefix, no generic names.
+static std::string normaliseAMDName(std::string name) {
+    size_t open = name.rfind('[');
+    size_t close = name.rfind(']');
+    if (open != std::string::npos && close != std::string::npos && close > open)
+        name = name.substr(open + 1, close - open - 1);
+    for (const char *prefix : {"AMD ", "ATI "})
+        if (name.rfind(prefix, 0) == 0)
+            name.erase(0, strlen(prefix));
+
+    // Board partner branding precedes the chip name and memory size trails it, neither is part of Apple style names.
+    size_t family = std::min(name.find("Radeon"), name.find("FirePro"));
+    if (family != std::string::npos)
+        name.erase(0, family);
+    static const std::regex memorySize(R"( \d+ ?GB$)");
+    name = std::regex_replace(name, memorySize, "");
+
+    bool hasDigit = false;
+    for (char c : name)
+        hasDigit |= isdigit((unsigned char)c) != 0;
+    if (!hasDigit || (name.find("Radeon") == std::string::npos && name.find("FirePro") == std::string::npos))
+        return std::string();
+
+    static const std::regex evergreen(R"((Mobility )?Radeon HD 5\d\d\d)");
+    return (std::regex_search(name, evergreen) ? "ATI " : "AMD ") + name;
+}
+
+static std::string normaliseIntelName(std::string name) {
+    size_t open = name.rfind('[');
+    size_t close = name.rfind(']');
+    if (open != std::string::npos && close != std::string::npos && close > open)
+        name = name.substr(open + 1, close - open - 1);
+    return name.rfind("Intel ", 0) == 0 ? name : "Intel " + name;
+}
+
+static bool isSubOnly(const ModelEntry &e) {
+    return e.mode == "DetectSub" || e.mode == "DetectAll";
+}
+
+static std::string formatModel(const ModelEntry &e, bool last) {
+    char line[256];
+    snprintf(line, sizeof(line), "\t{Model::%s, 0x%04x, 0x%04x, 0x%04x, \"%s\"}%s\n", e.mode.c_str(), e.subven, e.sub, e.rev, e.name.c_str(), last ? "" : ",");
+    return line;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s pci.ids kern_model.cpp [output.cpp]\n", argv[0]);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!parseModelSource(argv[2])) {
+        fprintf(stderr, "cannot parse model tables from %s\n", argv[2]);
+        return 1;
+    }
+    if (!parsePciIds(argv[1])) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    // New lines go in front of a source line, or after the last entry of a table made of subsystems only.
+    std::map<size_t, std::vector<ModelEntry>> insertBefore, appendAfter;
+    size_t added = 0, renamed = 0, candidates = 0;
+
+    for (auto &table : radeonTables) {
+        unsigned dev = table.first;
+        const std::vector<ModelEntry> &entries = table.second;
+        auto pci = pciAMD.find(dev);
+        if (pci == pciAMD.end() || entries.empty())
+            continue;
+
+        std::set<std::pair<unsigned, unsigned>> known;
+        for (auto &e : entries) {
+            if (isSubOnly(e))
+                known.insert({e.subven, e.sub});
+        }
+
+        // New subsystems join the leading subsystem block, the first entry to match must not change for known ids.
+        size_t leading = 0;
+        while (leading < entries.size() && isSubOnly(entries[leading]))
+            leading++;
+
+        for (auto &sub : pci->second.subsystems) {
+            std::string name = normaliseAMDName(sub.second);
+            if (name.empty())
+                continue;
+            if (known.count(sub.first)) {
+                for (auto &e : entries) {
+                    if (e.mode == "DetectSub" && e.subven == sub.first.first && e.sub == sub.first.second && e.name != name) {
+                        fprintf(stderr, "renamed %04x %04x:%04x \"%s\" -> \"%s\" (kept)\n", dev, e.subven, e.sub, e.name.c_str(), name.c_str());
+                        renamed++;
+                    }
+                }
+                continue;
+            }
+
+            ModelEntry addition {"DetectSub", sub.first.first, sub.first.second, 0, name, 0};
+            size_t pos = 0;
+            while (pos < leading && std::make_pair(entries[pos].subven, entries[pos].sub) < sub.first)
+                pos++;
+            if (pos < entries.size())
+                insertBefore[entries[pos].line].push_back(addition);
+            else
+                appendAfter[entries.back().line].push_back(addition);
+            fprintf(stderr, "added   %04x %04x:%04x \"%s\"\n", dev, sub.first.first, sub.first.second, name.c_str());
+            added++;
+        }
+    }
+
+    // Sandy Bridge (0x01xx) and newer only, rule 1 for Intel.
+    for (auto &dev : pciIntel) {
+        if (dev.first >= 0x0100 && !intelKnown.count(dev.first)) {
+            fprintf(stderr, "intel   %04x \"%s\" (needs a fake id, not emitted)\n", dev.first, normaliseIntelName(dev.second).c_str());
+            candidates++;
+        }
+    }
+
+    std::string output;
+    for (size_t i = 0; i < sourceLines.size(); i++) {
+        auto before = insertBefore.find(i);
+        if (before != insertBefore.end()) {
+            for (auto &e : before->second)
+                output += formatModel(e, false);
+        }
+
+        auto after = appendAfter.find(i);
+        if (after == appendAfter.end()) {
+            output += sourceLines[i];
+            continue;
+        }
+        std::string line = sourceLines[i];
+        size_t close = line.rfind('}');
+        if (close != std::string::npos && line.compare(close + 1, 1, ",") != 0)
+            line.insert(close + 1, ",");
+        output += line;
+        for (size_t j = 0; j < after->second.size(); j++)
+            output += formatModel(after->second[j], j + 1 == after->second.size());
+    }
+
+    // The output may replace the source, which is fully read by now.
+    FILE *out = argc > 3 ? fopen(argv[3], "wb") : stdout;
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", argv[3]);
+        return 1;
+    }
+    fwrite(output.data(), 1, output.size(), out);
+    if (out != stdout)
+        fclose(out);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "pci.ids %s: %zu added, %zu renamed, %zu intel candidates in %.1f ms\n",
+        pciVersion.empty() ? "(unknown version)" : pciVersion.c_str(), added, renamed, candidates, ms);
+    return 0;
+}
@@ -512,6 +512,85 @@ bool IGFX::processKext(KernelPatcher &patcher, size_t index, mach_vm_address_t a
 	return false;
 }
 
+// MARK: - Framebuffer Explorer
+
+IGFX::AppleIntelFramebufferExplorer::IndexCacheEntry IGFX::AppleIntelFramebufferExplorer::indexCache[IndexCacheSize] {};
+bool IGFX::AppleIntelFramebufferExplorer::indexCacheWriting {false};
+uint32_t IGFX::AppleIntelFramebufferExplorer::indexCacheVictim {0};
+
+bool IGFX::AppleIntelFramebufferExplorer::findCachedIndex(IORegistryEntry *framebuffer, uint64_t entryID, uint32_t &index) {
+	for (auto &entry : indexCache) {
+		// Skip entries being written and entries modified while being read
+		uint32_t sequence = __atomic_load_n(&entry.sequence, __ATOMIC_ACQUIRE);
+		if (sequence & 1)
+			continue;
+		auto cachedFramebuffer = __atomic_load_n(&entry.framebuffer, __ATOMIC_RELAXED);
+		auto cachedEntryID = __atomic_load_n(&entry.entryID, __ATOMIC_RELAXED);
+		auto cachedIndex = __atomic_load_n(&entry.index, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&entry.sequence, __ATOMIC_RELAXED) != sequence)
+			continue;
+		
+		if (cachedFramebuffer == framebuffer && cachedEntryID == entryID) {
+			index = cachedIndex;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+void IGFX::AppleIntelFramebufferExplorer::cacheIndex(IORegistryEntry *framebuffer, uint64_t entryID, uint32_t index) {
+	// Writers are serialized, a miss racing with another writer is simply not cached
+	if (__atomic_exchange_n(&indexCacheWriting, true, __ATOMIC_ACQUIRE))
+		return;
+	
+	// Another writer may have cached the same framebuffer in the meantime
+	uint32_t cachedIndex;
+	if (!findCachedIndex(framebuffer, entryID, cachedIndex)) {
+		// Reuse the entry of a previous framebuffer at the same address first, then an unused entry,
+		// and otherwise evict entries in turn so that framebuffers which have gone away are dropped
+		IndexCacheEntry *victim = nullptr;
+		for (auto &entry : indexCache) {
+			auto cachedFramebuffer = __atomic_load_n(&entry.framebuffer, __ATOMIC_RELAXED);
+			if (cachedFramebuffer == framebuffer) {
+				victim = &entry;
+				break;
+			}
+			if (cachedFramebuffer == nullptr && victim == nullptr)
+				victim = &entry;
+		}
+		if (victim == nullptr)
+			victim = &indexCache[indexCacheVictim++ % IndexCacheSize];
+		
+		uint32_t sequence = victim->sequence;
+		__atomic_store_n(&victim->sequence, sequence + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		__atomic_store_n(&victim->framebuffer, framebuffer, __ATOMIC_RELAXED);
+		__atomic_store_n(&victim->entryID, entryID, __ATOMIC_RELAXED);
+		__atomic_store_n(&victim->index, index, __ATOMIC_RELAXED);
+		__atomic_store_n(&victim->sequence, sequence + 2, __ATOMIC_RELEASE);
+	}
+	
+	__atomic_store_n(&indexCacheWriting, false, __ATOMIC_RELEASE);
+}
+
+bool IGFX::AppleIntelFramebufferExplorer::getIndex(IORegistryEntry *framebuffer, uint32_t &index) {
+	if (framebuffer == nullptr)
+		return false;
+	
+	uint64_t entryID = framebuffer->getRegistryEntryID();
+	if (findCachedIndex(framebuffer, entryID, index))
+		return true;
+	
+	auto idxnum = OSDynamicCast(OSNumber, framebuffer->getProperty("IOFBDependentIndex"));
+	if (idxnum == nullptr)
+		return false;
+	index = idxnum->unsigned32BitValue();
+	cacheIndex(framebuffer, entryID, index);
+	return true;
+}
+
 // MARK: - Global Framebuffer Controller Access Support
 
 void IGFX::FramebufferControllerAccessSupport::init() {
@@ -1321,11 +1400,11 @@ void IGFX::doFrameBufferStuff() {
 
 	if (callbackIGFX->applyFramebufferPatch && cpuGeneration >= CPUInfo::CpuGeneration::SandyBridge) {
 		DBGLOG("igfx", "IGFX::doFrameBufferStuff applyFramebufferPatch");
-		callbackIGFX->applyFramebufferPatches();
+		callbackIGFX->applyPlatformInformationListPatches(true, false);
 	}
 	else if (callbackIGFX->hdmiAutopatch) {
 		DBGLOG("igfx", "IGFX::doFrameBufferStuff hdmiAutopatch");
-		callbackIGFX->applyHdmiAutopatch();
+		callbackIGFX->applyPlatformInformationListPatches(false, true);
 	}
 
 #ifdef DEBUG
@@ -1734,86 +1813,6 @@ bool IGFX::loadPatchesFromDevice(IORegistryEntry *igpu, uint32_t currentFramebuf
 	return hasFramebufferPatch;
 }
 
-uint8_t *IGFX::findFramebufferId(uint32_t framebufferId, uint8_t *startingAddress, size_t maxSize) {
-	uint32_t *startAddress = reinterpret_cast<uint32_t *>(startingAddress);
-	uint32_t *endAddress = reinterpret_cast<uint32_t *>(startingAddress + maxSize);
-	while (startAddress < endAddress) {
-		if (*startAddress == framebufferId)
-			return reinterpret_cast<uint8_t *>(startAddress);
-		startAddress++;
-	}
-
-	return nullptr;
-}
-
-#ifdef DEBUG
-size_t IGFX::calculatePlatformListSize(size_t maxSize) {
-	// sanity check maxSize
-	if (maxSize < sizeof(uint32_t)*2)
-		return maxSize;
-	// ig-platform-id table ends with 0xFFFFF, but to avoid false positive
-	// look for FFFFFFFF 00000000
-	// and Sandy Bridge is special, ending in 00000000 000c0c0c
-	uint8_t * startingAddress = reinterpret_cast<uint8_t *>(gPlatformInformationList);
-	uint32_t *startAddress = reinterpret_cast<uint32_t *>(startingAddress);
-	uint32_t *endAddress = reinterpret_cast<uint32_t *>(startingAddress + maxSize - sizeof(uint32_t));
-	while (startAddress < endAddress) {
-		if ((!gPlatformListIsSNB && 0xffffffff == startAddress[0] && 0 == startAddress[1]) ||
-			(gPlatformListIsSNB && 0 == startAddress[0] && 0x0c0c0c00 == startAddress[1]))
-			return reinterpret_cast<uint8_t *>(startAddress) - startingAddress + sizeof(uint32_t)*2;
-		startAddress++;
-	}
-
-	return maxSize; // in case of no termination, just return maxSize
-}
-
-void IGFX::writePlatformListData(const char *subKeyName) {
-	if (BaseDeviceInfo::get().cpuGeneration < CPUInfo::CpuGeneration::SandyBridge) {
-		DBGLOG("igfx", "writePlatformListData unsupported below Sandy bridge");
-		return;
-	}
-	
-	auto entry = IORegistryEntry::fromPath("IOService:/IOResources/WhateverGreen");
-	if (entry) {
-		entry->setProperty(subKeyName, gPlatformInformationList, static_cast<unsigned>(calculatePlatformListSize(PAGE_SIZE)));
-		entry->release();
-	}
-}
-#endif
-
-bool IGFX::applyPatch(const KernelPatcher::LookupPatch &patch, uint8_t *startingAddress, size_t maxSize) {
-	size_t i = 0, changes = 0;
-	uint8_t *currentAddress = startingAddress;
-	uint8_t *endingAddress = startingAddress + maxSize - patch.size;
-
-	if (currentAddress < framebufferStart)
-		currentAddress = framebufferStart;
-	if (endingAddress > framebufferStart + framebufferSize)
-		endingAddress = framebufferStart + framebufferSize;
-
-	while (currentAddress < endingAddress) {
-		for (i = 0; i < patch.size; i++) {
-			uint8_t mask = patch.maskFind ? patch.maskFind[i] : 0xFF;
-			if ((currentAddress[i] & mask) != (patch.find[i] & mask))
-				break;
-		}
-		if (i == patch.size) {
-			for (i = 0; i < patch.size; i++) {
-				uint8_t mask = patch.maskReplace ? patch.maskReplace[i] : 0xFF;
-				currentAddress[i] = (currentAddress[i] & ~mask) | (patch.replace[i] & mask);
-			}
-			changes++;
-			if (patch.count && changes >= patch.count)
-				break;
-			currentAddress += patch.size;
-		}
-		else
-			currentAddress++;
-	}
-
-	return changes > 0;
-}
-
 bool IGFX::setDictUInt32(OSDictionary *dict, const char *key, UInt32 value) {
 	auto *num = OSNumber::withNumber(value, sizeof(UInt32));
 	if (!num)
@@ -1824,327 +1823,6 @@ bool IGFX::setDictUInt32(OSDictionary *dict, const char *key, UInt32 value) {
 	return success;
 }
 
-template <>
-bool IGFX::applyPlatformInformationListPatch(uint32_t framebufferId, FramebufferSNB *platformInformationList) {
-	bool framebufferFound = false;
-
-	for (size_t i = 0; i < SandyPlatformNum; i++) {
-		if (sandyPlatformId[i] == framebufferId) {
-			if (framebufferPatchFlags.bits.FPFMobile)
-				platformInformationList[i].fMobile = framebufferPatch.fMobile;
-
-			if (framebufferPatchFlags.bits.FPFPipeCount)
-				platformInformationList[i].fPipeCount = framebufferPatch.fPipeCount;
-
-			if (framebufferPatchFlags.bits.FPFPortCount)
-				platformInformationList[i].fPortCount = framebufferPatch.fPortCount;
-
-			if (framebufferPatchFlags.bits.FPFFBMemoryCount)
-				platformInformationList[i].fFBMemoryCount = framebufferPatch.fFBMemoryCount;
-
-			for (size_t j = 0; j < arrsize(platformInformationList[i].connectors); j++) {
-				if (connectorPatchFlags[j].bits.CPFIndex)
-					platformInformationList[i].connectors[j].index = framebufferPatch.connectors[j].index;
-
-				if (connectorPatchFlags[j].bits.CPFBusId)
-					platformInformationList[i].connectors[j].busId = framebufferPatch.connectors[j].busId;
-
-				if (connectorPatchFlags[j].bits.CPFPipe)
-					platformInformationList[i].connectors[j].pipe = framebufferPatch.connectors[j].pipe;
-
-				if (connectorPatchFlags[j].bits.CPFType)
-					platformInformationList[i].connectors[j].type = framebufferPatch.connectors[j].type;
-
-				if (connectorPatchFlags[j].bits.CPFFlags)
-					platformInformationList[i].connectors[j].flags = framebufferPatch.connectors[j].flags;
-
-				if (connectorPatchFlags[j].value) {
-					DBGLOG("igfx", "patching framebufferId 0x%08X connector [%d] busId: 0x%02X, pipe: %u, type: 0x%08X, flags: 0x%08X", framebufferId, platformInformationList[i].connectors[j].index, platformInformationList[i].connectors[j].busId, platformInformationList[i].connectors[j].pipe, platformInformationList[i].connectors[j].type, platformInformationList[i].connectors[j].flags.value);
-
-					framebufferFound = true;
-				}
-			}
-
-			if (framebufferPatchFlags.value) {
-				DBGLOG("igfx", "patching framebufferId 0x%08X", framebufferId);
-				DBGLOG("igfx", "mobile: 0x%08X", platformInformationList[i].fMobile);
-				DBGLOG("igfx", "pipeCount: %u", platformInformationList[i].fPipeCount);
-				DBGLOG("igfx", "portCount: %u", platformInformationList[i].fPortCount);
-				DBGLOG("igfx", "fbMemoryCount: %u", platformInformationList[i].fFBMemoryCount);
-
-				framebufferFound = true;
-			}
-		}
-	}
-
-	return framebufferFound;
-}
-
-// Sandy and Ivy have no flags
-template <>
-void IGFX::applyPlatformInformationPatchEx(FramebufferSNB *frame) {}
-
-template <>
-void IGFX::applyPlatformInformationPatchEx(FramebufferIVB *frame) {}
-
-template <>
-void IGFX::applyPlatformInformationPatchEx(FramebufferHSW *frame) {
-	// fCursorMemorySize is Haswell specific
-	if (framebufferPatchFlags.bits.FPFFramebufferCursorSize) {
-		frame->fCursorMemorySize = fPatchCursorMemorySize;
-		DBGLOG("igfx", "fCursorMemorySize: 0x%08X", frame->fCursorMemorySize);
-	}
-
-	if (framebufferPatchFlags.bits.FPFFlags)
-		frame->flags.value = framebufferPatch.flags.value;
-
-	if (framebufferPatchFlags.bits.FPFCamelliaVersion)
-		frame->camelliaVersion = framebufferPatch.camelliaVersion;
-}
-
-template <typename T>
-void IGFX::applyPlatformInformationPatchEx(T *frame) {
-	if (framebufferPatchFlags.bits.FPFFlags)
-		frame->flags.value = framebufferPatch.flags.value;
-
-
-	if (framebufferPatchFlags.bits.FPFCamelliaVersion)
-		frame->camelliaVersion = framebufferPatch.camelliaVersion;
-}
-
-template <typename T>
-bool IGFX::applyPlatformInformationListPatch(uint32_t framebufferId, T *platformInformationList) {
-	auto frame = reinterpret_cast<T *>(findFramebufferId(framebufferId, reinterpret_cast<uint8_t *>(platformInformationList), PAGE_SIZE));
-	if (!frame)
-		return false;
-
-	bool r = false;
-
-	if (framebufferPatchFlags.bits.FPFMobile)
-		frame->fMobile = framebufferPatch.fMobile;
-
-	if (framebufferPatchFlags.bits.FPFPipeCount)
-		frame->fPipeCount = framebufferPatch.fPipeCount;
-
-	if (framebufferPatchFlags.bits.FPFPortCount)
-		frame->fPortCount = framebufferPatch.fPortCount;
-
-	if (framebufferPatchFlags.bits.FPFFBMemoryCount)
-		frame->fFBMemoryCount = framebufferPatch.fFBMemoryCount;
-
-	if (framebufferPatchFlags.bits.FPFStolenMemorySize)
-		frame->fStolenMemorySize = framebufferPatch.fStolenMemorySize;
-
-	if (framebufferPatchFlags.bits.FPFFramebufferMemorySize)
-		frame->fFramebufferMemorySize = framebufferPatch.fFramebufferMemorySize;
-
-	if (framebufferPatchFlags.bits.FPFUnifiedMemorySize)
-		frame->fUnifiedMemorySize = framebufferPatch.fUnifiedMemorySize;
-
-	if (framebufferPatchFlags.value) {
-		DBGLOG("igfx", "patching framebufferId 0x%08X", frame->framebufferId);
-		DBGLOG("igfx", "mobile: 0x%08X", frame->fMobile);
-		DBGLOG("igfx", "pipeCount: %u", frame->fPipeCount);
-		DBGLOG("igfx", "portCount: %u", frame->fPortCount);
-		DBGLOG("igfx", "fbMemoryCount: %u", frame->fFBMemoryCount);
-		DBGLOG("igfx", "stolenMemorySize: 0x%08X", frame->fStolenMemorySize);
-		DBGLOG("igfx", "framebufferMemorySize: 0x%08X", frame->fFramebufferMemorySize);
-		DBGLOG("igfx", "unifiedMemorySize: 0x%08X", frame->fUnifiedMemorySize);
-
-		r = true;
-	}
-
-	applyPlatformInformationPatchEx(frame);
-
-	for (size_t j = 0; j < arrsize(frame->connectors); j++) {
-		if (connectorPatchFlags[j].bits.CPFIndex)
-			frame->connectors[j].index = framebufferPatch.connectors[j].index;
-
-		if (connectorPatchFlags[j].bits.CPFBusId)
-			frame->connectors[j].busId = framebufferPatch.connectors[j].busId;
-
-		if (connectorPatchFlags[j].bits.CPFPipe)
-			frame->connectors[j].pipe = framebufferPatch.connectors[j].pipe;
-
-		if (connectorPatchFlags[j].bits.CPFType)
-			frame->connectors[j].type = framebufferPatch.connectors[j].type;
-
-		if (connectorPatchFlags[j].bits.CPFFlags)
-			frame->connectors[j].flags = framebufferPatch.connectors[j].flags;
-
-		if (connectorPatchFlags[j].value) {
-			DBGLOG("igfx", "patching framebufferId 0x%08X connector [%d] busId: 0x%02X, pipe: %u, type: 0x%08X, flags: 0x%08X", frame->framebufferId, frame->connectors[j].index, frame->connectors[j].busId, frame->connectors[j].pipe, frame->connectors[j].type, frame->connectors[j].flags.value);
-
-			r = true;
-		}
-	}
-
-	return r;
-}
-
-template <>
-bool IGFX::applyDPtoHDMIPatch(uint32_t framebufferId, FramebufferSNB *platformInformationList) {
-	bool found = false;
-
-	for (size_t i = 0; i < SandyPlatformNum; i++) {
-		if (sandyPlatformId[i] == framebufferId) {
-			for (size_t j = 0; j < arrsize(platformInformationList[i].connectors); j++) {
-				DBGLOG("igfx", "snb connector [%lu] busId: 0x%02X, pipe: %d, type: 0x%08X, flags: 0x%08X", j, platformInformationList[i].connectors[j].busId, platformInformationList[i].connectors[j].pipe,
-					   platformInformationList[i].connectors[j].type, platformInformationList[i].connectors[j].flags.value);
-
-				if (platformInformationList[i].connectors[j].type == ConnectorDP) {
-					platformInformationList[i].connectors[j].type = ConnectorHDMI;
-					DBGLOG("igfx", "replaced snb connector %lu type from DP to HDMI", j);
-					found = true;
-				}
-			}
-		}
-	}
-
-	return found;
-}
-
-template <typename T>
-bool IGFX::applyDPtoHDMIPatch(uint32_t framebufferId, T *platformInformationList) {
-	auto frame = reinterpret_cast<T *>(findFramebufferId(framebufferId, reinterpret_cast<uint8_t *>(platformInformationList), PAGE_SIZE));
-	if (!frame)
-		return false;
-
-	bool found = false;
-	for (size_t i = 0; i < arrsize(frame->connectors); i++) {
-		DBGLOG("igfx", "connector [%lu] busId: 0x%02X, pipe: %d, type: 0x%08X, flags: 0x%08X", i, platformInformationList[i].connectors[i].busId, platformInformationList[i].connectors[i].pipe,
-			   platformInformationList[i].connectors[i].type, platformInformationList[i].connectors[i].flags.value);
-
-		if (frame->connectors[i].type == ConnectorDP) {
-			frame->connectors[i].type = ConnectorHDMI;
-			DBGLOG("igfx", "replaced connector %lu type from DP to HDMI", i);
-			found = true;
-		}
-	}
-
-	return found;
-}
-
-void IGFX::applyFramebufferPatches() {
-	auto cpuGeneration = BaseDeviceInfo::get().cpuGeneration;
-	uint32_t framebufferId = framebufferPatch.framebufferId;
-
-	// Not tested prior to 10.10.5, and definitely different on 10.9.5 at least.
-	if (getKernelVersion() >= KernelVersion::Yosemite) {
-		bool success = false;
-		if (cpuGeneration == CPUInfo::CpuGeneration::SandyBridge)
-			success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferSNB *>(gPlatformInformationList));
-		else if (cpuGeneration == CPUInfo::CpuGeneration::IvyBridge)
-			success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferIVB *>(gPlatformInformationList));
-		else if (cpuGeneration == CPUInfo::CpuGeneration::Haswell)
-			success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferHSW *>(gPlatformInformationList));
-		else if (cpuGeneration == CPUInfo::CpuGeneration::Broadwell)
-			success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferBDW *>(gPlatformInformationList));
-		else if (cpuGeneration == CPUInfo::CpuGeneration::Skylake || cpuGeneration == CPUInfo::CpuGeneration::KabyLake ||
-				 (cpuGeneration == CPUInfo::CpuGeneration::CoffeeLake && static_cast<FramebufferSKL *>(gPlatformInformationList)->framebufferId == 0x591E0000))
-			//FIXME: write this in a nicer way (coffee pretending to be Kaby, detecting via first kaby frame)
-			success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferSKL *>(gPlatformInformationList));
-		else if (cpuGeneration == CPUInfo::CpuGeneration::CoffeeLake)
-			success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferCFL *>(gPlatformInformationList));
-		else if (cpuGeneration == CPUInfo::CpuGeneration::CometLake)
-			success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferCFL *>(gPlatformInformationList));
-		else if (cpuGeneration == CPUInfo::CpuGeneration::CannonLake)
-			success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferCNL *>(gPlatformInformationList));
-		else if (cpuGeneration == CPUInfo::CpuGeneration::IceLake) {
-			// FIXME: Need to address possible circumstance of both ICL kexts loaded at the same time
-			if (callbackIGFX->currentFramebuffer->loadIndex != KernelPatcher::KextInfo::Unloaded)
-				success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferICLLP *>(gPlatformInformationList));
-			else if (callbackIGFX->currentFramebufferOpt->loadIndex != KernelPatcher::KextInfo::Unloaded)
-				success = applyPlatformInformationListPatch(framebufferId, static_cast<FramebufferICLHP *>(gPlatformInformationList));
-		}
-
-		if (success)
-			DBGLOG("igfx", "patching framebufferId 0x%08X successful", framebufferId);
-		else
-			DBGLOG("igfx", "patching framebufferId 0x%08X failed", framebufferId);
-	}
-
-	uint8_t *platformInformationAddress = findFramebufferId(framebufferId, static_cast<uint8_t *>(gPlatformInformationList), PAGE_SIZE);
-	if (platformInformationAddress) {
-		for (size_t i = 0; i < MaxFramebufferPatchCount; i++) {
-			if (!framebufferPatches[i].find || !framebufferPatches[i].replace)
-				continue;
-
-			if (framebufferPatches[i].framebufferId != framebufferId) {
-				framebufferId = framebufferPatches[i].framebufferId;
-				platformInformationAddress = findFramebufferId(framebufferId, static_cast<uint8_t *>(gPlatformInformationList), PAGE_SIZE);
-			}
-
-			if (!platformInformationAddress) {
-				DBGLOG("igfx", "patch %lu framebufferId 0x%08X not found", i, framebufferId);
-				continue;
-			}
-
-			if (framebufferPatches[i].find->getLength() != framebufferPatches[i].replace->getLength()) {
-				DBGLOG("igfx", "patch %lu framebufferId 0x%08X length mistmatch", i, framebufferId);
-				continue;
-			}
-
-			KernelPatcher::LookupPatch patch {};
-			patch.kext = currentFramebuffer;
-			patch.find = static_cast<const uint8_t *>(framebufferPatches[i].find->getBytesNoCopy());
-			patch.replace = static_cast<const uint8_t *>(framebufferPatches[i].replace->getBytesNoCopy());
-			patch.size = framebufferPatches[i].find->getLength();
-			patch.count = framebufferPatches[i].count;
-			patch.maskFind = nullptr;
-			patch.maskReplace = nullptr;
-
-			if (applyPatch(patch, platformInformationAddress, PAGE_SIZE))
-				DBGLOG("igfx", "patch %lu framebufferId 0x%08X successful", i, framebufferId);
-			else
-				DBGLOG("igfx", "patch %lu framebufferId 0x%08X failed", i, framebufferId);
-
-			framebufferPatches[i].find->release();
-			framebufferPatches[i].find = nullptr;
-			framebufferPatches[i].replace->release();
-			framebufferPatches[i].replace = nullptr;
-		}
-	}
-}
-
-void IGFX::applyHdmiAutopatch() {
-	auto cpuGeneration = BaseDeviceInfo::get().cpuGeneration;
-	uint32_t framebufferId = framebufferPatch.framebufferId;
-
-	DBGLOG("igfx", "applyHdmiAutopatch framebufferId %X cpugen %X", framebufferId, cpuGeneration);
-
-	bool success = false;
-	if (cpuGeneration == CPUInfo::CpuGeneration::SandyBridge)
-		success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferSNB *>(gPlatformInformationList));
-	else if (cpuGeneration == CPUInfo::CpuGeneration::IvyBridge)
-		success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferIVB *>(gPlatformInformationList));
-	else if (cpuGeneration == CPUInfo::CpuGeneration::Haswell)
-		success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferHSW *>(gPlatformInformationList));
-	else if (cpuGeneration == CPUInfo::CpuGeneration::Broadwell)
-		success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferBDW *>(gPlatformInformationList));
-	else if (cpuGeneration == CPUInfo::CpuGeneration::Skylake || cpuGeneration == CPUInfo::CpuGeneration::KabyLake ||
-			 (cpuGeneration == CPUInfo::CpuGeneration::CoffeeLake && static_cast<FramebufferSKL *>(gPlatformInformationList)->framebufferId == 0x591E0000))
-		success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferSKL *>(gPlatformInformationList));
-	else if (cpuGeneration == CPUInfo::CpuGeneration::CoffeeLake)
-		success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferCFL *>(gPlatformInformationList));
-	else if (cpuGeneration == CPUInfo::CpuGeneration::CometLake)
-		success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferCFL *>(gPlatformInformationList));
-	else if (cpuGeneration == CPUInfo::CpuGeneration::CannonLake)
-		success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferCNL *>(gPlatformInformationList));
-	else if (cpuGeneration == CPUInfo::CpuGeneration::IceLake) {
-		// FIXME: Need to address possible circumstance of both ICL kexts loaded at the same time
-		if (callbackIGFX->currentFramebuffer->loadIndex != KernelPatcher::KextInfo::Unloaded)
-			success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferICLLP *>(gPlatformInformationList));
-		else if (callbackIGFX->currentFramebufferOpt->loadIndex != KernelPatcher::KextInfo::Unloaded)
-			success = applyDPtoHDMIPatch(framebufferId, static_cast<FramebufferICLHP *>(gPlatformInformationList));
-	}
-
-	if (success)
-		DBGLOG("igfx", "hdmi patching framebufferId 0x%08X successful", framebufferId);
-	else
-		DBGLOG("igfx", "hdmi patching framebufferId 0x%08X failed", framebufferId);
-}
-
 void IGFX::applyWestmerePatches(KernelPatcher &patcher) {
 	auto kernelVersion = getKernelVersion();
 	DBGLOG("igfx", "applyWestmerePatches kernel version %u", kernelVersion);
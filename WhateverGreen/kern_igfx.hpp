@@ -169,6 +169,33 @@ private:
 	 *  Framebuffer find / replace patches
 	 */
 	FramebufferPatch framebufferPatches[MaxFramebufferPatchCount] {};
+
+	/**
+	 *  Maximum framebuffers edited in one platform list pass, the patched one and one per find / replace batch
+	 */
+	static constexpr size_t MaxFramebufferPlanCount = MaxFramebufferPatchCount + 1;
+
+	/**
+	 *  Edits to one framebuffer of gPlatformInformationList, compiled before the list is walked
+	 */
+	struct FramebufferPlanEntry {
+		uint32_t framebufferId;
+		uint8_t *address;      // first occurrence in gPlatformInformationList or nullptr
+		bool patchFields;      // framebufferPatch fields and connectors
+		bool patchDPtoHDMI;    // DP to HDMI connector type changes
+		size_t batchStart;     // first find / replace patch in FramebufferPlan::batches
+		size_t batchNum;       // number of find / replace patches
+	};
+
+	/**
+	 *  All platform list edits in the order they are applied
+	 */
+	struct FramebufferPlan {
+		FramebufferPlanEntry entries[MaxFramebufferPlanCount];
+		size_t num;
+		size_t batches[MaxFramebufferPatchCount];
+		size_t batchNum;
+	};
 	
 	/**
 	 *  Framebuffer patches for first generation (Westmere).
@@ -211,6 +238,30 @@ private:
 	 */
 	bool gPlatformListIsSNB {false};
 
+	/**
+	 *  Slots in the framebuffer id index, a power of two well above the number of frames in a platform list
+	 */
+	static constexpr size_t FramebufferIndexSize = 64;
+
+	/**
+	 *  Framebuffer id index slot, open addressing with linear probing
+	 */
+	struct FramebufferIndexSlot {
+		uint32_t framebufferId;
+		uint16_t offset;   // offset of the frame in gPlatformInformationList
+		bool used;
+	};
+
+	/**
+	 *  Framebuffer id index of gPlatformInformationList, built on first lookup
+	 */
+	FramebufferIndexSlot framebufferIndex[FramebufferIndexSize] {};
+
+	/**
+	 *  Framebuffer id index was built
+	 */
+	bool framebufferIndexBuilt {false};
+
 	/**
 	 *  IGPU support
 	 */
@@ -371,16 +422,11 @@ private:
 		 */
 		I injector {};
 
-		/**
-		 *  A pointer to the next descriptor in a linked list
-		 */
-		InjectionDescriptor *next {nullptr};
-
 		/**
 		 *  Create an injection descriptor conveniently
 		 */
 		InjectionDescriptor(T t, I i) :
-			trigger(t), injector(i), next(nullptr) { }
+			trigger(t), injector(i) { }
 		
 		/**
 		 *  Member type `Trigger` is required by the coordinator
@@ -397,19 +443,38 @@ private:
 	 *  Represents a list of injection descriptors
 	 *
 	 *  @tparam D Specify the concrete type of the descriptor
+	 *  @note Descriptors are stored in an open addressing table indexed by the trigger value,
+	 *        so that looking up a trigger without an injector usually takes a single probe.
+	 *        The trigger type must be an integral type, e.g. a register address.
 	 */
 	template <typename D>
 	struct InjectionDescriptorList {
+		/**
+		 *  Maximum number of descriptors in the list, must be a power of two
+		 */
+		static constexpr size_t MaxDescriptors = 16;
+
 	private:
 		/**
-		 *  Head of the list
+		 *  Descriptor slots, unused slots are `nullptr`
 		 */
-		D *head {nullptr};
-		
+		D *slots[MaxDescriptors] {};
+
+		/**
+		 *  Number of registered descriptors
+		 */
+		size_t count {0};
+
 		/**
-		 *  Tail of the list
+		 *  Get the preferred slot of the given trigger
+		 *
+		 *  @param trigger The trigger value
+		 *  @return The slot index.
+		 *  @note Register addresses are dword aligned, hence the lowest bits are dropped.
 		 */
-		D *tail {nullptr};
+		static size_t slotOf(typename D::Trigger trigger) {
+			return (static_cast<size_t>(trigger) >> 2) & (MaxDescriptors - 1);
+		}
 		
 	public:
 		/**
@@ -419,9 +484,13 @@ private:
 		 *  @return The injector function on success, `nullptr` if the given trigger is not in the list.
 		 */
 		typename D::Injector getInjector(typename D::Trigger trigger) {
-			for (auto current = head; current != nullptr; current = current->next)
+			for (size_t i = slotOf(trigger), probes = 0; probes < count; i = (i + 1) & (MaxDescriptors - 1), probes++) {
+				auto current = slots[i];
+				if (current == nullptr)
+					break;
 				if (current->trigger == trigger)
 					return current->injector;
+			}
 			
 			return nullptr;
 		}
@@ -433,22 +502,24 @@ private:
 		 *  @warning Patch developers must ensure that triggers are unique.
 		 *           The coordinator registers injections on a first come, first served basis.
 		 *           i.e. The latter descriptor will NOT overwrite the injection function of the existing one.
-		 *  @note This function assumes that the trigger value of the given descriptor has not been registered yet.
+		 *  @note Descriptors must be registered before the coordinated function is invoked for the first time.
 		 */
 		void add(D *descriptor NONNULL) {
-			// Sanitize garbage value
-			descriptor->next = nullptr;
+			if (count == MaxDescriptors) {
+				SYSLOG("igfx", "Injection descriptor list is full, trigger 0x%llx is ignored.", static_cast<uint64_t>(descriptor->trigger));
+				return;
+			}
 			
-			// Append the new descriptor
-			if (head == nullptr)
-				// Empty list
-				head = descriptor;
-			else
-				// Non-empty list
-				tail->next = descriptor;
+			// Find the first free slot, keeping the existing injector of a duplicate trigger
+			size_t i = slotOf(descriptor->trigger);
+			while (slots[i] != nullptr) {
+				if (slots[i]->trigger == descriptor->trigger)
+					return;
+				i = (i + 1) & (MaxDescriptors - 1);
+			}
 			
-			// Update the tail
-			tail = descriptor;
+			slots[i] = descriptor;
+			count++;
 		}
 	};
 	
@@ -820,6 +891,39 @@ private:
 		 */
 		IORegistryEntry *(*orgICLGetFBFromPort)(AppleIntelFramebufferController *, AppleIntelPort *) {nullptr};
 		
+		/**
+		 *  Original AppleIntelFramebuffer::doSetPowerState function
+		 *
+		 *  @seealso Refer to the document of `wrapDoSetPowerState()` below.
+		 */
+		IOReturn (*orgDoSetPowerState)(IOService *, uint32_t) {nullptr};
+		
+		/**
+		 *  Number of immutable DPCD ranges mirrored by the shadow
+		 */
+		static constexpr size_t DPCDShadowRangeCount = 4;
+		
+		/**
+		 *  Size of the largest DPCD range mirrored by the shadow
+		 */
+		static constexpr size_t DPCDShadowRangeSize = 16;
+		
+		/**
+		 *  [Common] Shadow of the immutable DPCD ranges of the builtin display
+		 *
+		 *  @note Each range is filled by the first successful read covering it.
+		 *  @note The shadow is dropped on framebuffer power state changes and on failed AUX transactions.
+		 */
+		struct {
+			uint8_t bytes[DPCDShadowRangeCount][DPCDShadowRangeSize];
+			bool valid[DPCDShadowRangeCount];
+		} shadow {};
+		
+		/**
+		 *  [Common] Set once the power state wrapper is in place, the shadow is never used otherwise
+		 */
+		bool shadowEnabled {false};
+		
 		/**
 		 *  [CFL-] ReadAUX wrapper to modify the maximum link rate value in the DPCD buffer
 		 *
@@ -868,6 +972,41 @@ private:
 		 */
 		IOReturn orgReadAUX(uint32_t address, void* buffer, uint32_t length);
 		
+		/**
+		 *  [Common] Read from DPCD of the builtin display, using the shadow for immutable ranges
+		 *
+		 *  @param address DPCD register address
+		 *  @param buffer A non-null buffer to store bytes read from DPCD
+		 *  @param length Specify the number of bytes read from the register at `address`
+		 *  @return `kIOReturnSuccess` on success, other values otherwise.
+		 *  @note The caller must ensure that the current framebuffer is the builtin one.
+		 */
+		IOReturn readBuiltinDPCD(uint32_t address, void *buffer, uint32_t length);
+		
+		/**
+		 *  [Common] Find the shadowed bytes that can serve a DPCD read
+		 *
+		 *  @param address DPCD register address
+		 *  @param length Specify the number of bytes read from the register at `address`
+		 *  @return The shadowed bytes at `address` if a filled range covers the read, `NULL` otherwise.
+		 */
+		const uint8_t *findShadowRange(uint32_t address, uint32_t length);
+		
+		/**
+		 *  [Common] Drop every range of the DPCD shadow
+		 */
+		void invalidateShadow();
+		
+		/**
+		 *  [Common] AppleIntelFramebuffer::doSetPowerState wrapper to drop the DPCD shadow on sleep and wake
+		 *
+		 *  @param that The framebuffer instance
+		 *  @param state The new power state
+		 *  @return The value returned by the original function.
+		 *  @note Not routed when the framebuffer debug support wraps the same function, see `onPowerStateChange()`.
+		 */
+		static IOReturn wrapDoSetPowerState(IOService *that, uint32_t state);
+		
 		/**
 		 *  [Common] Retrieve the framebuffer index
 		 *
@@ -917,8 +1056,23 @@ private:
 		 */
 		void processFramebufferKextForICL(KernelPatcher &patcher, size_t index, mach_vm_address_t address, size_t size);
 		
-		// MARK: Patch Submodule IMP
 	public:
+		/**
+		 *  [Common] Report whether AppleIntelFramebuffer::doSetPowerState is routed, the shadow is only used if it is
+		 *
+		 *  @param hooked `true` if a doSetPowerState wrapper calls `onPowerStateChange()`, `false` otherwise.
+		 */
+		void onPowerStateHooked(bool hooked);
+		
+		/**
+		 *  [Common] Drop the DPCD shadow before a framebuffer power state change
+		 *
+		 *  @param state The new power state
+		 *  @note Called by whichever submodule owns the single doSetPowerState route.
+		 */
+		void onPowerStateChange(uint32_t state);
+		
+		// MARK: Patch Submodule IMP
 		void init() override;
 		void processKernel(KernelPatcher &patcher, DeviceInfo *info) override;
 		void processFramebufferKext(KernelPatcher &patcher, size_t index, mach_vm_address_t address, size_t size) override;
@@ -1004,6 +1158,105 @@ private:
 			uint32_t kdiv {0};
 		};
 		
+		/**
+		 *  Represents the final CRTC parameters computed for a pixel clock
+		 */
+		struct CachedDividers {
+			/// Odd while a writer updates the entry
+			uint32_t sequence {0};
+
+			/// The pixel clock value (in Hz), 0 if the entry is unused
+			uint32_t pixelClock {0};
+
+			/// The last time this entry was used, in terms of `cacheClock`
+			uint32_t lastUse {0};
+
+			/// The pdiv value [P0]
+			uint32_t pdiv {0};
+
+			/// The qdiv value [P1]
+			uint32_t qdiv {0};
+
+			/// The kdiv value [P2]
+			uint32_t kdiv {0};
+
+			/// Multiplier of 24 MHz
+			uint32_t multiplier {0};
+
+			/// Difference in Hz
+			uint32_t fraction {0};
+
+			/// Central frequency / 15625
+			uint32_t cf15625 {0};
+		};
+
+		/**
+		 *  Number of pixel clocks remembered by the dividers cache
+		 */
+		static constexpr size_t DividersCacheSize = 8;
+
+		/**
+		 *  Recently computed CRTC parameters, least recently used entries are evicted first
+		 *
+		 *  @note Readers do not lock: each entry is a seqlock, and writers are serialized by `cacheWriting`.
+		 */
+		CachedDividers dividersCache[DividersCacheSize] {};
+
+		/**
+		 *  `true` while a writer updates the cache
+		 */
+		bool cacheWriting {false};
+
+		/**
+		 *  Monotonic counter used to order cache entries by their last use
+		 */
+		uint32_t cacheClock {0};
+
+		/**
+		 *  Number of pixel clocks found in the cache
+		 */
+		uint32_t cacheHits {0};
+
+		/**
+		 *  Number of pixel clocks that had to be computed
+		 */
+		uint32_t cacheMisses {0};
+
+		/**
+		 *  Published cache hit counter, updated in place
+		 */
+		OSNumber *cacheHitsNumber {nullptr};
+
+		/**
+		 *  Published cache miss counter, updated in place
+		 */
+		OSNumber *cacheMissesNumber {nullptr};
+
+		/**
+		 *  [Helper] Find the cached CRTC parameters of the given pixel clock
+		 *
+		 *  @param pixelClock The pixel clock value (in Hz)
+		 *  @param result A copy of the cache entry on success
+		 *  @return `true` if the pixel clock is cached, `false` otherwise.
+		 */
+		bool lookupDividers(uint32_t pixelClock, CachedDividers &result);
+
+		/**
+		 *  [Helper] Remember the CRTC parameters of the given pixel clock, evicting the least recently used entry
+		 *
+		 *  @param entry The CRTC parameters to be cached, `pixelClock` must not be 0.
+		 *  @note The entry is dropped if another writer is updating the cache.
+		 */
+		void storeDividers(const CachedDividers &entry);
+
+		/**
+		 *  [Helper] Publish the cache hit and miss counters in the I/O registry
+		 *
+		 *  @param igpu The IGPU entry that receives the `fw-hdmi-dividers-cache` dictionary
+		 *  @note The counters are created once and updated in place by `wrapComputeHdmiP0P1P2`.
+		 */
+		void publishCacheStatistics(IORegistryEntry *igpu);
+
 		/**
 		 *  [Helper] Compute the final P0, P1, P2 values based on the current frequency divider
 		 *
@@ -1062,6 +1315,58 @@ private:
 		 */
 		IOReturn (*orgWriteI2COverAUX)(void *, IORegistryEntry *, void *, uint32_t, uint16_t, uint8_t *, bool) {nullptr};
 		
+		/**
+		 *  Context shared by all AUX transactions of an advanced I2C-over-AUX transfer
+		 */
+		struct Transfer {
+			void *that;
+			IORegistryEntry *framebuffer;
+			void *displayPath;
+			uint32_t address;
+			uint8_t flags;
+			uint32_t index; // Framebuffer index, only resolved for verbose output
+		};
+		
+		/**
+		 *  Create the context of an advanced I2C-over-AUX transfer
+		 *
+		 *  @note The framebuffer index is looked up once per transfer and only when verbose output is enabled.
+		 */
+		Transfer beginTransfer(void *that, IORegistryEntry *framebuffer, void *displayPath, uint32_t address, uint8_t flags);
+		
+		/**
+		 *  Perform a single I2C-over-AUX read of a transfer
+		 *
+		 *  @param transfer The transfer context
+		 *  @param length The number of bytes requested to read, must be <= 16
+		 *  @param buffer A buffer to store the read bytes
+		 *  @param intermediate Set `true` to keep the Middle-of-Transaction bit set
+		 *  @return `kIOReturnSuccess` on success, other values otherwise.
+		 *  @note Calls the original function directly, verbose output logs the request before it and the result only on failure.
+		 */
+		IOReturn transferRead(const Transfer &transfer, uint16_t length, uint8_t *buffer, bool intermediate);
+		
+		/**
+		 *  Perform a single I2C-over-AUX write of a transfer
+		 *
+		 *  @param transfer The transfer context
+		 *  @param length The number of bytes requested to write, must be <= 16
+		 *  @param buffer A buffer that stores the bytes to write
+		 *  @param intermediate Set `true` to keep the Middle-of-Transaction bit set
+		 *  @return `kIOReturnSuccess` on success, other values otherwise.
+		 *  @note Calls the original function directly, verbose output logs the request before it and the result only on failure.
+		 */
+		IOReturn transferWrite(const Transfer &transfer, uint16_t length, uint8_t *buffer, bool intermediate);
+		
+		/**
+		 *  Start the transfer and set the offset of the next register to access
+		 *
+		 *  @param transfer The transfer context
+		 *  @param offset The address of the next register to access
+		 *  @return `kIOReturnSuccess` on success, other values otherwise.
+		 */
+		IOReturn transferSeek(const Transfer &transfer, uint32_t offset);
+		
 	public:
 		/// MARK: I2C-over-AUX Transaction APIs
 
@@ -2204,6 +2509,26 @@ private:
 		 */
 		static constexpr uint32_t kMinimumQueueSize = 32;
 		
+		/**
+		 *  Brightness changes by the same amount at each step
+		 */
+		static constexpr uint32_t kCurveLinear = 0;
+		
+		/**
+		 *  Brightness changes quickly at first and slows down when approaching the target
+		 */
+		static constexpr uint32_t kCurveEaseOut = 1;
+		
+		/**
+		 *  Brightness changes linearly in a gamma 2.0 corrected space to look uniform to the human eye
+		 */
+		static constexpr uint32_t kCurveGamma = 2;
+		
+		/**
+		 *  Default easing curve of the transition
+		 */
+		static constexpr uint32_t kDefaultCurve = kCurveLinear;
+		
 		/**
 		 *  The total number of steps to reach the target duty value
 		 */
@@ -2224,6 +2549,11 @@ private:
 		 */
 		uint32_t queueSize {kDefaultQueueSize};
 		
+		/**
+		 *  The easing curve of the transition
+		 */
+		uint32_t curve {kDefaultCurve};
+		
 		/**
 		 *  The range of the brightness level (represented as register values)
 		 */
@@ -2235,9 +2565,9 @@ private:
 		OSObject *owner {nullptr};
 
 		/**
-		 *  A list of pending brightness adjustment requests
+		 *  A queue of pending brightness adjustment requests
 		 */
-		BrightnessRequest request;
+		BrightnessRequestQueue queue;
 
 		/**
 		 *  A workloop that provides a kernel thread to adjust the brightness
@@ -2249,6 +2579,47 @@ private:
 		 */
 		BrightnessRequestEventSource *eventSource {nullptr};
 
+		/**
+		 *  A timer event source that performs one step of the current transition at each tick
+		 */
+		IOTimerEventSource *timer {nullptr};
+		
+		/**
+		 *  The current brightness transition, only accessed on the workloop
+		 */
+		BrightnessTransition transition;
+		
+		/**
+		 *  Calculate the brightness level at the given step of the current transition
+		 *
+		 *  @param step The step index, must not exceed the total number of steps
+		 *  @return The brightness level shaped by the configured easing curve.
+		 */
+		uint32_t getTransitionBrightness(uint32_t step);
+		
+		/**
+		 *  Start a new transition or steer the ongoing one towards the given request
+		 *
+		 *  @param request The latest brightness request
+		 *  @note This function must be invoked on the workloop.
+		 */
+		void processRequest(const BrightnessRequest &request);
+		
+		/**
+		 *  Write the next brightness level of the current transition and schedule the following one
+		 *
+		 *  @note This function must be invoked on the workloop.
+		 */
+		void advanceTransition();
+		
+		/**
+		 *  Invoked by the timer event source on the workloop when the next step is due
+		 *
+		 *  @param owner The owner of the timer event source
+		 *  @param sender The timer event source
+		 */
+		static void onTransitionTimer(OSObject *owner, IOTimerEventSource *sender);
+
 		/**
 		 *  [IVB ] Wrapper to write to BLC_PWM_CPU_CTL smoothly
 		 *
@@ -2297,6 +2668,11 @@ private:
 	 *  A submodule to provide support for debugging the framebuffer driver
 	 */
 	class FramebufferDebugSupport: public PatchSubmodule {
+		/**
+		 *  AppleIntelFramebuffer::doSetPowerState tracing wrapper, also notifies MLR of power state changes
+		 */
+		static IOReturn wrapDoSetPowerState(IOService *framebuffer, uint32_t state);
+		
 	public:
 		// MARK: Patch Submodule IMP
 		void init() override;
@@ -2511,18 +2887,66 @@ private:
 		 *  @param framebuffer An `AppleIntelFramebuffer` instance
 		 *  @param index The framebuffer index on return
 		 *  @return `true` on success, `false` if the framebuffer is NULL or the index does not exist.
+		 *  @note Indices are cached, as this function is called for every AUX transaction.
 		 */
-		static bool getIndex(IORegistryEntry *framebuffer, uint32_t &index) {
-			if (framebuffer == nullptr)
-				return false;
-			
-			auto idxnum = OSDynamicCast(OSNumber, framebuffer->getProperty("IOFBDependentIndex"));
-			if (idxnum != nullptr) {
-				index = idxnum->unsigned32BitValue();
-				return true;
-			}
-			return false;
-		}
+		static bool getIndex(IORegistryEntry *framebuffer, uint32_t &index);
+
+	private:
+		/**
+		 *  Represents a cached framebuffer index
+		 */
+		struct IndexCacheEntry {
+			/// Sequence counter, odd while the entry is being written
+			uint32_t sequence {0};
+
+			/// The framebuffer instance
+			IORegistryEntry *framebuffer {nullptr};
+
+			/// Registry entry ID of the framebuffer, to reject a new instance allocated at the same address
+			uint64_t entryID {0};
+
+			/// The framebuffer index
+			uint32_t index {0};
+		};
+
+		/**
+		 *  Maximum number of cached framebuffer indices
+		 */
+		static constexpr size_t IndexCacheSize = 8;
+
+		/**
+		 *  Cached framebuffer indices, read without locking and validated by their sequence counters
+		 */
+		static IndexCacheEntry indexCache[IndexCacheSize];
+
+		/**
+		 *  `true` while a writer updates the cache
+		 */
+		static bool indexCacheWriting;
+
+		/**
+		 *  Next entry to evict once every entry is in use
+		 */
+		static uint32_t indexCacheVictim;
+
+		/**
+		 *  Find the cached index of a framebuffer
+		 *
+		 *  @param framebuffer An `AppleIntelFramebuffer` instance
+		 *  @param entryID Registry entry ID of the framebuffer
+		 *  @param index The framebuffer index on return
+		 *  @return `true` if the framebuffer is cached.
+		 */
+		static bool findCachedIndex(IORegistryEntry *framebuffer, uint64_t entryID, uint32_t &index);
+
+		/**
+		 *  Remember the index of a framebuffer unless another writer is busy or it is cached already
+		 *
+		 *  @param framebuffer An `AppleIntelFramebuffer` instance
+		 *  @param entryID Registry entry ID of the framebuffer
+		 *  @param index The framebuffer index
+		 */
+		static void cacheIndex(IORegistryEntry *framebuffer, uint64_t entryID, uint32_t index);
 	};
 
 	/**
@@ -2654,7 +3078,6 @@ private:
 	 */
 	uint8_t *findFramebufferId(uint32_t framebufferId, uint8_t *startingAddress, size_t maxSize);
 
-#ifdef DEBUG
 	/**
 	 * Calculate total size of platform table list, including termination entry (FFFFFFFF 00000000)
 	 *
@@ -2664,6 +3087,53 @@ private:
 	 */
 	size_t calculatePlatformListSize(size_t maxSize);
 
+	/**
+	 *  Call a visitor with the framebuffer layout of gPlatformInformationList for the current generation
+	 *
+	 *  @param visitor  callable taking a null pointer of the frame type
+	 *  @param unknown  result when the layout is unknown
+	 *
+	 *  @return visitor result or unknown
+	 */
+	template <typename R, typename F>
+	R visitPlatformInformationLayout(F visitor, R unknown);
+
+	/**
+	 *  Size of one frame of gPlatformInformationList for the current generation
+	 *
+	 *  @return frame size or 0 when the layout is unknown
+	 */
+	size_t platformInformationEntrySize();
+
+	/**
+	 *  Size of one frame of gPlatformInformationList with the given layout
+	 *
+	 *  @return sizeof(T)
+	 */
+	template <typename T>
+	static size_t platformInformationEntrySize(T *) {
+		return sizeof(T);
+	}
+
+	/**
+	 *  Index every frame of gPlatformInformationList up to its terminator by framebuffer id
+	 *
+	 *  @note Sandy Bridge lists are not indexed, their frames carry no id.
+	 */
+	void buildFramebufferIndex();
+
+	/**
+	 *  Find the framebuffer id in gPlatformInformationList through the index,
+	 *  falling back to findFramebufferId for ids past the detected list end
+	 *
+	 *  @param framebufferId    Framebuffer id to search
+	 *
+	 *  @return pointer to the frame or nullptr
+	 */
+	uint8_t *lookupFramebufferId(uint32_t framebufferId);
+
+#ifdef DEBUG
+
 	/**
 	 * Write platform table data to ioreg
 	 *
@@ -2673,15 +3143,70 @@ private:
 #endif
 
 	/**
-	 *  Patch data without changing kernel protection
+	 *  Select the byte of the find pattern used to locate match candidates
+	 *
+	 *  @param patch            KernelPatcher instance
+	 *
+	 *  @return index of an unmasked find byte or patch.size if every byte is masked
+	 */
+	size_t findPatchAnchor(const KernelPatcher::LookupPatch &patch);
+
+	/**
+	 *  Skip to the next offset where the anchor byte of the patch matches
 	 *
 	 *  @param patch            KernelPatcher instance
+	 *  @param anchor           Anchor index returned by findPatchAnchor
+	 *  @param currentAddress   First address to check
+	 *  @param endingAddress    End of data to search
+	 *
+	 *  @return candidate address or endingAddress when there is none
+	 */
+	uint8_t *findPatchCandidate(const KernelPatcher::LookupPatch &patch, size_t anchor, uint8_t *currentAddress, uint8_t *endingAddress);
+
+	/**
+	 *  Check whether two byte patterns agree at any relative position where they overlap
+	 *
+	 *  @param first            First pattern
+	 *  @param firstMask        First pattern mask or nullptr
+	 *  @param firstSize        First pattern size
+	 *  @param second           Second pattern
+	 *  @param secondMask       Second pattern mask or nullptr
+	 *  @param secondSize       Second pattern size
+	 *
+	 *  @return true if the patterns may describe overlapping bytes
+	 */
+	bool patchBytesOverlap(const uint8_t *first, const uint8_t *firstMask, size_t firstSize, const uint8_t *second, const uint8_t *secondMask, size_t secondSize);
+
+	/**
+	 *  Check whether a single pass over two patches may differ from applying them one after another
+	 *
+	 *  @param earlier          Patch applied first
+	 *  @param later            Patch applied second
+	 *
+	 *  @return true if the patches need to be applied in separate passes
+	 */
+	bool patchesInteract(const KernelPatcher::LookupPatch &earlier, const KernelPatcher::LookupPatch &later);
+
+	/**
+	 *  Patch data with several patches in a single pass without changing kernel protection
+	 *
+	 *  @param patches          KernelPatcher patch instances that do not interact, earlier ones go first at the same offset
+	 *  @param changes          Number of replacements made by every patch (out)
+	 *  @param num              Number of patches, up to MaxFramebufferPatchCount
 	 *  @param startingAddress  Start address of data to search
 	 *  @param maxSize          Maximum size of data to search
+	 */
+	void applyPatches(const KernelPatcher::LookupPatch *patches, size_t *changes, size_t num, uint8_t *startingAddress, size_t maxSize);
+
+	/**
+	 *  Apply and release a group of framebuffer find / replace patches sharing one framebuffer
 	 *
-	 *  @return true if patched anything
+	 *  @param framebufferId               Framebuffer id
+	 *  @param platformInformationAddress  Framebuffer address in platformInformationList
+	 *  @param indices                     Indices in framebufferPatches
+	 *  @param num                         Number of indices
 	 */
-	bool applyPatch(const KernelPatcher::LookupPatch &patch, uint8_t *startingAddress, size_t maxSize);
+	void applyFramebufferPatchBatch(uint32_t framebufferId, uint8_t *platformInformationAddress, const size_t *indices, size_t num);
 	
 	/**
 	 *  Add int to dictionary.
@@ -2699,11 +3224,12 @@ private:
 	 *
 	 *  @param framebufferId               Framebuffer id
 	 *  @param platformInformationList     PlatformInformationList pointer
+	 *  @param frame                       Framebuffer in platformInformationList or nullptr
 	 *
 	 *  @return true if patched anything
 	 */
 	template <typename T>
-	bool applyPlatformInformationListPatch(uint32_t framebufferId, T *platformInformationList);
+	bool applyPlatformInformationListPatch(uint32_t framebufferId, T *platformInformationList, T *frame);
 
 	/**
 	 *  Extended patching called from applyPlatformInformationListPatch
@@ -2714,26 +3240,61 @@ private:
 	template <typename T>
 	void applyPlatformInformationPatchEx(T* frame);
 
-	/**
-	 *  Apply framebuffer patches
-	 */
-	void applyFramebufferPatches();
-
 	/**
 	 *  Patch platformInformationList with DP to HDMI connector type replacements
 	 *
 	 *  @param framebufferId               Framebuffer id
 	 *  @param platformInformationList     PlatformInformationList pointer
+	 *  @param frame                       Framebuffer in platformInformationList or nullptr
+	 *
+	 *  @return true if patched anything
+	 */
+	template <typename T>
+	bool applyDPtoHDMIPatch(uint32_t framebufferId, T *platformInformationList, T *frame);
+
+	/**
+	 *  Compile framebuffer field, DP to HDMI and find / replace edits into a plan
+	 *
+	 *  @param plan                 Plan to fill (out)
+	 *  @param patchFramebuffer     Apply framebufferPatch and framebufferPatches
+	 *  @param patchDPtoHDMI        Apply DP to HDMI connector type changes
+	 */
+	void compileFramebufferPlan(FramebufferPlan &plan, bool patchFramebuffer, bool patchDPtoHDMI);
+
+	/**
+	 *  Locate every planned framebuffer in gPlatformInformationList
+	 *
+	 *  @param plan                 Compiled plan
+	 */
+	void resolveFramebufferPlan(FramebufferPlan &plan);
+
+	/**
+	 *  Apply field and DP to HDMI edits of a plan entry with the framebuffer layout of the current generation
+	 *
+	 *  @param entry                Resolved plan entry
+	 *
+	 *  @return true if patched anything
+	 */
+	bool applyPlatformInformationPlan(const FramebufferPlanEntry &entry);
+
+	/**
+	 *  Apply field and DP to HDMI edits of a plan entry
+	 *
+	 *  @param entry                Resolved plan entry
+	 *  @param layout               Frame type of gPlatformInformationList, unused
 	 *
 	 *  @return true if patched anything
 	 */
 	template <typename T>
-	bool applyDPtoHDMIPatch(uint32_t framebufferId, T *platformInformationList);
+	bool applyPlatformInformationEntry(const FramebufferPlanEntry &entry, T *layout);
 
 	/**
-	 *  Apply DP to HDMI automatic connector type changes
+	 *  Apply framebuffer patches and DP to HDMI automatic connector type changes in one platform list pass
+	 *
+	 *  @param patchFramebuffer     Apply framebufferPatch and framebufferPatches
+	 *  @param patchDPtoHDMI        Apply DP to HDMI connector type changes
 	 */
-	void applyHdmiAutopatch();
+	void applyPlatformInformationListPatches(bool patchFramebuffer, bool patchDPtoHDMI);
 	
 	/**
 	 *	Apply patches for first generation framebuffer.
@@ -1214,6 +1214,79 @@ IOReturn IGFX::BacklightRegistersAltFixCFL::wrapHwSetBacklight(void *controller,
 	return kIOReturnSuccess;
 }
 
+//
+// MARK: - Brightness Request Queue
+//
+
+bool BrightnessRequestQueue::init(uint32_t size) {
+	requests = Buffer::create<BrightnessRequest>(size);
+	if (requests == nullptr)
+		return false;
+	
+	capacity = size;
+	head = 0;
+	tail = 0;
+	replacements = 0;
+	return true;
+}
+
+void BrightnessRequestQueue::deinit() {
+	if (requests != nullptr) {
+		Buffer::deleter(requests);
+		requests = nullptr;
+	}
+	capacity = 0;
+}
+
+void BrightnessRequestQueue::push(const BrightnessRequest &request) {
+	uint32_t index = head;
+	uint32_t consumed = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+	if (index - consumed < capacity) {
+		requests[index % capacity] = request;
+		__atomic_store_n(&head, index + 1, __ATOMIC_RELEASE);
+		return;
+	}
+	
+	// The queue is full, but only the latest request matters, so replace the most recent one
+	uint32_t sequence = replacements;
+	__atomic_store_n(&replacements, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	requests[(index - 1) % capacity] = request;
+	__atomic_store_n(&replacements, sequence + 2, __ATOMIC_RELEASE);
+	
+	// Either the consumer notices the replacement, or it has taken the requests meanwhile
+	// and there is room to submit the request once more
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&tail, __ATOMIC_RELAXED) != consumed) {
+		requests[index % capacity] = request;
+		__atomic_store_n(&head, index + 1, __ATOMIC_RELEASE);
+	}
+}
+
+bool BrightnessRequestQueue::popLatest(BrightnessRequest &request) {
+	uint32_t index = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+	if (index == tail)
+		return false;
+	
+	while (true) {
+		// Intermediate requests are superseded by the latest one, which the producer may be replacing
+		uint32_t sequence;
+		do {
+			sequence = __atomic_load_n(&replacements, __ATOMIC_ACQUIRE);
+			request = requests[(index - 1) % capacity];
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		} while ((sequence & 1) != 0 || sequence != __atomic_load_n(&replacements, __ATOMIC_RELAXED));
+		
+		__atomic_store_n(&tail, index, __ATOMIC_RELEASE);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&replacements, __ATOMIC_RELAXED) == sequence)
+			return true;
+		
+		// The latest request was replaced after it had been read
+		index = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+	}
+}
+
 //
 // MARK: - Brightness Request Event Source
 //
@@ -1224,7 +1297,7 @@ IOReturn IGFX::BacklightRegistersAltFixCFL::wrapHwSetBacklight(void *controller,
 OSDefineMetaClassAndStructors(BrightnessRequestEventSource, IOEventSource);
 
 /**
- *  Check whether a brightness adjustment request is pending and if so process the request on the workloop
+ *  Check whether a brightness adjustment request is pending and if so start or retarget the transition on the workloop
  *
  *  @return `true` if the work loop should invoke this function again.
  *          i.e., One or more requests are pending after the workloop has processed the current one.
@@ -1233,65 +1306,19 @@ bool BrightnessRequestEventSource::checkForWork() {
 	// Get the brightness smoother submodule
 	IGFX::BacklightSmoother *smoother = &IGFX::callbackIGFX->modBacklightSmoother;
 	
-	// Get a pending request
+	// Get the latest pending request
 	// No work if the queue is empty
-	BrightnessRequest request = smoother->request; // TODO: read it atomically, or compare the whole requests instead of ID
-	if (!request.controller) {
-		DBGLOG("igfx", "BLS: [COMM] The request is empty. Will wait for the next invocation.");
+	BrightnessRequest request;
+	if (!smoother->queue.popLatest(request)) {
+		DBGLOG("igfx", "BLS: [COMM] The queue is empty. Will wait for the next invocation.");
 		return false;
 	}
 	
-	// Prepare the request
-	[[maybe_unused]] uint64_t snanosecs = getCurrentTimeNs();
-	uint32_t current = IGFX::callbackIGFX->readRegister32(request.controller, request.address);
-	uint32_t cbrightness = request.getCurrentBrightness(current);
-	uint32_t tbrightness = request.getTargetBrightness();
-
-	if (cbrightness == tbrightness) {
-		DBGLOG("igfx", "BLS: [COMM] The request is already completed. Will wait for the next invocation.");
-		return false;		
-	}
-	
-	tbrightness = max(tbrightness, smoother->brightnessRange.first);  // Ensure that target >= lowerbound
-	tbrightness = min(tbrightness, smoother->brightnessRange.second); // Ensure that target <= upperbound
-	uint32_t distance = max(cbrightness, tbrightness) - min(cbrightness, tbrightness);
-	DBGLOG("igfx", "BLS: [COMM] Processing the request: Current = 0x%08x; Target = 0x%08x; Distance = %04u; Steps = %u.",
-		   cbrightness, tbrightness, distance, smoother->steps);
-	
-	// Process the request
-	if (distance > smoother->threshold) {
-		if (cbrightness < tbrightness) {
-			// Increase the brightness
-			for (uint32_t i = 1; i < smoother->steps; i++) {
-				uint32_t value = cbrightness + i * distance / smoother->steps;
-				IGFX::callbackIGFX->writeRegister32(request.controller, request.address, request.getTargetRegisterValue(value));
-				IOSleep(smoother->interval);
-				if (smoother->request.id != request.id) {
-					return true; // Start again, because there is a new request
-				}
-			}
-		} else if (cbrightness > tbrightness) {
-			// Decrease the brightness
-			for (uint32_t i = 1; i < smoother->steps; i++) {
-				uint32_t value = cbrightness - i * distance / smoother->steps;
-				IGFX::callbackIGFX->writeRegister32(request.controller, request.address, request.getTargetRegisterValue(value));
-				IOSleep(smoother->interval);
-				if (smoother->request.id != request.id) {
-					return true; // Start again, because there is a new request
-				}
-			}
-		}
-	} else {
-		DBGLOG("igfx", "BLS: [COMM] Distance is too short. Will set the target value directly.");
-	}
-	
-	// Finish by writting the target value
-	IGFX::callbackIGFX->writeRegister32(request.controller, request.address, request.getTargetRegisterValue(tbrightness));
-	[[maybe_unused]] uint64_t enanosecs = getCurrentTimeNs();
-	DBGLOG("igfx", "BLS: [COMM] The request completed in %llu nanoseconds.", enanosecs - snanosecs);
+	// The transition itself is performed by the timer, so the workloop is not blocked
+	smoother->processRequest(request);
 	
-	// No need to invoke this function again if the request is the same
-	return smoother->request.id != request.id;
+	// No need to invoke this function again if no request has been submitted in the meantime
+	return !smoother->queue.isEmpty();
 }
 
 /**
@@ -1317,6 +1344,147 @@ BrightnessRequestEventSource *BrightnessRequestEventSource::create(OSObject *own
 // MARK: - Backlight Smoother
 //
 
+/**
+ *  Calculate the integer square root
+ *
+ *  @param value A 64-bit value
+ *  @return The largest integer whose square does not exceed the given value.
+ */
+static uint64_t isqrt(uint64_t value) {
+	uint64_t result = 0;
+	uint64_t bit = 1ULL << 62;
+	
+	while (bit > value)
+		bit >>= 2;
+	
+	while (bit != 0) {
+		if (value >= result + bit) {
+			value -= result + bit;
+			result = (result >> 1) + bit;
+		} else {
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+	
+	return result;
+}
+
+uint32_t IGFX::BacklightSmoother::getTransitionBrightness(uint32_t step) {
+	uint64_t start = transition.start;
+	uint64_t target = transition.target;
+	uint64_t steps = transition.steps;
+	
+	switch (curve) {
+		case kCurveEaseOut: {
+			// f(t) = 1 - (1 - t)^2, where t = step / steps
+			uint64_t remaining = steps - step;
+			uint64_t progress = steps * steps - remaining * remaining;
+			uint64_t distance = start < target ? target - start : start - target;
+			uint64_t delta = distance * progress / (steps * steps);
+			return static_cast<uint32_t>(start < target ? start + delta : start - delta);
+		}
+			
+		case kCurveGamma: {
+			// Interpolate the square roots of both levels, then square the result
+			int64_t from = static_cast<int64_t>(isqrt(start));
+			int64_t to = static_cast<int64_t>(isqrt(target));
+			uint64_t level = static_cast<uint64_t>(from + (to - from) * static_cast<int64_t>(step) / static_cast<int64_t>(steps));
+			level *= level;
+			// Never overshoot either end of the transition
+			level = max(level, min(start, target));
+			level = min(level, max(start, target));
+			return static_cast<uint32_t>(level);
+		}
+			
+		default: {
+			uint64_t distance = start < target ? target - start : start - target;
+			uint64_t delta = step * distance / steps;
+			return static_cast<uint32_t>(start < target ? start + delta : start - delta);
+		}
+	}
+}
+
+void IGFX::BacklightSmoother::processRequest(const BrightnessRequest &request) {
+	uint32_t tbrightness = request.getTargetBrightness();
+	
+	// Guard: Steer the ongoing transition towards the latest target with the remaining steps instead of starting over
+	if (transition.active) {
+		tbrightness = max(tbrightness, brightnessRange.first);  // Ensure that target >= lowerbound
+		tbrightness = min(tbrightness, brightnessRange.second); // Ensure that target <= upperbound
+		transition.request = request;
+		transition.start = transition.current;
+		transition.target = tbrightness;
+		transition.steps -= transition.step;
+		transition.step = 0;
+		DBGLOG("igfx", "BLS: [COMM] Retargeting the request: Current = 0x%08x; Target = 0x%08x; Steps = %u.",
+			   transition.start, transition.target, transition.steps);
+		return;
+	}
+	
+	// Prepare the request
+	uint32_t current = callbackIGFX->readRegister32(request.controller, request.address);
+	uint32_t cbrightness = request.getCurrentBrightness(current);
+	
+	if (cbrightness == tbrightness) {
+		DBGLOG("igfx", "BLS: [COMM] The request is already completed. Will wait for the next invocation.");
+		return;
+	}
+	
+	tbrightness = max(tbrightness, brightnessRange.first);  // Ensure that target >= lowerbound
+	tbrightness = min(tbrightness, brightnessRange.second); // Ensure that target <= upperbound
+	uint32_t distance = max(cbrightness, tbrightness) - min(cbrightness, tbrightness);
+	DBGLOG("igfx", "BLS: [COMM] Processing the request: Current = 0x%08x; Target = 0x%08x; Distance = %04u; Steps = %u.",
+		   cbrightness, tbrightness, distance, steps);
+	
+	// Guard: Set the target value directly if the distance is too short
+	if (distance <= threshold) {
+		DBGLOG("igfx", "BLS: [COMM] Distance is too short. Will set the target value directly.");
+		callbackIGFX->writeRegister32(request.controller, request.address, request.getTargetRegisterValue(tbrightness));
+		return;
+	}
+	
+	// Start the transition with the first step
+	transition.request = request;
+	transition.start = cbrightness;
+	transition.target = tbrightness;
+	transition.current = cbrightness;
+	transition.steps = steps;
+	transition.step = 0;
+	transition.active = true;
+	advanceTransition();
+}
+
+void IGFX::BacklightSmoother::advanceTransition() {
+	if (!transition.active)
+		return;
+	
+	transition.step++;
+	
+	// Guard: Finish by writing the target value
+	if (transition.step >= transition.steps) {
+		callbackIGFX->writeRegister32(transition.request.controller, transition.request.address, transition.request.getTargetRegisterValue(transition.target));
+		transition.current = transition.target;
+		transition.active = false;
+		DBGLOG("igfx", "BLS: [COMM] The request completed with target 0x%08x.", transition.target);
+		return;
+	}
+	
+	transition.current = getTransitionBrightness(transition.step);
+	callbackIGFX->writeRegister32(transition.request.controller, transition.request.address, transition.request.getTargetRegisterValue(transition.current));
+	
+	// The workloop thread is free to process new requests until the next step is due
+	if (timer->setTimeoutMS(interval) != kIOReturnSuccess) {
+		SYSLOG("igfx", "BLS: [COMM] Failed to schedule the next step. Will set the target value directly.");
+		transition.step = transition.steps - 1;
+		advanceTransition();
+	}
+}
+
+void IGFX::BacklightSmoother::onTransitionTimer(OSObject *owner, IOTimerEventSource *sender) {
+	callbackIGFX->modBacklightSmoother.advanceTransition();
+}
+
 void IGFX::BacklightSmoother::init() {
 	// We only need to patch the framebuffer driver
 	requiresPatchingFramebuffer = true;
@@ -1329,6 +1497,11 @@ void IGFX::BacklightSmoother::init() {
 void IGFX::BacklightSmoother::deinit() {
 	// `BacklightSmoother::processKernel()` guarantees that all pointers are nullptr on failure
 	if (workloop != nullptr) {
+		if (timer != nullptr) {
+			timer->cancelTimeout();
+			workloop->removeEventSource(timer);
+			OSSafeReleaseNULL(timer);
+		}
 		if (eventSource != nullptr) {
 			workloop->removeEventSource(eventSource);
 			OSSafeReleaseNULL(eventSource);
@@ -1336,6 +1509,7 @@ void IGFX::BacklightSmoother::deinit() {
 		OSSafeReleaseNULL(workloop);
 	}
 	OSSafeReleaseNULL(owner);
+	queue.deinit();
 }
 
 void IGFX::BacklightSmoother::processKernel(KernelPatcher &patcher, DeviceInfo *info) {
@@ -1359,6 +1533,8 @@ void IGFX::BacklightSmoother::processKernel(KernelPatcher &patcher, DeviceInfo *
 		DBGLOG("igfx", "BLS: User requested brightness lower bound = %u.", brightnessRange.first);
 	if (WIOKit::getOSDataValue(info->videoBuiltin, "backlight-smoother-upperbound", brightnessRange.second))
 		DBGLOG("igfx", "BLS: User requested brightness upper bound = %u.", brightnessRange.second);
+	if (WIOKit::getOSDataValue(info->videoBuiltin, "backlight-smoother-curve", curve))
+		DBGLOG("igfx", "BLS: User requested curve = %u.", curve);
 	
 	// Sanitize user configurations
 	if (steps == 0) {
@@ -1371,6 +1547,11 @@ void IGFX::BacklightSmoother::processKernel(KernelPatcher &patcher, DeviceInfo *
 		queueSize = kMinimumQueueSize;
 	}
 	
+	if (curve > kCurveGamma) {
+		SYSLOG("igfx", "BLS: Warning: User requested curve is invalid. Will use the default curve %u.", kDefaultCurve);
+		curve = kDefaultCurve;
+	}
+	
 	if (brightnessRange.first > brightnessRange.second) {
 		SYSLOG("igfx", "BLS: Warning: User requested brightness range is invalid. Will use the default range.");
 		brightnessRange.first = 0;
@@ -1387,7 +1568,12 @@ void IGFX::BacklightSmoother::processKernel(KernelPatcher &patcher, DeviceInfo *
 	}
 	
 	// Initialize the request queue
-	request = BrightnessRequest();
+	if (!queue.init(queueSize)) {
+		SYSLOG("igfx", "BLS: Failed to allocate the request queue.");
+		deinit();
+		enabled = false;
+		return;
+	}
 	
 	// Initialize the workloop
 	workloop = IOWorkLoop::workLoop();
@@ -1412,6 +1598,23 @@ void IGFX::BacklightSmoother::processKernel(KernelPatcher &patcher, DeviceInfo *
 		SYSLOG("igfx", "BLS: Failed to register the request event source.");
 		deinit();
 		enabled = false;
+		return;
+	}
+	
+	// Initialize the transition timer
+	timer = IOTimerEventSource::timerEventSource(owner, onTransitionTimer);
+	if (timer == nullptr) {
+		SYSLOG("igfx", "BLS: Failed to create the transition timer.");
+		deinit();
+		enabled = false;
+		return;
+	}
+	
+	// Register the timer
+	if (workloop->addEventSource(timer) != kIOReturnSuccess) {
+		SYSLOG("igfx", "BLS: Failed to register the transition timer.");
+		deinit();
+		enabled = false;
 	}
 }
 
@@ -1436,7 +1639,7 @@ void IGFX::BacklightSmoother::smoothIVBWriteRegisterPWMCCTRL(void *controller, u
 	PANIC_COND(address != BLC_PWM_CPU_CTL, "igfx", "Fatal Error: Register should be BLC_PWM_CPU_CTL.");
 	
 	// Submit the request and notify the event source
-	callbackIGFX->modBacklightSmoother.request = BrightnessRequest(callbackIGFX->modBacklightSmoother.request.id + 1, controller, address, value);
+	callbackIGFX->modBacklightSmoother.queue.push(BrightnessRequest(controller, address, value));
 	callbackIGFX->modBacklightSmoother.eventSource->enable();
 	DBGLOG("igfx", "BLS: [IVB ] WriteRegister32<BLC_PWM_CPU_CTL>: The brightness request has been submitted.");
 }
@@ -1446,7 +1649,7 @@ void IGFX::BacklightSmoother::smoothHSWWriteRegisterPWMFreq1(void *controller, u
 	PANIC_COND(address != BXT_BLC_PWM_FREQ1, "igfx", "Fatal Error: Register should be BXT_BLC_PWM_FREQ1.");
 	
 	// Submit the request and notify the event source
-	callbackIGFX->modBacklightSmoother.request = BrightnessRequest(callbackIGFX->modBacklightSmoother.request.id + 1, controller, address, value, 0xFFFF);
+	callbackIGFX->modBacklightSmoother.queue.push(BrightnessRequest(controller, address, value, 0xFFFF));
 	callbackIGFX->modBacklightSmoother.eventSource->enable();
 	DBGLOG("igfx", "BLS: [HSW+] WriteRegister32<BXT_BLC_PWM_FREQ1>: The brightness request has been submitted.");
 }
@@ -1456,7 +1659,7 @@ void IGFX::BacklightSmoother::smoothCFLWriteRegisterPWMDuty1(void *controller, u
 	PANIC_COND(address != BXT_BLC_PWM_DUTY1, "igfx", "Fatal Error: Register should be BXT_BLC_PWM_DUTY1.");
 	
 	// Submit the request and notify the event source
-	callbackIGFX->modBacklightSmoother.request = BrightnessRequest(callbackIGFX->modBacklightSmoother.request.id + 1, controller, address, value);
+	callbackIGFX->modBacklightSmoother.queue.push(BrightnessRequest(controller, address, value));
 	callbackIGFX->modBacklightSmoother.eventSource->enable();
 	DBGLOG("igfx", "BLS: [CFL+] WriteRegister32<BXT_BLC_PWM_DUTY1>: The brightness request has been submitted.");
 }
@@ -10,6 +10,7 @@
 #define kern_igfx_backlight_hpp
 
 #include <IOKit/IOEventSource.h>
+#include <IOKit/IOTimerEventSource.h>
 #include "kern_util.hpp"
 
 /**
@@ -54,11 +55,6 @@ struct BrightnessRequest {
 	 */
 	uint32_t mask {0};
 	
-	/**
-	 * The request ID to check if the request was changed
-	 */
-	uint32_t id {0};
-	
 	/**
 	 *  Create an empty request
 	 */
@@ -67,8 +63,8 @@ struct BrightnessRequest {
 	/**
 	 *  Create a brightness request
 	 */
-	BrightnessRequest(uint32_t id, void *controller, uint32_t address, uint32_t target, uint32_t mask = 0xFFFFFFFF) :
-		id(id), controller(controller), address(address), target(target), mask(mask) {}
+	BrightnessRequest(void *controller, uint32_t address, uint32_t target, uint32_t mask = 0xFFFFFFFF) :
+		controller(controller), address(address), target(target), mask(mask) {}
 	
 	/**
 	 *  Get the current brightness level
@@ -76,7 +72,7 @@ struct BrightnessRequest {
 	 *  @param current The current register value
 	 *  @return The current brightness level.
 	 */
-	inline uint32_t getCurrentBrightness(uint32_t current) {
+	inline uint32_t getCurrentBrightness(uint32_t current) const {
 		return current & mask;
 	}
 	
@@ -85,7 +81,7 @@ struct BrightnessRequest {
 	 *
 	 *  @return The target brightness level.
 	 */
-	inline uint32_t getTargetBrightness() {
+	inline uint32_t getTargetBrightness() const {
 		return target & mask;
 	}
 	
@@ -95,11 +91,123 @@ struct BrightnessRequest {
 	 *  @param brightness The brightness level
 	 *  @return The corresponding register value
 	 */
-	inline uint32_t getTargetRegisterValue(uint32_t brightness) {
+	inline uint32_t getTargetRegisterValue(uint32_t brightness) const {
 		return brightness | (target & ~mask);
 	}
 };
 
+/**
+ *  Represents an ongoing brightness transition driven by the workloop timer
+ */
+struct BrightnessTransition {
+	/**
+	 *  The request being processed
+	 */
+	BrightnessRequest request;
+	
+	/**
+	 *  The brightness level at the beginning of the transition
+	 */
+	uint32_t start {0};
+	
+	/**
+	 *  The brightness level at the end of the transition
+	 */
+	uint32_t target {0};
+	
+	/**
+	 *  The last brightness level written to the register
+	 */
+	uint32_t current {0};
+	
+	/**
+	 *  The total number of steps of the transition
+	 */
+	uint32_t steps {0};
+	
+	/**
+	 *  The number of steps that have been completed
+	 */
+	uint32_t step {0};
+	
+	/**
+	 *  `true` if the transition is in progress
+	 */
+	bool active {false};
+};
+
+/**
+ *  A single-producer single-consumer lock-free ring buffer of brightness requests
+ *
+ *  @note The producer is the `WriteRegister32()` wrapper that submits requests,
+ *        and the consumer is the workloop thread that processes them.
+ */
+class BrightnessRequestQueue {
+	/**
+	 *  Storage of the ring buffer
+	 */
+	BrightnessRequest *requests {nullptr};
+	
+	/**
+	 *  Number of requests the ring buffer can hold
+	 */
+	uint32_t capacity {0};
+	
+	/**
+	 *  Free running index of the next request to be submitted, only modified by the producer
+	 */
+	uint32_t head {0};
+	
+	/**
+	 *  Free running index of the next request to be processed, only modified by the consumer
+	 */
+	uint32_t tail {0};
+	
+	/**
+	 *  Sequence counter of the producer replacing the most recent request in a full queue, odd while a replacement is in progress
+	 */
+	uint32_t replacements {0};
+	
+public:
+	/**
+	 *  Allocate the ring buffer
+	 *
+	 *  @param size The maximum number of pending requests
+	 *  @return `true` on success, `false` otherwise.
+	 */
+	bool init(uint32_t size);
+	
+	/**
+	 *  Release the ring buffer
+	 */
+	void deinit();
+	
+	/**
+	 *  [Producer] Submit a request
+	 *
+	 *  @param request The brightness request
+	 *  @note When the queue is full, the request replaces the most recent pending one.
+	 */
+	void push(const BrightnessRequest &request);
+	
+	/**
+	 *  [Consumer] Take all pending requests and coalesce them into the latest one
+	 *
+	 *  @param request The latest brightness request on return
+	 *  @return `true` on success, `false` if the queue is empty.
+	 */
+	bool popLatest(BrightnessRequest &request);
+	
+	/**
+	 *  [Consumer] Check whether there is no pending request
+	 *
+	 *  @return `true` if the queue is empty.
+	 */
+	bool isEmpty() const {
+		return __atomic_load_n(&head, __ATOMIC_ACQUIRE) == tail;
+	}
+};
+
 /**
  *  An event source that adjusts the brightness smoothly
  */
@@ -112,7 +220,7 @@ class BrightnessRequestEventSource: public IOEventSource {
 	using super = IOEventSource;
 	
 	/**
-	 *  Check whether a brightness adjustment request is pending and if so process the request on the workloop
+	 *  Check whether a brightness adjustment request is pending and if so start or retarget the transition on the workloop
 	 *
 	 *  @return `true` if the work loop should invoke this function again.
 	 *          i.e., One or more requests are pending after the workloop has processed the current one.
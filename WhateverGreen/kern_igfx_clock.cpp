@@ -53,6 +53,19 @@ static constexpr uint32_t DPCD_EDP_SUPPORTED_LINK_RATES_ADDRESS = 0x010;
  */
 static constexpr size_t DP_MAX_NUM_SUPPORTED_RATES = 8;
 
+/**
+ *  Immutable DPCD ranges mirrored by the shadow of the builtin display
+ */
+static constexpr struct {
+	uint32_t address;
+	uint32_t length;
+} DPCD_SHADOW_RANGES[] = {
+	{DPCD_DEFAULT_RECEIVER_CAPS_ADDRESS, 16},
+	{DPCD_EDP_SUPPORTED_LINK_RATES_ADDRESS, DP_MAX_NUM_SUPPORTED_RATES * sizeof(uint16_t)},
+	{DPCD_EDP_VERSION_ADDRESS, 1},
+	{DPCD_EXTENDED_RECEIVER_CAPS_ADDRESS, 16},
+};
+
 /**
  *  Represents the first 16 fields of the receiver capabilities defined in DPCD
  *
@@ -167,6 +180,40 @@ void IGFX::DPCDMaxLinkRateFix::processFramebufferKext(KernelPatcher &patcher, si
 		DBGLOG("igfx", "MLR: Found CFL- platforms. Will setup the fix for the CFL- graphics driver.");
 		processFramebufferKextForCFL(patcher, index, address, size);
 	}
+	
+	// The DPCD shadow relies on power state changes to notice that the panel may have been turned off
+	// Framebuffer debugging routes doSetPowerState as well and notifies us from its wrapper, so the symbol is routed once
+	if (callbackIGFX->modFramebufferDebugSupport.enabled) {
+		DBGLOG("igfx", "MLR: [COMM] Will share the doSetPowerState route of the framebuffer debug support.");
+		return;
+	}
+	
+	KernelPatcher::RouteRequest request = {
+		"__ZN21AppleIntelFramebuffer15doSetPowerStateEj",
+		wrapDoSetPowerState,
+		orgDoSetPowerState
+	};
+	
+	bool routed = patcher.routeMultiple(index, &request, 1, address, size);
+	if (!routed)
+		patcher.clearError();
+	onPowerStateHooked(routed);
+}
+
+void IGFX::DPCDMaxLinkRateFix::onPowerStateHooked(bool hooked) {
+	shadowEnabled = hooked;
+	if (shadowEnabled)
+		DBGLOG("igfx", "MLR: [COMM] DPCD shadow of the builtin display is enabled.");
+	else
+		SYSLOG("igfx", "MLR: [COMM] Failed to route doSetPowerState. DPCD shadow is disabled.");
+}
+
+void IGFX::DPCDMaxLinkRateFix::onPowerStateChange(uint32_t state) {
+	// The panel may be turned off or replaced across power state changes, drop the shadow before the driver reads DPCD again
+	if (shadowEnabled) {
+		DBGLOG("igfx", "MLR: [COMM] OnPowerStateChange() Dropping the DPCD shadow for power state %u.", state);
+		invalidateShadow();
+	}
 }
 
 IOReturn IGFX::DPCDMaxLinkRateFix::wrapCFLReadAUX(AppleIntelFramebufferController *that, IORegistryEntry *framebuffer, uint32_t address, uint16_t length, void *buffer, void *displayPath) {
@@ -214,28 +261,32 @@ IOReturn IGFX::DPCDMaxLinkRateFix::wrapReadAUX(uint32_t address, void *buffer, u
 	// Phase 2: https://www.firewolf.science/2018/11/coffee-lake-intel-uhd-graphics-630-on-macos-mojave-a-nearly-ultimate-solution-to-the-kernel-panic-due-to-division-by-zero-in-the-framebuffer-driver/
 	// Phase 3: https://www.firewolf.science/2020/10/coffee-lake-intel-uhd-graphics-630-on-macos-catalina-the-ultimate-solution-to-the-kernel-panic-due-to-division-by-zero-in-the-framebuffer-driver/
 
-	// Call the original ReadAUX() function to read from DPCD
-	IOReturn retVal = callbackIGFX->modDPCDMaxLinkRateFix.orgReadAUX(address, buffer, length);
-
 	// Guard: Check the DPCD register address
 	// The first 16 fields of the receiver capabilities reside at 0x0 (DPCD Register Address)
-	if (address != DPCD_DEFAULT_RECEIVER_CAPS_ADDRESS && address != DPCD_EXTENDED_RECEIVER_CAPS_ADDRESS)
-		return retVal;
+	// Other immutable ranges of the builtin display are served from the shadow once filled,
+	// so other reads pay for the framebuffer index lookup only when the shadow holds them
+	bool isReceiverCaps = address == DPCD_DEFAULT_RECEIVER_CAPS_ADDRESS || address == DPCD_EXTENDED_RECEIVER_CAPS_ADDRESS;
+	if (!isReceiverCaps && callbackIGFX->modDPCDMaxLinkRateFix.findShadowRange(address, length) == nullptr)
+		return callbackIGFX->modDPCDMaxLinkRateFix.orgReadAUX(address, buffer, length);
 
-	// The driver tries to read the first 16 bytes from DPCD (0x0000) or extended DPCD (0x2200)
 	// Get the current framebuffer index (An UInt32 field at 0x1dc in a framebuffer instance)
 	// We read the value of "IOFBDependentIndex" instead of accessing that field directly
 	uint32_t index;
 	// Guard: Should be able to retrieve the index from the registry
 	if (!callbackIGFX->modDPCDMaxLinkRateFix.getFramebufferIndex(index)) {
 		SYSLOG("igfx", "MLR: [COMM] wrapReadAUX() Failed to read the current framebuffer index.");
-		return retVal;
+		return callbackIGFX->modDPCDMaxLinkRateFix.orgReadAUX(address, buffer, length);
 	}
 
 	// Guard: Check the framebuffer index
 	// By default, FB 0 refers to the builtin display
 	if (index != 0)
-		// The driver is reading DPCD for an external display
+		// The driver is reading DPCD for an external display, which may be replaced at any time
+		return callbackIGFX->modDPCDMaxLinkRateFix.orgReadAUX(address, buffer, length);
+
+	// Read from DPCD of the builtin display
+	IOReturn retVal = callbackIGFX->modDPCDMaxLinkRateFix.readBuiltinDPCD(address, buffer, length);
+	if (!isReceiverCaps)
 		return retVal;
 
 	// The driver tries to read the receiver capabilities for the builtin display
@@ -270,6 +321,61 @@ IOReturn IGFX::DPCDMaxLinkRateFix::orgReadAUX(uint32_t address, void *buffer, ui
 	return orgCFLReadAUX(controller, framebuffer, address, length, buffer, displayPath);
 }
 
+IOReturn IGFX::DPCDMaxLinkRateFix::readBuiltinDPCD(uint32_t address, void *buffer, uint32_t length) {
+	static_assert(arrsize(DPCD_SHADOW_RANGES) == DPCDShadowRangeCount, "Update the DPCD shadow layout");
+	
+	// Guard: Serve the read from the shadow if a mirrored range covers it
+	auto cached = findShadowRange(address, length);
+	if (cached != nullptr) {
+		DBGLOG("igfx", "MLR: [COMM] ReadBuiltinDPCD() Served from the shadow with Address = 0x%x; Length = %u.", address, length);
+		lilu_os_memcpy(buffer, cached, length);
+		return kIOReturnSuccess;
+	}
+	
+	IOReturn retVal = orgReadAUX(address, buffer, length);
+	if (!shadowEnabled)
+		return retVal;
+	
+	// Guard: A failed transaction may mean that the panel is gone, so read everything again next time
+	if (retVal != kIOReturnSuccess) {
+		invalidateShadow();
+		return retVal;
+	}
+	
+	// Mirror every range covered by this read
+	for (size_t i = 0; i < arrsize(DPCD_SHADOW_RANGES); i++) {
+		auto &range = DPCD_SHADOW_RANGES[i];
+		if (address <= range.address && range.address + range.length <= address + length) {
+			lilu_os_memcpy(shadow.bytes[i], static_cast<uint8_t *>(buffer) + (range.address - address), range.length);
+			shadow.valid[i] = true;
+		}
+	}
+	
+	return retVal;
+}
+
+const uint8_t *IGFX::DPCDMaxLinkRateFix::findShadowRange(uint32_t address, uint32_t length) {
+	if (!shadowEnabled)
+		return nullptr;
+	
+	for (size_t i = 0; i < arrsize(DPCD_SHADOW_RANGES); i++) {
+		auto &range = DPCD_SHADOW_RANGES[i];
+		if (shadow.valid[i] && address >= range.address && address + length <= range.address + range.length)
+			return shadow.bytes[i] + (address - range.address);
+	}
+	return nullptr;
+}
+
+void IGFX::DPCDMaxLinkRateFix::invalidateShadow() {
+	for (auto &valid : shadow.valid)
+		valid = false;
+}
+
+IOReturn IGFX::DPCDMaxLinkRateFix::wrapDoSetPowerState(IOService *that, uint32_t state) {
+	callbackIGFX->modDPCDMaxLinkRateFix.onPowerStateChange(state);
+	return callbackIGFX->modDPCDMaxLinkRateFix.orgDoSetPowerState(that, state);
+}
+
 bool IGFX::DPCDMaxLinkRateFix::getFramebufferIndex(uint32_t &index) {
 	auto fb = port != nullptr ? orgICLGetFBFromPort(callbackIGFX->defaultController(), port) : this->framebuffer;
 	DBGLOG("igfx", "MLR: [COMM] GetFBIndex() Port at 0x%llx; Framebuffer at 0x%llx.", (uint64_t)port, (uint64_t)fb);
@@ -280,7 +386,7 @@ uint32_t IGFX::DPCDMaxLinkRateFix::probeMaxLinkRate() {
 	// Precondition: This function is only called when the framebuffer index is 0 (i.e. builtin display)
 	// Guard: Read the eDP version from DPCD
 	uint8_t eDPVersion;
-	if (orgReadAUX(DPCD_EDP_VERSION_ADDRESS, &eDPVersion, 1) != kIOReturnSuccess) {
+	if (readBuiltinDPCD(DPCD_EDP_VERSION_ADDRESS, &eDPVersion, 1) != kIOReturnSuccess) {
 		SYSLOG("igfx", "MLR: [COMM] ProbeMaxLinkRate() Failed to read the eDP version. Aborted.");
 		return 0;
 	}
@@ -294,7 +400,7 @@ uint32_t IGFX::DPCDMaxLinkRateFix::probeMaxLinkRate() {
 	
 	// Guard: Read all supported link rates
 	uint16_t rates[DP_MAX_NUM_SUPPORTED_RATES] = {0};
-	if (orgReadAUX(DPCD_EDP_SUPPORTED_LINK_RATES_ADDRESS, rates, sizeof(rates)) != kIOReturnSuccess) {
+	if (readBuiltinDPCD(DPCD_EDP_SUPPORTED_LINK_RATES_ADDRESS, rates, sizeof(rates)) != kIOReturnSuccess) {
 		SYSLOG("igfx", "MLR: [COMM] ProbeMaxLinkRate() Failed to read supported link rates from DPCD.");
 		return 0;
 	}
@@ -632,6 +738,109 @@ static constexpr uint64_t SKL_DCO_MAX_POS_DEVIATION = 100;
  */
 static constexpr uint64_t SKL_DCO_MAX_NEG_DEVIATION = 600;
 
+/**
+ *  All possible DCO central frequency values
+ */
+static constexpr uint64_t SKL_DCO_CENTRAL_FREQUENCIES[3] = {8400000000ULL, 9000000000ULL, 9600000000ULL};
+
+/**
+ *  The lowest and the highest DCO frequencies that may satisfy the deviation requirements
+ *
+ *  @note These bounds narrow the divider search before the exact deviation is checked.
+ */
+static constexpr uint64_t SKL_DCO_MIN_FREQUENCY = SKL_DCO_CENTRAL_FREQUENCIES[0] / 10000 * (10000 - SKL_DCO_MAX_NEG_DEVIATION);
+static constexpr uint64_t SKL_DCO_MAX_FREQUENCY = SKL_DCO_CENTRAL_FREQUENCIES[2] / 10000 * (10000 + SKL_DCO_MAX_POS_DEVIATION);
+
+/**
+ *  The largest possible DCO divider
+ */
+static constexpr uint32_t SKL_DCO_MAX_DIVIDER = 98;
+
+/**
+ *  P0, P1 and P2 values corresponding to a DCO divider
+ */
+struct DividerMultipliers {
+	uint8_t p0 {};
+	uint8_t p1 {};
+	uint8_t p2 {};
+};
+
+/**
+ *  Compute P0, P1 and P2 values for the given DCO divider
+ *
+ *  @param p The DCO divider
+ *  @return The multipliers, all zero if the divider is not supported.
+ *  @ref static void skl_wrpll_get_multipliers(p:p0:p1:p2:)
+ */
+static constexpr DividerMultipliers computeDividerMultipliers(uint32_t p) {
+	DividerMultipliers m {};
+
+	// Even divider
+	if (p % 2 == 0) {
+		uint32_t half = p / 2;
+		if (half == 1 || half == 2 || half == 3 || half == 5) {
+			m.p0 = 2;
+			m.p1 = 1;
+			m.p2 = half;
+		} else if (half % 2 == 0) {
+			m.p0 = 2;
+			m.p1 = half / 2;
+			m.p2 = 2;
+		} else if (half % 3 == 0) {
+			m.p0 = 3;
+			m.p1 = half / 3;
+			m.p2 = 2;
+		} else if (half % 7 == 0) {
+			m.p0 = 7;
+			m.p1 = half / 7;
+			m.p2 = 2;
+		}
+	}
+	// Odd divider
+	else if (p == 3 || p == 9) {
+		m.p0 = 3;
+		m.p1 = 1;
+		m.p2 = p / 3;
+	} else if (p == 5 || p == 7) {
+		m.p0 = p;
+		m.p1 = 1;
+		m.p2 = 1;
+	} else if (p == 15) {
+		m.p0 = 3;
+		m.p1 = 1;
+		m.p2 = 5;
+	} else if (p == 21) {
+		m.p0 = 7;
+		m.p1 = 1;
+		m.p2 = 3;
+	} else if (p == 35) {
+		m.p0 = 7;
+		m.p1 = 1;
+		m.p2 = 5;
+	}
+
+	return m;
+}
+
+/**
+ *  P0, P1 and P2 values of every DCO divider up to SKL_DCO_MAX_DIVIDER
+ */
+struct DividerMultipliersTable {
+	DividerMultipliers entries[SKL_DCO_MAX_DIVIDER + 1] {};
+
+	constexpr DividerMultipliersTable() {
+		for (uint32_t p = 0; p <= SKL_DCO_MAX_DIVIDER; p++)
+			entries[p] = computeDividerMultipliers(p);
+	}
+};
+
+static constexpr DividerMultipliersTable SKL_DCO_DIVIDER_MULTIPLIERS {};
+
+static_assert(SKL_DCO_DIVIDER_MULTIPLIERS.entries[98].p0 == 7 && SKL_DCO_DIVIDER_MULTIPLIERS.entries[98].p1 == 7 &&
+			  SKL_DCO_DIVIDER_MULTIPLIERS.entries[98].p2 == 2, "Invalid multipliers table, please check your compiler.");
+static_assert(SKL_DCO_DIVIDER_MULTIPLIERS.entries[35].p0 == 7 && SKL_DCO_DIVIDER_MULTIPLIERS.entries[35].p1 == 1 &&
+			  SKL_DCO_DIVIDER_MULTIPLIERS.entries[35].p2 == 5, "Invalid multipliers table, please check your compiler.");
+
 /**
  *  Reflect the `AppleIntelFramebufferController::CRTCParams` struct
  *
@@ -683,6 +892,8 @@ void IGFX::HDMIDividersCalcFix::processKernel(KernelPatcher &patcher, DeviceInfo
 	// Of if "enable-hdmi-dividers-fix" is set in IGPU property
 	if (!enabled)
 		enabled = info->videoBuiltin->getProperty("enable-hdmi-dividers-fix") != nullptr;
+	if (enabled)
+		publishCacheStatistics(info->videoBuiltin);
 }
 
 void IGFX::HDMIDividersCalcFix::processFramebufferKext(KernelPatcher &patcher, size_t index, mach_vm_address_t address, size_t size) {
@@ -692,58 +903,94 @@ void IGFX::HDMIDividersCalcFix::processFramebufferKext(KernelPatcher &patcher, s
 }
 
 void IGFX::HDMIDividersCalcFix::populateP0P1P2(struct ProbeContext *context) {
-	uint32_t p = context->divider;
-	uint32_t p0 = 0;
-	uint32_t p1 = 0;
-	uint32_t p2 = 0;
+	DividerMultipliers m {};
+	if (context->divider <= SKL_DCO_MAX_DIVIDER)
+		m = SKL_DCO_DIVIDER_MULTIPLIERS.entries[context->divider];
 
-	// Even divider
-	if (p % 2 == 0) {
-		uint32_t half = p / 2;
-		if (half == 1 || half == 2 || half == 3 || half == 5) {
-			p0 = 2;
-			p1 = 1;
-			p2 = half;
-		} else if (half % 2 == 0) {
-			p0 = 2;
-			p1 = half / 2;
-			p2 = 2;
-		} else if (half % 3 == 0) {
-			p0 = 3;
-			p1 = half / 3;
-			p2 = 2;
-		} else if (half % 7 == 0) {
-			p0 = 7;
-			p1 = half / 7;
-			p2 = 2;
+	context->pdiv = m.p0;
+	context->qdiv = m.p1;
+	context->kdiv = m.p2;
+}
+
+bool IGFX::HDMIDividersCalcFix::lookupDividers(uint32_t pixelClock, CachedDividers &result) {
+	for (auto &entry : dividersCache) {
+		// Skip entries being written and entries modified while being read
+		uint32_t sequence = __atomic_load_n(&entry.sequence, __ATOMIC_ACQUIRE);
+		if (sequence & 1)
+			continue;
+		if (__atomic_load_n(&entry.pixelClock, __ATOMIC_RELAXED) != pixelClock)
+			continue;
+		result.pdiv = __atomic_load_n(&entry.pdiv, __ATOMIC_RELAXED);
+		result.qdiv = __atomic_load_n(&entry.qdiv, __ATOMIC_RELAXED);
+		result.kdiv = __atomic_load_n(&entry.kdiv, __ATOMIC_RELAXED);
+		result.multiplier = __atomic_load_n(&entry.multiplier, __ATOMIC_RELAXED);
+		result.fraction = __atomic_load_n(&entry.fraction, __ATOMIC_RELAXED);
+		result.cf15625 = __atomic_load_n(&entry.cf15625, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&entry.sequence, __ATOMIC_RELAXED) != sequence)
+			continue;
+
+		// The use order is only a hint for eviction, a lost update is harmless
+		result.pixelClock = pixelClock;
+		__atomic_store_n(&entry.lastUse, __atomic_add_fetch(&cacheClock, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+		return true;
+	}
+
+	return false;
+}
+
+void IGFX::HDMIDividersCalcFix::storeDividers(const CachedDividers &entry) {
+	// Writers are serialized, a miss racing with another writer is simply not cached
+	if (__atomic_exchange_n(&cacheWriting, true, __ATOMIC_ACQUIRE))
+		return;
+
+	// Prefer an unused entry, otherwise evict the least recently used one
+	auto victim = &dividersCache[0];
+	for (auto &current : dividersCache) {
+		if (current.pixelClock == 0) {
+			victim = &current;
+			break;
 		}
+		if (__atomic_load_n(&current.lastUse, __ATOMIC_RELAXED) < __atomic_load_n(&victim->lastUse, __ATOMIC_RELAXED))
+			victim = &current;
 	}
-	// Odd divider
-	else if (p == 3 || p == 9) {
-		p0 = 3;
-		p1 = 1;
-		p2 = p / 3;
-	} else if (p == 5 || p == 7) {
-		p0 = p;
-		p1 = 1;
-		p2 = 1;
-	} else if (p == 15) {
-		p0 = 3;
-		p1 = 1;
-		p2 = 5;
-	} else if (p == 21) {
-		p0 = 7;
-		p1 = 1;
-		p2 = 3;
-	} else if (p == 35) {
-		p0 = 7;
-		p1 = 1;
-		p2 = 5;
+
+	uint32_t sequence = victim->sequence;
+	__atomic_store_n(&victim->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&victim->pixelClock, entry.pixelClock, __ATOMIC_RELAXED);
+	__atomic_store_n(&victim->pdiv, entry.pdiv, __ATOMIC_RELAXED);
+	__atomic_store_n(&victim->qdiv, entry.qdiv, __ATOMIC_RELAXED);
+	__atomic_store_n(&victim->kdiv, entry.kdiv, __ATOMIC_RELAXED);
+	__atomic_store_n(&victim->multiplier, entry.multiplier, __ATOMIC_RELAXED);
+	__atomic_store_n(&victim->fraction, entry.fraction, __ATOMIC_RELAXED);
+	__atomic_store_n(&victim->cf15625, entry.cf15625, __ATOMIC_RELAXED);
+	__atomic_store_n(&victim->lastUse, __atomic_add_fetch(&cacheClock, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+	__atomic_store_n(&victim->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&cacheWriting, false, __ATOMIC_RELEASE);
+}
+
+void IGFX::HDMIDividersCalcFix::publishCacheStatistics(IORegistryEntry *igpu) {
+	if (igpu == nullptr)
+		return;
+
+	auto stats = OSDictionary::withCapacity(2);
+	auto hits = OSNumber::withNumber(0ULL, 32);
+	auto misses = OSNumber::withNumber(0ULL, 32);
+	if (stats != nullptr && hits != nullptr && misses != nullptr &&
+		stats->setObject("Hits", hits) && stats->setObject("Misses", misses) &&
+		igpu->setProperty("fw-hdmi-dividers-cache", stats)) {
+		// The registry keeps the dictionary, which keeps the numbers
+		cacheHitsNumber = hits;
+		cacheMissesNumber = misses;
+	} else {
+		SYSLOG("igfx", "HDC: Failed to publish the dividers cache statistics.");
 	}
 
-	context->pdiv = p0;
-	context->qdiv = p1;
-	context->kdiv = p2;
+	OSSafeReleaseNULL(hits);
+	OSSafeReleaseNULL(misses);
+	OSSafeReleaseNULL(stats);
 }
 
 void IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(AppleIntelFramebufferController *that, uint32_t pixelClock, void *displayPath, void *parameters) {
@@ -784,6 +1031,35 @@ void IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(AppleIntelFramebufferContr
 
 	DBGLOG("igfx", "HDC: ComputeHdmiP0P1P2() DInfo: Called with pixel clock = %d Hz.", pixelClock);
 
+	// Guard: The given CRTC parameters should never be NULL
+	if (parameters == nullptr) {
+		DBGLOG("igfx", "HDC: ComputeHdmiP0P1P2() Error: The given CRTC parameters should not be NULL.");
+		return;
+	}
+
+	auto module = &callbackIGFX->modHDMIDividersCalcFix;
+	auto params = reinterpret_cast<CRTCParams*>(parameters);
+
+	// Guard: Repeated modesets reuse the parameters computed previously
+	CachedDividers cached;
+	if (module->lookupDividers(pixelClock, cached)) {
+		params->pdiv = cached.pdiv;
+		params->qdiv = cached.qdiv;
+		params->kdiv = cached.kdiv;
+		params->multiplier = cached.multiplier;
+		params->fraction = cached.fraction;
+		params->cf15625 = cached.cf15625;
+		auto hits = __atomic_add_fetch(&module->cacheHits, 1, __ATOMIC_RELAXED);
+		if (module->cacheHitsNumber != nullptr)
+			module->cacheHitsNumber->setValue(hits);
+		DBGLOG("igfx", "HDC: ComputeHdmiP0P1P2() DInfo: CTRC parameters have been populated from the cache.");
+		return;
+	}
+
+	auto misses = __atomic_add_fetch(&module->cacheMisses, 1, __ATOMIC_RELAXED);
+	if (module->cacheMissesNumber != nullptr)
+		module->cacheMissesNumber->setValue(misses);
+
 	/// All possible dividers
 	static constexpr uint32_t dividers[] = {
 		// Even dividers
@@ -796,9 +1072,6 @@ void IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(AppleIntelFramebufferContr
 		3, 5, 7, 9, 15, 21, 35
 	};
 
-	/// All possible central frequency values
-	static constexpr uint64_t centralFrequencies[3] = {8400000000ULL, 9000000000ULL, 9600000000ULL};
-
 	// Calculate the AFE clock
 	uint64_t afeClock = static_cast<uint64_t>(pixelClock) * 5;
 
@@ -811,13 +1084,22 @@ void IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(AppleIntelFramebufferContr
 	// It's OK because the deviation is still bound by MAX_POS_DEV and MAX_NEG_DEV.
 	context.minDeviation = UINT64_MAX;
 
+	// Only dividers that bring the DCO frequency close to one of the central frequencies are worth checking
+	uint64_t minDivider = afeClock != 0 ? SKL_DCO_MIN_FREQUENCY / afeClock : UINT64_MAX;
+	uint64_t maxDivider = afeClock != 0 ? SKL_DCO_MAX_FREQUENCY / afeClock + 1 : 0;
+	DBGLOG("igfx", "HDC: ComputeHdmiP0P1P2() DInfo: Probing dividers from %llu to %llu.", minDivider, maxDivider);
+
+	bool found = false;
 	for (auto divider : dividers) {
-		for (auto central : centralFrequencies) {
+		// Guard: The divider may produce a DCO frequency within the allowed range
+		if (divider < minDivider || divider > maxDivider)
+			continue;
+
+		for (auto central : SKL_DCO_CENTRAL_FREQUENCIES) {
 			// Calculate the current DCO frequency
 			uint64_t frequency = divider * afeClock;
 			// Calculate the deviation
 			uint64_t deviation = (frequency > central ? frequency - central : central - frequency) * 10000 / central;
-			DBGLOG("igfx", "HDC: ComputeHdmiP0P1P2() DInfo: Dev = %6llu; Central = %10llu Hz; DCO Freq = %12llu Hz; Divider = %2d.\n", deviation, central, frequency, divider);
 
 			// Guard: Positive deviation is within the allowed range
 			if (frequency >= central && deviation >= SKL_DCO_MAX_POS_DEVIATION)
@@ -844,11 +1126,16 @@ void IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(AppleIntelFramebufferContr
 				continue;
 
 			// Guard: An even divider is preferred
+			// Nothing can beat it, so the search is over
 			if (divider % 2 == 0) {
 				DBGLOG("igfx", "HDC: ComputeHdmiP0P1P2() DInfo: Found an even divider [%d] with deviation 0.\n", divider);
+				found = true;
 				break;
 			}
 		}
+
+		if (found)
+			break;
 	}
 
 	// Guard: A valid divider has been found
@@ -867,14 +1154,7 @@ void IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(AppleIntelFramebufferContr
 	uint32_t cf15625 = (uint32_t) (context.central / 15625);
 	DBGLOG("igfx", "HDC: ComputeHdmiP0P1P2() DInfo: Multiplier = %d; Fraction = %d; CF15625 = %d.\n", multiplier, fraction, cf15625);
 	
-	// Guard: The given CRTC parameters should never be NULL
-	if (parameters == nullptr) {
-		DBGLOG("igfx", "HDC: ComputeHdmiP0P1P2() Error: The given CRTC parameters should not be NULL.");
-		return;
-	}
-	
 	// Save all parameters
-	auto params = reinterpret_cast<CRTCParams*>(parameters);
 	params->pdiv = context.pdiv;
 	params->qdiv = context.qdiv;
 	params->kdiv = context.kdiv;
@@ -882,6 +1162,18 @@ void IGFX::HDMIDividersCalcFix::wrapComputeHdmiP0P1P2(AppleIntelFramebufferContr
 	params->fraction = fraction;
 	params->cf15625 = cf15625;
 	DBGLOG("igfx", "HDC: ComputeHdmiP0P1P2() DInfo: CTRC parameters have been populated successfully.");
+
+	// Remember the parameters for the next modeset with the same pixel clock
+	CachedDividers entry {};
+	entry.pixelClock = pixelClock;
+	entry.pdiv = context.pdiv;
+	entry.qdiv = context.qdiv;
+	entry.kdiv = context.kdiv;
+	entry.multiplier = multiplier;
+	entry.fraction = fraction;
+	entry.cf15625 = cf15625;
+	if (pixelClock != 0)
+		module->storeDividers(entry);
 	return;
 }
 
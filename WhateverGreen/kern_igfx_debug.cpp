@@ -112,12 +112,14 @@ static IOReturn fbdebugWrapGetOnlineInfo(IOService *framebuffer, void *displayPa
 	return ret;
 }
 
-static IOReturn fbdebugWrapDoSetPowerState(IOService *framebuffer, uint32_t state) {
+IOReturn IGFX::FramebufferDebugSupport::wrapDoSetPowerState(IOService *framebuffer, uint32_t state) {
 	// state 0 = sleep, 1 = wake, 2 = doze, cap at doze if higher.
 	auto idxnum = OSDynamicCast(OSNumber, framebuffer->getProperty("IOFBDependentIndex"));
 	int idx = (idxnum != nullptr) ? (int) idxnum->unsigned32BitValue() : -1;
 	SYSLOG("igfx", "[ doSetPowerState %d %u", idx, state);
-	IOReturn ret = FunctionCast(fbdebugWrapDoSetPowerState, fbdebugOrgDoSetPowerState)(framebuffer, state);
+	// MLR shares this route to drop its DPCD shadow
+	callbackIGFX->modDPCDMaxLinkRateFix.onPowerStateChange(state);
+	IOReturn ret = FunctionCast(wrapDoSetPowerState, fbdebugOrgDoSetPowerState)(framebuffer, state);
 	char resultStr[40];
 	SYSLOG("igfx", "] doSetPowerState %d %u%s", idx, state, DumpOneReturn(resultStr, sizeof(resultStr), ret));
 	return ret;
@@ -208,7 +210,7 @@ void IGFX::FramebufferDebugSupport::processFramebufferKext(KernelPatcher &patche
 		{"__ZN21AppleIntelFramebuffer15connectionProbeEjj", fbdebugWrapConnectionProbe, fbdebugOrgConnectionProbe},
 		{"__ZN21AppleIntelFramebuffer16getDisplayStatusEP21AppleIntelDisplayPath", fbdebugWrapGetDisplayStatus, fbdebugOrgGetDisplayStatus},
 		{"__ZN21AppleIntelFramebuffer13GetOnlineInfoEP21AppleIntelDisplayPathPhS2_PNS0_15DisplayPortTypeEPbb", fbdebugWrapGetOnlineInfo, fbdebugOrgGetOnlineInfo},
-		{"__ZN21AppleIntelFramebuffer15doSetPowerStateEj", fbdebugWrapDoSetPowerState, fbdebugOrgDoSetPowerState},
+		{"__ZN21AppleIntelFramebuffer15doSetPowerStateEj", wrapDoSetPowerState, fbdebugOrgDoSetPowerState},
 		{"__ZN21AppleIntelFramebuffer18IsMultiLinkDisplayEv", fbdebugWrapIsMultilinkDisplay, fbdebugOrgIsMultilinkDisplay},
 		{"__ZN21AppleIntelFramebuffer19validateDisplayModeEiPPKNS_15ModeDescriptionEPPK29IODetailedTimingInformationV2", fbdebugWrapValidateDisplayMode, fbdebugOrgValidateDisplayMode},
 		{"__ZN31AppleIntelFramebufferController18hasExternalDisplayEv", fbdebugWrapHasExternalDisplay, fbdebugOrgHasExternalDisplay},
@@ -220,6 +222,10 @@ void IGFX::FramebufferDebugSupport::processFramebufferKext(KernelPatcher &patche
 
 	if (!patcher.routeMultiple(index, requests, address, size, true, true))
 		SYSLOG("igfx", "DBG: Failed to route igfx tracing.");
+	
+	// MLR does not route doSetPowerState itself while framebuffer debugging is enabled
+	if (callbackIGFX->modDPCDMaxLinkRateFix.enabled)
+		callbackIGFX->modDPCDMaxLinkRateFix.onPowerStateHooked(fbdebugOrgDoSetPowerState != 0);
 }
 
 #else
@@ -74,11 +74,40 @@ IOReturn IGFX::AdvancedI2COverAUXSupport::wrapWriteI2COverAUX(void *that, IORegi
 	}
 }
 
-IOReturn IGFX::AdvancedI2COverAUXSupport::advSeekI2COverAUX(void *that, IORegistryEntry *framebuffer, void *displayPath, uint32_t address, uint32_t offset, uint8_t flags) {
+IGFX::AdvancedI2COverAUXSupport::Transfer IGFX::AdvancedI2COverAUXSupport::beginTransfer(void *that, IORegistryEntry *framebuffer, void *displayPath, uint32_t address, uint8_t flags) {
+	Transfer transfer {that, framebuffer, displayPath, address, flags, 0xFF};
+	if (verbose)
+		AppleIntelFramebufferExplorer::getIndex(framebuffer, transfer.index);
+	return transfer;
+}
+
+IOReturn IGFX::AdvancedI2COverAUXSupport::transferRead(const Transfer &transfer, uint16_t length, uint8_t *buffer, bool intermediate) {
+	// The request is logged up front, so a transaction that never returns still shows up
+	if (verbose)
+		DBGLOG("igfx", "I2C:  ReadI2COverAUX() FB%d: Addr = 0x%02x; Len = %02d; MOT = %d; Flags = %d.",
+			   transfer.index, transfer.address, length, intermediate, transfer.flags);
+	IOReturn retVal = orgReadI2COverAUX(transfer.that, transfer.framebuffer, transfer.displayPath, transfer.address, length, buffer, intermediate, transfer.flags);
+	if (verbose && retVal != kIOReturnSuccess)
+		DBGLOG("igfx", "I2C:  ReadI2COverAUX() FB%d: Failed with 0x%x.", transfer.index, retVal);
+	return retVal;
+}
+
+IOReturn IGFX::AdvancedI2COverAUXSupport::transferWrite(const Transfer &transfer, uint16_t length, uint8_t *buffer, bool intermediate) {
+	// The request is logged up front, so a transaction that never returns still shows up
+	if (verbose)
+		DBGLOG("igfx", "I2C: WriteI2COverAUX() FB%d: Addr = 0x%02x; Len = %02d; MOT = %d; Flags = 0.",
+			   transfer.index, transfer.address, length, intermediate);
+	IOReturn retVal = orgWriteI2COverAUX(transfer.that, transfer.framebuffer, transfer.displayPath, transfer.address, length, buffer, intermediate);
+	if (verbose && retVal != kIOReturnSuccess)
+		DBGLOG("igfx", "I2C: WriteI2COverAUX() FB%d: Failed with 0x%x.", transfer.index, retVal);
+	return retVal;
+}
+
+IOReturn IGFX::AdvancedI2COverAUXSupport::transferSeek(const Transfer &transfer, uint32_t offset) {
 	// No need to check the given `address` and `offset`
 	// if they are invalid, the underlying RunAUXCommand() will return an error
 	// First start the transaction by performing an empty write
-	IOReturn retVal = wrapWriteI2COverAUX(that, framebuffer, displayPath, address, 0, nullptr, true);
+	IOReturn retVal = transferWrite(transfer, 0, nullptr, true);
 
 	// Guard: Check the START transaction
 	if (retVal != kIOReturnSuccess) {
@@ -88,7 +117,12 @@ IOReturn IGFX::AdvancedI2COverAUXSupport::advSeekI2COverAUX(void *that, IORegist
 
 	// Write a single byte to the given I2C slave
 	// and set the Middle-of-Transaction bit to 1
-	return wrapWriteI2COverAUX(that, framebuffer, displayPath, address, 1, reinterpret_cast<uint8_t*>(&offset), true);
+	return transferWrite(transfer, 1, reinterpret_cast<uint8_t*>(&offset), true);
+}
+
+IOReturn IGFX::AdvancedI2COverAUXSupport::advSeekI2COverAUX(void *that, IORegistryEntry *framebuffer, void *displayPath, uint32_t address, uint32_t offset, uint8_t flags) {
+	auto &module = callbackIGFX->modAdvancedI2COverAUXSupport;
+	return module.transferSeek(module.beginTransfer(that, framebuffer, displayPath, address, flags), offset);
 }
 
 IOReturn IGFX::AdvancedI2COverAUXSupport::advReadI2COverAUX(void *that, IORegistryEntry *framebuffer, void *displayPath, uint32_t address, uint32_t offset, uint16_t length, uint8_t *buffer, uint8_t flags) {
@@ -104,8 +138,12 @@ IOReturn IGFX::AdvancedI2COverAUXSupport::advReadI2COverAUX(void *that, IORegist
 		return kIOReturnInvalid;
 	}
 
+	// All AUX transactions of this transfer share a single context
+	auto &module = callbackIGFX->modAdvancedI2COverAUXSupport;
+	auto transfer = module.beginTransfer(that, framebuffer, displayPath, address, flags);
+
 	// Guard: Start the transaction and set the access offset successfully
-	IOReturn retVal = advSeekI2COverAUX(that, framebuffer, displayPath, address, offset, flags);
+	IOReturn retVal = module.transferSeek(transfer, offset);
 	if (retVal != kIOReturnSuccess) {
 		SYSLOG("igfx", "I2C: AdvReadI2COverAUX() Error: Failed to set the data offset.");
 		return retVal;
@@ -114,17 +152,18 @@ IOReturn IGFX::AdvancedI2COverAUXSupport::advReadI2COverAUX(void *that, IORegist
 	// Process the read request
 	// ReadI2COverAUX() can only process up to 16 bytes in one AUX transaction
 	// because the burst data size is 20 bytes, in which the first 4 bytes are used for the AUX message header
+	// The Middle-of-Transaction bit stays set, so the slave keeps streaming from the current offset
 	while (length != 0) {
 		// Calculate the new length for this I2C-over-AUX transaction
 		uint16_t newLength = length >= 16 ? 16 : length;
 
 		// This is an intermediate transaction
-		retVal = wrapReadI2COverAUX(that, framebuffer, displayPath, address, newLength, buffer, true, flags);
+		retVal = module.transferRead(transfer, newLength, buffer, true);
 
 		// Guard: The intermediate transaction succeeded
 		if (retVal != kIOReturnSuccess) {
 			// Terminate the transaction
-			wrapReadI2COverAUX(that, framebuffer, displayPath, address, 0, nullptr, false, flags);
+			module.transferRead(transfer, 0, nullptr, false);
 			return retVal;
 		}
 
@@ -135,7 +174,7 @@ IOReturn IGFX::AdvancedI2COverAUXSupport::advReadI2COverAUX(void *that, IORegist
 
 	// All intermediate transactions succeeded
 	// Terminate the transaction
-	return wrapReadI2COverAUX(that, framebuffer, displayPath, address, 0, nullptr, false, flags);
+	return module.transferRead(transfer, 0, nullptr, false);
 }
 
 IOReturn IGFX::AdvancedI2COverAUXSupport::advWriteI2COverAUX(void *that, IORegistryEntry *framebuffer, void *displayPath, uint32_t address, uint32_t offset, uint16_t length, uint8_t *buffer, uint8_t flags) {
@@ -151,8 +190,12 @@ IOReturn IGFX::AdvancedI2COverAUXSupport::advWriteI2COverAUX(void *that, IORegis
 		return kIOReturnInvalid;
 	}
 
+	// All AUX transactions of this transfer share a single context
+	auto &module = callbackIGFX->modAdvancedI2COverAUXSupport;
+	auto transfer = module.beginTransfer(that, framebuffer, displayPath, address, flags);
+
 	// Guard: Start the transaction and set the access offset successfully
-	IOReturn retVal = advSeekI2COverAUX(that, framebuffer, displayPath, address, offset, flags);
+	IOReturn retVal = module.transferSeek(transfer, offset);
 	if (retVal != kIOReturnSuccess) {
 		SYSLOG("igfx", "I2C: AdvWriteI2COverAUX() Error: Failed to set the data offset.");
 		return retVal;
@@ -166,12 +209,12 @@ IOReturn IGFX::AdvancedI2COverAUXSupport::advWriteI2COverAUX(void *that, IORegis
 		uint16_t newLength = length >= 16 ? 16 : length;
 
 		// This is an intermediate transaction
-		retVal = wrapWriteI2COverAUX(that, framebuffer, displayPath, address, newLength, buffer, true);
+		retVal = module.transferWrite(transfer, newLength, buffer, true);
 
 		// Guard: The intermediate transaction succeeded
 		if (retVal != kIOReturnSuccess) {
 			// Terminate the transaction
-			wrapWriteI2COverAUX(that, framebuffer, displayPath, address, 0, nullptr, false);
+			module.transferWrite(transfer, 0, nullptr, false);
 			return retVal;
 		}
 
@@ -182,5 +225,5 @@ IOReturn IGFX::AdvancedI2COverAUXSupport::advWriteI2COverAUX(void *that, IORegis
 
 	// All intermediate transactions succeeded
 	// Terminate the transaction
-	return wrapWriteI2COverAUX(that, framebuffer, displayPath, address, 0, nullptr, false);
+	return module.transferWrite(transfer, 0, nullptr, false);
 }
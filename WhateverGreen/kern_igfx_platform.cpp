@@ -0,0 +1,633 @@
+//
+//  kern_igfx_platform.cpp
+//  WhateverGreen
+//
+//  Copyright © 2018 vit9696. All rights reserved.
+//
+
+#include "kern_igfx.hpp"
+#include <Headers/kern_util.hpp>
+
+///
+/// This file contains the edits to gPlatformInformationList
+///
+/// 1. Framebuffer field patches and find / replace patches from device properties.
+/// 2. DP to HDMI connector autopatch.
+///
+/// Both are compiled into a plan and applied in one walk over the list.
+///
+
+
+uint8_t *IGFX::findFramebufferId(uint32_t framebufferId, uint8_t *startingAddress, size_t maxSize) {
+	uint32_t *startAddress = reinterpret_cast<uint32_t *>(startingAddress);
+	uint32_t *endAddress = reinterpret_cast<uint32_t *>(startingAddress + maxSize);
+	while (startAddress < endAddress) {
+		if (*startAddress == framebufferId)
+			return reinterpret_cast<uint8_t *>(startAddress);
+		startAddress++;
+	}
+
+	return nullptr;
+}
+
+size_t IGFX::calculatePlatformListSize(size_t maxSize) {
+	// sanity check maxSize
+	if (maxSize < sizeof(uint32_t)*2)
+		return maxSize;
+	// ig-platform-id table ends with 0xFFFFF, but to avoid false positive
+	// look for FFFFFFFF 00000000
+	// and Sandy Bridge is special, ending in 00000000 000c0c0c
+	uint8_t * startingAddress = reinterpret_cast<uint8_t *>(gPlatformInformationList);
+	uint32_t *startAddress = reinterpret_cast<uint32_t *>(startingAddress);
+	uint32_t *endAddress = reinterpret_cast<uint32_t *>(startingAddress + maxSize - sizeof(uint32_t));
+	while (startAddress < endAddress) {
+		if ((!gPlatformListIsSNB && 0xffffffff == startAddress[0] && 0 == startAddress[1]) ||
+			(gPlatformListIsSNB && 0 == startAddress[0] && 0x0c0c0c00 == startAddress[1]))
+			return reinterpret_cast<uint8_t *>(startAddress) - startingAddress + sizeof(uint32_t)*2;
+		startAddress++;
+	}
+
+	return maxSize; // in case of no termination, just return maxSize
+}
+
+template <typename R, typename F>
+R IGFX::visitPlatformInformationLayout(F visitor, R unknown) {
+	auto cpuGeneration = BaseDeviceInfo::get().cpuGeneration;
+	if (cpuGeneration == CPUInfo::CpuGeneration::SandyBridge)
+		return visitor(static_cast<FramebufferSNB *>(nullptr));
+	else if (cpuGeneration == CPUInfo::CpuGeneration::IvyBridge)
+		return visitor(static_cast<FramebufferIVB *>(nullptr));
+	else if (cpuGeneration == CPUInfo::CpuGeneration::Haswell)
+		return visitor(static_cast<FramebufferHSW *>(nullptr));
+	else if (cpuGeneration == CPUInfo::CpuGeneration::Broadwell)
+		return visitor(static_cast<FramebufferBDW *>(nullptr));
+	else if (cpuGeneration == CPUInfo::CpuGeneration::Skylake || cpuGeneration == CPUInfo::CpuGeneration::KabyLake ||
+			 (cpuGeneration == CPUInfo::CpuGeneration::CoffeeLake && static_cast<FramebufferSKL *>(gPlatformInformationList)->framebufferId == 0x591E0000))
+		//FIXME: write this in a nicer way (coffee pretending to be Kaby, detecting via first kaby frame)
+		return visitor(static_cast<FramebufferSKL *>(nullptr));
+	else if (cpuGeneration == CPUInfo::CpuGeneration::CoffeeLake)
+		return visitor(static_cast<FramebufferCFL *>(nullptr));
+	else if (cpuGeneration == CPUInfo::CpuGeneration::CometLake)
+		return visitor(static_cast<FramebufferCFL *>(nullptr));
+	else if (cpuGeneration == CPUInfo::CpuGeneration::CannonLake)
+		return visitor(static_cast<FramebufferCNL *>(nullptr));
+	else if (cpuGeneration == CPUInfo::CpuGeneration::IceLake) {
+		// FIXME: Need to address possible circumstance of both ICL kexts loaded at the same time
+		if (callbackIGFX->currentFramebuffer->loadIndex != KernelPatcher::KextInfo::Unloaded)
+			return visitor(static_cast<FramebufferICLLP *>(nullptr));
+		else if (callbackIGFX->currentFramebufferOpt->loadIndex != KernelPatcher::KextInfo::Unloaded)
+			return visitor(static_cast<FramebufferICLHP *>(nullptr));
+	}
+
+	return unknown;
+}
+
+size_t IGFX::platformInformationEntrySize() {
+	return visitPlatformInformationLayout([](auto layout) { return platformInformationEntrySize(layout); }, static_cast<size_t>(0));
+}
+
+static size_t framebufferIndexSlot(uint32_t framebufferId) {
+	// Ids mostly differ in their upper half, multiplicative hashing spreads them over the slots.
+	return (framebufferId * 2654435761U) >> (32 - 6);
+}
+
+void IGFX::buildFramebufferIndex() {
+	static_assert(IGFX::FramebufferIndexSize == 1U << 6, "Update framebufferIndexSlot");
+	static_assert(PAGE_SIZE <= UINT16_MAX, "Frame offsets must fit the index slot");
+
+	framebufferIndexBuilt = true;
+	size_t entrySize = platformInformationEntrySize();
+	if (!gPlatformInformationList || entrySize == 0)
+		return;
+
+	// Sandy Bridge frames carry no id, lookups keep using the word scan there so that
+	// find / replace patches target the same bytes as before.
+	if (gPlatformListIsSNB)
+		return;
+
+	auto list = static_cast<uint8_t *>(gPlatformInformationList);
+	size_t listSize = calculatePlatformListSize(PAGE_SIZE);
+	size_t count = 0;
+	for (size_t offset = 0; offset + entrySize <= listSize; offset += entrySize) {
+		uint32_t framebufferId = *reinterpret_cast<uint32_t *>(list + offset);
+		if (framebufferId == 0xFFFFFFFF)
+			break;
+
+		// The first frame with a given id wins, like with a linear search.
+		for (size_t probe = 0, slot = framebufferIndexSlot(framebufferId); probe < FramebufferIndexSize; probe++, slot = (slot + 1) % FramebufferIndexSize) {
+			auto &s = framebufferIndex[slot];
+			if (s.used && s.framebufferId == framebufferId)
+				break;
+			if (!s.used) {
+				s.framebufferId = framebufferId;
+				s.offset = static_cast<uint16_t>(offset);
+				s.used = true;
+				count++;
+				break;
+			}
+		}
+	}
+
+	DBGLOG("igfx", "indexed %lu framebuffers in %lu bytes of platform list", count, listSize);
+}
+
+uint8_t *IGFX::lookupFramebufferId(uint32_t framebufferId) {
+	if (!framebufferIndexBuilt)
+		buildFramebufferIndex();
+
+	auto list = static_cast<uint8_t *>(gPlatformInformationList);
+	for (size_t probe = 0, slot = framebufferIndexSlot(framebufferId); probe < FramebufferIndexSize; probe++, slot = (slot + 1) % FramebufferIndexSize) {
+		auto &s = framebufferIndex[slot];
+		if (!s.used)
+			break;
+		if (s.framebufferId == framebufferId)
+			return list + s.offset;
+	}
+
+	return findFramebufferId(framebufferId, list, PAGE_SIZE);
+}
+
+#ifdef DEBUG
+
+void IGFX::writePlatformListData(const char *subKeyName) {
+	if (BaseDeviceInfo::get().cpuGeneration < CPUInfo::CpuGeneration::SandyBridge) {
+		DBGLOG("igfx", "writePlatformListData unsupported below Sandy bridge");
+		return;
+	}
+	
+	auto entry = IORegistryEntry::fromPath("IOService:/IOResources/WhateverGreen");
+	if (entry) {
+		entry->setProperty(subKeyName, gPlatformInformationList, static_cast<unsigned>(calculatePlatformListSize(PAGE_SIZE)));
+		entry->release();
+	}
+}
+#endif
+
+size_t IGFX::findPatchAnchor(const KernelPatcher::LookupPatch &patch) {
+	// Prefer a fully unmasked byte that is neither 0x00 nor 0xFF, as these are by far
+	// the most common values in framebuffer data and would produce too many candidates.
+	size_t anchor = patch.size;
+	for (size_t i = 0; i < patch.size; i++) {
+		if (patch.maskFind && patch.maskFind[i] != 0xFF)
+			continue;
+		if (patch.find[i] != 0x00 && patch.find[i] != 0xFF)
+			return i;
+		if (anchor == patch.size)
+			anchor = i;
+	}
+
+	return anchor;
+}
+
+uint8_t *IGFX::findPatchCandidate(const KernelPatcher::LookupPatch &patch, size_t anchor, uint8_t *currentAddress, uint8_t *endingAddress) {
+	// A match at currentAddress needs currentAddress + patch.size to stay below endingAddress.
+	if (currentAddress >= endingAddress || static_cast<size_t>(endingAddress - currentAddress) <= patch.size)
+		return endingAddress;
+
+	uint8_t *lastAddress = endingAddress - patch.size;
+	if (anchor < patch.size) {
+		uint8_t anchorValue = patch.find[anchor];
+		while (currentAddress < lastAddress && currentAddress[anchor] != anchorValue)
+			currentAddress++;
+	}
+
+	return currentAddress < lastAddress ? currentAddress : endingAddress;
+}
+
+bool IGFX::patchBytesOverlap(const uint8_t *first, const uint8_t *firstMask, size_t firstSize, const uint8_t *second, const uint8_t *secondMask, size_t secondSize) {
+	// Try every relative position at which the two windows share at least one byte.
+	for (ssize_t shift = -static_cast<ssize_t>(secondSize) + 1; shift < static_cast<ssize_t>(firstSize); shift++) {
+		size_t i = shift > 0 ? shift : 0;
+		size_t end = firstSize < shift + secondSize ? firstSize : shift + secondSize;
+		for (; i < end; i++) {
+			uint8_t mask = (firstMask ? firstMask[i] : 0xFF) & (secondMask ? secondMask[i - shift] : 0xFF);
+			if ((first[i] & mask) != (second[i - shift] & mask))
+				break;
+		}
+		if (i == end)
+			return true;
+	}
+
+	return false;
+}
+
+bool IGFX::patchesInteract(const KernelPatcher::LookupPatch &earlier, const KernelPatcher::LookupPatch &later) {
+	// Matches of two patches can only influence each other when their windows overlap. That needs
+	// the later find to fit the earlier find or replace (chaining), or the later replace to fit the
+	// earlier find (a later patch writing over a position the earlier one matches at a higher offset).
+	// Unknown bits of the replacement are treated as matching anything.
+	return patchBytesOverlap(earlier.find, earlier.maskFind, earlier.size, later.find, later.maskFind, later.size) ||
+		patchBytesOverlap(earlier.replace, earlier.maskReplace, earlier.size, later.find, later.maskFind, later.size) ||
+		patchBytesOverlap(earlier.find, earlier.maskFind, earlier.size, later.replace, later.maskReplace, later.size);
+}
+
+void IGFX::applyPatches(const KernelPatcher::LookupPatch *patches, size_t *changes, size_t num, uint8_t *startingAddress, size_t maxSize) {
+	if (num > MaxFramebufferPatchCount) {
+		SYSLOG("igfx", "too many patches %lu in a single pass", num);
+		num = MaxFramebufferPatchCount;
+	}
+
+	uint8_t *currentAddress = startingAddress;
+	uint8_t *endingAddress = startingAddress + maxSize;
+
+	if (currentAddress < framebufferStart)
+		currentAddress = framebufferStart;
+	if (endingAddress > framebufferStart + framebufferSize)
+		endingAddress = framebufferStart + framebufferSize;
+
+	// Every patch keeps its own anchor byte, match count and next candidate found by skipping to
+	// its anchor, so the pass only stops at offsets where at least one of the patches may match.
+	// The callers only group patches that do not interact (see patchesInteract), which makes this
+	// equivalent to applying them one after another.
+	size_t anchors[MaxFramebufferPatchCount];
+	uint8_t *candidates[MaxFramebufferPatchCount];
+	for (size_t p = 0; p < num; p++) {
+		changes[p] = 0;
+		anchors[p] = findPatchAnchor(patches[p]);
+		candidates[p] = patches[p].size > 0 ? findPatchCandidate(patches[p], anchors[p], currentAddress, endingAddress) : endingAddress;
+	}
+
+	while (true) {
+		currentAddress = endingAddress;
+		for (size_t p = 0; p < num; p++) {
+			if (candidates[p] < currentAddress)
+				currentAddress = candidates[p];
+		}
+		if (currentAddress == endingAddress)
+			break;
+
+		// Earlier patches take precedence when several of them match at the same offset.
+		for (size_t p = 0; p < num; p++) {
+			if (candidates[p] != currentAddress)
+				continue;
+
+			auto &patch = patches[p];
+			size_t i = 0;
+			for (i = 0; i < patch.size; i++) {
+				uint8_t mask = patch.maskFind ? patch.maskFind[i] : 0xFF;
+				if ((currentAddress[i] & mask) != (patch.find[i] & mask))
+					break;
+			}
+			if (i != patch.size) {
+				candidates[p] = findPatchCandidate(patch, anchors[p], currentAddress + 1, endingAddress);
+				continue;
+			}
+
+			for (i = 0; i < patch.size; i++) {
+				uint8_t mask = patch.maskReplace ? patch.maskReplace[i] : 0xFF;
+				currentAddress[i] = (currentAddress[i] & ~mask) | (patch.replace[i] & mask);
+			}
+			changes[p]++;
+			if (patch.count && changes[p] >= patch.count)
+				candidates[p] = endingAddress;
+			else
+				candidates[p] = findPatchCandidate(patch, anchors[p], currentAddress + patch.size, endingAddress);
+		}
+	}
+}
+
+void IGFX::applyFramebufferPatchBatch(uint32_t framebufferId, uint8_t *platformInformationAddress, const size_t *indices, size_t num) {
+	if (num == 0)
+		return;
+
+	KernelPatcher::LookupPatch patches[MaxFramebufferPatchCount] {};
+	size_t changes[MaxFramebufferPatchCount] {};
+	for (size_t p = 0; p < num; p++) {
+		auto &entry = framebufferPatches[indices[p]];
+		patches[p].kext = currentFramebuffer;
+		patches[p].find = static_cast<const uint8_t *>(entry.find->getBytesNoCopy());
+		patches[p].replace = static_cast<const uint8_t *>(entry.replace->getBytesNoCopy());
+		patches[p].size = entry.find->getLength();
+		patches[p].count = entry.count;
+		patches[p].maskFind = nullptr;
+		patches[p].maskReplace = nullptr;
+	}
+
+	// Patches are applied in runs that share a single pass. A patch that may interact with one
+	// already in the current run starts a new run, so chained or overlapping patches still see
+	// the data exactly as sequential application would leave it.
+	size_t runStart = 0;
+	for (size_t p = 1; p <= num; p++) {
+		bool interacts = false;
+		for (size_t q = runStart; p < num && !interacts && q < p; q++)
+			interacts = patchesInteract(patches[q], patches[p]);
+		if (p < num && !interacts)
+			continue;
+
+		if (interacts)
+			DBGLOG("igfx", "patch %lu framebufferId 0x%08X overlaps earlier patches, applying after them", indices[p], framebufferId);
+		applyPatches(&patches[runStart], &changes[runStart], p - runStart, platformInformationAddress, PAGE_SIZE);
+		runStart = p;
+	}
+
+	for (size_t p = 0; p < num; p++) {
+		auto &entry = framebufferPatches[indices[p]];
+		if (changes[p] > 0)
+			DBGLOG("igfx", "patch %lu framebufferId 0x%08X successful", indices[p], framebufferId);
+		else
+			DBGLOG("igfx", "patch %lu framebufferId 0x%08X failed", indices[p], framebufferId);
+
+		entry.find->release();
+		entry.find = nullptr;
+		entry.replace->release();
+		entry.replace = nullptr;
+	}
+}
+
+template <>
+bool IGFX::applyPlatformInformationListPatch(uint32_t framebufferId, FramebufferSNB *platformInformationList, FramebufferSNB *) {
+	bool framebufferFound = false;
+
+	for (size_t i = 0; i < SandyPlatformNum; i++) {
+		if (sandyPlatformId[i] == framebufferId) {
+			if (framebufferPatchFlags.bits.FPFMobile)
+				platformInformationList[i].fMobile = framebufferPatch.fMobile;
+
+			if (framebufferPatchFlags.bits.FPFPipeCount)
+				platformInformationList[i].fPipeCount = framebufferPatch.fPipeCount;
+
+			if (framebufferPatchFlags.bits.FPFPortCount)
+				platformInformationList[i].fPortCount = framebufferPatch.fPortCount;
+
+			if (framebufferPatchFlags.bits.FPFFBMemoryCount)
+				platformInformationList[i].fFBMemoryCount = framebufferPatch.fFBMemoryCount;
+
+			for (size_t j = 0; j < arrsize(platformInformationList[i].connectors); j++) {
+				if (connectorPatchFlags[j].bits.CPFIndex)
+					platformInformationList[i].connectors[j].index = framebufferPatch.connectors[j].index;
+
+				if (connectorPatchFlags[j].bits.CPFBusId)
+					platformInformationList[i].connectors[j].busId = framebufferPatch.connectors[j].busId;
+
+				if (connectorPatchFlags[j].bits.CPFPipe)
+					platformInformationList[i].connectors[j].pipe = framebufferPatch.connectors[j].pipe;
+
+				if (connectorPatchFlags[j].bits.CPFType)
+					platformInformationList[i].connectors[j].type = framebufferPatch.connectors[j].type;
+
+				if (connectorPatchFlags[j].bits.CPFFlags)
+					platformInformationList[i].connectors[j].flags = framebufferPatch.connectors[j].flags;
+
+				if (connectorPatchFlags[j].value) {
+					DBGLOG("igfx", "patching framebufferId 0x%08X connector [%d] busId: 0x%02X, pipe: %u, type: 0x%08X, flags: 0x%08X", framebufferId, platformInformationList[i].connectors[j].index, platformInformationList[i].connectors[j].busId, platformInformationList[i].connectors[j].pipe, platformInformationList[i].connectors[j].type, platformInformationList[i].connectors[j].flags.value);
+
+					framebufferFound = true;
+				}
+			}
+
+			if (framebufferPatchFlags.value) {
+				DBGLOG("igfx", "patching framebufferId 0x%08X", framebufferId);
+				DBGLOG("igfx", "mobile: 0x%08X", platformInformationList[i].fMobile);
+				DBGLOG("igfx", "pipeCount: %u", platformInformationList[i].fPipeCount);
+				DBGLOG("igfx", "portCount: %u", platformInformationList[i].fPortCount);
+				DBGLOG("igfx", "fbMemoryCount: %u", platformInformationList[i].fFBMemoryCount);
+
+				framebufferFound = true;
+			}
+		}
+	}
+
+	return framebufferFound;
+}
+
+// Sandy and Ivy have no flags
+template <>
+void IGFX::applyPlatformInformationPatchEx(FramebufferSNB *frame) {}
+
+template <>
+void IGFX::applyPlatformInformationPatchEx(FramebufferIVB *frame) {}
+
+template <>
+void IGFX::applyPlatformInformationPatchEx(FramebufferHSW *frame) {
+	// fCursorMemorySize is Haswell specific
+	if (framebufferPatchFlags.bits.FPFFramebufferCursorSize) {
+		frame->fCursorMemorySize = fPatchCursorMemorySize;
+		DBGLOG("igfx", "fCursorMemorySize: 0x%08X", frame->fCursorMemorySize);
+	}
+
+	if (framebufferPatchFlags.bits.FPFFlags)
+		frame->flags.value = framebufferPatch.flags.value;
+
+	if (framebufferPatchFlags.bits.FPFCamelliaVersion)
+		frame->camelliaVersion = framebufferPatch.camelliaVersion;
+}
+
+template <typename T>
+void IGFX::applyPlatformInformationPatchEx(T *frame) {
+	if (framebufferPatchFlags.bits.FPFFlags)
+		frame->flags.value = framebufferPatch.flags.value;
+
+
+	if (framebufferPatchFlags.bits.FPFCamelliaVersion)
+		frame->camelliaVersion = framebufferPatch.camelliaVersion;
+}
+
+template <typename T>
+bool IGFX::applyPlatformInformationListPatch(uint32_t framebufferId, T *platformInformationList, T *frame) {
+	if (!frame)
+		return false;
+
+	bool r = false;
+
+	if (framebufferPatchFlags.bits.FPFMobile)
+		frame->fMobile = framebufferPatch.fMobile;
+
+	if (framebufferPatchFlags.bits.FPFPipeCount)
+		frame->fPipeCount = framebufferPatch.fPipeCount;
+
+	if (framebufferPatchFlags.bits.FPFPortCount)
+		frame->fPortCount = framebufferPatch.fPortCount;
+
+	if (framebufferPatchFlags.bits.FPFFBMemoryCount)
+		frame->fFBMemoryCount = framebufferPatch.fFBMemoryCount;
+
+	if (framebufferPatchFlags.bits.FPFStolenMemorySize)
+		frame->fStolenMemorySize = framebufferPatch.fStolenMemorySize;
+
+	if (framebufferPatchFlags.bits.FPFFramebufferMemorySize)
+		frame->fFramebufferMemorySize = framebufferPatch.fFramebufferMemorySize;
+
+	if (framebufferPatchFlags.bits.FPFUnifiedMemorySize)
+		frame->fUnifiedMemorySize = framebufferPatch.fUnifiedMemorySize;
+
+	if (framebufferPatchFlags.value) {
+		DBGLOG("igfx", "patching framebufferId 0x%08X", frame->framebufferId);
+		DBGLOG("igfx", "mobile: 0x%08X", frame->fMobile);
+		DBGLOG("igfx", "pipeCount: %u", frame->fPipeCount);
+		DBGLOG("igfx", "portCount: %u", frame->fPortCount);
+		DBGLOG("igfx", "fbMemoryCount: %u", frame->fFBMemoryCount);
+		DBGLOG("igfx", "stolenMemorySize: 0x%08X", frame->fStolenMemorySize);
+		DBGLOG("igfx", "framebufferMemorySize: 0x%08X", frame->fFramebufferMemorySize);
+		DBGLOG("igfx", "unifiedMemorySize: 0x%08X", frame->fUnifiedMemorySize);
+
+		r = true;
+	}
+
+	applyPlatformInformationPatchEx(frame);
+
+	for (size_t j = 0; j < arrsize(frame->connectors); j++) {
+		if (connectorPatchFlags[j].bits.CPFIndex)
+			frame->connectors[j].index = framebufferPatch.connectors[j].index;
+
+		if (connectorPatchFlags[j].bits.CPFBusId)
+			frame->connectors[j].busId = framebufferPatch.connectors[j].busId;
+
+		if (connectorPatchFlags[j].bits.CPFPipe)
+			frame->connectors[j].pipe = framebufferPatch.connectors[j].pipe;
+
+		if (connectorPatchFlags[j].bits.CPFType)
+			frame->connectors[j].type = framebufferPatch.connectors[j].type;
+
+		if (connectorPatchFlags[j].bits.CPFFlags)
+			frame->connectors[j].flags = framebufferPatch.connectors[j].flags;
+
+		if (connectorPatchFlags[j].value) {
+			DBGLOG("igfx", "patching framebufferId 0x%08X connector [%d] busId: 0x%02X, pipe: %u, type: 0x%08X, flags: 0x%08X", frame->framebufferId, frame->connectors[j].index, frame->connectors[j].busId, frame->connectors[j].pipe, frame->connectors[j].type, frame->connectors[j].flags.value);
+
+			r = true;
+		}
+	}
+
+	return r;
+}
+
+template <>
+bool IGFX::applyDPtoHDMIPatch(uint32_t framebufferId, FramebufferSNB *platformInformationList, FramebufferSNB *) {
+	bool found = false;
+
+	for (size_t i = 0; i < SandyPlatformNum; i++) {
+		if (sandyPlatformId[i] == framebufferId) {
+			for (size_t j = 0; j < arrsize(platformInformationList[i].connectors); j++) {
+				DBGLOG("igfx", "snb connector [%lu] busId: 0x%02X, pipe: %d, type: 0x%08X, flags: 0x%08X", j, platformInformationList[i].connectors[j].busId, platformInformationList[i].connectors[j].pipe,
+					   platformInformationList[i].connectors[j].type, platformInformationList[i].connectors[j].flags.value);
+
+				if (platformInformationList[i].connectors[j].type == ConnectorDP) {
+					platformInformationList[i].connectors[j].type = ConnectorHDMI;
+					DBGLOG("igfx", "replaced snb connector %lu type from DP to HDMI", j);
+					found = true;
+				}
+			}
+		}
+	}
+
+	return found;
+}
+
+template <typename T>
+bool IGFX::applyDPtoHDMIPatch(uint32_t framebufferId, T *platformInformationList, T *frame) {
+	if (!frame)
+		return false;
+
+	bool found = false;
+	for (size_t i = 0; i < arrsize(frame->connectors); i++) {
+		DBGLOG("igfx", "connector [%lu] busId: 0x%02X, pipe: %d, type: 0x%08X, flags: 0x%08X", i, frame->connectors[i].busId, frame->connectors[i].pipe,
+			   frame->connectors[i].type, frame->connectors[i].flags.value);
+
+		if (frame->connectors[i].type == ConnectorDP) {
+			frame->connectors[i].type = ConnectorHDMI;
+			DBGLOG("igfx", "replaced connector %lu type from DP to HDMI", i);
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+void IGFX::compileFramebufferPlan(FramebufferPlan &plan, bool patchFramebuffer, bool patchDPtoHDMI) {
+	plan.num = 0;
+	plan.batchNum = 0;
+
+	// The selected framebuffer comes first, its field edits precede any find / replace patch.
+	// Not tested prior to 10.10.5, and definitely different on 10.9.5 at least.
+	auto &frame = plan.entries[plan.num++];
+	frame = {};
+	frame.framebufferId = framebufferPatch.framebufferId;
+	frame.patchFields = patchFramebuffer && getKernelVersion() >= KernelVersion::Yosemite;
+	frame.patchDPtoHDMI = patchDPtoHDMI;
+
+	if (!patchFramebuffer)
+		return;
+
+	// Consecutive patches for the same framebuffer are applied together in a single batch.
+	auto entry = &frame;
+	for (size_t i = 0; i < MaxFramebufferPatchCount; i++) {
+		if (!framebufferPatches[i].find || !framebufferPatches[i].replace)
+			continue;
+
+		if (framebufferPatches[i].framebufferId != entry->framebufferId) {
+			entry = &plan.entries[plan.num++];
+			*entry = {};
+			entry->framebufferId = framebufferPatches[i].framebufferId;
+		}
+
+		if (framebufferPatches[i].find->getLength() != framebufferPatches[i].replace->getLength()) {
+			DBGLOG("igfx", "patch %lu framebufferId 0x%08X length mistmatch", i, entry->framebufferId);
+			continue;
+		}
+
+		if (entry->batchNum == 0)
+			entry->batchStart = plan.batchNum;
+		plan.batches[plan.batchNum++] = i;
+		entry->batchNum++;
+	}
+}
+
+void IGFX::resolveFramebufferPlan(FramebufferPlan &plan) {
+	for (size_t i = 0; i < plan.num; i++) {
+		// Entries of one framebuffer often follow each other, reuse the previous lookup.
+		if (i > 0 && plan.entries[i].framebufferId == plan.entries[i - 1].framebufferId)
+			plan.entries[i].address = plan.entries[i - 1].address;
+		else
+			plan.entries[i].address = lookupFramebufferId(plan.entries[i].framebufferId);
+	}
+}
+
+template <typename T>
+bool IGFX::applyPlatformInformationEntry(const FramebufferPlanEntry &entry, T *) {
+	auto platformInformationList = static_cast<T *>(gPlatformInformationList);
+	auto frame = reinterpret_cast<T *>(entry.address);
+
+	bool success = false;
+	if (entry.patchFields)
+		success = applyPlatformInformationListPatch(entry.framebufferId, platformInformationList, frame);
+	if (entry.patchDPtoHDMI)
+		success = applyDPtoHDMIPatch(entry.framebufferId, platformInformationList, frame) || success;
+	return success;
+}
+
+bool IGFX::applyPlatformInformationPlan(const FramebufferPlanEntry &entry) {
+	return visitPlatformInformationLayout([this, &entry](auto layout) { return applyPlatformInformationEntry(entry, layout); }, false);
+}
+
+void IGFX::applyPlatformInformationListPatches(bool patchFramebuffer, bool patchDPtoHDMI) {
+	FramebufferPlan plan;
+	compileFramebufferPlan(plan, patchFramebuffer, patchDPtoHDMI);
+	resolveFramebufferPlan(plan);
+
+	DBGLOG("igfx", "applyPlatformInformationListPatches framebufferId %X cpugen %X entries %lu", framebufferPatch.framebufferId, BaseDeviceInfo::get().cpuGeneration, plan.num);
+
+	for (size_t i = 0; i < plan.num; i++) {
+		auto &entry = plan.entries[i];
+
+		if (entry.patchFields || entry.patchDPtoHDMI) {
+			bool success = applyPlatformInformationPlan(entry);
+			DBGLOG("igfx", "%spatching framebufferId 0x%08X %s", entry.patchDPtoHDMI ? "hdmi " : "", entry.framebufferId, success ? "successful" : "failed");
+
+			// Sandy Bridge ids are found by the word scan, which may match the fields just edited.
+			if (success && gPlatformListIsSNB)
+				resolveFramebufferPlan(plan);
+		}
+
+		if (entry.batchNum == 0)
+			continue;
+
+		// Find / replace patches are only applied when the selected framebuffer exists.
+		if (!entry.address || !plan.entries[0].address) {
+			for (size_t p = 0; p < entry.batchNum; p++)
+				DBGLOG("igfx", "patch %lu framebufferId 0x%08X not found", plan.batches[entry.batchStart + p], entry.framebufferId);
+			continue;
+		}
+
+		applyFramebufferPatchBatch(entry.framebufferId, entry.address, &plan.batches[entry.batchStart], entry.batchNum);
+	}
+}
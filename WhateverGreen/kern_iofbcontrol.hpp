@@ -0,0 +1,54 @@
+//
+//  kern_iofbcontrol.hpp
+//  WhateverGreen
+//
+//  Created by agent on 2026-10-17.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef kern_iofbcontrol_hpp
+#define kern_iofbcontrol_hpp
+
+// This header is shared with Tools/IOFBControl and must stay plain C.
+
+/**
+ *  Batch category of the 0xFB/0xFB I2C control channel.
+ *  The send buffer holds IOFBControlBatchHeader followed by count IOFBControlCommand entries,
+ *  the reply buffer receives IOFBControlBatchHeader followed by count IOFBControlResult entries.
+ */
+#define kIOFBControlBatch        'btch'
+#define kIOFBControlBatchVersion 1
+#define kIOFBControlBatchMax     32
+
+/**
+ *  Batch command operations
+ */
+#define kIOFBControlGet 'get '
+#define kIOFBControlSet 'set '
+
+struct IOFBControlBatchHeader {
+	uint32_t category; // kIOFBControlBatch
+	uint32_t version;  // kIOFBControlBatchVersion
+	uint32_t count;    // number of commands or results that follow
+	uint32_t reserved;
+};
+
+/**
+ *  One get or set, with the same category and values as a single 0xFB transaction
+ */
+struct IOFBControlCommand {
+	uint32_t operation; // kIOFBControlGet or kIOFBControlSet
+	uint32_t category;  // 'iofb', 'atfc' or 'attr'
+	uint32_t val1;
+	uint32_t val2;
+	uint32_t val3;
+	uint32_t reserved;
+};
+
+struct IOFBControlResult {
+	uint32_t result;    // IOReturn of the command
+	uint32_t reserved;
+	uint64_t value;     // value read by a get, zero for a set
+};
+
+#endif /* kern_iofbcontrol_hpp */
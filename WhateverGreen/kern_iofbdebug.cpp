@@ -15,12 +15,12 @@
 #include <IOKit/i2c/IOI2CInterface.h>
 #include <IOKit/ndrvsupport/IONDRVLibraries.h>
 #include <IOKit/graphics/IOGraphicsTypes.h>
+#include <kern/clock.h>
 
 #include "kern_iofbdebug.hpp"
+#include "kern_iofbcontrol.hpp"
 #include "kern_agdc.hpp"
 
-int bprintf(char * buf, size_t bufSize, const char * format, ...) __printflike(3, 4);
-
 int bprintf(char * buf, size_t bufSize, const char * format, ...) {
 	// can't use scnprintf for Mojave installer or earlier installers.
 	va_list va;
@@ -227,6 +227,11 @@ IOFB *IOFB::callbackIOFB;
 void IOFB::init() {
 	DBGLOG("iofb", "[ init");
 	callbackIOFB = this;
+	if (!iofbvtables.init() || !agdcvtables.init() || !iofbvars.init() || !agdcvars.init())
+		SYSLOG("iofb", "failed to allocate framebuffer registry locks");
+	iofbedidLock = IOLockAlloc();
+	if (!iofbedidLock)
+		SYSLOG("iofb", "failed to allocate EDID override lock");
 	lilu.onKextLoadForce(kextList, arrsize(kextList));
 
 	DBGLOG("iofb", "] init");
@@ -234,6 +239,18 @@ void IOFB::init() {
 
 void IOFB::deinit() {
 	DBGLOG("iofb", "[ deinit");
+	iofbvtables.deinit();
+	agdcvtables.deinit();
+	iofbvars.deleteValues();
+	iofbvars.deinit();
+	agdcvars.deinit();
+	if (iofbedidLock) {
+		IOLockLock(iofbedidLock);
+		publishEDIDOverrideSet(NULL);
+		IOLockUnlock(iofbedidLock);
+		IOLockFree(iofbedidLock);
+		iofbedidLock = nullptr;
+	}
 	DBGLOG("iofb", "] deinit");
 }
 
@@ -261,6 +278,10 @@ void IOFB::processKernel(KernelPatcher &patcher, DeviceInfo *info) {
 	if (!patchIODB) kextList[KextIOGraphics].switchOff();
 	if (!patchAGDC) kextList[KextAGDC].switchOff();
 
+	// -iofbtrace -> record framebuffer calls into the binary trace ring from boot
+	if (patchIODB && checkKernelArgument("-iofbtrace"))
+		setTraceEnabled(true);
+
 	DBGLOG("iofb", "] processKernel patchIODB:%d disableIOFB:%d patchAGDC:%d disableAGDC:%d", patchIODB, disableIOFB, patchAGDC, disableAGDC);
 }
 
@@ -295,160 +316,185 @@ bool IOFB::processKext(KernelPatcher &patcher, size_t index, mach_vm_address_t a
 IOFB::IOFBvtable *IOFB::getIOFBvtable(IOFramebuffer *service) {
 	uintptr_t vtable = (UInt64)reinterpret_cast<uintptr_t **>(service)[0];
 
-	for (int i = 0; i < callbackIOFB->iofbvtablesCount; i++) {
-		if (callbackIOFB->iofbvtables[i] && callbackIOFB->iofbvtables[i]->vtable == vtable) {
-			return callbackIOFB->iofbvtables[i];
-		}
-	}
+	IOFBvtable *iofbvtable = callbackIOFB->iofbvtables.find(vtable);
+	if (iofbvtable)
+		return iofbvtable;
 
 	DBGLOG("iofb", "[ getIOFBvtable new vtable:0x%llx", (uint64_t)vtable);
-	int currentiofbvtablesNdx = OSIncrementAtomic(&callbackIOFB->iofbvtablesCount);
-
-	while (callbackIOFB->iofbvtablesCount > callbackIOFB->iofbvtablesMaxCount) {
-		OSAddAtomic(10, &callbackIOFB->iofbvtablesMaxCount);
-		if (!callbackIOFB->iofbvtables) {
-			DBGLOG("iofb", "creating iofbvtables");
-			callbackIOFB->iofbvtables = (IOFBvtablePtr*)kern_os_malloc(callbackIOFB->iofbvtablesMaxCount * sizeof(IOFBvtablePtr));
-		}
-		else {
-			DBGLOG("iofb", "reallocating iofbvtables");
-			callbackIOFB->iofbvtables = (IOFBvtablePtr*)kern_os_realloc(callbackIOFB->iofbvtables, callbackIOFB->iofbvtablesMaxCount * sizeof(IOFBvtablePtr));
-		}
-		if (!callbackIOFB->iofbvtables) {
-			DBGLOG("iofb", "] getIOFBvtable cannot create iofbvtables size:%d", callbackIOFB->iofbvtablesMaxCount);
-			return NULL;
-		}
-	}
-
-	callbackIOFB->iofbvtables[currentiofbvtablesNdx] = new IOFBvtable;
-	if (!callbackIOFB->iofbvtables[currentiofbvtablesNdx]) {
+	IOFBvtable *created = new IOFBvtable;
+	if (!created) {
 		DBGLOG("iofb", "] getIOFBvtable cannot create IOFBvtable");
 		return NULL;
 	}
+	created->vtable = vtable;
 
-	DBGLOG("iofb", "] getIOFBvtable");
-	callbackIOFB->iofbvtables[currentiofbvtablesNdx]->vtable = vtable;
-	return callbackIOFB->iofbvtables[currentiofbvtablesNdx];
+	iofbvtable = callbackIOFB->iofbvtables.insert(vtable, created);
+	if (iofbvtable != created)
+		delete created;
+	if (!iofbvtable)
+		DBGLOG("iofb", "] getIOFBvtable cannot insert IOFBvtable");
+	else
+		DBGLOG("iofb", "] getIOFBvtable");
+	return iofbvtable;
 }
 
 
 IOFB::AGDCvtable *IOFB::getAGDCvtable(IOService *service) {
 	uintptr_t vtable = (UInt64)reinterpret_cast<uintptr_t **>(service)[0];
 
-	for (int i = 0; i < callbackIOFB->agdcvtablesCount; i++) {
-		if (callbackIOFB->agdcvtables[i] && callbackIOFB->agdcvtables[i]->vtable == vtable) {
-			return callbackIOFB->agdcvtables[i];
-		}
-	}
+	AGDCvtable *agdcvtable = callbackIOFB->agdcvtables.find(vtable);
+	if (agdcvtable)
+		return agdcvtable;
 
 	DBGLOG("agdc", "[ getAGDCvtable new vtable:0x%llx", (uint64_t)vtable);
-	int currentagdcvtablesNdx = OSIncrementAtomic(&callbackIOFB->agdcvtablesCount);
-
-	while (callbackIOFB->agdcvtablesCount > callbackIOFB->agdcvtablesMaxCount) {
-		OSAddAtomic(10, &callbackIOFB->agdcvtablesMaxCount);
-		if (!callbackIOFB->agdcvtables) {
-			DBGLOG("agdc", "creating agdcvtables");
-			callbackIOFB->agdcvtables = (AGDCvtablePtr*)kern_os_malloc(callbackIOFB->agdcvtablesMaxCount * sizeof(AGDCvtablePtr));
-		}
-		else {
-			DBGLOG("agdc", "reallocating agdcvtables");
-			callbackIOFB->agdcvtables = (AGDCvtablePtr*)kern_os_realloc(callbackIOFB->agdcvtables, callbackIOFB->agdcvtablesMaxCount * sizeof(AGDCvtablePtr));
-		}
-		if (!callbackIOFB->agdcvtables) {
-			DBGLOG("agdc", "] getAGDCvtable cannot create agdcvtables size:%d", callbackIOFB->agdcvtablesMaxCount);
-			return NULL;
-		}
-	}
-
-	callbackIOFB->agdcvtables[currentagdcvtablesNdx] = new AGDCvtable;
-	if (!callbackIOFB->agdcvtables[currentagdcvtablesNdx]) {
+	AGDCvtable *created = new AGDCvtable;
+	if (!created) {
 		DBGLOG("agdc", "] getAGDCvtable cannot create AGDCvtable");
 		return NULL;
 	}
+	created->vtable = vtable;
 
-	DBGLOG("agdc", "] getAGDCvtable");
-	callbackIOFB->agdcvtables[currentagdcvtablesNdx]->vtable = vtable;
-	return callbackIOFB->agdcvtables[currentagdcvtablesNdx];
+	agdcvtable = callbackIOFB->agdcvtables.insert(vtable, created);
+	if (agdcvtable != created)
+		delete created;
+	if (!agdcvtable)
+		DBGLOG("agdc", "] getAGDCvtable cannot insert AGDCvtable");
+	else
+		DBGLOG("agdc", "] getAGDCvtable");
+	return agdcvtable;
 }
 
 
 IOFB::IOFBVars *IOFB::getIOFBVars(IOFramebuffer *service) {
-	for (int i = 0; i < callbackIOFB->iofbvarsCount; i++) {
-		if (callbackIOFB->iofbvars[i] && callbackIOFB->iofbvars[i]->fb == service) {
-			return callbackIOFB->iofbvars[i];
-		}
-	}
+	IOFBVars *iofbVars = callbackIOFB->iofbvars.find(reinterpret_cast<uintptr_t>(service));
+	if (iofbVars)
+		return iofbVars;
 
 	int currentiofbvarsNdx = OSIncrementAtomic(&callbackIOFB->iofbvarsCount);
 	DBGLOG("iofb", "[ getIOFBVars iofb:%d new IOFramebuffer:0x%llx", currentiofbvarsNdx, (uint64_t)service);
 
-	while (callbackIOFB->iofbvarsCount > callbackIOFB->iofbvarsMaxCount) {
-		OSAddAtomic(10, &callbackIOFB->iofbvarsMaxCount);
-		if (!callbackIOFB->iofbvars) {
-			DBGLOG("iofb", "creating iofbvars");
-			callbackIOFB->iofbvars = (IOFBVarsPtr*)kern_os_malloc(callbackIOFB->iofbvarsMaxCount * sizeof(IOFBVarsPtr));
-		}
-		else {
-			DBGLOG("iofb", "reallocating iofbvars");
-			callbackIOFB->iofbvars = (IOFBVarsPtr*)kern_os_realloc(callbackIOFB->iofbvars, callbackIOFB->iofbvarsMaxCount * sizeof(IOFBVarsPtr));
-		}
-		if (!callbackIOFB->iofbvars) {
-			DBGLOG("iofb", "] getIOFBVars cannot create iofbvars size:%d", callbackIOFB->iofbvarsMaxCount);
-			return NULL;
-		}
-	}
-
-	callbackIOFB->iofbvars[currentiofbvarsNdx] = new IOFBVars;
-	if (!callbackIOFB->iofbvars[currentiofbvarsNdx]) {
+	IOFBVars *created = new IOFBVars;
+	if (!created) {
 		DBGLOG("iofb", "[] getIOFBVars cannot create IOFBVars");
 		return NULL;
 	}
+	created->fb = service;
+	created->iofbvtable = getIOFBvtable(service);
+	created->index = currentiofbvarsNdx;
 
-	DBGLOG("iofb", "] getIOFBVars");
-	callbackIOFB->iofbvars[currentiofbvarsNdx]->fb = service;
-	callbackIOFB->iofbvars[currentiofbvarsNdx]->iofbvtable = getIOFBvtable(service);
-	callbackIOFB->iofbvars[currentiofbvarsNdx]->index = currentiofbvarsNdx;
-	return callbackIOFB->iofbvars[currentiofbvarsNdx];
+	iofbVars = callbackIOFB->iofbvars.insert(reinterpret_cast<uintptr_t>(service), created);
+	if (iofbVars != created)
+		delete created;
+	if (!iofbVars)
+		DBGLOG("iofb", "] getIOFBVars cannot insert IOFBVars");
+	else
+		DBGLOG("iofb", "] getIOFBVars");
+	return iofbVars;
 }
 
 
 IOFB::AGDCVars *IOFB::getAGDCVars(IOService *service) {
-	for (int i = 0; i < callbackIOFB->agdcvarsCount; i++) {
-		if (callbackIOFB->agdcvars[i] && callbackIOFB->agdcvars[i]->agdc == service) {
-			return callbackIOFB->agdcvars[i];
-		}
-	}
+	AGDCVars *agdcVars = callbackIOFB->agdcvars.find(reinterpret_cast<uintptr_t>(service));
+	if (agdcVars)
+		return agdcVars;
 
 	int currentagdcvarsNdx = OSIncrementAtomic(&callbackIOFB->agdcvarsCount);
 	DBGLOG("agdc", "[ getAGDCVars agdc:%d new AppleGraphicsDeviceControl:0x%llx", currentagdcvarsNdx, (uint64_t)service);
 
-	while (callbackIOFB->agdcvarsCount > callbackIOFB->agdcvarsMaxCount) {
-		OSAddAtomic(10, &callbackIOFB->agdcvarsMaxCount);
-		if (!callbackIOFB->agdcvars) {
-			DBGLOG("agdc", "creating agdcvars");
-			callbackIOFB->agdcvars = (AGDCVarsPtr*)kern_os_malloc(callbackIOFB->agdcvarsMaxCount * sizeof(AGDCVarsPtr));
-		}
-		else {
-			DBGLOG("agdc", "reallocating agdcvars");
-			callbackIOFB->agdcvars = (AGDCVarsPtr*)kern_os_realloc(callbackIOFB->agdcvars, callbackIOFB->agdcvarsMaxCount * sizeof(AGDCVarsPtr));
-		}
-		if (!callbackIOFB->agdcvars) {
-			DBGLOG("agdc", "] getAGDCVars cannot create agdcvars size:%d", callbackIOFB->agdcvarsMaxCount);
-			return NULL;
-		}
-	}
-
-	callbackIOFB->agdcvars[currentagdcvarsNdx] = new AGDCVars;
-	if (!callbackIOFB->agdcvars[currentagdcvarsNdx]) {
+	AGDCVars *created = new AGDCVars;
+	if (!created) {
 		DBGLOG("agdc", "[] getAGDCVars cannot create AGDCVars");
 		return NULL;
 	}
+	created->agdc = service;
+	created->agdcvtable = getAGDCvtable(service);
+	created->index = currentagdcvarsNdx;
 
-	DBGLOG("agdc", "] getAGDCVars");
-	callbackIOFB->agdcvars[currentagdcvarsNdx]->agdc = service;
-	callbackIOFB->agdcvars[currentagdcvarsNdx]->agdcvtable = getAGDCvtable(service);
-	callbackIOFB->agdcvars[currentagdcvarsNdx]->index = currentagdcvarsNdx;
-	return callbackIOFB->agdcvars[currentagdcvarsNdx];
+	agdcVars = callbackIOFB->agdcvars.insert(reinterpret_cast<uintptr_t>(service), created);
+	if (agdcVars != created)
+		delete created;
+	if (!agdcVars)
+		DBGLOG("agdc", "] getAGDCVars cannot insert AGDCVars");
+	else
+		DBGLOG("agdc", "] getAGDCVars");
+	return agdcVars;
+}
+
+
+void IOFB::setTraceEnabled(bool enable) {
+	if (enable && !__atomic_load_n(&traceRing, __ATOMIC_ACQUIRE)) {
+		auto ring = static_cast<IOFBTraceRecord *>(kern_os_malloc(kIOFBTraceRingSize * sizeof(IOFBTraceRecord)));
+		if (!ring) {
+			SYSLOG("iofb", "cannot allocate trace ring");
+			return;
+		}
+		for (size_t i = 0; i < kIOFBTraceRingSize; i++)
+			ring[i].sequence = kIOFBTraceInvalidSequence;
+		IOFBTraceRecord *expected = nullptr;
+		if (!__atomic_compare_exchange_n(&traceRing, &expected, ring, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			kern_os_free(ring);
+	}
+	DBGLOG("iofb", "[] setTraceEnabled %d", enable);
+	__atomic_store_n(&traceEnabled, enable, __ATOMIC_RELEASE);
+}
+
+
+void IOFB::traceRecord(UInt32 tag, IOService *service, IOReturn result, UInt64 arg0, UInt64 arg1, UInt64 arg2) {
+	auto ring = __atomic_load_n(&traceRing, __ATOMIC_ACQUIRE);
+	if (!ring)
+		return;
+
+	// Every writer owns its slot by sequence number, readers detect a torn record by rechecking it.
+	UInt32 sequence = __atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED);
+	IOFBTraceRecord &record = ring[sequence & (kIOFBTraceRingSize - 1)];
+	__atomic_store_n(&record.sequence, kIOFBTraceInvalidSequence, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	record.timestamp = mach_absolute_time();
+	record.service = reinterpret_cast<uint64_t>(service);
+	record.args[0] = arg0;
+	record.args[1] = arg1;
+	record.args[2] = arg2;
+	record.tag = tag;
+	record.result = result;
+	__atomic_store_n(&record.sequence, sequence, __ATOMIC_RELEASE);
+}
+
+
+IOReturn IOFB::readTrace(UInt32 firstSequence, UInt8 *buffer, UInt32 size) {
+	auto ring = __atomic_load_n(&traceRing, __ATOMIC_ACQUIRE);
+	if (!ring)
+		return kIOReturnNotReady;
+	if (size < sizeof(IOFBTraceReply))
+		return kIOReturnNoSpace;
+
+	UInt32 head = __atomic_load_n(&traceHead, __ATOMIC_ACQUIRE);
+	UInt32 oldest = head > kIOFBTraceRingSize ? head - kIOFBTraceRingSize : 0;
+	if (firstSequence < oldest || firstSequence > head)
+		firstSequence = oldest;
+
+	auto reply = reinterpret_cast<IOFBTraceReply *>(buffer);
+	auto records = reinterpret_cast<IOFBTraceRecord *>(reply + 1);
+	UInt32 capacity = (size - sizeof(IOFBTraceReply)) / sizeof(IOFBTraceRecord);
+	if (capacity > kIOFBTraceMaxReplyRecords)
+		capacity = kIOFBTraceMaxReplyRecords;
+	UInt32 count = 0;
+	UInt32 sequence = firstSequence;
+	for (; sequence != head && count < capacity; sequence++) {
+		const IOFBTraceRecord &record = ring[sequence & (kIOFBTraceRingSize - 1)];
+		if (__atomic_load_n(&record.sequence, __ATOMIC_ACQUIRE) != sequence)
+			continue;
+		records[count] = record;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		// Skip records overwritten while being copied.
+		if (__atomic_load_n(&record.sequence, __ATOMIC_RELAXED) == sequence && records[count].sequence == sequence)
+			count++;
+	}
+
+	reply->firstSequence = firstSequence;
+	reply->nextSequence = sequence;
+	reply->count = count;
+	reply->reserved = 0;
+	return kIOReturnSuccess;
 }
 
 
@@ -1847,77 +1893,6 @@ void IOFB::UpdateAttribute( IOFramebuffer *service, bool set, IOIndex connectInd
 	}
 } // UpdateAttribute
 
-void IOFB::setEDIDOverride(UInt8 *orgEDID, UInt32 orgSize, UInt8 *newEDID, UInt32 newSize) {
-	DBGLOG("iofb", "[ setEDIDOverride");
-	if (!orgSize) {
-		iofbedidCount = 0;
-		DBGLOG("iofb", "] setEDIDOverride clear all EDID overrides");
-		return;
-	}
-
-	#ifdef DEBUG
-	char hex[128*8];
-	#endif
-	DBGLOG("iofb", "org[%d]: %s", orgSize, HEX(hex, sizeof(hex), orgEDID, orgSize));
-	DBGLOG("iofb", "new[%d]: %s", newSize, HEX(hex, sizeof(hex), newEDID, newSize));
-
-	IOFBEDIDOverride *ov = iofbEDIDOverrides;
-	IOFBEDIDOverride *ovempty = NULL;
-	int i = 0;
-	for (; i < iofbedidCount; i++, ov++) {
-		if (!ovempty && !ov->orgSize)
-			ovempty = ov;
-		if (ov->orgSize == orgSize && !memcmp(ov->orgEDID, orgEDID, orgSize)) {
-			break;
-		}
-	}
-
-	if (i < iofbedidCount) {
-		if (!newSize) {
-			// delete existing EDID override
-			kern_os_free(ov->orgEDID);
-			ov->orgSize = 0;
-		}
-		// change existing EDID override
-		kern_os_free(ov->newEDID);
-		ov->newSize = 0;
-	}
-
-	if (newSize) {
-		if (i >= iofbedidCount) {
-			// add new EDID override
-			if (ovempty) {
-				ov = ovempty;
-			}
-			else {
-				int currentiofbedidNdx = OSIncrementAtomic(&iofbedidCount);
-
-				while (iofbedidCount > iofbedidMaxCount) {
-					OSAddAtomic(10, &iofbedidMaxCount);
-					if (!iofbEDIDOverrides) {
-						iofbEDIDOverrides = (IOFBEDIDOverride*)kern_os_malloc(iofbedidMaxCount * sizeof(IOFBEDIDOverride));
-					}
-					else {
-						iofbEDIDOverrides = (IOFBEDIDOverride*)kern_os_realloc(iofbEDIDOverrides, iofbedidMaxCount * sizeof(IOFBEDIDOverride));
-					}
-					if (!iofbEDIDOverrides) {
-						DBGLOG("iofb", "] setEDIDOverride cannot create list of EDID overrides");
-						return;
-					}
-				}
-				ov = &iofbEDIDOverrides[currentiofbedidNdx];
-			}
-			ov->orgEDID = (UInt8*)kern_os_malloc(orgSize);
-			ov->orgSize = orgSize;
-			memcpy(ov->orgEDID, orgEDID, orgSize);
-		}
-		ov->newEDID = (UInt8*)kern_os_malloc(newSize);
-		ov->newSize = newSize;
-		memcpy(ov->newEDID, newEDID, newSize);
-	}
-	DBGLOG("iofb", "] setEDIDOverride");
-}
-
 
 //========================================================================================
 // Wrapped functions for IOGraphicsDevice, IOFramebuffer, IONDRVFramebuffer
@@ -1970,6 +1945,133 @@ void IOFB::wrapgetBoundingRect( IOFramebuffer *service, IOGBounds ** bounds )
 UInt8 whole[300];
 int wholelen = 0;
 
+IOReturn IOFB::controlGet(IOFramebuffer *service, IOFBVars *iofbVars, const UInt32 *command, void *reply, UInt32 replyBytes)
+{
+	IOReturn result = kIOReturnSuccess;
+	UInt32 category = command[0];
+	UInt32 val1     = command[1];
+	UInt32 val2     = command[2];
+
+	switch (category) {
+		case 'iofb':
+			switch (val1) {
+				case 'iofb'                              : *(UInt32*)reply = 'iofb'                                  ; break;
+				case 'vala'                              : *(UInt32*)reply = iofbVars->iofbValidateAll               ; break;
+				case 'sbnd'                              : *(UInt32*)reply = iofbVars->iofbSidebandDownRep           ; break;
+				case 'sdtm'                              : *(UInt32*)reply = iofbVars->iofbDumpsetDetailedTimings    ; break;
+				case 'pixi'                              : *(UInt32*)reply = iofbVars->iofbDumpgetPixelInformation   ; break;
+				case 'vald'                              : *(UInt32*)reply = iofbVars->iofbDumpvalidateDetailedTiming; break;
+				case 'i2cr'                              : *(UInt32*)reply = iofbVars->iofbDumpdoI2CRequest          ; break;
+				case 'attr'                              : *(UInt32*)reply = iofbVars->iofbDumpAttributes            ; break;
+				case kConnectionColorModesSupported      : *(UInt32*)reply = iofbVars->iofbColorModesSupported       ; break;
+				case kConnectionControllerDepthsSupported: *(UInt32*)reply = iofbVars->iofbControllerDepthsSupported ; break;
+				case kConnectionColorDepthsSupported     : *(UInt32*)reply = iofbVars->iofbColorDepthsSupported      ; break;
+				case 'trac'                              : *(UInt32*)reply = callbackIOFB->gIOGATFlagsPtr ? *callbackIOFB->gIOGATFlagsPtr : 0 ; break;
+				case 'dbge'                              : *(UInt32*)reply = ADDPR(debugEnabled)                     ; break;
+				case 'trce'                              : *(UInt32*)reply = callbackIOFB->traceEnabled              ; break;
+				default                                  : result = kIOReturnBadArgument; break;
+			}
+			break;
+		case 'atfc': result = wrapgetAttributeForConnection(service, val1, val2, (uintptr_t*)reply); break;
+		case 'attr': result = wrapgetAttribute(service, val1, (uintptr_t*)reply); break;
+		case 'trce': result = callbackIOFB->readTrace(val1, (UInt8*)reply, replyBytes); break;
+		default    : result = kIOReturnBadArgument; break;
+	}
+	return result;
+}
+
+IOReturn IOFB::controlSet(IOFramebuffer *service, IOFBVars *iofbVars, const UInt32 *command)
+{
+	IOReturn result = kIOReturnSuccess;
+	UInt32 category = command[0];
+	UInt32 val1     = command[1];
+	UInt32 val2     = command[2];
+	UInt32 val3     = command[3];
+
+	switch (category) {
+		case 'iofb':
+			switch (val1) {
+				case 'vala'                              : iofbVars->iofbValidateAll                = val2; break;
+				case 'sbnd'                              : iofbVars->iofbSidebandDownRep            = val2; break;
+				case 'sdtm'                              : iofbVars->iofbDumpsetDetailedTimings     = val2; break;
+				case 'pixi'                              : iofbVars->iofbDumpgetPixelInformation    = val2; break;
+				case 'vald'                              : iofbVars->iofbDumpvalidateDetailedTiming = val2; break;
+				case 'i2cr'                              : iofbVars->iofbDumpdoI2CRequest           = val2; break;
+				case 'attr'                              : iofbVars->iofbDumpAttributes             = val2; break;
+				case kConnectionColorModesSupported      : iofbVars->iofbColorModesSupported        = val2; break;
+				case kConnectionControllerDepthsSupported: iofbVars->iofbControllerDepthsSupported  = val2; break;
+				case kConnectionColorDepthsSupported     : iofbVars->iofbColorDepthsSupported       = val2; break;
+				case 'trac'                              : if (callbackIOFB->gIOGATFlagsPtr) *callbackIOFB->gIOGATFlagsPtr = val2; break;
+				case 'trce'                              : callbackIOFB->setTraceEnabled(val2); break;
+				case 'dbge'                              :
+					// This is a flag that affects all WhateverGreen patches.
+					// Maybe there should be a different flag for each source file?
+					DBGLOG("iofb", "Setting debugEnabled to %d", val2);
+					ADDPR(debugEnabled) = val2;
+					break;
+				case 'edid':
+					result = callbackIOFB->setEDIDOverride((UInt8*)&command[4], val2, (UInt8*)&command[4] + val2, val3);
+					break;
+				default: result = kIOReturnBadArgument; break;
+			}
+			break;
+		case 'atfc': result = wrapsetAttributeForConnection(service, val1, val2, val3); break;
+		case 'attr': result = wrapsetAttribute(service, val1, val2); break;
+		default    : result = kIOReturnBadArgument; break;
+	}
+	return result;
+}
+
+IOReturn IOFB::controlBatch(IOFramebuffer *service, IOFBVars *iofbVars, struct IOI2CRequest *request)
+{
+	auto header = (const IOFBControlBatchHeader*)request->sendBuffer;
+	if (request->sendBytes < sizeof(IOFBControlBatchHeader) || header->version != kIOFBControlBatchVersion)
+		return kIOReturnUnsupported;
+
+	UInt32 count = header->count;
+	if (count > kIOFBControlBatchMax || request->sendBytes < sizeof(IOFBControlBatchHeader) + count * sizeof(IOFBControlCommand))
+		return kIOReturnBadArgument;
+	if (request->replyBytes < sizeof(IOFBControlBatchHeader) + count * sizeof(IOFBControlResult))
+		return kIOReturnNoSpace;
+
+	auto commands = (const IOFBControlCommand*)(header + 1);
+	auto replyHeader = (IOFBControlBatchHeader*)request->replyBuffer;
+	auto results = (IOFBControlResult*)(replyHeader + 1);
+
+	for (UInt32 i = 0; i < count; i++) {
+		const IOFBControlCommand &command = commands[i];
+		UInt32 values[4] = { command.category, command.val1, command.val2, command.val3 };
+		uintptr_t value = 0;
+		IOReturn result;
+
+		// Every result has room for a single value, so anything that replies with more
+		// or carries a payload behind the command only works as a separate transaction.
+		bool single = command.category == kIOFBControlBatch || command.category == 'trce' ||
+			(command.category == 'atfc' && (command.val2 == kConnectionDisplayParameters || command.val2 == kConnectionHandleDisplayPortEvent)) ||
+			(command.category == 'iofb' && command.val1 == 'edid');
+
+		if (single)
+			result = kIOReturnUnsupported;
+		else if (command.operation == kIOFBControlGet)
+			result = controlGet(service, iofbVars, values, &value, sizeof(value));
+		else if (command.operation == kIOFBControlSet)
+			result = controlSet(service, iofbVars, values);
+		else
+			result = kIOReturnBadArgument;
+
+		results[i].result = result;
+		results[i].reserved = 0;
+		results[i].value = value;
+	}
+
+	replyHeader->category = kIOFBControlBatch;
+	replyHeader->version = kIOFBControlBatchVersion;
+	replyHeader->count = count;
+	replyHeader->reserved = 0;
+	DBGLOG("iofb", "[] IofbBatch count:%d", count);
+	return kIOReturnSuccess;
+}
+
 IOReturn IOFB::wrapdoI2CRequest( IOFramebuffer *service, UInt32 bus, struct IOI2CBusTiming * timing, struct IOI2CRequest * request )
 {
 	IOFBVars *iofbVars = callbackIOFB->getIOFBVars(service);
@@ -1982,62 +2084,14 @@ IOReturn IOFB::wrapdoI2CRequest( IOFramebuffer *service, UInt32 bus, struct IOI2
 		UInt32 val2     = ((UInt32*)request->sendBuffer)[2];
 		UInt32 val3     = ((UInt32*)request->sendBuffer)[3];
 		if (request->replyTransactionType == kIOI2CSimpleTransactionType && request->replyAddress == 0xfb && request->replySubAddress == 0xfb && request->replyBuffer && request->replyBytes) {
-			switch (category) {
-				case 'iofb':
-					switch (val1) {
-						case 'iofb'                              : *(UInt32*)request->replyBuffer = 'iofb'                                  ; break;
-						case 'vala'                              : *(UInt32*)request->replyBuffer = iofbVars->iofbValidateAll               ; break;
-						case 'sbnd'                              : *(UInt32*)request->replyBuffer = iofbVars->iofbSidebandDownRep           ; break;
-						case 'sdtm'                              : *(UInt32*)request->replyBuffer = iofbVars->iofbDumpsetDetailedTimings    ; break;
-						case 'pixi'                              : *(UInt32*)request->replyBuffer = iofbVars->iofbDumpgetPixelInformation   ; break;
-						case 'vald'                              : *(UInt32*)request->replyBuffer = iofbVars->iofbDumpvalidateDetailedTiming; break;
-						case 'i2cr'                              : *(UInt32*)request->replyBuffer = iofbVars->iofbDumpdoI2CRequest          ; break;
-						case 'attr'                              : *(UInt32*)request->replyBuffer = iofbVars->iofbDumpAttributes            ; break;
-						case kConnectionColorModesSupported      : *(UInt32*)request->replyBuffer = iofbVars->iofbColorModesSupported       ; break;
-						case kConnectionControllerDepthsSupported: *(UInt32*)request->replyBuffer = iofbVars->iofbControllerDepthsSupported ; break;
-						case kConnectionColorDepthsSupported     : *(UInt32*)request->replyBuffer = iofbVars->iofbColorDepthsSupported      ; break;
-						case 'trac'                              : *(UInt32*)request->replyBuffer = callbackIOFB->gIOGATFlagsPtr ? *callbackIOFB->gIOGATFlagsPtr : 0 ; break;
-						case 'dbge'                              : *(UInt32*)request->replyBuffer = ADDPR(debugEnabled)                     ; break;
-						default                                  : result = kIOReturnBadArgument; break;
-					}
-					break;
-				case 'atfc': result = wrapgetAttributeForConnection(service, val1, val2, (uintptr_t*)request->replyBuffer); break;
-				case 'attr': result = wrapgetAttribute(service, val1, (uintptr_t*)request->replyBuffer)                   ; break;
-				default    : result = kIOReturnBadArgument; break;
-			}
+			if (category == kIOFBControlBatch)
+				result = controlBatch(service, iofbVars, request);
+			else
+				result = controlGet(service, iofbVars, (const UInt32*)request->sendBuffer, (void*)request->replyBuffer, request->replyBytes);
 			DBGLOG("iofb", "[] IofbGetAttribute %x %x %x %x%s", category, val1, val2, val3, DumpOneReturn(resultStr, sizeof(resultStr), request->result));
 		}
 		else {
-			switch (category) {
-				case 'iofb':
-					switch (val1) {
-						case 'vala'                              : iofbVars->iofbValidateAll                = val2; break;
-						case 'sbnd'                              : iofbVars->iofbSidebandDownRep            = val2; break;
-						case 'sdtm'                              : iofbVars->iofbDumpsetDetailedTimings     = val2; break;
-						case 'pixi'                              : iofbVars->iofbDumpgetPixelInformation    = val2; break;
-						case 'vald'                              : iofbVars->iofbDumpvalidateDetailedTiming = val2; break;
-						case 'i2cr'                              : iofbVars->iofbDumpdoI2CRequest           = val2; break;
-						case 'attr'                              : iofbVars->iofbDumpAttributes             = val2; break;
-						case kConnectionColorModesSupported      : iofbVars->iofbColorModesSupported        = val2; break;
-						case kConnectionControllerDepthsSupported: iofbVars->iofbControllerDepthsSupported  = val2; break;
-						case kConnectionColorDepthsSupported     : iofbVars->iofbColorDepthsSupported       = val2; break;
-						case 'trac'                              : if (callbackIOFB->gIOGATFlagsPtr) *callbackIOFB->gIOGATFlagsPtr = val2; break;
-						case 'dbge'                              :
-							// This is a flag that affects all WhateverGreen patches.
-							// Maybe there should be a different flag for each source file?
-							DBGLOG("iofb", "Setting debugEnabled to %d", val2);
-							ADDPR(debugEnabled) = val2;
-							break;
-						case 'edid':
-							callbackIOFB->setEDIDOverride((UInt8*)&((UInt32*)request->sendBuffer)[4], val2, (UInt8*)&((UInt32*)request->sendBuffer)[4] + val2, val3);
-
-						default: result = kIOReturnBadArgument; break;
-					}
-					break;
-				case 'atfc': result = wrapsetAttributeForConnection(service, val1, val2, val3); break;
-				case 'attr': result = wrapsetAttribute(service, val1, val2); break;
-				default    : result = kIOReturnBadArgument; break;
-			}
+			result = controlSet(service, iofbVars, (const UInt32*)request->sendBuffer);
 			DBGLOG("iofb", "[] IofbSetAttribute %x %x %x %x%s", category, val1, val2, val3, DumpOneReturn(resultStr, sizeof(resultStr), request->result));
 		}
 		request->result = result;
@@ -2108,6 +2162,12 @@ IOReturn IOFB::wrapdoI2CRequest( IOFramebuffer *service, UInt32 bus, struct IOI2
 	else {
 		result = iofbVars->iofbvtable->orgdoI2CRequest( service, bus, timing, request );
 	}
+	// 0xFB control channel traffic, including trace reads, is not traced
+	if (request && !(reqcopy.sendAddress == 0xfb && reqcopy.sendSubAddress == 0xfb) && !(reqcopy.replyAddress == 0xfb && reqcopy.replySubAddress == 0xfb)) {
+		callbackIOFB->trace(kIOFBTraceDoI2CRequest, service, result, bus,
+			(UInt64)reqcopy.sendTransactionType << 24 | reqcopy.sendAddress,
+			(UInt64)reqcopy.replyTransactionType << 24 | reqcopy.replyAddress);
+	}
 
 	if (iofbVars->iofbDumpdoI2CRequest) {
 		if (request) {
@@ -2555,6 +2615,7 @@ IOReturn IOFB::wrapsetAttribute( IOFramebuffer *service, IOSelect attribute, uin
 	char resultStr[40];
 	#endif
 	IOReturn result = iofbVars->iofbvtable->orgsetAttribute( service, attribute, value );
+	callbackIOFB->trace(kIOFBTraceSetAttribute, service, result, attribute, value);
 	if (iofbVars->iofbDumpAttributes == 1 || (result && iofbVars->iofbDumpAttributes == 2)) {
 		DBGLOG("iofb", "[] setAttribute fb:0x%llx attribute:%s value:%s%s", (UInt64)service,
 			DumpOneAttribute(attributeStr, sizeof(attributeStr), attribute, false),
@@ -2575,6 +2636,7 @@ IOReturn IOFB::wrapgetAttribute( IOFramebuffer *service, IOSelect attribute, uin
 	char resultStr[40];
 	#endif
 	IOReturn result = iofbVars->iofbvtable->orggetAttribute( service, attribute, value );
+	callbackIOFB->trace(kIOFBTraceGetAttribute, service, result, attribute, value ? *value : 0);
 	if (iofbVars->iofbDumpAttributes == 1 || (result && iofbVars->iofbDumpAttributes == 2)) {
 		DBGLOG("iofb", "[] getAttribute fb:0x%llx attribute:%s%s value:%s", (UInt64)service,
 			DumpOneAttribute(attributeStr, sizeof(attributeStr), attribute, false),
@@ -2740,6 +2802,7 @@ IOReturn IOFB::wrapsetAttributeForConnection( IOFramebuffer *service, IOIndex co
 	char resultStr[40];
 	#endif
 	IOReturn result = iofbVars->iofbvtable->orgsetAttributeForConnection( service, connectIndex, attribute, value );
+	callbackIOFB->trace(kIOFBTraceSetAttributeForConnection, service, result, attribute, value, connectIndex);
 
 	if (iofbVars->iofbDumpAttributes == 1 || (result && iofbVars->iofbDumpAttributes == 2)) {
 		DBGLOG("iofb", "[] setAttributeForConnection fb:0x%llx connectIndex:%d attribute:%s value:%s%s",
@@ -2765,54 +2828,49 @@ IOReturn IOFB::wrapgetAttributeForConnection( IOFramebuffer *service, IOIndex co
 {
 	IOFBVars *iofbVars = callbackIOFB->getIOFBVars(service);
 	IOReturn result = iofbVars->iofbvtable->orggetAttributeForConnection( service, connectIndex, attribute, value );
+	callbackIOFB->trace(kIOFBTraceGetAttributeForConnection, service, result, attribute, value ? *value : 0, connectIndex);
 
 	unsigned int size = 0;
+	uintptr_t numParameters = 0;
 #ifdef DEBUG
-	char attributeStr[100];
-	char valueStr[1000];
-	char resultStr[40];
-
-	valueStr[0] = '\0';
-	int inc = 0;
+	bool numParametersError = false;
 #endif
 	if (value) {
 		if (attribute == kConnectionDisplayParameters) {
-			uintptr_t numParameters = 0;
 			if (kIOReturnSuccess != iofbVars->iofbvtable->orggetAttributeForConnection(service, connectIndex, kConnectionDisplayParameterCount, &numParameters)) {
 				#ifdef DEBUG
-				inc = bprintf(valueStr, sizeof(valueStr), "(error getting parameter count)");
-				#endif
-			}
-			else {
-				#ifdef DEBUG
-				DumpOneDisplayParameters(valueStr + inc, sizeof(valueStr) - inc, value, numParameters);
+				numParametersError = true;
 				#endif
 			}
 			size = (unsigned int)numParameters * sizeof(uintptr_t);
-
 		}
 		else if (attribute == kConnectionHandleDisplayPortEvent) {
 			size = 16 * sizeof(uintptr_t);
-			#ifdef DEBUG
-			HEX(valueStr, sizeof(valueStr), value, size);
-			#endif
 		}
 		else {
 			size = sizeof(*value);
-			#ifdef DEBUG
-			DumpOneAttributeValue(valueStr, sizeof(valueStr), attribute, false, true, value, size);
-			#endif
 		}
 	}
-	else {
-		size = 0;
-		#ifdef DEBUG
-		bprintf(valueStr, sizeof(valueStr), "NULL");
-		#endif
-	}
 
 #ifdef DEBUG
+	// Format only when dumping, this is one of the hottest framebuffer calls.
 	if (iofbVars->iofbDumpAttributes == 1 || (result && iofbVars->iofbDumpAttributes == 2)) {
+		char attributeStr[100];
+		char valueStr[1000];
+		char resultStr[40];
+
+		valueStr[0] = '\0';
+		if (!value)
+			bprintf(valueStr, sizeof(valueStr), "NULL");
+		else if (attribute == kConnectionDisplayParameters && numParametersError)
+			bprintf(valueStr, sizeof(valueStr), "(error getting parameter count)");
+		else if (attribute == kConnectionDisplayParameters)
+			DumpOneDisplayParameters(valueStr, sizeof(valueStr), value, numParameters);
+		else if (attribute == kConnectionHandleDisplayPortEvent)
+			HEX(valueStr, sizeof(valueStr), value, size);
+		else
+			DumpOneAttributeValue(valueStr, sizeof(valueStr), attribute, false, true, value, size);
+
 		DBGLOG("iofb", "[] getAttributeForConnection fb:0x%llx connectIndex:%d attribute:%s%s value:%s",
 			(UInt64)service, connectIndex, DumpOneAttribute(attributeStr, sizeof(attributeStr), attribute, true),
 			DumpOneReturn(resultStr, sizeof(resultStr), result),
@@ -2969,121 +3027,6 @@ bool IOFB::wraphasDDCConnect( IOFramebuffer *service, IOIndex connectIndex )
 	return result;
 }
 
-IOReturn IOFB::wrapgetDDCBlock( IOFramebuffer *service, IOIndex connectIndex, UInt32 blockNumber, IOSelect blockType, IOOptionBits options, UInt8 * data, IOByteCount * length )
-{
-	IOFBVars *iofbVars = callbackIOFB->getIOFBVars(service);
-	IOFBEDIDOverride *ov = iofbVars->edidOverride;
-
-	char hex[128*8];
-	unsigned int lenBefore = (length ? (unsigned int)*length : 128);
-	unsigned int len = lenBefore;
-	IOReturn result = kIOReturnSuccess;
-
-	if (ov) {
-		if (blockNumber < 1)
-			result = kIOReturnInvalid;
-		else {
-			SInt32 offset = (blockNumber - 1) * 128;
-			if (offset + lenBefore > ov->newSize) {
-				len = offset > ov->newSize ? 0 : ov->newSize - offset;
-				if (length) {
-					*length = len;
-				}
-			}
-			memcpy(data, ov->newEDID + offset, len);
-		}
-	}
-	else {
-		result = iofbVars->iofbvtable->orggetDDCBlock( service, connectIndex, blockNumber, blockType, options, data, length );
-		len = (length ? (unsigned int)*length : 128);
-	}
-
-	#ifdef DEBUG
-	char resultStr[40];
-	#endif
-	DBGLOG("iofb", "[] getDDCBlock fb:0x%llx connectIndex:%d blockNumber:%d blockType:%d options:%x%s %sbytes:%s",
-		(UInt64)service, connectIndex, blockNumber, blockType, options,
-		DumpOneReturn(resultStr, sizeof(resultStr), result), ov ? "override" : "", HEX(hex, sizeof(hex), data, len)
-	);
-	if (len != lenBefore) {
-		DBGLOG("iofb", "getDDCBlock len changed from %d to %d", lenBefore, len);
-	}
-
-	if (!result) {
-		{
-			char propertyName[20];
-			bprintf(propertyName, sizeof(propertyName), "IOFBEDID%d", connectIndex);
-			OSData *oldData = OSDynamicCast(OSData, service->getProperty(propertyName));
-			OSData *edidData;
-			unsigned int newLength = (blockNumber - 1) * 128 + len;
-			if (oldData) {
-				edidData = OSData::withData(oldData);
-			}
-			else {
-				edidData = OSData::withCapacity(128);
-			}
-			if (edidData) {
-				if (edidData->getLength() < newLength) {
-					edidData->appendBytes(NULL, newLength - edidData->getLength());
-				}
-			}
-			if (edidData) {
-				memcpy((UInt8 *)edidData->getBytesNoCopy() + (blockNumber - 1) * 128, data, len);
-				service->setProperty(propertyName, edidData);
-				edidData->release();
-			}
-		}
-
-		if (!ov && (blockNumber == 1) && len && !(len & 0x7f)) {
-			ov = callbackIOFB->iofbEDIDOverrides;
-			int extensionReadPos = 0;
-			for (int i = 0; i < callbackIOFB->iofbedidCount; i++, ov++) {
-				UInt32 edidComparePos = ov->orgSize < len ? ov->orgSize : len;
-				if (ov->orgSize && !memcmp(ov->orgEDID, data, edidComparePos)) {
-					DBGLOG("iofb", "[ #%d possible EDID override match first %d bytes", i, edidComparePos);
-					IOReturn result = kIOReturnSuccess;
-					UInt32 extensionComparePos = 0;
-					while (edidComparePos < ov->orgSize) {
-						if (extensionComparePos == extensionReadPos) {
-							IOByteCount length = 128;
-							int readBlockNum = edidComparePos / 128 + 1;
-							DBGLOG("iofb", "read block %d", readBlockNum);
-
-							result = iofbVars->iofbvtable->orggetDDCBlock( service, connectIndex, readBlockNum, blockType, options, (UInt8*)(hex + extensionReadPos), &length );
-							if (result) {
-								DBGLOG("iofb", "failed read block %d", readBlockNum);
-								break;
-							}
-							extensionReadPos += length;
-						}
-						UInt32 extensionBytes = extensionReadPos - extensionComparePos;
-						UInt32 edidBytes = ov->orgSize - edidComparePos;
-						UInt32 compareBytes = edidBytes < extensionBytes ? edidBytes : extensionBytes;
-						DBGLOG("iofb", "compare org_offset:%d extension_offset:%d size:%d", edidComparePos, extensionComparePos, compareBytes);
-						if (memcmp(ov->orgEDID + edidComparePos, hex + extensionComparePos, compareBytes)) {
-							DBGLOG("iofb", "] #%d failed compare", i);
-							break;
-						}
-						edidComparePos += compareBytes;
-						extensionComparePos += compareBytes;
-					}
-
-					if (edidComparePos == ov->orgSize) {
-						memcpy(data, ov->newEDID + (blockNumber - 1) * 128, len);
-						iofbVars->edidOverride = ov;
-						DBGLOG("iofb", "] #%d matched; overridebytes:%s", i, HEX(hex, sizeof(hex), data, len));
-						break;
-					}
-
-					DBGLOG("iofb", "] #%d not matched", i);
-				}
-			}
-		}
-	}
-
-	return result;
-}
-
 IOReturn IOFB::wrapregisterForInterruptType( IOFramebuffer *service, IOSelect interruptType, IOFBInterruptProc proc, OSObject * target, void * ref, void ** interruptRef )
 {
 	IOFBVars *iofbVars = callbackIOFB->getIOFBVars(service);
@@ -12,7 +12,10 @@
 #include <Headers/kern_iokit.hpp>
 #include <IOKit/ndrvsupport/IONDRVFramebuffer.h>
 #include "kern_agdc.hpp"
+#include "kern_iofbtrace.hpp"
 
+int bprintf(char * buf, size_t bufSize, const char * format, ...) __printflike(3, 4);
+char * HEX(char * buf, size_t bufSize, void* bytes, size_t byteslen);
 char * DumpOneDetailedTimingInformationPtr(char * buf, size_t bufSize, const void * IOFBDetailedTiming, size_t timingSize);
 char * DumpOneReturn(char * buf, size_t bufSize, IOReturn val);
 UInt32 IOFBAttribChars(UInt32 attribute);
@@ -47,6 +50,164 @@ public:
 
 private:
 
+	/**
+	 *  Open-addressing map from a vtable or service pointer to its bookkeeping object.
+	 *  Lookups are lock-free; insertions are serialised by a lock. A full table is never
+	 *  reallocated in place: a larger copy is published instead and the old one is kept
+	 *  alive until deinit, so a reader holding it can still finish its probe.
+	 */
+	template <typename T>
+	class PointerMap {
+		struct Table {
+			Table *previous;
+			size_t capacity;
+			size_t count;
+			uintptr_t *keys;
+			T **values;
+		};
+
+		/**
+		 *  Current table, published with release semantics
+		 */
+		Table *table {nullptr};
+
+		/**
+		 *  Writer lock
+		 */
+		IOLock *lock {nullptr};
+
+		static constexpr size_t InitialCapacity = 16;
+
+		static size_t slotOf(uintptr_t key, size_t capacity) {
+			// Fibonacci hashing, low bits are always zero for aligned pointers.
+			return static_cast<size_t>((static_cast<uint64_t>(key >> 3) * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity - 1);
+		}
+
+		static Table *createTable(size_t capacity) {
+			auto t = static_cast<Table *>(kern_os_malloc(sizeof(Table) + capacity * (sizeof(uintptr_t) + sizeof(T *))));
+			if (!t)
+				return nullptr;
+			t->previous = nullptr;
+			t->capacity = capacity;
+			t->count = 0;
+			t->keys = reinterpret_cast<uintptr_t *>(t + 1);
+			t->values = reinterpret_cast<T **>(t->keys + capacity);
+			for (size_t i = 0; i < capacity; i++) {
+				t->keys[i] = 0;
+				t->values[i] = nullptr;
+			}
+			return t;
+		}
+
+		static void place(Table *t, uintptr_t key, T *value) {
+			size_t i = slotOf(key, t->capacity);
+			while (t->keys[i] != 0)
+				i = (i + 1) & (t->capacity - 1);
+			// Readers match on the key, so the value must be visible first.
+			t->values[i] = value;
+			__atomic_store_n(&t->keys[i], key, __ATOMIC_RELEASE);
+			t->count++;
+		}
+
+	public:
+		bool init() {
+			lock = IOLockAlloc();
+			return lock != nullptr;
+		}
+
+		void deinit() {
+			auto t = table;
+			while (t) {
+				auto previous = t->previous;
+				kern_os_free(t);
+				t = previous;
+			}
+			table = nullptr;
+			if (lock) {
+				IOLockFree(lock);
+				lock = nullptr;
+			}
+		}
+
+		/**
+		 *  Lock-free lookup
+		 *
+		 *  @param key  vtable or service pointer
+		 *
+		 *  @return stored object or nullptr
+		 */
+		T *find(uintptr_t key) {
+			auto t = __atomic_load_n(&table, __ATOMIC_ACQUIRE);
+			if (!t)
+				return nullptr;
+			size_t i = slotOf(key, t->capacity);
+			for (size_t n = 0; n < t->capacity; n++) {
+				auto k = __atomic_load_n(&t->keys[i], __ATOMIC_ACQUIRE);
+				if (k == key)
+					return t->values[i];
+				if (k == 0)
+					return nullptr;
+				i = (i + 1) & (t->capacity - 1);
+			}
+			return nullptr;
+		}
+
+		/**
+		 *  Delete every stored object, only valid once no reader can look them up
+		 */
+		void deleteValues() {
+			auto t = table;
+			if (!t)
+				return;
+			for (size_t i = 0; i < t->capacity; i++) {
+				if (t->keys[i] != 0) {
+					delete t->values[i];
+					t->values[i] = nullptr;
+				}
+			}
+		}
+
+		/**
+		 *  Insert an object unless another thread got there first
+		 *
+		 *  @param key    vtable or service pointer
+		 *  @param value  object to store
+		 *
+		 *  @return the object now stored for the key, or nullptr on allocation failure
+		 */
+		T *insert(uintptr_t key, T *value) {
+			if (!lock)
+				return nullptr;
+			IOLockLock(lock);
+			T *result = find(key);
+			if (!result) {
+				auto t = table;
+				// Keep the load factor at or below one half so that probes stay short.
+				if (!t || (t->count + 1) * 2 > t->capacity) {
+					auto grown = createTable(t ? t->capacity * 2 : InitialCapacity);
+					if (grown) {
+						if (t) {
+							for (size_t i = 0; i < t->capacity; i++)
+								if (t->keys[i] != 0)
+									place(grown, t->keys[i], t->values[i]);
+						}
+						grown->previous = t;
+						__atomic_store_n(&table, grown, __ATOMIC_RELEASE);
+						t = grown;
+					} else if (!t || t->count + 1 >= t->capacity) {
+						t = nullptr;
+					}
+				}
+				if (t) {
+					place(t, key, value);
+					result = value;
+				}
+			}
+			IOLockUnlock(lock);
+			return result;
+		}
+	};
+
 	/**
 	 *  IOFramebuffer vtable
 	 */
@@ -59,10 +220,7 @@ private:
 			#define onevtableitem(_patch, _index, _result, _name, _params) t_ ## _name org ## _name { nullptr };
 			#include "IOFramebuffer_vtable.hpp"
 	};
-	typedef IOFBvtable* IOFBvtablePtr;
-	IOFBvtablePtr *iofbvtables;
-	SInt32 iofbvtablesCount = 0;
-	SInt32 iofbvtablesMaxCount = 0;
+	PointerMap<IOFBvtable> iofbvtables;
 
 	static IOFBvtable *getIOFBvtable(IOFramebuffer *service);
 
@@ -90,10 +248,7 @@ private:
 			#define onevtableitem(_patch, _index, _result, _name, _params) t_ ## _name org ## _name { nullptr };
 			#include "AppleGraphicsDeviceControl_vtable.hpp"
 	};
-	typedef AGDCvtable* AGDCvtablePtr;
-	AGDCvtablePtr *agdcvtables;
-	SInt32 agdcvtablesCount = 0;
-	SInt32 agdcvtablesMaxCount = 0;
+	PointerMap<AGDCvtable> agdcvtables;
 
 	static AGDCvtable *getAGDCvtable(IOService *service);
 
@@ -121,12 +276,123 @@ private:
 			UInt32 orgSize;
 			UInt8 *newEDID;
 			UInt32 newSize;
+
+			/**
+			 *  Hash of the 128-byte base block of orgEDID
+			 */
+			UInt32 baseHash;
+
+			/**
+			 *  Next override in the same bucket plus one, 0 terminates the chain
+			 */
+			SInt32 next;
 	};
-	IOFBEDIDOverride *iofbEDIDOverrides { nullptr };
-	SInt32 iofbedidCount = 0;
-	SInt32 iofbedidMaxCount = 0;
 
-	void setEDIDOverride(UInt8 *orgEDID, UInt32 orgSize, UInt8 *newEDID, UInt32 newSize);
+	static constexpr size_t EDIDOverrideBuckets = 64;
+
+	/**
+	 *  Immutable set of EDID overrides. The overrides and all of their EDID bytes share one allocation.
+	 *  Every change builds a new set and publishes it, so readers never see entries freed or moved.
+	 *  Override chains by base block hash are kept in registration order so that the first match wins.
+	 *  Chain entries are override indices plus one, overrides shorter than a block live in shortChain.
+	 */
+	struct EDIDOverrideSet {
+		EDIDOverrideSet *retired;
+		UInt32 generation;
+		SInt32 count;
+		SInt32 buckets[EDIDOverrideBuckets];
+		SInt32 shortChain;
+		IOFBEDIDOverride *overrides;
+	};
+
+	/**
+	 *  Published set, replaced under iofbedidLock and read without locking
+	 */
+	EDIDOverrideSet *iofbedidSet { nullptr };
+
+	/**
+	 *  Replaced sets waiting for iofbedidReaders to drop to zero before being freed
+	 */
+	EDIDOverrideSet *iofbedidRetired { nullptr };
+	UInt32 iofbedidReaders = 0;
+	UInt32 iofbedidGeneration = 0;
+	IOLock *iofbedidLock { nullptr };
+
+	/**
+	 *  Maximum extension bytes compared while probing an override, the base block is not included
+	 */
+	static constexpr UInt32 EDIDOverrideMaxExtensionBytes = 7 * 128;
+
+	/**
+	 *  Add, replace or remove an EDID override
+	 *
+	 *  @param orgEDID  EDID to match
+	 *  @param orgSize  EDID to match size, 0 removes all overrides
+	 *  @param newEDID  replacement EDID
+	 *  @param newSize  replacement EDID size, 0 removes the override
+	 *
+	 *  @return kIOReturnBadArgument if orgEDID has more extension blocks than can be matched
+	 */
+	IOReturn setEDIDOverride(UInt8 *orgEDID, UInt32 orgSize, UInt8 *newEDID, UInt32 newSize);
+
+	/**
+	 *  Build a compacted copy of an override set with one override added, replaced or removed
+	 *
+	 *  @param current  current set or NULL
+	 *  @param orgEDID  EDID to match
+	 *  @param orgSize  EDID to match size
+	 *  @param newEDID  replacement EDID
+	 *  @param newSize  replacement EDID size, 0 removes the override
+	 *
+	 *  @return new set or NULL on allocation failure
+	 */
+	static EDIDOverrideSet *buildEDIDOverrideSet(const EDIDOverrideSet *current, const UInt8 *orgEDID, UInt32 orgSize, const UInt8 *newEDID, UInt32 newSize);
+
+	/**
+	 *  Replace the published override set, freeing replaced sets once no reader uses them
+	 *
+	 *  @param set  new set or NULL to remove all overrides
+	 */
+	void publishEDIDOverrideSet(EDIDOverrideSet *set);
+
+	/**
+	 *  Free every retired set, only valid while there are no readers
+	 */
+	void freeRetiredEDIDOverrideSets();
+
+	/**
+	 *  Build the override chains of a new set
+	 *
+	 *  @param set  set to index
+	 */
+	static void indexEDIDOverrides(EDIDOverrideSet *set);
+
+	/**
+	 *  Hash an EDID base block
+	 *
+	 *  @param block  128 bytes
+	 *
+	 *  @return FNV-1a hash
+	 */
+	static UInt32 hashEDIDBlock(const UInt8 *block);
+
+	class IOFBVars;
+
+	/**
+	 *  Find the first registered override matching the EDID of a connection
+	 *
+	 *  @param set           published override set
+	 *  @param iofbVars      framebuffer settings
+	 *  @param service       framebuffer
+	 *  @param connectIndex  connection
+	 *  @param blockType     DDC block type
+	 *  @param options       DDC options
+	 *  @param base          base block that was just read
+	 *  @param len           base block length
+	 *
+	 *  @return matching override or NULL
+	 */
+	static IOFBEDIDOverride *matchEDIDOverride(const EDIDOverrideSet *set, IOFBVars *iofbVars, IOFramebuffer *service, IOIndex connectIndex, IOSelect blockType, IOOptionBits options, const UInt8 *base, UInt32 len);
 
 
 	/**
@@ -164,14 +430,93 @@ private:
 			// -1 = all bits
 
 			IOFBEDIDOverride *edidOverride = NULL;
+
+			/**
+			 *  Private copy of the matched override that edidOverride points to, independent of later override changes
+			 */
+			IOFBEDIDOverride edidOverrideCopy {};
+
+			/**
+			 *  Generation of the set edidOverrideCopy was matched in and registry entry ID of the framebuffer it was matched for
+			 */
+			UInt32 edidOverrideGeneration = 0;
+			UInt64 edidOverrideEntryID = 0;
+
+			/**
+			 *  EDID being read block by block, published as IOFBEDIDn once complete
+			 */
+			UInt8 *edidBuffer = NULL;
+			UInt32 edidBufferSize = 0;
+			UInt32 edidExpected = 0;
+			UInt32 edidLength = 0;
+			IOIndex edidConnectIndex = -1;
+
+			~IOFBVars() {
+				if (edidBuffer)
+					kern_os_free(edidBuffer);
+				if (edidOverrideCopy.newEDID)
+					kern_os_free(edidOverrideCopy.newEDID);
+			}
 	};
-	typedef IOFBVars* IOFBVarsPtr;
-	IOFBVarsPtr *iofbvars;
+	PointerMap<IOFBVars> iofbvars;
 	SInt32 iofbvarsCount = 0;
-	SInt32 iofbvarsMaxCount = 0;
 
 	static IOFBVars *getIOFBVars(IOFramebuffer *service);
 
+	/**
+	 *  Stop overriding the EDID of a framebuffer and free the private copy of the override
+	 *
+	 *  @param iofbVars  framebuffer settings
+	 */
+	static void releaseEDIDOverride(IOFBVars *iofbVars);
+
+	/**
+	 *  Collect a DDC block and publish the IOFBEDIDn property once the whole EDID was read
+	 *
+	 *  @param iofbVars      framebuffer settings
+	 *  @param service       framebuffer
+	 *  @param connectIndex  connection
+	 *  @param blockNumber   1-based block number
+	 *  @param data          block contents
+	 *  @param len           block length
+	 */
+	static void recordEDIDBlock(IOFBVars *iofbVars, IOFramebuffer *service, IOIndex connectIndex, UInt32 blockNumber, const UInt8 *data, UInt32 len);
+
+	/**
+	 *  Handle a get on the 0xFB/0xFB I2C control channel
+	 *
+	 *  @param service     framebuffer the request was sent to
+	 *  @param iofbVars    framebuffer settings
+	 *  @param command     category, val1, val2, val3
+	 *  @param reply       reply buffer
+	 *  @param replyBytes  reply buffer size
+	 *
+	 *  @return command result
+	 */
+	static IOReturn controlGet(IOFramebuffer *service, IOFBVars *iofbVars, const UInt32 *command, void *reply, UInt32 replyBytes);
+
+	/**
+	 *  Handle a set on the 0xFB/0xFB I2C control channel
+	 *
+	 *  @param service   framebuffer the request was sent to
+	 *  @param iofbVars  framebuffer settings
+	 *  @param command   category, val1, val2, val3 followed by the payload if any
+	 *
+	 *  @return command result
+	 */
+	static IOReturn controlSet(IOFramebuffer *service, IOFBVars *iofbVars, const UInt32 *command);
+
+	/**
+	 *  Handle a kIOFBControlBatch request carrying several gets and sets, see kern_iofbcontrol.hpp
+	 *
+	 *  @param service   framebuffer the request was sent to
+	 *  @param iofbVars  framebuffer settings
+	 *  @param request   I2C request with the batch and the reply buffer
+	 *
+	 *  @return batch result, per command results are in the reply
+	 */
+	static IOReturn controlBatch(IOFramebuffer *service, IOFBVars *iofbVars, struct IOI2CRequest *request);
+
 
 	/**
 	 *  AGDC settings per AppleGraphicsDeviceControl service
@@ -182,14 +527,55 @@ private:
 			AGDCvtable *agdcvtable = NULL;
 			int index = 0;
 	};
-	typedef AGDCVars* AGDCVarsPtr;
-	AGDCVarsPtr *agdcvars;
+	PointerMap<AGDCVars> agdcvars;
 	SInt32 agdcvarsCount = 0;
-	SInt32 agdcvarsMaxCount = 0;
 
 	static AGDCVars *getAGDCVars(IOService *service);
 
 
+	/**
+	 *  Binary trace ring of kIOFBTraceRingSize records, drained through the 0xFB 'trce' read
+	 */
+	IOFBTraceRecord *traceRing {nullptr};
+	UInt32 traceHead {0};
+	bool traceEnabled {false};
+
+	/**
+	 *  Enable or disable tracing, allocating the ring on first use
+	 *
+	 *  @param enable  new tracing state
+	 */
+	void setTraceEnabled(bool enable);
+
+	/**
+	 *  Record one framebuffer call without formatting anything
+	 *
+	 *  @param tag      kIOFBTrace* record tag
+	 *  @param service  framebuffer the call was made on
+	 *  @param result   call result
+	 *  @param arg0     first raw argument
+	 *  @param arg1     second raw argument
+	 *  @param arg2     third raw argument
+	 */
+	void trace(UInt32 tag, IOService *service, IOReturn result, UInt64 arg0, UInt64 arg1, UInt64 arg2 = 0) {
+		if (traceEnabled)
+			traceRecord(tag, service, result, arg0, arg1, arg2);
+	}
+
+	void traceRecord(UInt32 tag, IOService *service, IOReturn result, UInt64 arg0, UInt64 arg1, UInt64 arg2);
+
+	/**
+	 *  Copy traced records into an 0xFB reply buffer
+	 *
+	 *  @param firstSequence  first record the caller has not seen yet
+	 *  @param buffer         reply buffer receiving IOFBTraceReply and the records
+	 *  @param size           reply buffer size
+	 *
+	 *  @return kIOReturnSuccess or an error when tracing was never enabled or the buffer is too small
+	 */
+	IOReturn readTrace(UInt32 firstSequence, UInt8 *buffer, UInt32 size);
+
+
 	/**
 	 *  Private self instance for callbacks
 	 */
@@ -0,0 +1,372 @@
+//
+//  kern_iofbedid.cpp
+//  WhateverGreen
+//
+//  Copyright © 2022 vit9696. All rights reserved.
+//
+
+#include <Headers/kern_api.hpp>
+#include <Headers/kern_devinfo.hpp>
+#include <Headers/kern_iokit.hpp>
+
+#include "kern_iofbdebug.hpp"
+
+//========================================================================================
+// EDID overrides
+
+IOReturn IOFB::setEDIDOverride(UInt8 *orgEDID, UInt32 orgSize, UInt8 *newEDID, UInt32 newSize) {
+	DBGLOG("iofb", "[ setEDIDOverride");
+	if (!iofbedidLock) {
+		DBGLOG("iofb", "] setEDIDOverride no lock");
+		return kIOReturnNotReady;
+	}
+
+	IOLockLock(iofbedidLock);
+	if (!orgSize) {
+		publishEDIDOverrideSet(NULL);
+		IOLockUnlock(iofbedidLock);
+		DBGLOG("iofb", "] setEDIDOverride clear all EDID overrides");
+		return kIOReturnSuccess;
+	}
+
+	// matchEDIDOverride buffers a limited number of extension blocks, longer overrides could never match.
+	if (orgSize > 128 + EDIDOverrideMaxExtensionBytes) {
+		IOLockUnlock(iofbedidLock);
+		SYSLOG("iofb", "setEDIDOverride EDID to match has %u bytes, at most %u are supported", orgSize, 128 + EDIDOverrideMaxExtensionBytes);
+		return kIOReturnBadArgument;
+	}
+
+	#ifdef DEBUG
+	char hex[128*8];
+	#endif
+	DBGLOG("iofb", "org[%d]: %s", orgSize, HEX(hex, sizeof(hex), orgEDID, orgSize));
+	DBGLOG("iofb", "new[%d]: %s", newSize, HEX(hex, sizeof(hex), newEDID, newSize));
+
+	EDIDOverrideSet *set = buildEDIDOverrideSet(iofbedidSet, orgEDID, orgSize, newEDID, newSize);
+	if (!set) {
+		IOLockUnlock(iofbedidLock);
+		DBGLOG("iofb", "] setEDIDOverride cannot create list of EDID overrides");
+		return kIOReturnNoMemory;
+	}
+	set->generation = ++iofbedidGeneration;
+	SInt32 count = set->count;
+	if (!count) {
+		kern_os_free(set);
+		set = NULL;
+	}
+	publishEDIDOverrideSet(set);
+	IOLockUnlock(iofbedidLock);
+	DBGLOG("iofb", "] setEDIDOverride generation:%d count:%d", iofbedidGeneration, count);
+	return kIOReturnSuccess;
+}
+
+IOFB::EDIDOverrideSet *IOFB::buildEDIDOverrideSet(const EDIDOverrideSet *current, const UInt8 *orgEDID, UInt32 orgSize, const UInt8 *newEDID, UInt32 newSize) {
+	SInt32 currentCount = current ? current->count : 0;
+	SInt32 existing = -1;
+	for (SInt32 i = 0; i < currentCount; i++) {
+		const IOFBEDIDOverride *ov = &current->overrides[i];
+		if (ov->orgSize == orgSize && !memcmp(ov->orgEDID, orgEDID, orgSize)) {
+			existing = i;
+			break;
+		}
+	}
+
+	// Size the arena for the surviving overrides, deleted entries are compacted away.
+	SInt32 count = 0;
+	size_t payload = 0;
+	for (SInt32 i = 0; i < currentCount; i++) {
+		if (i == existing && !newSize)
+			continue;
+		count++;
+		payload += current->overrides[i].orgSize + (i == existing ? newSize : current->overrides[i].newSize);
+	}
+	if (existing < 0 && newSize) {
+		count++;
+		payload += orgSize + newSize;
+	}
+
+	size_t size = sizeof(EDIDOverrideSet) + count * sizeof(IOFBEDIDOverride) + payload;
+	auto set = static_cast<EDIDOverrideSet *>(kern_os_malloc(size));
+	if (!set)
+		return NULL;
+	set->retired = NULL;
+	set->generation = 0;
+	set->count = count;
+	set->overrides = reinterpret_cast<IOFBEDIDOverride *>(set + 1);
+	UInt8 *bump = reinterpret_cast<UInt8 *>(set->overrides + count);
+
+	auto append = [&](IOFBEDIDOverride *ov, const UInt8 *org, UInt32 orgLength, const UInt8 *repl, UInt32 replLength) {
+		ov->orgEDID = bump;
+		ov->orgSize = orgLength;
+		memcpy(bump, org, orgLength);
+		bump += orgLength;
+		ov->newEDID = bump;
+		ov->newSize = replLength;
+		memcpy(bump, repl, replLength);
+		bump += replLength;
+		ov->baseHash = orgLength >= 128 ? hashEDIDBlock(org) : 0;
+	};
+
+	SInt32 n = 0;
+	for (SInt32 i = 0; i < currentCount; i++) {
+		const IOFBEDIDOverride *ov = &current->overrides[i];
+		if (i == existing && !newSize)
+			continue;
+		if (i == existing)
+			append(&set->overrides[n++], ov->orgEDID, ov->orgSize, newEDID, newSize);
+		else
+			append(&set->overrides[n++], ov->orgEDID, ov->orgSize, ov->newEDID, ov->newSize);
+	}
+	if (existing < 0 && newSize)
+		append(&set->overrides[n++], orgEDID, orgSize, newEDID, newSize);
+
+	indexEDIDOverrides(set);
+	return set;
+}
+
+void IOFB::publishEDIDOverrideSet(EDIDOverrideSet *set) {
+	EDIDOverrideSet *old = iofbedidSet;
+	__atomic_store_n(&iofbedidSet, set, __ATOMIC_SEQ_CST);
+	if (old) {
+		old->retired = iofbedidRetired;
+		iofbedidRetired = old;
+	}
+
+	// Readers register before loading the set, so once none are left nobody can still hold a retired one.
+	if (__atomic_load_n(&iofbedidReaders, __ATOMIC_SEQ_CST) == 0)
+		freeRetiredEDIDOverrideSets();
+}
+
+void IOFB::freeRetiredEDIDOverrideSets() {
+	while (iofbedidRetired) {
+		EDIDOverrideSet *retired = iofbedidRetired->retired;
+		kern_os_free(iofbedidRetired);
+		iofbedidRetired = retired;
+	}
+}
+
+UInt32 IOFB::hashEDIDBlock(const UInt8 *block) {
+	UInt32 hash = 2166136261U;
+	for (size_t i = 0; i < 128; i++)
+		hash = (hash ^ block[i]) * 16777619U;
+	return hash;
+}
+
+void IOFB::indexEDIDOverrides(EDIDOverrideSet *set) {
+	for (size_t i = 0; i < EDIDOverrideBuckets; i++)
+		set->buckets[i] = 0;
+	set->shortChain = 0;
+
+	// Walk backwards and prepend so that every chain ends up in registration order.
+	for (SInt32 i = set->count - 1; i >= 0; i--) {
+		IOFBEDIDOverride *ov = &set->overrides[i];
+		SInt32 *head = ov->orgSize >= 128 ? &set->buckets[ov->baseHash % EDIDOverrideBuckets] : &set->shortChain;
+		ov->next = *head;
+		*head = i + 1;
+	}
+}
+
+IOFB::IOFBEDIDOverride *IOFB::matchEDIDOverride(const EDIDOverrideSet *set, IOFBVars *iofbVars, IOFramebuffer *service, IOIndex connectIndex, IOSelect blockType, IOOptionBits options, const UInt8 *base, UInt32 len) {
+	// Extension blocks are read once per probe and shared by all candidates.
+	UInt8 extensions[EDIDOverrideMaxExtensionBytes];
+	UInt32 extensionLength = 0;
+	bool extensionFailed = false;
+
+	auto matches = [&](SInt32 i) {
+		const IOFBEDIDOverride *ov = &set->overrides[i];
+		UInt32 edidComparePos = ov->orgSize < len ? ov->orgSize : len;
+		if (memcmp(ov->orgEDID, base, edidComparePos))
+			return false;
+		DBGLOG("iofb", "[ #%d possible EDID override match first %d bytes", i, edidComparePos);
+
+		UInt32 extensionBytes = ov->orgSize - edidComparePos;
+		if (extensionBytes > sizeof(extensions)) {
+			DBGLOG("iofb", "] #%d too many extension bytes %d", i, extensionBytes);
+			return false;
+		}
+		while (extensionLength < extensionBytes && !extensionFailed) {
+			IOByteCount length = 128;
+			int readBlockNum = (len + extensionLength) / 128 + 1;
+			if (extensionLength + length > sizeof(extensions)) {
+				extensionFailed = true;
+				break;
+			}
+			DBGLOG("iofb", "read block %d", readBlockNum);
+			IOReturn result = iofbVars->iofbvtable->orggetDDCBlock( service, connectIndex, readBlockNum, blockType, options, extensions + extensionLength, &length );
+			if (result || !length) {
+				DBGLOG("iofb", "failed read block %d", readBlockNum);
+				extensionFailed = true;
+				break;
+			}
+			extensionLength += length;
+		}
+		if (extensionLength < extensionBytes || memcmp(ov->orgEDID + edidComparePos, extensions, extensionBytes)) {
+			DBGLOG("iofb", "] #%d not matched", i);
+			return false;
+		}
+		DBGLOG("iofb", "] #%d matched", i);
+		return true;
+	};
+
+	SInt32 found = 0;
+	if (len >= 128) {
+		UInt32 baseHash = hashEDIDBlock(base);
+		for (SInt32 i = set->buckets[baseHash % EDIDOverrideBuckets]; i; i = set->overrides[i - 1].next) {
+			if (set->overrides[i - 1].baseHash == baseHash && matches(i - 1)) {
+				found = i;
+				break;
+			}
+		}
+	}
+	// Overrides shorter than a block can still win if they were registered earlier.
+	for (SInt32 i = set->shortChain; i && (!found || i < found); i = set->overrides[i - 1].next) {
+		if (matches(i - 1)) {
+			found = i;
+			break;
+		}
+	}
+
+	return found ? &set->overrides[found - 1] : NULL;
+}
+
+
+//========================================================================================
+// DDC blocks
+
+void IOFB::releaseEDIDOverride(IOFBVars *iofbVars)
+{
+	iofbVars->edidOverride = NULL;
+	if (iofbVars->edidOverrideCopy.newEDID)
+		kern_os_free(iofbVars->edidOverrideCopy.newEDID);
+	iofbVars->edidOverrideCopy.newEDID = NULL;
+	iofbVars->edidOverrideCopy.newSize = 0;
+}
+
+void IOFB::recordEDIDBlock(IOFBVars *iofbVars, IOFramebuffer *service, IOIndex connectIndex, UInt32 blockNumber, const UInt8 *data, UInt32 len)
+{
+	if (blockNumber < 1)
+		return;
+
+	// The base block starts a new EDID and tells how many extension blocks follow.
+	if (blockNumber == 1) {
+		iofbVars->edidConnectIndex = connectIndex;
+		iofbVars->edidExpected = len >= 128 ? (data[126] + 1) * 128 : len;
+		iofbVars->edidLength = 0;
+		if (iofbVars->edidBufferSize < iofbVars->edidExpected) {
+			if (iofbVars->edidBuffer)
+				kern_os_free(iofbVars->edidBuffer);
+			iofbVars->edidBuffer = (UInt8*)kern_os_malloc(iofbVars->edidExpected);
+			iofbVars->edidBufferSize = iofbVars->edidBuffer ? iofbVars->edidExpected : 0;
+		}
+	}
+	else if (iofbVars->edidConnectIndex != connectIndex) {
+		return;
+	}
+
+	if (!iofbVars->edidBuffer || !iofbVars->edidExpected)
+		return;
+
+	UInt32 offset = (blockNumber - 1) * 128;
+	if (offset >= iofbVars->edidExpected || offset > iofbVars->edidLength)
+		return;
+	UInt32 copyLength = len < iofbVars->edidExpected - offset ? len : iofbVars->edidExpected - offset;
+	memcpy(iofbVars->edidBuffer + offset, data, copyLength);
+	if (offset + copyLength > iofbVars->edidLength)
+		iofbVars->edidLength = offset + copyLength;
+
+	if (iofbVars->edidLength == iofbVars->edidExpected) {
+		char propertyName[20];
+		bprintf(propertyName, sizeof(propertyName), "IOFBEDID%d", connectIndex);
+		OSData *edidData = OSData::withBytes(iofbVars->edidBuffer, iofbVars->edidLength);
+		if (edidData) {
+			service->setProperty(propertyName, edidData);
+			edidData->release();
+		}
+		iofbVars->edidExpected = 0;
+	}
+}
+
+IOReturn IOFB::wrapgetDDCBlock( IOFramebuffer *service, IOIndex connectIndex, UInt32 blockNumber, IOSelect blockType, IOOptionBits options, UInt8 * data, IOByteCount * length )
+{
+	IOFBVars *iofbVars = callbackIOFB->getIOFBVars(service);
+	IOFBEDIDOverride *ov = iofbVars->edidOverride;
+
+	// A base block read matches again when the overrides changed or another framebuffer took this address.
+	if (ov && blockNumber == 1) {
+		__atomic_fetch_add(&callbackIOFB->iofbedidReaders, 1, __ATOMIC_SEQ_CST);
+		EDIDOverrideSet *set = __atomic_load_n(&callbackIOFB->iofbedidSet, __ATOMIC_SEQ_CST);
+		UInt32 generation = set ? set->generation : 0;
+		__atomic_fetch_sub(&callbackIOFB->iofbedidReaders, 1, __ATOMIC_RELEASE);
+		if (generation != iofbVars->edidOverrideGeneration || service->getRegistryEntryID() != iofbVars->edidOverrideEntryID) {
+			DBGLOG("iofb", "getDDCBlock EDID override generation %d is stale, now %d", iofbVars->edidOverrideGeneration, generation);
+			releaseEDIDOverride(iofbVars);
+			ov = NULL;
+		}
+	}
+
+	char hex[128*8];
+	unsigned int lenBefore = (length ? (unsigned int)*length : 128);
+	unsigned int len = lenBefore;
+	IOReturn result = kIOReturnSuccess;
+
+	if (ov) {
+		if (blockNumber < 1)
+			result = kIOReturnInvalid;
+		else {
+			SInt32 offset = (blockNumber - 1) * 128;
+			if (offset + lenBefore > ov->newSize) {
+				len = offset > ov->newSize ? 0 : ov->newSize - offset;
+				if (length) {
+					*length = len;
+				}
+			}
+			memcpy(data, ov->newEDID + offset, len);
+		}
+	}
+	else {
+		result = iofbVars->iofbvtable->orggetDDCBlock( service, connectIndex, blockNumber, blockType, options, data, length );
+		len = (length ? (unsigned int)*length : 128);
+	}
+
+	#ifdef DEBUG
+	char resultStr[40];
+	#endif
+	DBGLOG("iofb", "[] getDDCBlock fb:0x%llx connectIndex:%d blockNumber:%d blockType:%d options:%x%s %sbytes:%s",
+		(UInt64)service, connectIndex, blockNumber, blockType, options,
+		DumpOneReturn(resultStr, sizeof(resultStr), result), ov ? "override" : "", HEX(hex, sizeof(hex), data, len)
+	);
+	if (len != lenBefore) {
+		DBGLOG("iofb", "getDDCBlock len changed from %d to %d", lenBefore, len);
+	}
+
+	if (!result) {
+		if (!ov && (blockNumber == 1) && len && !(len & 0x7f)) {
+			// The set is only guaranteed to stay allocated while registered as a reader,
+			// keep a private copy of the match for the blocks that follow.
+			__atomic_fetch_add(&callbackIOFB->iofbedidReaders, 1, __ATOMIC_SEQ_CST);
+			EDIDOverrideSet *set = __atomic_load_n(&callbackIOFB->iofbedidSet, __ATOMIC_SEQ_CST);
+			IOFBEDIDOverride *match = set ? matchEDIDOverride(set, iofbVars, service, connectIndex, blockType, options, data, len) : NULL;
+			UInt8 *newEDID = match ? (UInt8*)kern_os_malloc(match->newSize) : NULL;
+			if (newEDID) {
+				memcpy(newEDID, match->newEDID, match->newSize);
+				ov = &iofbVars->edidOverrideCopy;
+				ov->newEDID = newEDID;
+				ov->newSize = match->newSize;
+				iofbVars->edidOverrideGeneration = set->generation;
+				iofbVars->edidOverrideEntryID = service->getRegistryEntryID();
+			}
+			__atomic_fetch_sub(&callbackIOFB->iofbedidReaders, 1, __ATOMIC_RELEASE);
+
+			if (ov) {
+				memcpy(data, ov->newEDID + (blockNumber - 1) * 128, len);
+				iofbVars->edidOverride = ov;
+				DBGLOG("iofb", "EDID override overridebytes:%s", HEX(hex, sizeof(hex), data, len));
+			}
+		}
+
+		// Record the block the caller gets, an override may change the number of extension blocks.
+		recordEDIDBlock(iofbVars, service, connectIndex, blockNumber, data, len);
+	}
+
+	return result;
+}
@@ -0,0 +1,70 @@
+//
+//  kern_iofbtrace.hpp
+//  WhateverGreen
+//
+//  Created by agent on 2026-10-17.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef kern_iofbtrace_hpp
+#define kern_iofbtrace_hpp
+
+// This header is shared with Tools/IOFBTrace and must stay plain C.
+
+/**
+ *  Trace record tags, four character codes like the rest of the 0xFB channel
+ */
+#define kIOFBTraceGetAttribute              'gatt'
+#define kIOFBTraceSetAttribute              'satt'
+#define kIOFBTraceGetAttributeForConnection 'gafc'
+#define kIOFBTraceSetAttributeForConnection 'safc'
+#define kIOFBTraceDoI2CRequest              'i2cr'
+
+/**
+ *  Number of records kept by the kernel, must be a power of two
+ */
+#define kIOFBTraceRingSize 1024
+
+/**
+ *  Sequence value of a slot that is being written or was never written
+ */
+#define kIOFBTraceInvalidSequence 0xFFFFFFFFU
+
+/**
+ *  One traced framebuffer call. The arguments are stored raw and only formatted by the decoder.
+ *
+ *  gatt/satt: args[0] attribute, args[1] value
+ *  gafc/safc: args[0] attribute, args[1] value, args[2] connectIndex
+ *  i2cr:      args[0] bus, args[1] send type << 24 | send address, args[2] reply type << 24 | reply address
+ */
+struct IOFBTraceRecord {
+	uint64_t timestamp; // mach_absolute_time
+	uint64_t service;   // IOFramebuffer pointer
+	uint64_t args[3];
+	uint32_t tag;
+	uint32_t result;
+	uint32_t sequence;
+	uint32_t reserved;
+};
+
+/**
+ *  Reply to a 0xFB 'trce' read: this header followed by count records starting at firstSequence
+ */
+struct IOFBTraceReply {
+	uint32_t firstSequence;
+	uint32_t nextSequence;
+	uint32_t count;
+	uint32_t reserved;
+};
+
+/**
+ *  IOI2CSendRequest only passes reply buffers of up to this size inline and fails with kIOReturnOverrun otherwise
+ */
+#define kIOFBTraceMaxReplyBytes 1024
+
+/**
+ *  Maximum number of records in a single 'trce' reply
+ */
+#define kIOFBTraceMaxReplyRecords ((kIOFBTraceMaxReplyBytes - sizeof(struct IOFBTraceReply)) / sizeof(struct IOFBTraceRecord))
+
+#endif /* kern_iofbtrace_hpp */
@@ -27,6 +27,8 @@
  *
  * Some identifiers are taken from https://github.com/pciutils/pciids/blob/master/pci.ids?raw=true
  * Last synced version 2017.07.24 (https://github.com/pciutils/pciids/blob/699e70f3de/pci.ids?raw=true)
+ * Tools/ModelTables regenerates the tables below from a local pci.ids following these rules
+ * and reports added subsystems, renamed entries and new Intel identifiers.
  */
 
 struct Model {
@@ -877,7 +879,7 @@ static constexpr DevicePair devices[] {
 	{0x9488, dev9488, arrsize(dev9488)}
 };
 
-static BuiltinModel devIntel[] {
+static constexpr BuiltinModel devIntel[] {
 	// For Sandy only 0x0116 and 0x0126 controllers are properly supported by AppleIntelSNBGraphicsFB.
 	// 0x0102 and 0x0106 are implemented as AppleIntelSNBGraphicsController/AppleIntelSNBGraphicsController2.
 	// AppleIntelHD3000Graphics actually supports more (0x0106, 0x0601, 0x0102, 0x0116, 0x0126).
@@ -1011,33 +1013,94 @@ static BuiltinModel devIntel[] {
 	// Reserved/unused/generic Ice Lake },
 };
 
-const char *WEG::getIntelModel(uint32_t dev, uint32_t &fakeId) {
-	fakeId = 0;
+/**
+ *  Lookup tables must be strictly increasing by device id for the binary searches below.
+ *  devices is kept sorted in source, devIntel keeps its generation grouping and is sorted at compile time.
+ */
+static constexpr bool devicesSorted() {
+	for (size_t i = 1; i < arrsize(devices); i++)
+		if (devices[i - 1].dev >= devices[i].dev)
+			return false;
+	return true;
+}
+
+static_assert(devicesSorted(), "devices must be sorted by device id without duplicates");
+
+struct SortedBuiltinModels {
+	BuiltinModel models[arrsize(devIntel)];
+};
+
+static constexpr SortedBuiltinModels sortBuiltinModels() {
+	SortedBuiltinModels sorted {};
 	for (size_t i = 0; i < arrsize(devIntel); i++) {
-		if (devIntel[i].device == dev) {
-			fakeId = devIntel[i].fake;
-			return devIntel[i].name;
+		size_t j = i;
+		while (j > 0 && sorted.models[j - 1].device > devIntel[i].device) {
+			sorted.models[j] = sorted.models[j - 1];
+			j--;
 		}
+		sorted.models[j] = devIntel[i];
+	}
+	return sorted;
+}
+
+static constexpr SortedBuiltinModels devIntelSorted = sortBuiltinModels();
+
+static constexpr bool devIntelUnique() {
+	for (size_t i = 1; i < arrsize(devIntelSorted.models); i++)
+		if (devIntelSorted.models[i - 1].device == devIntelSorted.models[i].device)
+			return false;
+	return true;
+}
+
+static_assert(devIntelUnique(), "devIntel must not contain duplicate device ids");
+
+/**
+ *  Find an entry by device id in a table sorted by device id
+ *
+ *  @param entries  sorted table
+ *  @param num      number of entries
+ *  @param dev      device id to find
+ *  @param key      device id of an entry
+ *
+ *  @return matching entry or nullptr
+ */
+template <typename T, typename K>
+static const T *findDevice(const T *entries, size_t num, uint32_t dev, K key) {
+	size_t lo = 0, hi = num;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (key(entries[mid]) < dev)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo < num && key(entries[lo]) == dev) ? &entries[lo] : nullptr;
+}
+
+const char *WEG::getIntelModel(uint32_t dev, uint32_t &fakeId) {
+	fakeId = 0;
+	auto model = findDevice(devIntelSorted.models, arrsize(devIntelSorted.models), dev, [](const BuiltinModel &m) { return m.device; });
+	if (model) {
+		fakeId = model->fake;
+		return model->name;
 	}
 
 	return nullptr;
 }
 
 const char *WEG::getRadeonModel(uint16_t dev, uint16_t rev, uint16_t subven, uint16_t sub) {
-	for (auto &device : devices) {
-		if (device.dev == dev) {
-			for (size_t j = 0; j < device.modelNum; j++) {
-				auto &model = device.models[j];
+	auto device = findDevice(devices, arrsize(devices), dev, [](const DevicePair &d) { return static_cast<uint32_t>(d.dev); });
+	if (device) {
+		for (size_t j = 0; j < device->modelNum; j++) {
+			auto &model = device->models[j];
 
-				if (model.mode & Model::DetectSub && (model.subven != subven || model.sub != sub))
-					continue;
+			if (model.mode & Model::DetectSub && (model.subven != subven || model.sub != sub))
+				continue;
 
-				if (model.mode & Model::DetectRev && (model.rev != rev))
-					continue;
+			if (model.mode & Model::DetectRev && (model.rev != rev))
+				continue;
 
-				return model.name;
-			}
-			break;
+			return model.name;
 		}
 	}
 
@@ -302,22 +302,6 @@ void NGFX::applyAcceleratorProperties(IOService *that) {
 	}
 }
 
-int NGFX::wrapCsfgGetPlatformBinary(void *fg) {
-	//DBGLOG("ngfx", "csfg_get_platform_binary is called"); // is called quite often
-
-	int result = FunctionCast(wrapCsfgGetPlatformBinary, callbackNGFX->orgCsfgGetPlatformBinary)(fg);
-	if (!result) {
-		// Special case NVIDIA drivers
-		const char *teamId = callbackNGFX->orgCsfgGetTeamId(fg);
-		if (teamId && !strcmp(teamId, NvidiaTeamId)) {
-			DBGLOG("ngfx", "platform binary override for %s", NvidiaTeamId);
-			return 1;
-		}
-	}
-
-	return result;
-}
-
 bool NGFX::wrapVaddrPreSubmit(void *that) {
 	bool r = orgVaddrPresubmitTrampoline(that);
 
@@ -56,6 +56,11 @@ private:
 	 */
 	static constexpr const char *NvidiaTeamId { "6KR3T733EC" };
 
+	/**
+	 *  Apple Developer Team ID length, all of them are 10 characters
+	 */
+	static constexpr size_t TeamIdLength {10};
+
 	/**
 	 *  Force Web Driver compatibility, -1 lets us override via GPU property
 	 */
@@ -101,6 +106,17 @@ private:
 	 */
 	mach_vm_address_t orgCsfgGetPlatformBinary {};
 
+#ifdef DEBUG
+	/**
+	 *  csfg_get_platform_binary wrapper statistics
+	 */
+	struct {
+		uint64_t calls;
+		uint64_t teamIdChecks;
+		uint64_t overrides;
+	} platformBinaryStats {};
+#endif
+
 	/**
 	 * Original SetAccelProperties functions for official and web drivers
 	 */
@@ -135,6 +151,15 @@ private:
 	 */
 	void applyAcceleratorProperties(IOService *that);
 
+	/**
+	 *  Check a team ID against NvidiaTeamId, reading at most TeamIdLength + 1 bytes
+	 *
+	 *  @param teamId  team ID string
+	 *
+	 *  @return true for NVIDIA binaries
+	 */
+	static bool isNvidiaTeamId(const char *teamId);
+
 	/**
 	 *  csfg_get_platform_binary wrapper used for fixing visual glitches with web drivers due to missing entitlements.
 	 *
@@ -0,0 +1,52 @@
+//
+//  kern_ngfx_teamid.cpp
+//  WhateverGreen
+//
+//  Copyright © 2018 vit9696. All rights reserved.
+//
+
+#include "kern_ngfx.hpp"
+#include <Headers/kern_util.hpp>
+
+///
+/// This file contains the csfg_get_platform_binary override granting NVIDIA Web Driver
+/// binaries platform access rights by their team ID.
+///
+
+bool NGFX::isNvidiaTeamId(const char *teamId) {
+	// Most binaries differ in the first character, the rest never reads past the terminator.
+	return teamId[0] == NvidiaTeamId[0] && strncmp(teamId + 1, NvidiaTeamId + 1, TeamIdLength) == 0;
+}
+
+int NGFX::wrapCsfgGetPlatformBinary(void *fg) {
+	//DBGLOG("ngfx", "csfg_get_platform_binary is called"); // is called quite often
+
+	// Fileglobs are recycled without notice, so every verdict is recomputed rather than cached per fileglob.
+	int result = FunctionCast(wrapCsfgGetPlatformBinary, callbackNGFX->orgCsfgGetPlatformBinary)(fg);
+#ifdef DEBUG
+	auto &stats = callbackNGFX->platformBinaryStats;
+	auto calls = __atomic_add_fetch(&stats.calls, 1, __ATOMIC_RELAXED);
+#endif
+	if (!result) {
+		// Special case NVIDIA drivers
+#ifdef DEBUG
+		__atomic_fetch_add(&stats.teamIdChecks, 1, __ATOMIC_RELAXED);
+#endif
+		const char *teamId = callbackNGFX->orgCsfgGetTeamId(fg);
+		if (teamId && isNvidiaTeamId(teamId)) {
+#ifdef DEBUG
+			__atomic_fetch_add(&stats.overrides, 1, __ATOMIC_RELAXED);
+#endif
+			DBGLOG("ngfx", "platform binary override for %s", NvidiaTeamId);
+			result = 1;
+		}
+	}
+
+#ifdef DEBUG
+	if ((calls & (calls - 1)) == 0)
+		DBGLOG("ngfx", "csfg_get_platform_binary %llu calls, %llu team id checks, %llu overrides", calls,
+			   __atomic_load_n(&stats.teamIdChecks, __ATOMIC_RELAXED), __atomic_load_n(&stats.overrides, __ATOMIC_RELAXED));
+#endif
+
+	return result;
+}
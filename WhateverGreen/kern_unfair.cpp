@@ -20,6 +20,23 @@
 
 UNFAIR *UNFAIR::callbackUNFAIR;
 
+static const uint8_t relaxedDrmModelFind[29] = {
+	0x4D, 0x61, 0x63, 0x50, 0x72, 0x6F, 0x35, 0x2C, 0x31, 0x00, 0x4D, 0x61, 0x63, 0x50, 0x72, 0x6F,
+	0x36, 0x2C, 0x31, 0x00, 0x49, 0x4F, 0x53, 0x65, 0x72, 0x76, 0x69, 0x63, 0x65
+};
+
+static const uint8_t hwgvaIdFind[18] = {
+	0x62, 0x6F, 0x61, 0x72, 0x64, 0x2D, 0x69, 0x64, 0x00, 0x68, 0x77, 0x2E, 0x6D, 0x6F, 0x64, 0x65,
+	0x6C
+};
+
+static const uint8_t hwgvaIdReplace[5] = {
+	0x68, 0x77, 0x67, 0x76, 0x61
+};
+
+static const uint8_t streamingCpuidFind[] = {0xC7, 0xC0, 0x01, 0x00, 0x00, 0x00, 0x0F, 0xA2};
+static const uint8_t streamingCpuidReplace[] = {0xC7, 0xC0, 0xC3, 0x06, 0x03, 0x00, 0x90, 0x90};
+
 void UNFAIR::init() {
 	DBGLOG("unfair", "[ UNFAIR::init");
 	callbackUNFAIR = this;
@@ -39,45 +56,248 @@ void UNFAIR::deinit() {
 	DBGLOG("unfair", "] UNFAIR::deinit");
 }
 
+UNFAIR::PageVerdict UNFAIR::classifyPath(const char *path) {
+	if ((unfairGva & UnfairDyldSharedCache) != 0 && UserPatcher::matchSharedCachePath(path))
+		return PageVerdict::SharedCache;
+
+	if ((unfairGva & UnfairAllowHardwareDrmStreamDecoderOnOldCpuid) != 0 &&
+		(UNLIKELY(strcmp(path, "/System/Library/PrivateFrameworks/CoreLSKDMSE.framework/Versions/A/CoreLSKDMSE") == 0) ||
+		UNLIKELY(strcmp(path, "/System/Library/PrivateFrameworks/CoreLSKD.framework/Versions/A/CoreLSKD") == 0)))
+		return PageVerdict::CoreLSKD;
+
+	return PageVerdict::Ignore;
+}
+
+static size_t verdictSlotIndex(vnode *vp, uint32_t vid) {
+	// vnodes come from a zone, drop the low bits shared by every element before mixing in the id.
+	auto key = (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(vp)) >> 4) ^ (static_cast<uint64_t>(vid) << 32);
+	return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
+UNFAIR::PageVerdict UNFAIR::lookupVerdict(vnode *vp, uint32_t vid) {
+	static_assert(VerdictCacheSize == 1U << 8, "Update verdictSlotIndex");
+	auto &slot = verdictCache[verdictSlotIndex(vp, vid)];
+
+	uint32_t sequence = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+	if (sequence & 1U)
+		return PageVerdict::Unknown;
+
+	auto slotVp = __atomic_load_n(&slot.vp, __ATOMIC_RELAXED);
+	auto slotVid = __atomic_load_n(&slot.vid, __ATOMIC_RELAXED);
+	auto verdict = __atomic_load_n(&slot.verdict, __ATOMIC_RELAXED);
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) != sequence || slotVp != vp || slotVid != vid)
+		return PageVerdict::Unknown;
+
+	return static_cast<PageVerdict>(verdict);
+}
+
+void UNFAIR::storeVerdict(vnode *vp, uint32_t vid, PageVerdict verdict) {
+	auto &slot = verdictCache[verdictSlotIndex(vp, vid)];
+
+	uint32_t sequence = __atomic_load_n(&slot.sequence, __ATOMIC_RELAXED);
+	if ((sequence & 1U) || !__atomic_compare_exchange_n(&slot.sequence, &sequence, sequence + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&slot.vp, vp, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot.vid, vid, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot.verdict, static_cast<uint32_t>(verdict), __ATOMIC_RELAXED);
+	__atomic_store_n(&slot.sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+void UNFAIR::PageRewriteSet::add(const PageRewrite &rewrite) {
+	if (num >= MaxRewrites || rewrite.findSize == 0 || rewrite.findSize > PageEdgeSize + 1 || rewrite.replaceSize > rewrite.findSize) {
+		SYSLOG("unfair", "unsupported page rewrite %s", rewrite.name);
+		return;
+	}
+
+	rewrites[num++] = rewrite;
+
+	// Every pattern takes part through its first window bytes, so rebuild the tables for the new shortest length.
+	window = rewrites[0].findSize;
+	for (size_t r = 1; r < num; r++)
+		window = min(window, rewrites[r].findSize);
+
+	memset(shift, static_cast<int>(window), sizeof(shift));
+	memset(lastBytes, 0, sizeof(lastBytes));
+	for (size_t r = 0; r < num; r++) {
+		auto find = rewrites[r].find;
+		for (size_t j = 0; j + 1 < window; j++)
+			shift[find[j]] = min(shift[find[j]], static_cast<uint8_t>(window - 1 - j));
+		lastBytes[find[window - 1] / 32] |= 1U << (find[window - 1] % 32);
+	}
+}
+
+/**
+ *  Call found(rewrite index, position) for every rewrite pattern starting in [from, to) and ending within size bytes,
+ *  stop once found returns false
+ */
+template <typename S, typename F>
+static void matchPageRewrites(const S &set, const uint8_t *data, size_t size, size_t from, size_t to, F found) {
+	for (size_t i = from; i < to && i + set.window <= size; i += set.shift[data[i + set.window - 1]]) {
+		uint8_t last = data[i + set.window - 1];
+		if (LIKELY((set.lastBytes[last / 32] & (1U << (last % 32))) == 0))
+			continue;
+
+		for (size_t r = 0; r < set.num; r++) {
+			auto &rewrite = set.rewrites[r];
+			if (i + rewrite.findSize <= size && memcmp(data + i, rewrite.find, rewrite.findSize) == 0 && !found(r, i))
+				return;
+		}
+	}
+}
+
+static size_t pageEdgeSlotIndex(vnode *vp, memory_object_offset_t offset) {
+	// Consecutive pages of a file land in consecutive slots and never evict their neighbours.
+	auto base = (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(vp)) >> 4) * 0x9E3779B97F4A7C15ULL >> 58;
+	return static_cast<size_t>(base + offset / PAGE_SIZE) & (64 - 1);
+}
+
+bool UNFAIR::loadPageEdge(vnode *vp, uint32_t vid, memory_object_offset_t offset, bool tail, uint8_t *edge) {
+	static_assert(PageEdgeCacheSize == 64, "Update pageEdgeSlotIndex");
+	auto &slot = pageEdgeCache[pageEdgeSlotIndex(vp, offset)];
+
+	uint32_t sequence = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+	if (sequence & 1U)
+		return false;
+
+	auto slotVp = __atomic_load_n(&slot.vp, __ATOMIC_RELAXED);
+	auto slotVid = __atomic_load_n(&slot.vid, __ATOMIC_RELAXED);
+	auto slotOffset = __atomic_load_n(&slot.offset, __ATOMIC_RELAXED);
+	uint64_t words[PageEdgeSize / sizeof(uint64_t)];
+	auto source = tail ? slot.tail : slot.head;
+	for (size_t i = 0; i < arrsize(words); i++)
+		words[i] = __atomic_load_n(&source[i], __ATOMIC_RELAXED);
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) != sequence || slotVp != vp || slotVid != vid || slotOffset != offset)
+		return false;
+
+	lilu_os_memcpy(edge, words, PageEdgeSize);
+	return true;
+}
+
+void UNFAIR::storePageEdges(vnode *vp, uint32_t vid, memory_object_offset_t offset, const uint8_t *head, const uint8_t *tail) {
+	auto &slot = pageEdgeCache[pageEdgeSlotIndex(vp, offset)];
+
+	uint32_t sequence = __atomic_load_n(&slot.sequence, __ATOMIC_RELAXED);
+	if ((sequence & 1U) || !__atomic_compare_exchange_n(&slot.sequence, &sequence, sequence + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+
+	uint64_t headWords[PageEdgeSize / sizeof(uint64_t)], tailWords[PageEdgeSize / sizeof(uint64_t)];
+	lilu_os_memcpy(headWords, head, PageEdgeSize);
+	lilu_os_memcpy(tailWords, tail, PageEdgeSize);
+
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&slot.vp, vp, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot.vid, vid, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot.offset, offset, __ATOMIC_RELAXED);
+	for (size_t i = 0; i < arrsize(headWords); i++) {
+		__atomic_store_n(&slot.head[i], headWords[i], __ATOMIC_RELAXED);
+		__atomic_store_n(&slot.tail[i], tailWords[i], __ATOMIC_RELAXED);
+	}
+	__atomic_store_n(&slot.sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+void UNFAIR::rewritePage(const PageRewriteSet &set, vnode *vp, uint32_t vid, memory_object_offset_t offset, uint8_t *data) {
+	if (set.num == 0)
+		return;
+
+	struct Piece {
+		size_t position;
+		const uint8_t *bytes;
+		size_t size;
+		const char *name;
+		bool edge;
+	};
+	Piece pieces[PageRewriteSet::MaxRewrites * 2];
+	size_t pieceNum = 0;
+
+	// Like findAndReplace, every rewrite applies to its first match within the page.
+	uint32_t pending = (1U << set.num) - 1;
+	matchPageRewrites(set, data, PAGE_SIZE, 0, PAGE_SIZE, [&](size_t r, size_t position) {
+		if (pending & (1U << r)) {
+			pending &= ~(1U << r);
+			auto &rewrite = set.rewrites[r];
+			pieces[pieceNum++] = {position, rewrite.replace, rewrite.replaceSize, rewrite.name, false};
+		}
+		return pending != 0;
+	});
+
+	// A pattern crossing a page edge is only rewritten when its whole replacement lies in this page,
+	// which needs the next page to be seen first. Rewriting a part of it would map bytes that are
+	// neither the original nor the replacement, so any other crossing match is left alone.
+	uint8_t window[PageEdgeSize * 2];
+#ifdef DEBUG
+	if (offset >= PAGE_SIZE && loadPageEdge(vp, vid, offset - PAGE_SIZE, true, window)) {
+		lilu_os_memcpy(window + PageEdgeSize, data, PageEdgeSize);
+		matchPageRewrites(set, window, sizeof(window), 0, PageEdgeSize, [&](size_t r, size_t position) {
+			auto &rewrite = set.rewrites[r];
+			if (position + rewrite.findSize > PageEdgeSize)
+				DBGLOG("unfair", "not rewriting %s crossing from the previous page", rewrite.name);
+			return true;
+		});
+	}
+#endif
+
+	if (loadPageEdge(vp, vid, offset + PAGE_SIZE, false, window + PageEdgeSize)) {
+		lilu_os_memcpy(window, data + PAGE_SIZE - PageEdgeSize, PageEdgeSize);
+		matchPageRewrites(set, window, sizeof(window), 0, PageEdgeSize, [&](size_t r, size_t position) {
+			auto &rewrite = set.rewrites[r];
+			if (position + rewrite.findSize <= PageEdgeSize)
+				return true;
+			if (position + rewrite.replaceSize <= PageEdgeSize && pieceNum < arrsize(pieces))
+				pieces[pieceNum++] = {PAGE_SIZE - PageEdgeSize + position, rewrite.replace, rewrite.replaceSize, rewrite.name, true};
+			else
+				DBGLOG("unfair", "not rewriting %s with a replacement crossing the page edge", rewrite.name);
+			return true;
+		});
+	}
+
+	// Neighbours match against the original bytes, remember them before rewriting.
+	storePageEdges(vp, vid, offset, data, data + PAGE_SIZE - PageEdgeSize);
+
+	if (LIKELY(pieceNum == 0))
+		return;
+
+	if (MachInfo::setKernelWriting(true, KernelPatcher::kernelWriteLock) != KERN_SUCCESS) {
+		SYSLOG("unfair", "failed to obtain write permissions for page rewrite");
+		return;
+	}
+
+	for (size_t i = 0; i < pieceNum; i++)
+		lilu_os_memcpy(data + pieces[i].position, pieces[i].bytes, pieces[i].size);
+
+	MachInfo::setKernelWriting(false, KernelPatcher::kernelWriteLock);
+
+	for (size_t i = 0; i < pieceNum; i++)
+		DBGLOG("unfair", "patched %s%s", pieces[i].name, pieces[i].edge ? " across page edge" : "");
+}
+
 void UNFAIR::csValidatePage(vnode *vp, memory_object_t pager, memory_object_offset_t page_offset, const void *data, int *validated_p, int *tainted_p, int *nx_p) {
 	FunctionCast(csValidatePage, callbackUNFAIR->orgCsValidatePage)(vp, pager, page_offset, data, validated_p, tainted_p, nx_p);
 
-	char path[PATH_MAX];
-	int pathlen = PATH_MAX;
-	if (vn_getpath(vp, path, &pathlen) == 0) {
-		//DBGLOG("unfair", "csValidatePage %s", path);
+	// Most validated pages belong to binaries we never patch, answer them without resolving the path.
+	uint32_t vid = vnode_vid(vp);
+	auto verdict = callbackUNFAIR->lookupVerdict(vp, vid);
+	if (verdict == PageVerdict::Unknown) {
+		char path[PATH_MAX];
+		int pathlen = PATH_MAX;
+		if (vn_getpath(vp, path, &pathlen) != 0)
+			return;
 
-		if ((callbackUNFAIR->unfairGva & UnfairDyldSharedCache) != 0 && UserPatcher::matchSharedCachePath(path)) {
-			if ((callbackUNFAIR->unfairGva & UnfairRelaxHdcpRequirements) != 0) {
-				static const uint8_t find[29] = {
-					0x4D, 0x61, 0x63, 0x50, 0x72, 0x6F, 0x35, 0x2C, 0x31, 0x00, 0x4D, 0x61, 0x63, 0x50, 0x72, 0x6F,
-					0x36, 0x2C, 0x31, 0x00, 0x49, 0x4F, 0x53, 0x65, 0x72, 0x76, 0x69, 0x63, 0x65
-				};
-				if (UNLIKELY(KernelPatcher::findAndReplace(const_cast<void *>(data), PAGE_SIZE, find, sizeof(find), BaseDeviceInfo::get().modelIdentifier, 20)))
-					DBGLOG("unfair", "patched relaxed drm model");
-			}
-
-			if ((callbackUNFAIR->unfairGva & UnfairCustomAppleGvaBoardId) != 0) {
-				static const uint8_t find[18] = {
-					0x62, 0x6F, 0x61, 0x72, 0x64, 0x2D, 0x69, 0x64, 0x00, 0x68, 0x77, 0x2E, 0x6D, 0x6F, 0x64, 0x65,
-					0x6C
-				};
-				static const uint8_t repl[5] = {
-					0x68, 0x77, 0x67, 0x76, 0x61
-				};
-				if (UNLIKELY(KernelPatcher::findAndReplace(const_cast<void *>(data), PAGE_SIZE, find, sizeof(find), repl, sizeof(repl))))
-					DBGLOG("unfair", "patched board-id -> hwgva-id");
-			}
-
-		} else if ((callbackUNFAIR->unfairGva & UnfairAllowHardwareDrmStreamDecoderOnOldCpuid) != 0 &&
-				   (UNLIKELY(strcmp(path, "/System/Library/PrivateFrameworks/CoreLSKDMSE.framework/Versions/A/CoreLSKDMSE") == 0) ||
-				   UNLIKELY(strcmp(path, "/System/Library/PrivateFrameworks/CoreLSKD.framework/Versions/A/CoreLSKD") == 0))) {
-			static const uint8_t find[] = {0xC7, 0xC0, 0x01, 0x00, 0x00, 0x00, 0x0F, 0xA2};
-			static const uint8_t repl[] = {0xC7, 0xC0, 0xC3, 0x06, 0x03, 0x00, 0x90, 0x90};
-			if (UNLIKELY(KernelPatcher::findAndReplace(const_cast<void *>(data), PAGE_SIZE, find, sizeof(find), repl, sizeof(repl))))
-				DBGLOG("unfair", "patched streaming cpuid to haswell");
-		}
+		//DBGLOG("unfair", "csValidatePage %s", path);
+		verdict = callbackUNFAIR->classifyPath(path);
+		callbackUNFAIR->storeVerdict(vp, vid, verdict);
 	}
+
+	auto page = static_cast<uint8_t *>(const_cast<void *>(data));
+	if (verdict == PageVerdict::SharedCache)
+		callbackUNFAIR->rewritePage(callbackUNFAIR->sharedCacheRewrites, vp, vid, page_offset, page);
+	else if (verdict == PageVerdict::CoreLSKD)
+		callbackUNFAIR->rewritePage(callbackUNFAIR->coreLSKDRewrites, vp, vid, page_offset, page);
 }
 
 void UNFAIR::processKernel(KernelPatcher &patcher, DeviceInfo *info) {
@@ -109,6 +329,14 @@ void UNFAIR::processKernel(KernelPatcher &patcher, DeviceInfo *info) {
 		}
 	}
 
+	if ((unfairGva & UnfairRelaxHdcpRequirements) != 0)
+		sharedCacheRewrites.add({relaxedDrmModelFind, sizeof(relaxedDrmModelFind),
+			reinterpret_cast<const uint8_t *>(BaseDeviceInfo::get().modelIdentifier), 20, "relaxed drm model"});
+	if ((unfairGva & UnfairCustomAppleGvaBoardId) != 0)
+		sharedCacheRewrites.add({hwgvaIdFind, sizeof(hwgvaIdFind), hwgvaIdReplace, sizeof(hwgvaIdReplace), "board-id -> hwgva-id"});
+	if ((unfairGva & UnfairAllowHardwareDrmStreamDecoderOnOldCpuid) != 0)
+		coreLSKDRewrites.add({streamingCpuidFind, sizeof(streamingCpuidFind), streamingCpuidReplace, sizeof(streamingCpuidReplace), "streaming cpuid to haswell"});
+
 	KernelPatcher::RouteRequest csRoute("_cs_validate_page", csValidatePage, orgCsValidatePage);
 	if (!patcher.routeMultipleLong(KernelPatcher::KernelID, &csRoute, 1)) {
 		SYSLOG("unfair", "failed to route cs validation pages");
@@ -52,6 +52,167 @@ private:
 	 */
 	uint32_t unfairGva {0};
 
+	/**
+	 *  What csValidatePage does with the pages of a binary
+	 */
+	enum class PageVerdict : uint32_t {
+		Unknown,
+		Ignore,
+		SharedCache,
+		CoreLSKD,
+	};
+
+	/**
+	 *  Verdict cache slot, guarded by a per-slot sequence counter
+	 */
+	struct VerdictSlot {
+		uint32_t sequence;   // odd while the slot is being written
+		uint32_t vid;
+		vnode *vp;
+		uint32_t verdict;    // PageVerdict
+	};
+
+	/**
+	 *  Verdict cache size, must be a power of two
+	 */
+	static constexpr size_t VerdictCacheSize = 256;
+
+	/**
+	 *  Verdict cache keyed by vnode pointer and vnode id, direct-mapped
+	 */
+	VerdictSlot verdictCache[VerdictCacheSize] {};
+
+	/**
+	 *  Page rewrite, replacing the first bytes of a matched pattern
+	 */
+	struct PageRewrite {
+		const uint8_t *find;
+		size_t findSize;
+		const uint8_t *replace;
+		size_t replaceSize;
+		const char *name;
+	};
+
+	/**
+	 *  Rewrites applied to the pages of one kind of binary, matched together in a single
+	 *  Horspool pass over windows of the shortest pattern length
+	 */
+	struct PageRewriteSet {
+		static constexpr size_t MaxRewrites = 2;
+		PageRewrite rewrites[MaxRewrites] {};
+		size_t num {0};
+		size_t window {0};                  // shortest pattern length
+		uint8_t shift[256] {};              // safe skip by the last window byte
+		uint32_t lastBytes[256 / 32] {};    // bitmap of last window bytes worth verifying
+
+		/**
+		 *  Add a rewrite to the set
+		 *
+		 *  @param rewrite  rewrite with a pattern of at most PageEdgeSize + 1 bytes, replacing its first bytes
+		 */
+		void add(const PageRewrite &rewrite);
+	};
+
+	/**
+	 *  Rewrites of dyld shared cache pages
+	 */
+	PageRewriteSet sharedCacheRewrites;
+
+	/**
+	 *  Rewrites of CoreLSKD pages
+	 */
+	PageRewriteSet coreLSKDRewrites;
+
+	/**
+	 *  Page bytes kept from each end of a page to match patterns crossing into its neighbours
+	 */
+	static constexpr size_t PageEdgeSize = 32;
+
+	/**
+	 *  Page edge cache slot, guarded by a per-slot sequence counter
+	 */
+	struct PageEdgeSlot {
+		uint32_t sequence;   // odd while the slot is being written
+		uint32_t vid;
+		vnode *vp;
+		memory_object_offset_t offset;
+		uint64_t head[PageEdgeSize / sizeof(uint64_t)];
+		uint64_t tail[PageEdgeSize / sizeof(uint64_t)];
+	};
+
+	/**
+	 *  Page edge cache size, must be a power of two
+	 */
+	static constexpr size_t PageEdgeCacheSize = 64;
+
+	/**
+	 *  Original edges of recently rewritten pages, adjacent pages of a file use adjacent slots
+	 */
+	PageEdgeSlot pageEdgeCache[PageEdgeCacheSize] {};
+
+	/**
+	 *  Look up an original page edge without locking
+	 *
+	 *  @param vp      vnode of the binary
+	 *  @param vid     vnode id of the binary
+	 *  @param offset  page offset in the binary
+	 *  @param tail    load the last PageEdgeSize bytes instead of the first ones
+	 *  @param edge    PageEdgeSize bytes of output
+	 *
+	 *  @return true when the page edge is known
+	 */
+	bool loadPageEdge(vnode *vp, uint32_t vid, memory_object_offset_t offset, bool tail, uint8_t *edge);
+
+	/**
+	 *  Remember the original edges of a page, skipped when another thread is writing the same slot
+	 *
+	 *  @param vp      vnode of the binary
+	 *  @param vid     vnode id of the binary
+	 *  @param offset  page offset in the binary
+	 *  @param head    first PageEdgeSize bytes of the page
+	 *  @param tail    last PageEdgeSize bytes of the page
+	 */
+	void storePageEdges(vnode *vp, uint32_t vid, memory_object_offset_t offset, const uint8_t *head, const uint8_t *tail);
+
+	/**
+	 *  Apply a rewrite set to a page, including patterns crossing into the already seen next page when their replacement fits this page
+	 *
+	 *  @param set     rewrites to apply
+	 *  @param vp      vnode of the binary
+	 *  @param vid     vnode id of the binary
+	 *  @param offset  page offset in the binary
+	 *  @param data    page contents
+	 */
+	void rewritePage(const PageRewriteSet &set, vnode *vp, uint32_t vid, memory_object_offset_t offset, uint8_t *data);
+
+	/**
+	 *  Decide what to do with the pages of a binary
+	 *
+	 *  @param path  binary path
+	 *
+	 *  @return verdict for the binary
+	 */
+	PageVerdict classifyPath(const char *path);
+
+	/**
+	 *  Look up a cached verdict without locking
+	 *
+	 *  @param vp   vnode of the binary
+	 *  @param vid  vnode id of the binary
+	 *
+	 *  @return cached verdict or PageVerdict::Unknown
+	 */
+	PageVerdict lookupVerdict(vnode *vp, uint32_t vid);
+
+	/**
+	 *  Remember a verdict, skipped when another thread is writing the same slot
+	 *
+	 *  @param vp       vnode of the binary
+	 *  @param vid      vnode id of the binary
+	 *  @param verdict  verdict to remember
+	 */
+	void storeVerdict(vnode *vp, uint32_t vid, PageVerdict verdict);
+
 	/**
 	 *  Codesign page validation wrapper used for userspace patching
 	 */